@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2020, Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+
+"""
+Prints GPU latency histograms of an UMD Perf Profiler output file, one per
+process, engine and component. Reads the file written at exit as well as
+the one streamed by ring mode while the process is still running.
+
+Usage: MediaPerfHistogram.py [--freq HZ] [--by-tag] linux_perf_out.bin
+"""
+
+import argparse
+import struct
+import sys
+
+# Layout of NodeHeader and PerfEntry in media_perf_profiler.cpp
+HEADER_SIZE = 4
+NODE_SIZE = 168
+NODE_FIELDS = struct.Struct('<6I')  # nodeIndex, processId, instanceId, engineTag, perfTag, timeStampBase
+# Timestamps are stored 8 bytes aligned and nodes start 4 bytes off, so both
+# timestamps sit 4 bytes after their field. Only the low dword of the end
+# timestamp is inside the node, the high one spills into the next node.
+BEGIN_TS_OFFSET = 156
+END_TS_LOW_OFFSET = 164
+
+ENGINES = {0: '3D', 1: 'VIDEO', 2: 'BLT', 3: 'VE', 4: 'VIDEO2'}
+
+BAR_WIDTH = 40
+
+
+def read_latencies(path, freq, by_tag):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    groups = {}
+    incomplete = 0
+    noFreq = False
+    for base in range(HEADER_SIZE, len(data) - NODE_SIZE + 1, NODE_SIZE):
+        _, pid, _, engine, tag, tsBase = NODE_FIELDS.unpack_from(data, base)
+        begin = struct.unpack_from('<Q', data, base + BEGIN_TS_OFFSET)[0]
+        endLow = struct.unpack_from('<I', data, base + END_TS_LOW_OFFSET)[0]
+        if begin == 0 or endLow == 0:
+            incomplete += 1
+            continue
+
+        # Node latency is far below 2^32 ticks, so the low dwords are enough
+        ticks = (endLow - begin) & 0xFFFFFFFF
+        hz = freq or tsBase
+        noFreq = noFreq or hz == 0
+        latency = ticks * 1e6 / hz if hz else float(ticks)
+
+        component = tag if by_tag else tag & 0xF000
+        key = (pid, ENGINES.get(engine, 'UNKNOWN(%d)' % engine), component)
+        groups.setdefault(key, []).append(latency)
+
+    return groups, incomplete, noFreq
+
+
+def print_histogram(key, latencies, unit):
+    pid, engine, component = key
+    latencies.sort()
+    count = len(latencies)
+    print('pid %d  engine %s  tag 0x%04x  nodes %d' % (pid, engine, component, count))
+    print('  min %.1f  avg %.1f  p50 %.1f  p99 %.1f  max %.1f %s' % (
+        latencies[0], sum(latencies) / count, latencies[count // 2],
+        latencies[min(count - 1, count * 99 // 100)], latencies[-1], unit))
+
+    # Power of two buckets
+    buckets = {}
+    for latency in latencies:
+        upper = 1
+        while upper <= latency:
+            upper *= 2
+        buckets[upper] = buckets.get(upper, 0) + 1
+
+    peak = max(buckets.values())
+    for upper in sorted(buckets):
+        bar = '#' * max(1, buckets[upper] * BAR_WIDTH // peak)
+        print('  %10d - %-10d %8d  %s' % (upper // 2, upper, buckets[upper], bar))
+    print('')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per context GPU latency histograms of UMD Perf Profiler output')
+    parser.add_argument('file', help='output file of the perf profiler')
+    parser.add_argument('--freq', type=int, default=0,
+                        help='GPU timestamp frequency in Hz, default is the one recorded in the nodes')
+    parser.add_argument('--by-tag', action='store_true',
+                        help='split by full perf tag instead of component')
+    args = parser.parse_args()
+
+    groups, incomplete, noFreq = read_latencies(args.file, args.freq, args.by_tag)
+    if not groups:
+        print('No completed nodes in %s' % args.file)
+        return 1
+
+    # Without a frequency the latencies stay in GPU timestamp ticks
+    unit = 'ticks' if noFreq else 'us'
+    if noFreq:
+        print('No timestamp frequency recorded, use --freq to get microseconds\n')
+    for key in sorted(groups):
+        print_histogram(key, groups[key], unit)
+
+    if incomplete:
+        print('%d incomplete nodes skipped' % incomplete)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -56,7 +56,7 @@ struct CM_QUEUE_CREATE_OPTION
     bool                          UserGPUContext          : 1; // Is the user-provided GPU Context already created externally
     unsigned int                  GPUContext              : 8; // user-provided GPU Context ordinal
     CM_QUEUE_SSEU_USAGE_HINT_TYPE SseuUsageHint           : 3;
-    unsigned int                  Reserved1               : 1;
+    bool                          AsyncFlush              : 1; // Flush tasks from a dedicated thread instead of the enqueuing thread
     unsigned int                  Reserved2               : 12;
 };
 
@@ -1717,7 +1717,7 @@ public:
     //!                 bool UserGPUContext                         : 1;
     //!                 unsigned int GPUContext                     : 8;
     //!                 CM_QUEUE_SSEU_USAGE_HINT_TYPE SseuUsageHint : 3;
-    //!                 unsigned int Reserved1                      : 1;
+    //!                 bool AsyncFlush                             : 1;
     //!                 unsigned int Reserved2                      : 12;
     //!             }
     //!             \endcode
@@ -1749,6 +1749,12 @@ public:
     //!             };
     //!             \endcode
     //!             \n
+    //!             <b>AsyncFlush</b> makes Enqueue() hand tasks to a flush
+    //!             thread of the queue instead of flushing them on the calling
+    //!             thread. Enqueue() then only blocks when the queue's task ring
+    //!             is full, and CmEvent::WaitForTaskFinished() waits until the
+    //!             task has been flushed. Off by default.
+    //!             \n
     //! \retval     CM_SUCCESS if the CmQueue object is created.
     //! \note       This API is implemented in hardware mode only. Only
     //!             CM_QUEUE_TYPE_RENDER and CM_QUEUE_TYPE_COMPUTE are
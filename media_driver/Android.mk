@@ -75,7 +75,9 @@ LOCAL_SRC_FILES := \
     agnostic/common/codec/hal/codechal.cpp \
     agnostic/common/codec/hal/codechal_allocator.cpp \
     agnostic/common/codec/hal/codechal_debug.cpp \
+    agnostic/common/codec/hal/codechal_debug_compress.cpp \
     agnostic/common/codec/hal/codechal_debug_config_manager.cpp \
+    agnostic/common/codec/hal/codechal_debug_dump_writer.cpp \
     agnostic/common/codec/hal/codechal_debug_encode_par.cpp \
     agnostic/common/codec/hal/codechal_decode_avc.cpp \
     agnostic/common/codec/hal/codechal_decode_downsampling.cpp \
@@ -167,6 +169,8 @@ LOCAL_SRC_FILES := \
     agnostic/common/os/mos_os_virtualengine.cpp \
     agnostic/common/os/mos_os_virtualengine_scalability.cpp \
     agnostic/common/os/mos_os_virtualengine_singlepipe.cpp \
+    agnostic/common/os/mos_perf_records.cpp \
+    agnostic/common/os/mos_swizzle.cpp \
     agnostic/common/os/mos_util_debug.cpp \
     agnostic/common/os/mos_util_user_interface.cpp \
     agnostic/common/os/mos_utilities.cpp \
@@ -578,6 +582,7 @@ LOCAL_SRC_FILES := \
     linux/common/codec/ddi/media_ddi_encode_fei_hevc.cpp \
     linux/common/codec/ddi/media_ddi_encode_hevc.cpp \
     linux/common/codec/ddi/media_ddi_encode_jpeg.cpp \
+    linux/common/codec/ddi/media_ddi_encode_mfe.cpp \
     linux/common/codec/ddi/media_ddi_encode_mpeg2.cpp \
     linux/common/codec/ddi/media_ddi_encode_vp8.cpp \
     linux/common/codec/ddi/media_ddi_encode_vp9.cpp \
@@ -601,6 +606,7 @@ LOCAL_SRC_FILES := \
     linux/common/os/hwinfo_linux.c \
     linux/common/os/i915/mos_bufmgr.c \
     linux/common/os/i915/mos_bufmgr_api.c \
+    linux/common/os/i915/mos_vma.c \
     linux/common/os/i915/xf86drm.c \
     linux/common/os/i915/xf86drmHash.c \
     linux/common/os/i915/xf86drmMode.c \
@@ -625,6 +631,7 @@ LOCAL_SRC_FILES := \
     linux/common/renderhal/renderhal_linux.cpp \
     linux/common/vp/ddi/media_libva_vp.c \
     linux/common/vp/ddi/media_libva_vp_tools.c \
+    linux/common/vp/hal/hal_kerneldll_specific.c \
     linux/common/vp/hal/vphal_common_specific.c \
     linux/common/vp/hal/vphal_render_common_specific.c \
     linux/gen10/ddi/media_libva_caps_g10.cpp \
@@ -726,6 +733,7 @@ LOCAL_SRC_FILES := \
     media_driver_next/agnostic/common/shared/task/media_task.cpp \
     media_driver_next/agnostic/common/vp/hal/bufferMgr/vp_allocator.cpp \
     media_driver_next/agnostic/common/vp/hal/bufferMgr/vp_resource_manager.cpp \
+    media_driver_next/agnostic/common/vp/hal/bufferMgr/vp_surface_pool.cpp \
     media_driver_next/agnostic/common/vp/hal/feature_manager/hw_filter.cpp \
     media_driver_next/agnostic/common/vp/hal/feature_manager/hw_filter_pipe.cpp \
     media_driver_next/agnostic/common/vp/hal/feature_manager/policy.cpp \
@@ -794,6 +802,7 @@ LOCAL_SRC_FILES := \
     media_driver_next/linux/common/os/mos_os_specific_next.cpp \
     media_driver_next/linux/common/os/mos_os_virtualengine_scalability_specific_next.cpp \
     media_driver_next/linux/common/os/mos_os_virtualengine_singlepipe_specific_next.cpp \
+    media_driver_next/linux/common/os/mos_user_feature_store.cpp \
     media_driver_next/linux/common/os/mos_util_debug_specific_next.cpp \
     media_driver_next/linux/common/os/mos_utilities_specific_next.cpp \
     media_interface/media_interfaces_m10_cnl/media_interfaces_g10_cnl.cpp \
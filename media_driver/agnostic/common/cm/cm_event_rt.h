@@ -28,6 +28,9 @@
 #define MEDIADRIVER_AGNOSTIC_COMMON_CM_CMEVENTRT_H_
 
 #include "cm_event.h"
+
+#include <atomic>
+
 #include "cm_csync.h"
 #include "cm_hal.h"
 #include "cm_log.h"
@@ -125,6 +128,8 @@ public:
 
     CM_STATUS GetStatusWithoutFlush();
 
+    int32_t WaitForTaskFence(uint32_t timeOutMs);
+
 #if CM_LOG_ON
     std::string Log(const char *callerFuncName);
 
@@ -184,7 +189,7 @@ protected:
     void *m_callbackUserData;                  //Pdata for Callback
 
 private:
-    bool m_osSignalTriggered;
+    std::atomic<bool> m_osSignalTriggered;  // Written by the flush thread and by waiters
 
     CmEventRT(const CmEventRT& other);
     CmEventRT& operator=(const CmEventRT& other);
@@ -21,25 +21,47 @@
 */
 //!
 //! \file      cm_hal_hashtable.cpp  
-//! \brief         This modules implements a simple coalesced hash table used 
+//! \brief         This modules implements an open addressing hash table used 
 //!                for kernel search in dynamic state heap based CmHal. 
 //!                It exposes hash table initialization, destruction,     
 //!                registration, unregistration and search functions used to 
-//!                speed up kernel search. The hash table size is currently 
-//!                limited to 65535 (MAX uint16_t-1), and 2 keys may be used
+//!                speed up kernel search. 2 keys may be used
 //!                iKUID (Kernel Unique Identifier - int32_t) and 
 //!                CacheID (Arbitrary Kernel Cache ID - int32_t).
+//!                Only iKUID is hashed, so searches that don't care about
+//!                CacheID probe the same groups.
 //!                Given the dynamic nature of the ISH and kernel allocation,
 //!                the hash table is allowed to grow dynamically as needed.  
 //!
 
+#include <emmintrin.h>
+#include <string.h>
 #include "cm_hal_hashtable.h"
 
+#define CM_HAL_HASHTABLE_EMPTY     0x80         // Control byte of a slot never used since the last rehash
+#define CM_HAL_HASHTABLE_DELETED   0xFE         // Control byte of an unregistered slot
+#define CM_HAL_HASHTABLE_NO_SLOT   0xFFFFFFFF
+
+// Bit i set for every control byte i of the group equal to value
+static inline uint32_t CmHashTable_MatchGroup(const uint8_t *pControl, uint8_t value)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)pControl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+}
+
+// Bit i set for every empty or deleted control byte i of the group
+static inline uint32_t CmHashTable_MatchFree(const uint8_t *pControl)
+{
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)pControl));
+}
+
 MOS_STATUS CmHashTable::Init()
 {
     MOS_STATUS               eStatus = MOS_STATUS_SUCCESS;
     PCM_HAL_HASH_TABLE_ENTRY pHashEntry = nullptr;
 
+    MOS_ZeroMemory(&m_hashTable, sizeof(m_hashTable));
+
     pHashEntry = (PCM_HAL_HASH_TABLE_ENTRY)MOS_AllocMemory(CM_HAL_HASHTABLE_INITIAL * sizeof(CM_HAL_HASH_TABLE_ENTRY));
     if (!pHashEntry)
     {
@@ -47,19 +69,25 @@ MOS_STATUS CmHashTable::Init()
         return eStatus;
     }
 
-
     m_hashTable.pHashEntries = pHashEntry;
-    m_hashTable.wSize = CM_HAL_HASHTABLE_INITIAL;
-    m_hashTable.wFree = 1; // First free element = 1 (0 is reserved for nullptr; 0xffff could be used instead, but 0 makes it cleaner/easier to read/understand)
+    m_hashTable.dwSize = CM_HAL_HASHTABLE_INITIAL;
+    m_hashTable.dwFree = 1; // First free element = 1 (0 is reserved for nullptr; 0xffff could be used instead, but 0 makes it cleaner/easier to read/understand)
     for (int i = 0; i < CM_HAL_HASHTABLE_INITIAL - 1; i++, pHashEntry++)
     {
         pHashEntry->UniqID = -1;
         pHashEntry->CacheID = -1;
-        pHashEntry->wNext = i + 1;
+        pHashEntry->dwNext = i + 1;
         pHashEntry->pData = nullptr;
     }
     pHashEntry--;
-    pHashEntry->wNext = 0;
+    pHashEntry->dwNext = 0;
+
+    // Keep the load factor at or below 1/2 until the first growth
+    eStatus = Rehash(2 * CM_HAL_HASHTABLE_INITIAL / CM_HAL_HASHTABLE_GROUP);
+    if (eStatus != MOS_STATUS_SUCCESS)
+    {
+        Free();
+    }
 
     return eStatus;
 }
@@ -67,94 +95,216 @@ MOS_STATUS CmHashTable::Init()
 void CmHashTable::Free()
 {
     if (m_hashTable.pHashEntries) MOS_FreeMemory(m_hashTable.pHashEntries);
+    if (m_hashTable.pControl) MOS_FreeMemory(m_hashTable.pControl);
+    MOS_ZeroMemory(&m_hashTable, sizeof(m_hashTable));
 }
 
-uint16_t CmHashTable::SimpleHash(int32_t value)
+uint64_t CmHashTable::Hash(int32_t value)
 {
-    uint16_t wHash = ((value >> 16) ^ value) & 0xFFFF;
-    wHash = ((wHash >> 8) ^ wHash) & 0xFF;
-    return wHash;
+    // Full avalanche, consecutive kernel ids land in unrelated groups
+    uint64_t hash = (uint32_t)value;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
 }
 
-MOS_STATUS CmHashTable::Extend()
+MOS_STATUS CmHashTable::ExtendEntries()
 {
-    uint16_t                    wEntry;
+    uint32_t                    dwEntry;
     PCM_HAL_HASH_TABLE_ENTRY    pEntry;
-    int32_t                     iPrevSize, iNewSize;
+    uint32_t                    dwPrevSize, dwNewSize;
     MOS_STATUS                  hr = MOS_STATUS_UNKNOWN;
 
-    if (m_hashTable.wSize >= CM_HAL_HASHTABLE_MAX)
+    if (m_hashTable.dwSize >= CM_HAL_HASHTABLE_MAX)
     {
         goto finish;
     }
 
-    iPrevSize = m_hashTable.wSize * sizeof(CM_HAL_HASH_TABLE_ENTRY);
-    iNewSize = iPrevSize + CM_HAL_HASHTABLE_INCREMENT * sizeof(CM_HAL_HASH_TABLE_ENTRY);
-    pEntry = (PCM_HAL_HASH_TABLE_ENTRY)MOS_AllocMemory(iNewSize);
+    dwPrevSize = m_hashTable.dwSize;
+    dwNewSize = dwPrevSize * 2;
+    pEntry = (PCM_HAL_HASH_TABLE_ENTRY)MOS_AllocMemory(dwNewSize * sizeof(CM_HAL_HASH_TABLE_ENTRY));
     if (!pEntry)
     {
         hr = MOS_STATUS_NO_SPACE;
         goto finish;
     }
 
-    // Transfer the hash entries to larger table, free old (smaller) table
-    MOS_SecureMemcpy(pEntry, iPrevSize, m_hashTable.pHashEntries, iPrevSize);
+    // Transfer the hash entries to larger table, free old (smaller) table.
+    // Slots refer to entries by handle, so they are not touched.
+    MOS_SecureMemcpy(pEntry, dwNewSize * sizeof(CM_HAL_HASH_TABLE_ENTRY), m_hashTable.pHashEntries, dwPrevSize * sizeof(CM_HAL_HASH_TABLE_ENTRY));
     MOS_FreeMemory(m_hashTable.pHashEntries);
     m_hashTable.pHashEntries = pEntry;
 
     // Initialize entries
-    wEntry = m_hashTable.wSize + 1;
-    pEntry += m_hashTable.wSize;
-    for (int i = CM_HAL_HASHTABLE_INCREMENT; i > 0; i--, wEntry++, pEntry++)
+    dwEntry = dwPrevSize + 1;
+    pEntry += dwPrevSize;
+    for (uint32_t i = dwNewSize - dwPrevSize; i > 0; i--, dwEntry++, pEntry++)
     {
         pEntry->UniqID = -1;
         pEntry->CacheID = -1;
-        pEntry->wNext = wEntry;
+        pEntry->dwNext = dwEntry;
         pEntry->pData = nullptr;
     }
     pEntry--;
 
     // Update free list - new array is appended at the beginning of the free list, avoiding the need to traverse it.
-    pEntry->wNext = m_hashTable.wFree;               // Last entry of newly created entries points to first pre-existing free entry
-    m_hashTable.wFree = m_hashTable.wSize;               // Free list points to newly created array, which points to pre-existing array
-    m_hashTable.wSize += CM_HAL_HASHTABLE_INCREMENT; // Update size of the hash table
+    pEntry->dwNext = m_hashTable.dwFree;            // Last entry of newly created entries points to first pre-existing free entry
+    m_hashTable.dwFree = dwPrevSize;                // Free list points to newly created array, which points to pre-existing array
+    m_hashTable.dwSize = dwNewSize;                 // Update size of the hash table
 
     hr = MOS_STATUS_SUCCESS;
 
 finish:
     return hr;
 }
+
+MOS_STATUS CmHashTable::Rehash(uint32_t dwGroupCount)
+{
+    uint32_t    dwSlotCount = dwGroupCount * CM_HAL_HASHTABLE_GROUP;
+    uint8_t     *pPrevControl = m_hashTable.pControl;
+    uint32_t    *pPrevSlots = m_hashTable.pSlots;
+    uint32_t    dwPrevSlotCount = pPrevControl ? (m_hashTable.dwGroupMask + 1) * CM_HAL_HASHTABLE_GROUP : 0;
+    uint8_t     *pControl;
+
+    // Control bytes and slots share one allocation
+    pControl = (uint8_t *)MOS_AllocMemory(dwSlotCount * (sizeof(uint8_t) + sizeof(uint32_t)));
+    if (!pControl)
+    {
+        return MOS_STATUS_NO_SPACE;
+    }
+    memset(pControl, CM_HAL_HASHTABLE_EMPTY, dwSlotCount);
+
+    m_hashTable.pControl = pControl;
+    m_hashTable.pSlots = (uint32_t *)(pControl + dwSlotCount);
+    m_hashTable.dwGroupMask = dwGroupCount - 1;
+    m_hashTable.dwUsedSlots = 0;
+
+    // Reinsert full slots, dropping deleted ones
+    for (uint32_t i = 0; i < dwPrevSlotCount; i++)
+    {
+        if (pPrevControl[i] & CM_HAL_HASHTABLE_EMPTY)
+        {
+            continue;
+        }
+        uint32_t dwHandle = pPrevSlots[i];
+        InsertSlot(Hash(m_hashTable.pHashEntries[dwHandle].UniqID), dwHandle);
+    }
+
+    if (pPrevControl) MOS_FreeMemory(pPrevControl);
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void CmHashTable::InsertSlot(uint64_t hash, uint32_t dwHandle)
+{
+    uint32_t dwGroup = (uint32_t)(hash >> 7) & m_hashTable.dwGroupMask;
+
+    // Triangular probing visits every group once, and the table is never full
+    for (uint32_t dwStep = 1; ; dwStep++)
+    {
+        uint8_t  *pControl = m_hashTable.pControl + dwGroup * CM_HAL_HASHTABLE_GROUP;
+        uint32_t dwMatch = CmHashTable_MatchFree(pControl);
+        if (dwMatch)
+        {
+            uint32_t dwSlot = dwGroup * CM_HAL_HASHTABLE_GROUP + __builtin_ctz(dwMatch);
+            if (m_hashTable.pControl[dwSlot] == CM_HAL_HASHTABLE_EMPTY)
+            {
+                m_hashTable.dwUsedSlots++;
+            }
+            m_hashTable.pControl[dwSlot] = (uint8_t)(hash & 0x7F);
+            m_hashTable.pSlots[dwSlot] = dwHandle;
+            return;
+        }
+        dwGroup = (dwGroup + dwStep) & m_hashTable.dwGroupMask;
+    }
+}
+
+uint32_t CmHashTable::FindSlot(int32_t UniqID, int32_t CacheID)
+{
+    uint64_t hash = Hash(UniqID);
+    uint32_t dwGroup = (uint32_t)(hash >> 7) & m_hashTable.dwGroupMask;
+
+    if (!m_hashTable.pControl)
+    {
+        return CM_HAL_HASHTABLE_NO_SLOT;
+    }
+
+    for (uint32_t dwStep = 1; dwStep <= m_hashTable.dwGroupMask + 1; dwStep++)
+    {
+        uint8_t  *pControl = m_hashTable.pControl + dwGroup * CM_HAL_HASHTABLE_GROUP;
+        uint32_t dwMatch = CmHashTable_MatchGroup(pControl, (uint8_t)(hash & 0x7F));
+        while (dwMatch)
+        {
+            uint32_t dwSlot = dwGroup * CM_HAL_HASHTABLE_GROUP + __builtin_ctz(dwMatch);
+            PCM_HAL_HASH_TABLE_ENTRY pEntry = m_hashTable.pHashEntries + m_hashTable.pSlots[dwSlot];
+            if (pEntry->UniqID == UniqID && (CacheID < 0 || pEntry->CacheID == CacheID))
+            {
+                return dwSlot;
+            }
+            dwMatch &= dwMatch - 1;
+        }
+
+        // An empty slot ends the probe sequence, the key would have been stored there
+        if (CmHashTable_MatchGroup(pControl, CM_HAL_HASHTABLE_EMPTY))
+        {
+            break;
+        }
+        dwGroup = (dwGroup + dwStep) & m_hashTable.dwGroupMask;
+    }
+
+    return CM_HAL_HASHTABLE_NO_SLOT;
+}
+
 MOS_STATUS CmHashTable::Register(int32_t UniqID, int32_t CacheID, void  *pData)
 {
-    uint16_t                    wHash;
-    uint16_t                    wEntry;
+    uint32_t                    dwEntry;
+    uint32_t                    dwSlotCount;
     PCM_HAL_HASH_TABLE_ENTRY    pEntry;
     MOS_STATUS                  hr = MOS_STATUS_UNKNOWN;
 
-    wHash = SimpleHash(UniqID);
+    if (!m_hashTable.pControl)
+    {
+        goto finish;
+    }
+
+    // Keep at least 1/8 of the slots empty so misses stop early; grow when
+    // half the slots hold entries, otherwise only purge deleted slots
+    dwSlotCount = (m_hashTable.dwGroupMask + 1) * CM_HAL_HASHTABLE_GROUP;
+    if ((m_hashTable.dwUsedSlots + 1) * 8 > dwSlotCount * 7)
+    {
+        uint32_t dwGroupCount = m_hashTable.dwGroupMask + 1;
+        if ((m_hashTable.dwCount + 1) * 2 > dwSlotCount)
+        {
+            dwGroupCount *= 2;
+        }
+        hr = Rehash(dwGroupCount);
+        if (hr != MOS_STATUS_SUCCESS)
+            goto finish;
+    }
 
     // Get new entry
-    wEntry = m_hashTable.wFree;
+    dwEntry = m_hashTable.dwFree;
 
-    // Extend hash table, get new free entry
-    if (wEntry == 0)
+    // Extend entry array, get new free entry
+    if (dwEntry == 0)
     {
-        hr = Extend();
+        hr = ExtendEntries();
         if (hr != MOS_STATUS_SUCCESS)
             goto finish;
-        wEntry = m_hashTable.wFree;
+        dwEntry = m_hashTable.dwFree;
     }
 
     // Remove entry from free list
-    pEntry = m_hashTable.pHashEntries + wEntry;
-    m_hashTable.wFree = pEntry->wNext;
+    pEntry = m_hashTable.pHashEntries + dwEntry;
+    m_hashTable.dwFree = pEntry->dwNext;
 
-    // Link hash entry
     pEntry->UniqID = UniqID;                   // save unique id
-    pEntry->CacheID = CacheID;                  // save unique id
-    pEntry->pData = pData;                    // save pointer to data
-    pEntry->wNext = m_hashTable.wHead[wHash]; // points to next entry in same bucket
-    m_hashTable.wHead[wHash] = wEntry;          // move entry to head of the bucket
+    pEntry->CacheID = CacheID;                 // save cache id
+    pEntry->pData = pData;                     // save pointer to data
+    pEntry->dwNext = 0;
+
+    InsertSlot(Hash(UniqID), dwEntry);
+    m_hashTable.dwCount++;
 
     hr = MOS_STATUS_SUCCESS;
 
@@ -162,99 +312,67 @@ finish:
     return hr;
 }
 
-void* CmHashTable::Search(int32_t UniqID, int32_t CacheID, uint16_t &wSearchIndex)
+void* CmHashTable::Search(int32_t UniqID, int32_t CacheID, uint32_t &dwSearchIndex)
 {
-    PCM_HAL_HASH_TABLE_ENTRY    pEntry = nullptr;
-    void                        *pData = nullptr;
-    bool                        bFound;
+    uint32_t dwSlot = FindSlot(UniqID, CacheID);
 
-    // Get first entry, or continue previous search
-    if (wSearchIndex == 0 ||
-        wSearchIndex >= m_hashTable.wSize)
+    if (dwSlot == CM_HAL_HASHTABLE_NO_SLOT)
     {
-        uint16_t wHash = SimpleHash(UniqID);
-        wSearchIndex = m_hashTable.wHead[wHash];
+        dwSearchIndex = 0;
+        return nullptr;
     }
 
-    if (CacheID >= 0)
-    {
-        // Search for UniqID/CacheID
-        for (bFound = false; (wSearchIndex > 0) && (!bFound); wSearchIndex = pEntry->wNext)
-        {
-            pEntry = m_hashTable.pHashEntries + wSearchIndex;
-            bFound = (pEntry->UniqID == UniqID) && (pEntry->CacheID == CacheID);
-        }
-    }
-    else
-    {
-        // Search for UniqID (don't care about CacheID)
-        for (bFound = false; (wSearchIndex > 0) && (!bFound); wSearchIndex = pEntry->wNext)
-        {
-            pEntry = m_hashTable.pHashEntries + wSearchIndex;
-            bFound = (pEntry->UniqID == UniqID);
-        }
-    }
+    dwSearchIndex = m_hashTable.pSlots[dwSlot];
+    return m_hashTable.pHashEntries[dwSearchIndex].pData;
+}
 
-    // Retrieve user data
-    if (bFound)
+void* CmHashTable::GetData(uint32_t dwHandle)
+{
+    if (dwHandle == 0 || dwHandle >= m_hashTable.dwSize)
     {
-        pData = pEntry->pData;
+        return nullptr;
     }
 
-    return pData;
+    return m_hashTable.pHashEntries[dwHandle].pData;
 }
 
 void* CmHashTable::Unregister(int32_t UniqID, int32_t CacheID)
 {
-    uint16_t                    wHash;
-    uint16_t                    wEntry = 0;
-    uint16_t                    wSearchIndex;
-    PCM_HAL_HASH_TABLE_ENTRY    pEntry, pPrevEntry;
+    uint32_t                    dwSlot;
+    uint32_t                    dwEntry;
+    uint8_t                     *pGroup;
+    PCM_HAL_HASH_TABLE_ENTRY    pEntry;
     void                        *pData = nullptr;
 
+    dwSlot = FindSlot(UniqID, CacheID);
+    if (dwSlot == CM_HAL_HASHTABLE_NO_SLOT)
+    {
+        return pData;
+    }
 
-    wHash = SimpleHash(UniqID);
-
-    // Search for UniqID/CacheID (hashing should significantly speedup this search)
-    pEntry = pPrevEntry = nullptr;
-    wSearchIndex = m_hashTable.wHead[wHash];
-    bool bFound;
-
-    if (CacheID >= 0)
+    // A group that still has an empty slot was never full, so no probe
+    // sequence continues past it and the slot can become empty again
+    pGroup = m_hashTable.pControl + (dwSlot & ~(CM_HAL_HASHTABLE_GROUP - 1));
+    if (CmHashTable_MatchGroup(pGroup, CM_HAL_HASHTABLE_EMPTY))
     {
-        // Search for UniqID/CacheID
-        for (bFound = false; (wSearchIndex > 0) && (!bFound); wSearchIndex = pEntry->wNext)
-        {
-            wEntry = wSearchIndex;
-            pEntry = m_hashTable.pHashEntries + wSearchIndex;
-            bFound = (pEntry->UniqID == UniqID) && (pEntry->CacheID == CacheID);
-        }
+        m_hashTable.pControl[dwSlot] = CM_HAL_HASHTABLE_EMPTY;
+        m_hashTable.dwUsedSlots--;
     }
     else
     {
-        // Search for UniqID (don't care about CacheID)
-        for (bFound = false; (wSearchIndex > 0) && (!bFound); wSearchIndex = pEntry->wNext)
-        {
-            wEntry = wSearchIndex;
-            pEntry = m_hashTable.pHashEntries + wSearchIndex;
-            bFound = (pEntry->UniqID == UniqID);
-        }
+        m_hashTable.pControl[dwSlot] = CM_HAL_HASHTABLE_DELETED;
     }
 
-    // Entry found
-    if (wEntry > 0)
-    {
-        // Detach from hash list
-        if (pPrevEntry)
-            pPrevEntry->wNext = pEntry->wNext;
-        else
-            m_hashTable.wHead[wHash] = pEntry->wNext;
-
-        // Move hash entry to free list
-        pEntry->wNext = m_hashTable.wFree;
-        m_hashTable.wFree = wEntry;
-        pData = pEntry->pData;
-    }
+    // Move hash entry to free list
+    dwEntry = m_hashTable.pSlots[dwSlot];
+    pEntry = m_hashTable.pHashEntries + dwEntry;
+    pData = pEntry->pData;
+    pEntry->UniqID = -1;
+    pEntry->CacheID = -1;
+    pEntry->pData = nullptr;
+    pEntry->dwNext = m_hashTable.dwFree;
+    m_hashTable.dwFree = dwEntry;
+    m_hashTable.dwCount--;
 
     return pData;
 }
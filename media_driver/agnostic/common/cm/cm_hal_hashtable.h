@@ -26,44 +26,63 @@
 #ifndef __CM_HAL_HASHTABLE_H__
 #define __CM_HAL_HASHTABLE_H__
 
-#include "mos_os.h"
+#include "mos_utilities.h"
 #include "stdint.h"
 
-#define CM_HAL_HASHTABLE_INITIAL   128
-#define CM_HAL_HASHTABLE_INCREMENT 64
-#define CM_HAL_HASHTABLE_MAX       2048
+#define CM_HAL_HASHTABLE_INITIAL   128          // Initial number of entries
+#define CM_HAL_HASHTABLE_MAX       (1 << 20)    // Maximum number of entries
+#define CM_HAL_HASHTABLE_GROUP     16           // Control bytes probed at once
 
 typedef struct _CM_HAL_HASH_TABLE_ENTRY
 {
     int32_t UniqID;
     int32_t CacheID;
-    uint16_t wNext;
+    uint32_t dwNext;    // Next free entry while the entry is free, 0 if last
     void    *pData;
 } CM_HAL_HASH_TABLE_ENTRY, *PCM_HAL_HASH_TABLE_ENTRY;
 
-typedef struct _CM_HAL_COALESCED_HASH_TABLE
+typedef struct _CM_HAL_OPEN_HASH_TABLE
 {
-    uint16_t                    wHead[256];         // Head of bucket list, 0 if empty
-    uint16_t                    wFree;              // Head of the free hash table list, 0 if not present
-    uint16_t                    wSize;              // Size of the hash table currently allocated
-    CM_HAL_HASH_TABLE_ENTRY *pHashEntries;       // Dynamically expanding coalescing hash table
-} CM_HAL_COALESCED_HASH_TABLE, *PCM_HAL_COALESCED_HASH_TABLE;
-
-typedef struct _CM_HAL_COALESCED_HASH_TABLE *PCM_HAL_COALESCED_HASH_TABLE;
+    uint8_t                 *pControl;          // Per slot: empty, deleted or low 7 bits of the hash
+    uint32_t                *pSlots;            // Per slot: handle of the entry
+    uint32_t                dwGroupMask;        // Number of probe groups - 1 (power of 2)
+    uint32_t                dwUsedSlots;        // Slots that are full or deleted
+    uint32_t                dwCount;            // Number of registered entries
+    uint32_t                dwFree;             // Head of the free entry list, 0 if empty
+    uint32_t                dwSize;             // Number of entries currently allocated
+    CM_HAL_HASH_TABLE_ENTRY *pHashEntries;      // Entries indexed by handle (0 is reserved)
+} CM_HAL_OPEN_HASH_TABLE, *PCM_HAL_OPEN_HASH_TABLE;
 
+//!
+//! \brief    Kernel hash table keyed by UniqID and CacheID.
+//! \details  Open addressing over groups of 16 slots, probed with SSE2 compares
+//!           of one control byte per slot. Entries live in a separate array, so
+//!           their handles stay valid when the slot array grows.
+//!
 class CmHashTable
 {
 public:
     MOS_STATUS Init();
     void Free();
     MOS_STATUS Register(int32_t UniqID, int32_t CacheID, void  *pData);
-    void*      Search(int32_t UniqID, int32_t CacheID, uint16_t &wSearchIndex);
+    //!
+    //! \brief    Search an entry, CacheID < 0 matches any CacheID
+    //! \param    [out] dwSearchIndex
+    //!           Handle of the entry found, 0 if none
+    //! \return   Data registered with the entry, nullptr if none
+    //!
+    void*      Search(int32_t UniqID, int32_t CacheID, uint32_t &dwSearchIndex);
     void*      Unregister(int32_t UniqID, int32_t CacheID);
+    void*      GetData(uint32_t dwHandle);
+    uint32_t   GetCount() { return m_hashTable.dwCount; }
 
 private:
-    uint16_t   SimpleHash(int32_t value);
-    MOS_STATUS Extend();
-    CM_HAL_COALESCED_HASH_TABLE m_hashTable;
+    uint64_t   Hash(int32_t value);
+    uint32_t   FindSlot(int32_t UniqID, int32_t CacheID);
+    void       InsertSlot(uint64_t hash, uint32_t dwHandle);
+    MOS_STATUS Rehash(uint32_t dwGroupCount);
+    MOS_STATUS ExtendEntries();
+    CM_HAL_OPEN_HASH_TABLE m_hashTable;
 };
 
 #endif // __CM_HAL_HASHTABLE_H__
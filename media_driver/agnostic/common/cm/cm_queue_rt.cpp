@@ -140,6 +140,11 @@ CmQueueRT::CmQueueRT(CmDeviceRT *device,
     m_osSyncEvent(nullptr),
     m_trackerIndex(0),
     m_fastTrackerIndex(0),
+    m_asyncFlush(false),
+    m_flushThread(0),
+    m_flushSemaphore(nullptr),
+    m_flushPending(false),
+    m_flushThreadExit(false),
     m_streamIndex(0),
     m_gpuContextHandle(MOS_GPU_CONTEXT_INVALID_HANDLE),
     m_syncBufferHandle(INVALID_SYNC_BUFFER_HANDLE)
@@ -154,6 +159,8 @@ CmQueueRT::CmQueueRT(CmDeviceRT *device,
 //*-----------------------------------------------------------------------------
 CmQueueRT::~CmQueueRT()
 {
+    StopFlushThread();
+
     m_osSyncEvent = nullptr;
     uint32_t eventArrayUsedSize = m_eventArray.GetMaxSize();
     for( uint32_t i = 0; i < eventArrayUsedSize; i ++ )
@@ -331,6 +338,11 @@ int32_t CmQueueRT::Initialize()
         }
     }
 
+    if (m_queueOption.AsyncFlush)
+    {
+        CM_CHK_CMSTATUS_GOTOFINISH(StartFlushThread());
+    }
+
 finish:
     return hr;
 }
@@ -625,13 +637,7 @@ int32_t CmQueueRT::Enqueue_RT(
 
     task->SetProperty(taskConfig);
 
-    if( !m_enqueuedTasks.Push( task ) )
-    {
-        CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.");
-        return CM_FAILURE;
-    }
-
-    result = FlushTaskWithoutSync();
+    result = PushEnqueuedTask(task);
 
     return result;
 }
@@ -705,13 +711,7 @@ int32_t CmQueueRT::Enqueue_RT(CmKernelRT* kernelArray[],
 
     task->SetProperty(taskConfig);
 
-    if( !m_enqueuedTasks.Push( task ) )
-    {
-        CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.")
-        return CM_FAILURE;
-    }
-
-    result = FlushTaskWithoutSync();
+    result = PushEnqueuedTask(task);
 
     return result;
 }
@@ -825,13 +825,7 @@ int32_t CmQueueRT::Enqueue_RT( CmKernelRT* kernelArray[],
 
     task->SetPowerOption( powerOption );
 
-    if (!m_enqueuedTasks.Push(task))
-    {
-        CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.")
-        return CM_FAILURE;
-    }
-
-    result = FlushTaskWithoutSync();
+    result = PushEnqueuedTask(task);
 
     return result;
 }
@@ -2659,6 +2653,9 @@ int32_t CmQueueRT::CleanQueue( )
 
     int32_t status = CM_SUCCESS;
 
+    // Flush thread drains the task ring before exiting
+    StopFlushThread();
+
     // Maybe not necessary since
     // it is called by ~CmDevice only
     // Update: necessary because it calls FlushBlockWithoutSync
@@ -2701,7 +2698,7 @@ CM_QUEUE_CREATE_OPTION &CmQueueRT::GetQueueOption()
 //*-----------------------------------------------------------------------------
 int32_t CmQueueRT::GetTaskCount( uint32_t& numTasks )
 {
-    numTasks = m_enqueuedTasks.GetCount() + m_flushedTasks.GetCount();
+    numTasks = m_taskRing.GetCount() + m_enqueuedTasks.GetCount() + m_flushedTasks.GetCount();
     return CM_SUCCESS;
 }
 
@@ -3292,12 +3289,29 @@ finish:
 //! to their order in the the queue. The queue will be empty after flush,
 //! This is a non-blocking call. i.e. it returs immediately without waiting for
 //! GPU to finish the execution of tasks.
+//! In asynchronous flush mode a non-blocking flush only wakes up the flush
+//! thread and retires finished tasks.
 //! INPUT:
 //! OUTPUT:
 //!     CM_SUCCESS if all tasks in the queue are submitted
 //!     CM_FAILURE otherwise.
 //*-----------------------------------------------------------------------------
 int32_t CmQueueRT::FlushTaskWithoutSync( bool flushBlocked )
+{
+    if (m_asyncFlush && !flushBlocked)
+    {
+        WakeFlushThread();
+        return QueryFlushedTasks();
+    }
+
+    return FlushEnqueuedTasks(flushBlocked);
+}
+
+//*-----------------------------------------------------------------------------
+//| Purpose:    Submit the tasks in m_enqueuedTasks to the GPU in order
+//| Returns:    Result of the operation.
+//*-----------------------------------------------------------------------------
+int32_t CmQueueRT::FlushEnqueuedTasks( bool flushBlocked )
 {
     int32_t             hr          = CM_SUCCESS;
     CmTaskInternal*     task       = nullptr;
@@ -3319,10 +3333,19 @@ int32_t CmQueueRT::FlushTaskWithoutSync( bool flushBlocked )
             while( flushedTaskCount >= m_halMaxValues->maxTasks )
             {
                 // If the task count in flushed queue is no less than hw restrictiion,
-                // query the staus of flushed task queue. Remove any finished tasks from the queue
+                // sleep on the oldest task's fence and then remove any finished tasks from the queue.
+                // The fence wait runs outside the execute lock so that other enqueues are not stalled.
+                m_criticalSectionHalExecute.Release();
+                WaitForOldestFlushedTask();
+                m_criticalSectionHalExecute.Acquire();
                 QueryFlushedTasks();
                 flushedTaskCount = m_flushedTasks.GetCount();
             }
+            if ( m_enqueuedTasks.IsEmpty() )
+            {
+                // Another thread flushed the remaining tasks while we were waiting
+                break;
+            }
         }
         else
         {
@@ -3343,6 +3366,9 @@ int32_t CmQueueRT::FlushTaskWithoutSync( bool flushBlocked )
         task = (CmTaskInternal*)m_enqueuedTasks.Pop();
         CM_CHK_NULL_GOTOFINISH_CMERROR( task );
 
+        // Tasks may be flushed from the flush thread after other queues enqueued
+        cmData->cmHalState->renderHal->currentTrackerIndex = m_trackerIndex;
+
         CmNotifierGroup *notifiers = m_device->GetNotifiers();
         if (notifiers != nullptr)
         {
@@ -3428,6 +3454,204 @@ finish:
     return hr;
 }
 
+//*-----------------------------------------------------------------------------
+//| Purpose:    Hand an enqueued task over for flushing. In synchronous mode the
+//|             task is flushed on the calling thread, in asynchronous mode it
+//|             is pushed to the task ring and flushed by the flush thread.
+//| Returns:    Result of the operation.
+//*-----------------------------------------------------------------------------
+int32_t CmQueueRT::PushEnqueuedTask(CmTaskInternal *task)
+{
+    if (!m_asyncFlush)
+    {
+        if (!m_enqueuedTasks.Push(task))
+        {
+            CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.");
+            return CM_FAILURE;
+        }
+        return FlushTaskWithoutSync();
+    }
+
+    if (!m_taskRing.Push(task))
+    {
+        // Ring is full, wait until the flush thread drains it
+        CLock locker(m_criticalSectionFlushProgress);
+        while (!m_taskRing.Push(task))
+        {
+            WakeFlushThread();
+            if (!m_flushProgress.Wait(m_criticalSectionFlushProgress, CM_MAX_TIMEOUT_MS) &&
+                !m_taskRing.Push(task))
+            {
+                CM_ASSERTMESSAGE("Error: Timeout waiting for the flush thread.");
+                return CM_EXCEED_MAX_TIMEOUT;
+            }
+        }
+    }
+
+    WakeFlushThread();
+    return CM_SUCCESS;
+}
+
+//*-----------------------------------------------------------------------------
+//| Purpose:    Block until the event's task leaves the enqueued state
+//| Returns:    Result of the operation.
+//*-----------------------------------------------------------------------------
+int32_t CmQueueRT::WaitForTaskFlushed(CmEventRT *event, uint32_t timeOutMs)
+{
+    CM_CHK_NULL_RETURN_CMERROR(event);
+
+    CLock locker(m_criticalSectionFlushProgress);
+    while (event->GetStatusWithoutFlush() == CM_STATUS_QUEUED)
+    {
+        WakeFlushThread();
+        if (!m_flushProgress.Wait(m_criticalSectionFlushProgress, timeOutMs) &&
+            event->GetStatusWithoutFlush() == CM_STATUS_QUEUED)
+        {
+            return CM_EXCEED_MAX_TIMEOUT;
+        }
+    }
+
+    return CM_SUCCESS;
+}
+
+//*-----------------------------------------------------------------------------
+//| Purpose:    Sleep on the batch buffer fence of the oldest flushed task
+//|             instead of polling the task status. Must be called without
+//|             m_criticalSectionHalExecute held.
+//| Returns:    None.
+//*-----------------------------------------------------------------------------
+void CmQueueRT::WaitForOldestFlushedTask()
+{
+    CmEventRT *event = nullptr;
+
+    // Same lock order as QueryFlushedTasks() -> DestroyEvent()
+    m_criticalSectionFlushedTask.Acquire();
+    m_criticalSectionEvent.Acquire();
+    CmTaskInternal *task = (CmTaskInternal *)m_flushedTasks.Top();
+    if (task != nullptr)
+    {
+        task->GetTaskEvent(event);
+        if (event != nullptr)
+        {
+            // Keep the event alive if the task retires meanwhile
+            event->Acquire();
+        }
+    }
+    m_criticalSectionEvent.Release();
+    m_criticalSectionFlushedTask.Release();
+
+    if (event != nullptr)
+    {
+        event->WaitForTaskFence(CM_MAX_TIMEOUT_MS);
+
+        CmEvent *eventBase = event;
+        DestroyEvent(eventBase);
+    }
+}
+
+//*-----------------------------------------------------------------------------
+//| Purpose:    Create the task ring and start the flush thread
+//| Returns:    Result of the operation.
+//*-----------------------------------------------------------------------------
+int32_t CmQueueRT::StartFlushThread()
+{
+    // Room for two full rounds of in-flight tasks before producers block
+    uint32_t capacity = MOS_MAX(64, 2 * m_halMaxValues->maxTasks);
+    if (!m_taskRing.Init(capacity))
+    {
+        CM_ASSERTMESSAGE("Error: Failed to allocate the task ring.");
+        return CM_OUT_OF_HOST_MEMORY;
+    }
+
+    m_flushThreadExit = false;
+    m_flushPending    = false;
+    m_flushSemaphore  = MOS_CreateSemaphore(0, 1);
+    CM_CHK_NULL_RETURN_CMERROR(m_flushSemaphore);
+
+    m_flushThread = MOS_CreateThread((void *)FlushThread, this);
+    if (m_flushThread == 0)
+    {
+        CM_ASSERTMESSAGE("Error: Failed to create the flush thread.");
+        MOS_DestroySemaphore(m_flushSemaphore);
+        m_flushSemaphore = nullptr;
+        return CM_FAILURE;
+    }
+
+    m_asyncFlush = true;
+    return CM_SUCCESS;
+}
+
+//*-----------------------------------------------------------------------------
+//| Purpose:    Stop the flush thread after it flushed all tasks in the ring.
+//|             Later tasks are flushed on the enqueuing thread.
+//| Returns:    None.
+//*-----------------------------------------------------------------------------
+void CmQueueRT::StopFlushThread()
+{
+    if (m_flushThread)
+    {
+        m_flushThreadExit = true;
+        MOS_PostSemaphore(m_flushSemaphore, 1);
+        MOS_WaitThread(m_flushThread);
+        m_flushThread = 0;
+        m_asyncFlush  = false;
+    }
+    if (m_flushSemaphore)
+    {
+        MOS_DestroySemaphore(m_flushSemaphore);
+        m_flushSemaphore = nullptr;
+    }
+}
+
+void CmQueueRT::WakeFlushThread()
+{
+    if (m_flushSemaphore != nullptr && !m_flushPending.exchange(true))
+    {
+        MOS_PostSemaphore(m_flushSemaphore, 1);
+    }
+}
+
+void *CmQueueRT::FlushThread(void *data)
+{
+    CmQueueRT *queue = (CmQueueRT *)data;
+    if (queue == nullptr)
+    {
+        return nullptr;
+    }
+
+    while (MOS_WaitSemaphore(queue->m_flushSemaphore, INFINITE) == MOS_STATUS_SUCCESS)
+    {
+        // Clear before draining so a push racing with the drain posts again
+        queue->m_flushPending = false;
+
+        CmTaskInternal *task = nullptr;
+        while ((task = queue->m_taskRing.Pop()) != nullptr)
+        {
+            if (!queue->m_enqueuedTasks.Push(task))
+            {
+                CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.");
+                CmTaskInternal::Destroy(task);
+            }
+        }
+        queue->m_criticalSectionFlushProgress.Acquire();
+        queue->m_flushProgress.Broadcast();
+        queue->m_criticalSectionFlushProgress.Release();
+
+        queue->FlushEnqueuedTasks(true);
+
+        queue->m_criticalSectionFlushProgress.Acquire();
+        queue->m_flushProgress.Broadcast();
+        queue->m_criticalSectionFlushProgress.Release();
+
+        if (queue->m_flushThreadExit)
+        {
+            break;
+        }
+    }
+
+    return nullptr;
+}
+
 //*-----------------------------------------------------------------------------
 //| Purpose:    Enqueue a Vebox Task
 //| Arguments :
@@ -3471,14 +3695,7 @@ CM_RT_API int32_t CmQueueRT::EnqueueVebox(CmVebox * vebox, CmEvent* & event)
     }
     event = eventRT;
 
-    if (!m_enqueuedTasks.Push(task))
-    {
-        CM_ASSERTMESSAGE("Error: Push enqueued tasks failure.")
-        hr = CM_FAILURE;
-        goto finish;
-    }
-
-    CM_CHK_CMSTATUS_GOTOFINISH(FlushTaskWithoutSync());
+    CM_CHK_CMSTATUS_GOTOFINISH(PushEnqueuedTask(task));
 
 finish:
     if (hr != CM_SUCCESS)
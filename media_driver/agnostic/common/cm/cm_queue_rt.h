@@ -29,12 +29,14 @@
 
 #include "cm_queue.h"
 
+#include <atomic>
 #include <queue>
 
 #include "cm_array.h"
 #include "cm_csync.h"
 #include "cm_hal.h"
 #include "cm_log.h"
+#include "cm_task_ring.h"
 
 namespace CMRT_UMD
 {
@@ -224,6 +226,15 @@ public:
 
     int32_t FlushTaskWithoutSync(bool flushBlocked = false);
 
+    //!
+    //! \brief    Block until the event's task is flushed by the flush thread.
+    //! \details  Only used in asynchronous flush mode.
+    //! \return   CM_SUCCESS, or CM_EXCEED_MAX_TIMEOUT on timeout.
+    //!
+    int32_t WaitForTaskFlushed(CmEventRT *event, uint32_t timeOutMs);
+
+    bool IsAsyncFlush() { return m_asyncFlush; }
+
     int32_t GetTaskCount(uint32_t &numTasks);
 
     int32_t TouchFlushedTasks();
@@ -290,6 +301,20 @@ protected:
 
     int32_t QueryFlushedTasks();
 
+    int32_t FlushEnqueuedTasks(bool flushBlocked);
+
+    int32_t PushEnqueuedTask(CmTaskInternal *task);
+
+    int32_t StartFlushThread();
+
+    void StopFlushThread();
+
+    void WakeFlushThread();
+
+    void WaitForOldestFlushedTask();
+
+    static void *FlushThread(void *data);
+
     //New sub functions for different task flush
     int32_t FlushGeneralTask(CmTaskInternal *task);
 
@@ -364,6 +389,16 @@ protected:
     uint32_t m_trackerIndex;
     uint32_t m_fastTrackerIndex;
 
+    // Asynchronous flush mode, see CM_QUEUE_CREATE_OPTION::AsyncFlush
+    bool m_asyncFlush;
+    CmTaskRing m_taskRing;                 // Enqueued tasks not yet taken by the flush thread
+    MOS_THREADHANDLE m_flushThread;
+    PMOS_SEMAPHORE m_flushSemaphore;       // Wakes up the flush thread
+    std::atomic<bool> m_flushPending;      // Flush thread wake up already posted
+    std::atomic<bool> m_flushThreadExit;   // Flush thread should exit
+    CSync m_criticalSectionFlushProgress;  // Protects waits on m_flushProgress
+    CCondition m_flushProgress;            // Broadcast when the ring is drained or tasks are flushed
+
 private:
     static const uint32_t INVALID_SYNC_BUFFER_HANDLE = 0xDEADBEEF;
 
@@ -0,0 +1,168 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file      cm_task_ring.h
+//! \brief     Contains CmTaskRing definitions.
+//!
+
+#ifndef MEDIADRIVER_AGNOSTIC_COMMON_CM_CMTASKRING_H_
+#define MEDIADRIVER_AGNOSTIC_COMMON_CM_CMTASKRING_H_
+
+#include <atomic>
+#include <new>
+#include <stdint.h>
+
+namespace CMRT_UMD
+{
+class CmTaskInternal;
+
+//!
+//! \brief    Bounded multi-producer single-consumer ring of tasks.
+//! \details  Used by queues in asynchronous flush mode: application threads push
+//!           tasks, the queue's flush thread pops them. Every cell carries a
+//!           sequence number, so producers claim a cell with one compare-exchange
+//!           and the consumer never takes a lock.
+//!
+class CmTaskRing
+{
+public:
+    CmTaskRing(): m_cells(nullptr), m_mask(0), m_head(0), m_tail(0) {}
+
+    ~CmTaskRing() { delete[] m_cells; }
+
+    //!
+    //! \brief    Allocate the ring.
+    //! \param    [in] capacity
+    //!           Number of cells, rounded up to a power of 2.
+    //! \return   true if success.
+    //!
+    bool Init(uint32_t capacity)
+    {
+        uint64_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        m_cells = new (std::nothrow) Cell[size];
+        if (m_cells == nullptr)
+        {
+            return false;
+        }
+        for (uint64_t i = 0; i < size; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            m_cells[i].task = nullptr;
+        }
+        m_mask = size - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    //!
+    //! \brief    Push a task, safe from any number of threads.
+    //! \return   false if the ring is full.
+    //!
+    bool Push(CmTaskInternal *task)
+    {
+        uint64_t pos = m_head.load(std::memory_order_relaxed);
+        Cell    *cell;
+
+        for (;;)
+        {
+            cell = &m_cells[pos & m_mask];
+            int64_t diff = (int64_t)cell->sequence.load(std::memory_order_acquire) - (int64_t)pos;
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->task = task;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //!
+    //! \brief    Pop the oldest task, only from the consumer thread.
+    //! \return   nullptr if the ring is empty.
+    //!
+    CmTaskInternal *Pop()
+    {
+        uint64_t pos  = m_tail.load(std::memory_order_relaxed);
+        Cell    *cell = &m_cells[pos & m_mask];
+
+        if (cell->sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            return nullptr;
+        }
+
+        CmTaskInternal *task = cell->task;
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_tail.store(pos + 1, std::memory_order_release);
+        return task;
+    }
+
+    //!
+    //! \brief    Number of tasks in the ring, exact only when no push is in progress.
+    //!
+    uint32_t GetCount()
+    {
+        // Read the tail first so the difference can never go negative
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        return (uint32_t)(m_head.load(std::memory_order_acquire) - tail);
+    }
+
+    bool IsEmpty() { return GetCount() == 0; }
+
+    uint32_t GetCapacity() { return (uint32_t)(m_mask + 1); }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        CmTaskInternal        *task;
+    };
+
+    Cell                  *m_cells;
+    uint64_t              m_mask;
+    std::atomic<uint64_t> m_head;   // Next cell to claim (producers)
+    std::atomic<uint64_t> m_tail;   // Next cell to read (consumer)
+
+    CmTaskRing(const CmTaskRing &other);
+    CmTaskRing &operator=(const CmTaskRing &other);
+};
+};  //namespace
+
+#endif  // #ifndef MEDIADRIVER_AGNOSTIC_COMMON_CM_CMTASKRING_H_
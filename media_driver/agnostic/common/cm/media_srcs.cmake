@@ -109,6 +109,7 @@ set(TMP_HEADERS_
     ${CMAKE_CURRENT_LIST_DIR}/cm_task.h
     ${CMAKE_CURRENT_LIST_DIR}/cm_task_rt.h
     ${CMAKE_CURRENT_LIST_DIR}/cm_task_internal.h
+    ${CMAKE_CURRENT_LIST_DIR}/cm_task_ring.h
     ${CMAKE_CURRENT_LIST_DIR}/cm_thread_space.h
     ${CMAKE_CURRENT_LIST_DIR}/cm_thread_space_rt.h
     ${CMAKE_CURRENT_LIST_DIR}/cm_vebox.h
@@ -27,7 +27,11 @@
 #include "codechal_debug.h"
 #if USE_CODECHAL_DEBUG_TOOL
 #include "codechal_debug_config_manager.h"
+#include "codechal_debug_dump_writer.h"
 #include "codechal_hw.h"
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+#include "media_interfaces_mhw.h"
+#endif
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -44,6 +48,16 @@ CodechalDebugInterface::CodechalDebugInterface()
 }
 CodechalDebugInterface::~CodechalDebugInterface()
 {
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+    // Hands the pending snapshots to the writer before it drains
+    DestroySnapshotInterface();
+#endif
+
+    if (nullptr != m_dumpWriter)
+    {
+        MOS_Delete(m_dumpWriter);
+    }
+
     if (nullptr != m_configMgr)
     {
         MOS_Delete(m_configMgr);
@@ -138,6 +152,30 @@ MOS_STATUS CodechalDebugInterface::Initialize(
     CODECHAL_DEBUG_CHK_NULL(m_configMgr);
     CODECHAL_DEBUG_CHK_STATUS(m_configMgr->ParseConfig(m_osInterface->pOsContext));
 
+    m_dumpWriter = MOS_New(CodechalDebugDumpWriter);
+    CODECHAL_DEBUG_CHK_NULL(m_dumpWriter);
+    m_dumpWriter->SetCompression(m_configMgr->AttrIsEnabled(CodechalDbgAttr::attrCompressDumps));
+
+    // AsyncDump:1 snapshots dumps with CPU copies, AsyncDump:2 with GPU copies where possible
+    int32_t asyncDump = m_configMgr->AttrValue(CodechalDbgAttr::attrAsyncDump);
+    if (asyncDump > 0)
+    {
+        int32_t  queueDepth = m_configMgr->AttrValue(CodechalDbgAttr::attrAsyncDumpQueueDepth);
+        uint32_t depth      = queueDepth > 0 ? queueDepth : CODECHAL_DEBUG_DUMP_QUEUE_DEPTH;
+        if (m_dumpWriter->Start(depth) == MOS_STATUS_SUCCESS && asyncDump >= 2)
+        {
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+            m_gpuSnapshot = CreateSnapshotInterface(depth) == MOS_STATUS_SUCCESS;
+            if (!m_gpuSnapshot)
+            {
+                CODECHAL_DEBUG_NORMALMESSAGE("No GPU snapshot interface, AsyncDump:2 falls back to CPU snapshots");
+            }
+#else
+            CODECHAL_DEBUG_NORMALMESSAGE("GPU snapshots are not built in, AsyncDump:2 falls back to CPU snapshots");
+#endif
+        }
+    }
+
     // Create thread specified sub folder as dump folder.
     if (m_configMgr->AttrIsEnabled(CodechalDbgAttr::attrDumpToThreadFolder))
     {
@@ -515,12 +553,32 @@ MOS_STATUS CodechalDebugInterface::DumpYUVSurface(
         return MOS_STATUS_SUCCESS;
     }
 
+    CODECHAL_DEBUG_CHK_NULL(m_dumpWriter);
+
+    bool async = m_dumpWriter->IsAsync();
+
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+    // Snapshot with the GPU and leave the deswizzle to the writer thread
+    if (async && m_gpuSnapshot && !DumpIsEnabled(CodechalDbgAttr::attrDisableSwizzleForDumps))
+    {
+        CodechalDbgDumpJob *job = CreateYuvDumpJob(surface, surfName, width_in, height_in);
+        CODECHAL_DEBUG_CHK_NULL(job);
+
+        if (SnapshotResource(job, &surface->OsResource, 0) == MOS_STATUS_SUCCESS)
+        {
+            return MOS_STATUS_SUCCESS;
+        }
+        MOS_Delete(job);
+    }
+#endif
+
     MOS_LOCK_PARAMS lockFlags;
     MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
     lockFlags.ReadOnly = 1;
     lockFlags.TiledAsTiled = 1; // Bypass GMM CPU blit due to some issues in GMM CpuBlt function
 
-    uint8_t* lockedAddr = (uint8_t*)m_osInterface->pfnLockResource(m_osInterface, &surface->OsResource, &lockFlags);
+    PMOS_RESOURCE lockedResource = &surface->OsResource;
+    uint8_t* lockedAddr = (uint8_t*)m_osInterface->pfnLockResource(m_osInterface, lockedResource, &lockFlags);
     if (lockedAddr == nullptr) // Failed to lock. Try to submit copy task and dump another surface
     {
         uint32_t        sizeToBeCopied = 0;
@@ -573,7 +631,8 @@ MOS_STATUS CodechalDebugInterface::DumpYUVSurface(
             m_osInterface->pfnFreeResource(m_osInterface, &m_temp2DSurfForCopy.OsResource);
             return MOS_STATUS_NULL_POINTER;
         }
-        lockedAddr = (uint8_t*)m_osInterface->pfnLockResource(m_osInterface, &m_temp2DSurfForCopy.OsResource, &lockFlags);
+        lockedResource = &m_temp2DSurfForCopy.OsResource;
+        lockedAddr = (uint8_t*)m_osInterface->pfnLockResource(m_osInterface, lockedResource, &lockFlags);
         CODECHAL_DEBUG_CHK_NULL(lockedAddr);
 
         if (DumpIsEnabled(CodechalDbgAttr::attrDisableSwizzleForDumps))
@@ -602,26 +661,53 @@ MOS_STATUS CodechalDebugInterface::DumpYUVSurface(
         }
     }
 
-    uint8_t* surfBaseAddr = (uint8_t*)MOS_AllocMemory(sizeMain);
-    CODECHAL_DEBUG_CHK_NULL(surfBaseAddr);
+    CodechalDbgDumpJob *job = CreateYuvDumpJob(surface, surfName, width_in, height_in);
+    if (job == nullptr)
+    {
+        m_osInterface->pfnUnlockResource(m_osInterface, lockedResource);
+        return MOS_STATUS_NULL_POINTER;
+    }
 
-    if (DumpIsEnabled(CodechalDbgAttr::attrForceYUVDumpWithMemcpy))
+    if (async || DumpIsEnabled(CodechalDbgAttr::attrForceYUVDumpWithMemcpy))
     {
-        MOS_SecureMemcpy(surfBaseAddr, sizeMain, lockedAddr, sizeMain); // Firstly, copy to surfBaseAddr to faster unlock resource
-        m_osInterface->pfnUnlockResource(m_osInterface, &surface->OsResource);
-        lockedAddr = surfBaseAddr;
-        surfBaseAddr = (uint8_t*)MOS_AllocMemory(sizeMain);
-        CODECHAL_DEBUG_CHK_NULL(surfBaseAddr);
+        // Copy out first so the resource is unlocked before the deswizzle
+        job->data = (uint8_t*)MOS_AllocMemory(sizeMain);
+        if (job->data != nullptr)
+        {
+            MOS_SecureMemcpy(job->data, sizeMain, lockedAddr, sizeMain);
+            job->ownData = true;
+        }
+        m_osInterface->pfnUnlockResource(m_osInterface, lockedResource);
+
+        if (job->data == nullptr)
+        {
+            MOS_Delete(job);
+            return MOS_STATUS_NULL_POINTER;
+        }
+        return m_dumpWriter->Submit(job);
     }
 
-    // Always use MOS swizzle instead of GMM Cpu blit
-    CODECHAL_DEBUG_CHK_NULL(surfBaseAddr);
-    Mos_SwizzleData(lockedAddr, surfBaseAddr, surface->TileType, MOS_TILE_LINEAR, sizeMain / surface->dwPitch, surface->dwPitch, 0);
+    job->data = lockedAddr;
+    MOS_STATUS status = m_dumpWriter->Submit(job);
+    m_osInterface->pfnUnlockResource(m_osInterface, lockedResource);
+
+    return status;
+}
 
-    uint8_t* data = surfBaseAddr;
-    data += surface->dwOffset + surface->YPlaneOffset.iYOffset * surface->dwPitch;
+CodechalDbgDumpJob *CodechalDebugInterface::CreateYuvDumpJob(
+    PMOS_SURFACE surface,
+    const char * surfName,
+    uint32_t     width_in,
+    uint32_t     height_in)
+{
+    CodechalDbgDumpJob *job = MOS_New(CodechalDbgDumpJob);
+    if (job == nullptr)
+    {
+        return nullptr;
+    }
 
-    uint32_t width = width_in ? width_in : surface->dwWidth;
+    uint32_t offset = surface->dwOffset + surface->YPlaneOffset.iYOffset * surface->dwPitch;
+    uint32_t width  = width_in ? width_in : surface->dwWidth;
     uint32_t height = height_in ? height_in : surface->dwHeight;
 
     switch (surface->Format)
@@ -650,7 +736,7 @@ MOS_STATUS CodechalDebugInterface::DumpYUVSurface(
 
     if (CodecHal_PictureIsBottomField(m_currPic))
     {
-        data += pitch;
+        offset += pitch;
     }
 
     if (CodecHal_PictureIsField(m_currPic))
@@ -661,105 +747,17 @@ MOS_STATUS CodechalDebugInterface::DumpYUVSurface(
 
     const char* funcName = (m_codecFunction == CODECHAL_FUNCTION_DECODE) ? "_DEC" : (m_codecFunction == CODECHAL_FUNCTION_CENC_DECODE ? "_DEC" : "_ENC");
     std::string bufName = std::string(surfName) + "_w[" + std::to_string(surface->dwWidth) + "]_h[" + std::to_string(surface->dwHeight) + "]_p[" + std::to_string(pitch) + "]";
-    const char* filePath = CreateFileName(funcName, bufName.c_str(), CodechalDbgExtType::yuv);
 
-    std::ofstream ofs(filePath, std::ios_base::out | std::ios_base::binary);
-    if (ofs.fail())
-    {
-        return MOS_STATUS_UNKNOWN;
-    }
-
-    // write luma data to file
-    for (uint32_t h = 0; h < height; h++)
-    {
-        ofs.write((char*)data, width);
-        data += pitch;
-    }
-
-    if (surface->Format != Format_A8B8G8R8)
-    {
-        switch (surface->Format)
-        {
-        case Format_NV12:
-        case Format_P010:
-        case Format_P016:
-            height >>= 1;
-            break;
-        case  Format_Y416:
-        case  Format_AUYV:
-        case  Format_R10G10B10A2:
-            height *= 2;
-            break;
-        case  Format_YUY2:
-        case  Format_YUYV:
-        case  Format_YUY2V:
-        case  Format_Y216V:
-        case  Format_YVYU:
-        case  Format_UYVY:
-        case  Format_VYUY:
-        case  Format_Y216: //422 16bit
-        case  Format_Y210: //422 10bit
-        case  Format_P208: //422 8bit
-            break;
-        case Format_422V:
-        case Format_IMC3:
-            height = height / 2;
-            break;
-        case  Format_AYUV:
-        default:
-            height = 0;
-            break;
-        }
-
-        uint8_t* vPlaneData = surfBaseAddr;
-#ifdef LINUX
-        data = surfBaseAddr + surface->UPlaneOffset.iSurfaceOffset;
-        if (surface->Format == Format_422V
-            || surface->Format == Format_IMC3)
-        {
-            vPlaneData = surfBaseAddr + surface->VPlaneOffset.iSurfaceOffset;
-    }
-#else
-        data = surfBaseAddr + surface->UPlaneOffset.iLockSurfaceOffset;
-        if (surface->Format == Format_422V
-            || surface->Format == Format_IMC3)
-        {
-            vPlaneData = surfBaseAddr + surface->VPlaneOffset.iLockSurfaceOffset;
-        }
-
-#endif
-
-        // write chroma data to file
-        for (uint32_t h = 0; h < height; h++)
-        {
-            ofs.write((char*)data, width);
-            data += pitch;
-        }
-
-        // write v planar data to file
-        if (surface->Format == Format_422V
-            || surface->Format == Format_IMC3)
-        {
-            for (uint32_t h = 0; h < height; h++)
-            {
-                ofs.write((char*)vPlaneData, width);
-                vPlaneData += pitch;
-            }
-        }
-    }
-    ofs.close();
-
-    if (DumpIsEnabled(CodechalDbgAttr::attrForceYUVDumpWithMemcpy))
-    {
-        MOS_FreeMemory(lockedAddr);
-    }
-    else
-    {
-        m_osInterface->pfnUnlockResource(m_osInterface, &surface->OsResource);
-    }
-    MOS_FreeMemory(surfBaseAddr);
+    job->filePath = CreateFileName(funcName, bufName.c_str(), CodechalDbgExtType::yuv);
+    job->format   = dumpYuv;
+    job->size     = (uint32_t)surface->OsResource.pGmmResInfo->GetSizeMainSurface();
+    job->width    = width;
+    job->height   = height;
+    job->pitch    = pitch;
+    job->offset   = offset;
+    job->surface  = *surface;
 
-    return MOS_STATUS_SUCCESS;
+    return job;
 }
 
 MOS_STATUS CodechalDebugInterface::DumpBuffer(
@@ -799,13 +797,6 @@ MOS_STATUS CodechalDebugInterface::DumpBuffer(
         }
     }
 
-    MOS_LOCK_PARAMS lockFlags;
-    MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
-    lockFlags.ReadOnly = 1;
-    uint8_t *data      = (uint8_t *)m_osInterface->pfnLockResource(m_osInterface, resource, &lockFlags);
-    CODECHAL_DEBUG_CHK_NULL(data);
-    data += offset;
-
     const char *fileName;
     bool binaryDump = m_configMgr->AttrIsEnabled(CodechalDbgAttr::attrDumpBufferInBinary);
     const char* extType = binaryDump ? CodechalDbgExtType::dat : CodechalDbgExtType::txt;
@@ -820,22 +811,13 @@ MOS_STATUS CodechalDebugInterface::DumpBuffer(
         fileName           = CreateFileName(kernelName.c_str(), bufferName, extType);
     }
 
-    MOS_STATUS status;
-    if (binaryDump)
-    {
-        status = DumpBufferInBinary(data, size);
-    }
-    else
-    {
-        status = DumpBufferInHexDwords(data, size);
-    }
+    CodechalDbgDumpJob *job = MOS_New(CodechalDbgDumpJob);
+    CODECHAL_DEBUG_CHK_NULL(job);
+    job->filePath = fileName;
+    job->format   = binaryDump ? dumpBinary : dumpHexDwords;
+    job->size     = size;
 
-    if (data)
-    {
-        m_osInterface->pfnUnlockResource(m_osInterface, resource);
-    }
-
-    return status;
+    return SubmitResourceDump(job, resource, offset, true);
 }
 
 #define FIELD_TO_OFS(type, name)   ofs << #name << ": " << (int64_t)*((type*)report) << std::endl; report += sizeof(type) / sizeof(uint8_t);
@@ -942,12 +924,6 @@ MOS_STATUS CodechalDebugInterface::DumpSurface(
     bool binaryDump = m_configMgr->AttrIsEnabled(CodechalDbgAttr::attrDumpBufferInBinary);
     const char* extType = binaryDump ? CodechalDbgExtType::dat : CodechalDbgExtType::txt;
 
-    MOS_LOCK_PARAMS lockFlags;
-    MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
-    lockFlags.ReadOnly = 1;
-    uint8_t *data      = (uint8_t *)m_osInterface->pfnLockResource(m_osInterface, &surface->OsResource, &lockFlags);
-    CODECHAL_DEBUG_CHK_NULL(data);
-    
     std::string bufName  = std::string(surfaceName) + "_w[" + std::to_string(surface->dwWidth) + "]_h[" + std::to_string(surface->dwHeight) + "]_p[" + std::to_string(surface->dwPitch) + "]";
     const char *fileName;
     if (mediaState == CODECHAL_NUM_MEDIA_STATES)
@@ -960,22 +936,17 @@ MOS_STATUS CodechalDebugInterface::DumpSurface(
         fileName               = CreateFileName(kernelName.c_str(), bufName.c_str(), extType);
     }
 
-    MOS_STATUS status;
-    if (binaryDump)
-    {
-        status = Dump2DBufferInBinary(data, surface->dwWidth, surface->dwHeight, surface->dwPitch);
-    }
-    else
-    {
-        status = DumpBufferInHexDwords(data, surface->dwHeight*surface->dwPitch);
-    }
-
-    if (data)
-    {
-        m_osInterface->pfnUnlockResource(m_osInterface, &surface->OsResource);
-    }
+    CodechalDbgDumpJob *job = MOS_New(CodechalDbgDumpJob);
+    CODECHAL_DEBUG_CHK_NULL(job);
+    job->filePath = fileName;
+    job->format   = binaryDump ? dump2DBinary : dumpHexDwords;
+    job->size     = surface->dwHeight * surface->dwPitch;
+    job->width    = surface->dwWidth;
+    job->height   = surface->dwHeight;
+    job->pitch    = surface->dwPitch;
 
-    return status;
+    // The rows are only where the CPU expects them in a linear surface
+    return SubmitResourceDump(job, &surface->OsResource, 0, surface->TileType == MOS_TILE_LINEAR);
 }
 
 MOS_STATUS CodechalDebugInterface::DumpData(
@@ -995,19 +966,34 @@ MOS_STATUS CodechalDebugInterface::DumpData(
         return MOS_STATUS_SUCCESS;
     }
 
+    CODECHAL_DEBUG_CHK_NULL(m_dumpWriter);
+
     bool binaryDump = m_configMgr->AttrIsEnabled(CodechalDbgAttr::attrDumpBufferInBinary);
     const char *fileName = CreateFileName(bufferName, nullptr,
                                           binaryDump ? CodechalDbgExtType::dat : CodechalDbgExtType::txt);
 
-    if (binaryDump)
-    {
-        DumpBufferInBinary((uint8_t *)data, size);
-    }
-    else
+    CodechalDbgDumpJob *job = MOS_New(CodechalDbgDumpJob);
+    CODECHAL_DEBUG_CHK_NULL(job);
+    job->filePath = fileName;
+    job->format   = binaryDump ? dumpBinary : dumpHexDwords;
+    job->size     = size;
+    job->data     = (uint8_t *)data;
+
+    // The caller may reuse data as soon as this returns
+    if (m_dumpWriter->IsAsync() && size > 0)
     {
-        DumpBufferInHexDwords((uint8_t *)data, size);
+        job->data = (uint8_t *)MOS_AllocMemory(size);
+        if (job->data == nullptr)
+        {
+            MOS_Delete(job);
+            return MOS_STATUS_NULL_POINTER;
+        }
+        MOS_SecureMemcpy(job->data, size, data, size);
+        job->ownData = true;
     }
 
+    m_dumpWriter->Submit(job);
+
     return MOS_STATUS_SUCCESS;
 }
 
@@ -1276,23 +1262,7 @@ MOS_STATUS CodechalDebugInterface::CopySurfaceData_Vdbox(
     MOS_NULL_RENDERING_FLAGS                NullRenderingFlags;
     MOS_GPU_CONTEXT                         orgGpuContext;
 
-    if (!m_vdboxContextCreated)
-    {
-        MOS_GPUCTX_CREATOPTIONS createOption;
-
-        CODECHAL_DEBUG_CHK_STATUS(m_osInterface->pfnCreateGpuContext(
-            m_osInterface,
-            MOS_GPU_CONTEXT_VIDEO,
-            MOS_GPU_NODE_VIDEO,
-            &createOption));
-
-        // Register VDbox GPU context with the Batch Buffer completion event
-        CODECHAL_DEBUG_CHK_STATUS(m_osInterface->pfnRegisterBBCompleteNotifyEvent(
-            m_osInterface,
-            MOS_GPU_CONTEXT_VIDEO));
-
-        m_vdboxContextCreated = true;
-    }
+    CODECHAL_DEBUG_CHK_STATUS(CreateVdboxContext());
 
     CODECHAL_DEBUG_CHK_NULL(m_cpInterface);
     CODECHAL_DEBUG_CHK_NULL(m_osInterface);
@@ -1364,6 +1334,409 @@ MOS_STATUS CodechalDebugInterface::CopySurfaceData_Vdbox(
     return MOS_STATUS_SUCCESS;
 }
 
+MOS_STATUS CodechalDebugInterface::CreateVdboxContext()
+{
+    if (!m_vdboxContextCreated)
+    {
+        MOS_GPUCTX_CREATOPTIONS createOption;
+
+        CODECHAL_DEBUG_CHK_STATUS(m_osInterface->pfnCreateGpuContext(
+            m_osInterface,
+            MOS_GPU_CONTEXT_VIDEO,
+            MOS_GPU_NODE_VIDEO,
+            &createOption));
+
+        // Register VDbox GPU context with the Batch Buffer completion event
+        CODECHAL_DEBUG_CHK_STATUS(m_osInterface->pfnRegisterBBCompleteNotifyEvent(
+            m_osInterface,
+            MOS_GPU_CONTEXT_VIDEO));
+
+        m_vdboxContextCreated = true;
+    }
+
+    return MOS_STATUS_SUCCESS;
+}
+
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+MOS_STATUS CodechalDebugInterface::CreateSnapshotInterface(uint32_t depth)
+{
+    CODECHAL_DEBUG_CHK_NULL(m_osInterface);
+
+    m_snapshotOsInterface = (PMOS_INTERFACE)MOS_AllocAndZeroMemory(sizeof(MOS_INTERFACE));
+    CODECHAL_DEBUG_CHK_NULL(m_snapshotOsInterface);
+
+    // Shares the buffer manager with the codec, but not its OS states or GPU contexts
+    MOS_STATUS eStatus = Mos_InitInterface(m_snapshotOsInterface, m_osInterface->pOsContext, m_osInterface->Component);
+    if (eStatus != MOS_STATUS_SUCCESS)
+    {
+        MOS_FreeMemory(m_snapshotOsInterface);
+        m_snapshotOsInterface = nullptr;
+        return eStatus;
+    }
+
+    // The HuC dummy stream outs need buffers of the codec HW interface
+    MEDIA_FEATURE_TABLE *skuTable = m_snapshotOsInterface->pfnGetSkuTable(m_snapshotOsInterface);
+    MEDIA_WA_TABLE      *waTable  = m_snapshotOsInterface->pfnGetWaTable(m_snapshotOsInterface);
+    if (skuTable == nullptr || waTable == nullptr ||
+        (MEDIA_IS_SKU(skuTable, FtrEnableMediaKernels) &&
+            (MEDIA_IS_WA(waTable, WaHucStreamoutEnable) || MEDIA_IS_WA(waTable, WaHucStreamoutOnlyDisable))))
+    {
+        DestroySnapshotInterface();
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    MhwInterfaces::CreateParams params;
+    params.Flags.m_vdboxAll = true;
+    params.m_isDecode       = CodecHalIsDecode(m_codecFunction);
+    m_snapshotMhw           = MhwInterfaces::CreateFactory(params, m_snapshotOsInterface);
+    if (m_snapshotMhw == nullptr || m_snapshotMhw->m_miInterface == nullptr || m_snapshotMhw->m_hucInterface == nullptr)
+    {
+        DestroySnapshotInterface();
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    MOS_GPUCTX_CREATOPTIONS createOption;
+    eStatus = m_snapshotOsInterface->pfnCreateGpuContext(
+        m_snapshotOsInterface,
+        MOS_GPU_CONTEXT_VIDEO,
+        MOS_GPU_NODE_VIDEO,
+        &createOption);
+    if (eStatus == MOS_STATUS_SUCCESS)
+    {
+        eStatus = m_snapshotOsInterface->pfnSetGpuContext(m_snapshotOsInterface, MOS_GPU_CONTEXT_VIDEO);
+    }
+    if (eStatus != MOS_STATUS_SUCCESS)
+    {
+        DestroySnapshotInterface();
+        return eStatus;
+    }
+
+    m_snapshotDepth = depth;
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void CodechalDebugInterface::DestroySnapshotInterface()
+{
+    while (!m_snapshotPending.empty())
+    {
+        RetireSnapshot();
+    }
+
+    if (m_snapshotOsInterface == nullptr)
+    {
+        return;
+    }
+
+    for (auto &snapshot : m_snapshotFree)
+    {
+        m_snapshotOsInterface->pfnFreeResource(m_snapshotOsInterface, &snapshot.staging);
+    }
+    m_snapshotFree.clear();
+
+    if (m_snapshotMhw != nullptr)
+    {
+        m_snapshotMhw->Destroy();
+        MOS_Delete(m_snapshotMhw);
+    }
+
+    m_snapshotOsInterface->pfnDestroy(m_snapshotOsInterface, false);
+    MOS_FreeMemory(m_snapshotOsInterface);
+    m_snapshotOsInterface = nullptr;
+}
+
+MOS_STATUS CodechalDebugInterface::CopyResourceData_Vdbox(
+    PMOS_RESOURCE presSource,
+    uint32_t      srcOffset,
+    uint32_t      size,
+    PMOS_RESOURCE presDest)
+{
+    CODECHAL_DEBUG_CHK_NULL(presSource);
+    CODECHAL_DEBUG_CHK_NULL(presDest);
+    CODECHAL_DEBUG_CHK_NULL(m_snapshotOsInterface);
+
+    // The stream out reads the raw surface, compressed ones are copied by the CPU
+    if (presSource->pGmmResInfo != nullptr)
+    {
+        GMM_RESOURCE_FLAG gmmFlags = presSource->pGmmResInfo->GetResFlags();
+        if (gmmFlags.Gpu.MMC || gmmFlags.Gpu.CCS)
+        {
+            return MOS_STATUS_UNIMPLEMENTED;
+        }
+    }
+
+    PMOS_INTERFACE osInterface = m_snapshotOsInterface;
+
+    MOS_COMMAND_BUFFER cmdBuffer;
+    CODECHAL_DEBUG_CHK_STATUS(osInterface->pfnGetCommandBuffer(osInterface, &cmdBuffer, 0));
+
+    MOS_STATUS eStatus = AddCopyResourceDataCmds(&cmdBuffer, presSource, srcOffset, size, presDest);
+    osInterface->pfnReturnCommandBuffer(osInterface, &cmdBuffer, 0);
+
+    if (eStatus == MOS_STATUS_SUCCESS)
+    {
+        MOS_NULL_RENDERING_FLAGS nullRenderingFlags = osInterface->pfnGetNullHWRenderFlags(osInterface);
+
+        eStatus = osInterface->pfnSubmitCommandBuffer(
+            osInterface,
+            &cmdBuffer,
+            nullRenderingFlags.CtxVideo || nullRenderingFlags.CodecGlobal);
+    }
+
+    return eStatus;
+}
+
+MOS_STATUS CodechalDebugInterface::AddCopyResourceDataCmds(
+    PMOS_COMMAND_BUFFER cmdBuffer,
+    PMOS_RESOURCE       presSource,
+    uint32_t            srcOffset,
+    uint32_t            size,
+    PMOS_RESOURCE       presDest)
+{
+    PMOS_INTERFACE        osInterface   = m_snapshotOsInterface;
+    MhwMiInterface       *miInterface   = m_snapshotMhw->m_miInterface;
+    MhwVdboxHucInterface *hucInterface  = m_snapshotMhw->m_hucInterface;
+
+    osInterface->pfnResetOsStates(osInterface);
+
+    CODECHAL_DEBUG_CHK_STATUS(osInterface->pfnRegisterResource(
+        osInterface,
+        presDest,
+        true,
+        true));
+
+    CODECHAL_DEBUG_CHK_STATUS(osInterface->pfnRegisterResource(
+        osInterface,
+        presSource,
+        false,
+        true));
+
+    MHW_GENERIC_PROLOG_PARAMS genericPrologParams;
+    MOS_ZeroMemory(&genericPrologParams, sizeof(genericPrologParams));
+    genericPrologParams.pOsInterface  = osInterface;
+    genericPrologParams.pvMiInterface = miInterface;
+    genericPrologParams.bMmcEnabled   = false;
+    CODECHAL_DEBUG_CHK_STATUS(Mhw_SendGenericPrologCmd(cmdBuffer, &genericPrologParams));
+
+    // Same commands as CodechalHwInterface::PerformHucStreamOut, on the snapshot MHW
+    MHW_VDBOX_PIPE_MODE_SELECT_PARAMS pipeModeSelectParams;
+    pipeModeSelectParams.dwMediaSoftResetCounterValue = 2400;
+    pipeModeSelectParams.bStreamObjectUsed            = true;
+    pipeModeSelectParams.bStreamOutEnabled            = true;
+    if (osInterface->osCpInterface != nullptr && osInterface->osCpInterface->IsCpEnabled())
+    {
+        // Disable protection control setting in huc drm
+        pipeModeSelectParams.disableProtectionSetting = true;
+    }
+
+    uint32_t dataOffset     = MOS_ALIGN_FLOOR(srcOffset, MHW_PAGE_SIZE);
+    uint32_t relativeOffset = srcOffset - dataOffset;
+
+    MHW_VDBOX_IND_OBJ_BASE_ADDR_PARAMS indObjParams;
+    MOS_ZeroMemory(&indObjParams, sizeof(indObjParams));
+    indObjParams.presDataBuffer            = presSource;
+    indObjParams.dwDataSize                = MOS_ALIGN_CEIL(size + srcOffset + relativeOffset, MHW_PAGE_SIZE);
+    indObjParams.dwDataOffset              = dataOffset;
+    indObjParams.presStreamOutObjectBuffer = presDest;
+    indObjParams.dwStreamOutObjectSize     = MOS_ALIGN_CEIL(size, MHW_PAGE_SIZE);
+    indObjParams.dwStreamOutObjectOffset   = 0;
+
+    MHW_VDBOX_HUC_STREAM_OBJ_PARAMS streamObjParams;
+    MOS_ZeroMemory(&streamObjParams, sizeof(streamObjParams));
+    streamObjParams.dwIndStreamInLength           = size;
+    streamObjParams.dwIndStreamInStartAddrOffset  = relativeOffset;
+    streamObjParams.dwIndStreamOutStartAddrOffset = 0;
+    streamObjParams.bHucProcessing                = true;
+    streamObjParams.bStreamInEnable               = true;
+    streamObjParams.bStreamOutEnable              = true;
+
+    CODECHAL_DEBUG_CHK_STATUS(hucInterface->AddHucPipeModeSelectCmd(cmdBuffer, &pipeModeSelectParams));
+    CODECHAL_DEBUG_CHK_STATUS(hucInterface->AddHucIndObjBaseAddrStateCmd(cmdBuffer, &indObjParams));
+    CODECHAL_DEBUG_CHK_STATUS(hucInterface->AddHucStreamObjectCmd(cmdBuffer, &streamObjParams));
+
+    MHW_MI_FLUSH_DW_PARAMS flushDwParams;
+    MOS_ZeroMemory(&flushDwParams, sizeof(flushDwParams));
+    CODECHAL_DEBUG_CHK_STATUS(miInterface->AddMiFlushDwCmd(cmdBuffer, &flushDwParams));
+
+    CODECHAL_DEBUG_CHK_STATUS(miInterface->AddMiBatchBufferEnd(cmdBuffer, nullptr));
+
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS CodechalDebugInterface::SnapshotResource(
+    CodechalDbgDumpJob *job,
+    PMOS_RESOURCE       resource,
+    uint32_t            offset)
+{
+    CODECHAL_DEBUG_CHK_NULL(m_snapshotOsInterface);
+
+    if (job->size == 0)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    if (m_snapshotFree.empty() && m_snapshotPending.size() >= m_snapshotDepth)
+    {
+        CODECHAL_DEBUG_CHK_STATUS(RetireSnapshot());
+    }
+
+    GpuSnapshot snapshot;
+    MOS_ZeroMemory(&snapshot, sizeof(snapshot));
+    uint32_t size = MOS_ALIGN_CEIL(job->size, MHW_PAGE_SIZE);
+
+    // Take the smallest idle buffer that fits, else the last one, which is reallocated
+    auto fit = m_snapshotFree.end();
+    for (auto it = m_snapshotFree.begin(); it != m_snapshotFree.end(); it++)
+    {
+        if (it->size >= size && (fit == m_snapshotFree.end() || it->size < fit->size))
+        {
+            fit = it;
+        }
+    }
+    if (fit == m_snapshotFree.end() && !m_snapshotFree.empty() &&
+        m_snapshotFree.size() + m_snapshotPending.size() >= m_snapshotDepth)
+    {
+        fit = m_snapshotFree.end() - 1;
+    }
+    if (fit != m_snapshotFree.end())
+    {
+        snapshot = *fit;
+        m_snapshotFree.erase(fit);
+    }
+
+    if (snapshot.size < size)
+    {
+        if (!Mos_ResourceIsNull(&snapshot.staging))
+        {
+            m_snapshotOsInterface->pfnFreeResource(m_snapshotOsInterface, &snapshot.staging);
+        }
+        MOS_ZeroMemory(&snapshot, sizeof(snapshot));
+
+        MOS_ALLOC_GFXRES_PARAMS allocParams;
+        MOS_ZeroMemory(&allocParams, sizeof(MOS_ALLOC_GFXRES_PARAMS));
+        allocParams.Type     = MOS_GFXRES_BUFFER;
+        allocParams.TileType = MOS_TILE_LINEAR;
+        allocParams.Format   = Format_Buffer;
+        allocParams.dwBytes  = size;
+        allocParams.pBufName = "DumpStagingBuffer";
+
+        CODECHAL_DEBUG_CHK_STATUS(m_snapshotOsInterface->pfnAllocateResource(m_snapshotOsInterface, &allocParams, &snapshot.staging));
+        snapshot.size = size;
+    }
+
+    // Reads what the codec has submitted so far, unsubmitted commands are not waited for
+    if (CopyResourceData_Vdbox(resource, offset, job->size, &snapshot.staging) != MOS_STATUS_SUCCESS)
+    {
+        m_snapshotFree.push_back(snapshot);
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    snapshot.job = job;
+    m_snapshotPending.push_back(snapshot);
+
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS CodechalDebugInterface::RetireSnapshot()
+{
+    if (m_snapshotPending.empty())
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    GpuSnapshot snapshot = m_snapshotPending.front();
+    m_snapshotPending.pop_front();
+
+    CodechalDbgDumpJob *job = snapshot.job;
+    snapshot.job            = nullptr;
+
+    // Waits for the copy here, the writer thread never locks
+    MOS_LOCK_PARAMS lockFlags;
+    MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
+    lockFlags.ReadOnly = 1;
+    uint8_t *data      = (uint8_t *)m_snapshotOsInterface->pfnLockResource(m_snapshotOsInterface, &snapshot.staging, &lockFlags);
+    if (data != nullptr)
+    {
+        job->data = (uint8_t *)MOS_AllocMemory(job->size);
+        if (job->data != nullptr)
+        {
+            MOS_SecureMemcpy(job->data, job->size, data, job->size);
+            job->ownData = true;
+        }
+        m_snapshotOsInterface->pfnUnlockResource(m_snapshotOsInterface, &snapshot.staging);
+    }
+    m_snapshotFree.push_back(snapshot);
+
+    if (job->data == nullptr)
+    {
+        MOS_Delete(job);
+        return MOS_STATUS_NULL_POINTER;
+    }
+
+    return m_dumpWriter->Submit(job);
+}
+#endif  // CODECHAL_DEBUG_GPU_SNAPSHOT
+
+MOS_STATUS CodechalDebugInterface::SubmitResourceDump(
+    CodechalDbgDumpJob *job,
+    PMOS_RESOURCE       resource,
+    uint32_t            offset,
+    bool                gpuSnapshot)
+{
+    if (m_dumpWriter == nullptr)
+    {
+        MOS_Delete(job);
+        return MOS_STATUS_NULL_POINTER;
+    }
+
+    bool async = m_dumpWriter->IsAsync();
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+    if (async && gpuSnapshot && m_gpuSnapshot &&
+        SnapshotResource(job, resource, offset) == MOS_STATUS_SUCCESS)
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+#endif
+
+    MOS_LOCK_PARAMS lockFlags;
+    MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
+    lockFlags.ReadOnly = 1;
+    uint8_t *data      = (uint8_t *)m_osInterface->pfnLockResource(m_osInterface, resource, &lockFlags);
+    if (data == nullptr)
+    {
+        MOS_Delete(job);
+        return MOS_STATUS_NULL_POINTER;
+    }
+    data += offset;
+
+    MOS_STATUS status = MOS_STATUS_SUCCESS;
+    if (async)
+    {
+        job->data = (uint8_t *)MOS_AllocMemory(job->size);
+        if (job->data != nullptr)
+        {
+            MOS_SecureMemcpy(job->data, job->size, data, job->size);
+            job->ownData = true;
+        }
+        m_osInterface->pfnUnlockResource(m_osInterface, resource);
+
+        if (job->data == nullptr)
+        {
+            MOS_Delete(job);
+            return MOS_STATUS_NULL_POINTER;
+        }
+        status = m_dumpWriter->Submit(job);
+    }
+    else
+    {
+        job->data = data;
+        status    = m_dumpWriter->Submit(job);
+        m_osInterface->pfnUnlockResource(m_osInterface, resource);
+    }
+
+    return status;
+}
+
 MOS_STATUS CodechalDebugInterface::DumpNotSwizzled(
     std::string  surfName,
     MOS_SURFACE& surf,
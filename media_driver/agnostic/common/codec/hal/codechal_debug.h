@@ -38,9 +38,19 @@
 #include "codechal_debug_config_manager.h"
 #include <sstream>
 #include <fstream>
+#include <deque>
+#include <vector>
 
 #define CODECHAL_DEBUG_TOOL(expr)   expr;
 
+//!
+//! \brief   AsyncDump:2 GPU snapshots, off until they have been run on hardware.
+//!          Without them AsyncDump:2 behaves as AsyncDump:1.
+//!
+#ifndef CODECHAL_DEBUG_GPU_SNAPSHOT
+#define CODECHAL_DEBUG_GPU_SNAPSHOT 0
+#endif
+
 //------------------------------------------------------------------------------
 // Macros specific to MOS_CODEC_SUBCOMP_DEBUG sub-comp
 //------------------------------------------------------------------------------
@@ -154,6 +164,9 @@ enum CodechalHucRegionDumpType
 };
 
 struct _CODECHAL_DEBUG_INTERFACE;
+class CodechalDebugDumpWriter;
+class MhwInterfaces;
+struct CodechalDbgDumpJob;
 typedef struct _CODECHAL_DBG_CFG    CODECHAL_DBG_CFG, *PCODECHAL_DBG_CFG;
 
 typedef struct _CODECHAL_ME_OUTPUT_PARAMS
@@ -309,6 +322,72 @@ protected:
         PMOS_RESOURCE   presSourceSurface,
         PMOS_RESOURCE   presCopiedSurface);
 
+    MOS_STATUS CreateVdboxContext();
+
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+    //!
+    //! \brief    Create the OS interface, MHW interfaces and video context the
+    //!           GPU snapshots are submitted on, apart from the codec ones
+    //! \param    [in] depth
+    //!           Number of staging buffers
+    //!
+    MOS_STATUS CreateSnapshotInterface(uint32_t depth);
+
+    void DestroySnapshotInterface();
+
+    //!
+    //! \brief    Copy part of a resource into a linear buffer with a HuC stream out
+    //! \details  Submitted on the snapshot OS interface. Fails for compressed sources.
+    //!
+    MOS_STATUS CopyResourceData_Vdbox(
+        PMOS_RESOURCE   presSource,
+        uint32_t        srcOffset,
+        uint32_t        size,
+        PMOS_RESOURCE   presDest);
+
+    MOS_STATUS AddCopyResourceDataCmds(
+        PMOS_COMMAND_BUFFER cmdBuffer,
+        PMOS_RESOURCE       presSource,
+        uint32_t            srcOffset,
+        uint32_t            size,
+        PMOS_RESOURCE       presDest);
+
+    //!
+    //! \brief    Snapshot job->size bytes of resource into a staging buffer
+    //! \details  The job goes to the writer once RetireSnapshot() has copied
+    //!           the staging buffer out, the oldest one is retired when all
+    //!           staging buffers are in flight.
+    //!
+    MOS_STATUS SnapshotResource(
+        CodechalDbgDumpJob *job,
+        PMOS_RESOURCE       resource,
+        uint32_t            offset);
+
+    //!
+    //! \brief    Copy the oldest snapshot to the CPU and submit its job
+    //! \details  Locks on the calling thread, so the writer only sees CPU memory.
+    //!
+    MOS_STATUS RetireSnapshot();
+#endif
+
+    //!
+    //! \brief    Hand a dump of resource to the writer
+    //! \details  The writer thread gets a GPU snapshot when allowed and
+    //!           possible, else a CPU copy. Written inline from the locked resource
+    //!           without a writer thread.
+    //!
+    MOS_STATUS SubmitResourceDump(
+        CodechalDbgDumpJob *job,
+        PMOS_RESOURCE       resource,
+        uint32_t            offset,
+        bool                gpuSnapshot);
+
+    CodechalDbgDumpJob *CreateYuvDumpJob(
+        PMOS_SURFACE surface,
+        const char * surfName,
+        uint32_t     width_in,
+        uint32_t     height_in);
+
     MOS_STATUS DumpNotSwizzled(
         std::string  surfName,
         MOS_SURFACE& surf,
@@ -325,8 +404,25 @@ protected:
         uint32_t     height,
         uint32_t     pitch);
 
-    CodechalDebugConfigMgr *m_configMgr = nullptr;
-    std::string             m_outputFilePath;
+    CodechalDebugConfigMgr  *m_configMgr   = nullptr;
+    CodechalDebugDumpWriter *m_dumpWriter  = nullptr;
+    bool                     m_gpuSnapshot = false;  //!< Snapshot dumps for the writer thread with GPU copies
+    std::string              m_outputFilePath;
+
+#if CODECHAL_DEBUG_GPU_SNAPSHOT
+    struct GpuSnapshot
+    {
+        CodechalDbgDumpJob *job;
+        MOS_RESOURCE        staging;
+        uint32_t            size;
+    };
+
+    PMOS_INTERFACE           m_snapshotOsInterface = nullptr;  //!< Never the codec one, snapshots do not touch its states
+    MhwInterfaces           *m_snapshotMhw         = nullptr;
+    std::vector<GpuSnapshot> m_snapshotFree;                    //!< Idle staging buffers
+    std::deque<GpuSnapshot>  m_snapshotPending;                 //!< Submitted copies, oldest first
+    uint32_t                 m_snapshotDepth       = 0;
+#endif
 };
 #else
 #define USE_CODECHAL_DEBUG_TOOL     0
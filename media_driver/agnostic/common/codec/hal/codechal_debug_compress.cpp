@@ -0,0 +1,180 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     codechal_debug_compress.cpp
+//! \brief    Compression of debug dump files.
+//! \details  Produces LZ4 frames that the lz4 command line tool can decompress.
+//!
+#include "codechal_debug_compress.h"
+#include <string.h>
+
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5       // the last 5 bytes of a block are always literals
+#define LZ4_MF_LIMIT        12      // the last match starts at least 12 bytes before the end
+#define LZ4_MAX_DISTANCE    65535
+#define LZ4_HASH_LOG        16
+
+static inline uint32_t Lz4Read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Lz4Hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline uint8_t *Lz4WriteLength(uint8_t *op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static inline void Lz4Write32(std::vector<uint8_t> &frame, uint32_t value)
+{
+    frame.push_back((uint8_t)value);
+    frame.push_back((uint8_t)(value >> 8));
+    frame.push_back((uint8_t)(value >> 16));
+    frame.push_back((uint8_t)(value >> 24));
+}
+
+size_t CodechalDebugCompress::Lz4Block(
+    const uint8_t *src,
+    size_t         size,
+    uint8_t *      dst,
+    int32_t *      hashTable)
+{
+    uint8_t *op     = dst;
+    size_t   ip     = 0;
+    size_t   anchor = 0;
+
+    for (uint32_t i = 0; i < (1 << LZ4_HASH_LOG); i++)
+    {
+        hashTable[i] = -1;
+    }
+
+    // Greedy parse; the search step grows over incompressible runs
+    uint32_t misses = 0;
+    while (size >= LZ4_MF_LIMIT && ip <= size - LZ4_MF_LIMIT)
+    {
+        uint32_t sequence = Lz4Read32(src + ip);
+        uint32_t hash     = Lz4Hash(sequence);
+        int32_t  ref      = hashTable[hash];
+        hashTable[hash]   = (int32_t)ip;
+
+        if (ref < 0 || ip - ref > LZ4_MAX_DISTANCE || Lz4Read32(src + ref) != sequence)
+        {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+
+        size_t matchLength = LZ4_MIN_MATCH;
+        while (ip + matchLength < size - LZ4_LAST_LITERALS &&
+               src[ref + matchLength] == src[ip + matchLength])
+        {
+            matchLength++;
+        }
+
+        size_t   literalLength = ip - anchor;
+        uint8_t *token         = op++;
+        *token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+        if (literalLength >= 15)
+        {
+            op = Lz4WriteLength(op, literalLength - 15);
+        }
+        memcpy(op, src + anchor, literalLength);
+        op += literalLength;
+
+        uint32_t distance = (uint32_t)(ip - ref);
+        *op++ = (uint8_t)distance;
+        *op++ = (uint8_t)(distance >> 8);
+
+        size_t extraLength = matchLength - LZ4_MIN_MATCH;
+        *token |= (uint8_t)(extraLength >= 15 ? 15 : extraLength);
+        if (extraLength >= 15)
+        {
+            op = Lz4WriteLength(op, extraLength - 15);
+        }
+
+        ip += matchLength;
+        anchor = ip;
+    }
+
+    size_t literalLength = size - anchor;
+    *op++ = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15)
+    {
+        op = Lz4WriteLength(op, literalLength - 15);
+    }
+    memcpy(op, src + anchor, literalLength);
+    op += literalLength;
+
+    size_t compressedSize = op - dst;
+    return compressedSize < size ? compressedSize : 0;
+}
+
+void CodechalDebugCompress::Lz4Frame(
+    const uint8_t *       data,
+    size_t                size,
+    std::vector<uint8_t> &frame)
+{
+    // Magic, FLG (version 1, independent blocks), BD (4MB blocks) and the
+    // header checksum of FLG/BD
+    static const uint8_t header[] = {0x04, 0x22, 0x4d, 0x18, 0x60, 0x70, 0x73};
+
+    frame.assign(header, header + sizeof(header));
+
+    if (size > 0 && data != nullptr)
+    {
+        size_t               blockSize = size < m_lz4BlockSize ? size : m_lz4BlockSize;
+        std::vector<int32_t> hashTable(1 << LZ4_HASH_LOG);
+        std::vector<uint8_t> block(blockSize + blockSize / 255 + 16);
+
+        for (size_t offset = 0; offset < size; offset += blockSize)
+        {
+            size_t length         = size - offset < blockSize ? size - offset : blockSize;
+            size_t compressedSize = Lz4Block(data + offset, length, block.data(), hashTable.data());
+
+            if (compressedSize > 0)
+            {
+                Lz4Write32(frame, (uint32_t)compressedSize);
+                frame.insert(frame.end(), block.data(), block.data() + compressedSize);
+            }
+            else
+            {
+                // Stored uncompressed, flagged by the high bit of the size
+                Lz4Write32(frame, (uint32_t)length | 0x80000000);
+                frame.insert(frame.end(), data + offset, data + offset + length);
+            }
+        }
+    }
+
+    // End mark
+    Lz4Write32(frame, 0);
+}
@@ -0,0 +1,68 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     codechal_debug_compress.h
+//! \brief    Compression of debug dump files.
+//! \details  Produces LZ4 frames that the lz4 command line tool can decompress.
+//!
+#ifndef __CODECHAL_DEBUG_COMPRESS_H__
+#define __CODECHAL_DEBUG_COMPRESS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class CodechalDebugCompress
+{
+public:
+    //!
+    //! \brief    Compress data into a single LZ4 frame
+    //! \details  Blocks are independent, 4MB at most, without checksums.
+    //!           Incompressible blocks are stored raw.
+    //!
+    //! \param    [in] data
+    //!           Data to compress
+    //! \param    [in] size
+    //!           Size of data in bytes
+    //! \param    [out] frame
+    //!           Receives the frame, previous content is replaced
+    //!
+    static void Lz4Frame(
+        const uint8_t *       data,
+        size_t                size,
+        std::vector<uint8_t> &frame);
+
+    static const uint32_t m_lz4BlockSize = 4 * 1024 * 1024;
+
+protected:
+    //!
+    //! \brief    Compress one LZ4 block
+    //! \return   Compressed size, or 0 if the block does not shrink
+    //!
+    static size_t Lz4Block(
+        const uint8_t *src,
+        size_t         size,
+        uint8_t *      dst,
+        int32_t *      hashTable);
+};
+
+#endif  // __CODECHAL_DEBUG_COMPRESS_H__
@@ -187,6 +187,8 @@ MOS_STATUS CodechalDebugConfigMgr::ParseConfig(MOS_CONTEXT_HANDLE mosCtx)
         }
     }
 
+    m_dumpFrameInterval = AttrValue(CodechalDbgAttr::attrDumpFrameInterval);
+
     return MOS_STATUS_SUCCESS;
 }
 
@@ -261,6 +263,10 @@ void CodechalDebugConfigMgr::GenerateDefaultConfig()
     ofs << "##" << CodechalDbgAttr::attrCoeffProb << ":0" << std::endl;
     ofs << "##" << CodechalDbgAttr::attrROISurface << ":0" << std::endl;
     ofs << "##" << CodechalDbgAttr::attrHuCStitchDataBuf << ":0" << std::endl;
+    ofs << "##" << CodechalDbgAttr::attrAsyncDump << ":0" << std::endl;
+    ofs << "##" << CodechalDbgAttr::attrAsyncDumpQueueDepth << ":0" << std::endl;
+    ofs << "##" << CodechalDbgAttr::attrDumpFrameInterval << ":0" << std::endl;
+    ofs << "##" << CodechalDbgAttr::attrCompressDumps << ":0" << std::endl;
     
    // MD5 attributes
     ofs << "##" << CodechalDbgAttr::attrMD5HashEnable << ":0" << std::endl;
@@ -462,7 +468,7 @@ std::string CodechalDebugConfigMgr::GetMediaStateStr(CODECHAL_MEDIA_STATE_TYPE m
 
 bool CodechalDebugConfigMgr::AttrIsEnabled(std::string attrName)
 {
-    if (nullptr != m_debugAllConfigs)
+    if (nullptr != m_debugAllConfigs && FrameIsSampled(attrName))
     {
         int attrValue = m_debugAllConfigs->cmdAttribs[attrName];
         if (attrValue > 0)
@@ -493,7 +499,7 @@ bool CodechalDebugConfigMgr::AttrIsEnabled(
         return false;
     }
 
-    if (nullptr != m_debugAllConfigs)
+    if (nullptr != m_debugAllConfigs && FrameIsSampled(attrName))
     {
         KernelDumpConfig attrs   = m_debugAllConfigs->kernelAttribs[kernelName];
         bool             enabled = KernelAttrEnabled(attrs, attrName);
@@ -514,6 +520,54 @@ bool CodechalDebugConfigMgr::AttrIsEnabled(
     return false;
 }
 
+int32_t CodechalDebugConfigMgr::AttrValue(std::string attrName)
+{
+    if (nullptr == m_debugAllConfigs)
+    {
+        return 0;
+    }
+
+    auto it = m_debugAllConfigs->cmdAttribs.find(attrName);
+    return it != m_debugAllConfigs->cmdAttribs.end() ? it->second : 0;
+}
+
+bool CodechalDebugConfigMgr::FrameIsSampled(std::string attrName)
+{
+    if (m_dumpFrameInterval <= 1 ||
+        m_debugInterface->m_bufferDumpFrameNum % m_dumpFrameInterval == 0)
+    {
+        return true;
+    }
+
+    // Settings that shape the dumps rather than select them hold for every frame
+    static const char *settings[] = {
+        CodechalDbgAttr::attrDumpBufferInBinary,
+        CodechalDbgAttr::attrDumpToThreadFolder,
+        CodechalDbgAttr::attrDumpCmdBufInBinary,
+        CodechalDbgAttr::attrForceCmdDumpLvl,
+        CodechalDbgAttr::attrForceCurbeDumpLvl,
+        CodechalDbgAttr::attrForceYUVDumpWithMemcpy,
+        CodechalDbgAttr::attrDisableSwizzleForDumps,
+        CodechalDbgAttr::attrMD5HashEnable,
+        CodechalDbgAttr::attrMD5FlushInterval,
+        CodechalDbgAttr::attrMD5PicWidth,
+        CodechalDbgAttr::attrMD5PicHeight,
+        CodechalDbgAttr::attrAsyncDump,
+        CodechalDbgAttr::attrAsyncDumpQueueDepth,
+        CodechalDbgAttr::attrDumpFrameInterval,
+        CodechalDbgAttr::attrCompressDumps};
+
+    for (auto setting : settings)
+    {
+        if (attrName == setting)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool CodechalDebugConfigMgr::KernelAttrEnabled(KernelDumpConfig kernelConfig, std::string attrName)
 {
     if (!strncmp(attrName.c_str(), CodechalDbgAttr::attrDsh, sizeof(CodechalDbgAttr::attrDsh) - 1))
@@ -99,6 +99,10 @@ static const char *attrPakObjStreamout        = "PakObjStreamOut";
 static const char *attrTileBasedStats         = "TileBasedStats";
 static const char *attrROISurface             = "ROIInput";
 static const char *attrHuCStitchDataBuf       = "HuCStitchDataBuffer";
+static const char *attrAsyncDump              = "AsyncDump";
+static const char *attrAsyncDumpQueueDepth    = "AsyncDumpQueueDepth";
+static const char *attrDumpFrameInterval      = "DumpFrameInterval";
+static const char *attrCompressDumps          = "CompressDumps";
 
 // MD5 attributes
 static const char *attrMD5HashEnable    = "MD5HasEnable";
@@ -277,12 +281,18 @@ public:
     bool AttrIsEnabled(std::string attrib);
     bool AttrIsEnabled(CODECHAL_MEDIA_STATE_TYPE mediaState, std::string attrib);
 
+    //!
+    //! \brief    Value of an attribute set for all frames, 0 if it is not set
+    //!
+    int32_t AttrValue(std::string attrib);
+
 protected:
     void GenerateDefaultConfig();
     uint32_t GetFrameConfig(uint32_t frameIdx);
     void StoreDebugAttribs(std::string line, CodechalDbgCfg *dbgCfg);
     void ParseKernelAttribs(std::string line, CodechalDbgCfg *dbgCfg);
     bool KernelAttrEnabled(KernelDumpConfig kernelConfig, std::string attrName);
+    bool FrameIsSampled(std::string attrName);
 
 protected:
     CodechalDebugInterface *    m_debugInterface = nullptr;
@@ -290,6 +300,7 @@ protected:
     std::string                 m_outputFolderPath;
     std::vector<CodechalDbgCfg> m_debugFrameConfigs;
     CodechalDbgCfg *            m_debugAllConfigs = nullptr;
+    int32_t                     m_dumpFrameInterval = 0;  //!< Dump every Nth frame under @Frame ALL
 };
 
 #endif  //USE_CODECHAL_DEBUG_TOOL
@@ -0,0 +1,393 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     codechal_debug_dump_writer.cpp
+//! \brief    Defines the writer of CodecHal debug dumps.
+//! \details  Formats, compresses and writes dump files, either inline or on a
+//!           background thread fed by a bounded queue.
+//!
+#include "codechal_debug_dump_writer.h"
+#if USE_CODECHAL_DEBUG_TOOL
+#include "codechal_debug_compress.h"
+#include <fstream>
+
+CodechalDebugDumpWriter::CodechalDebugDumpWriter()
+{
+}
+
+CodechalDebugDumpWriter::~CodechalDebugDumpWriter()
+{
+    Stop();
+
+    if (m_jobSemaphore)
+    {
+        MOS_DestroySemaphore(m_jobSemaphore);
+        m_jobSemaphore = nullptr;
+    }
+    if (m_slotSemaphore)
+    {
+        MOS_DestroySemaphore(m_slotSemaphore);
+        m_slotSemaphore = nullptr;
+    }
+    if (m_mutex)
+    {
+        MOS_DestroyMutex(m_mutex);
+        m_mutex = nullptr;
+    }
+}
+
+MOS_STATUS CodechalDebugDumpWriter::Start(uint32_t queueDepth)
+{
+    CODECHAL_DEBUG_FUNCTION_ENTER;
+
+    if (m_async)
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    m_queueDepth = MOS_CLAMP_MIN_MAX(queueDepth, 1, CODECHAL_DEBUG_DUMP_MAX_QUEUE_DEPTH);
+
+    if (m_mutex == nullptr)
+    {
+        m_mutex         = MOS_CreateMutex();
+        m_jobSemaphore  = MOS_CreateSemaphore(0, m_queueDepth + 1);
+        m_slotSemaphore = MOS_CreateSemaphore(m_queueDepth, m_queueDepth);
+    }
+    CODECHAL_DEBUG_CHK_NULL(m_mutex);
+    CODECHAL_DEBUG_CHK_NULL(m_jobSemaphore);
+    CODECHAL_DEBUG_CHK_NULL(m_slotSemaphore);
+
+    m_thread = MOS_CreateThread((void *)WriterThread, this);
+    if (!m_thread)
+    {
+        CODECHAL_DEBUG_ASSERTMESSAGE("Failed to create the dump writer thread, dumps are written inline.");
+        return MOS_STATUS_UNKNOWN;
+    }
+    m_async = true;
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void CodechalDebugDumpWriter::Stop()
+{
+    if (!m_async)
+    {
+        return;
+    }
+
+    // Queued jobs are written before the thread sees the exit request
+    MOS_LockMutex(m_mutex);
+    m_jobs.push_back(nullptr);
+    MOS_UnlockMutex(m_mutex);
+    MOS_PostSemaphore(m_jobSemaphore, 1);
+
+    MOS_WaitThread(m_thread);
+    m_thread = 0;
+    m_async  = false;
+
+    CODECHAL_DEBUG_NORMALMESSAGE("Dump writer wrote %d dumps, %d submits waited for a free queue slot.",
+        m_jobCount, m_stallCount);
+}
+
+MOS_STATUS CodechalDebugDumpWriter::Submit(CodechalDbgDumpJob *job)
+{
+    CODECHAL_DEBUG_CHK_NULL(job);
+
+    if (!m_async)
+    {
+        MOS_STATUS status = Write(job);
+        Release(job);
+        return status;
+    }
+
+    if (!job->ownData)
+    {
+        CODECHAL_DEBUG_ASSERTMESSAGE("Queued dump does not own its snapshot.");
+        Release(job);
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    if (MOS_WaitSemaphore(m_slotSemaphore, 0) != MOS_STATUS_SUCCESS)
+    {
+        m_stallCount++;
+        MOS_WaitSemaphore(m_slotSemaphore, INFINITE);
+    }
+
+    MOS_LockMutex(m_mutex);
+    m_jobs.push_back(job);
+    m_jobCount++;
+    MOS_UnlockMutex(m_mutex);
+    MOS_PostSemaphore(m_jobSemaphore, 1);
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void CodechalDebugDumpWriter::Release(CodechalDbgDumpJob *job)
+{
+    if (job->ownData)
+    {
+        MOS_FreeMemory(job->data);
+    }
+    MOS_Delete(job);
+}
+
+MOS_STATUS CodechalDebugDumpWriter::Write(CodechalDbgDumpJob *job)
+{
+    uint8_t *data = job->data;
+    CODECHAL_DEBUG_CHK_NULL(data);
+
+    MOS_STATUS           status = MOS_STATUS_SUCCESS;
+    std::vector<uint8_t> out;
+
+    switch (job->format)
+    {
+    case dumpBinary:
+        status = WriteFile(job->filePath, data, job->size);
+        break;
+    case dump2DBinary:
+        out.reserve(job->width * job->height);
+        for (uint32_t h = 0; h < job->height; h++)
+        {
+            out.insert(out.end(), data, data + job->width);
+            data += job->pitch;
+        }
+        status = WriteFile(job->filePath, out.data(), out.size());
+        break;
+    case dumpHexDwords:
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+
+        // Same layout as DumpBufferInHexDwords, a partial last dword is zero padded
+        uint32_t dwordSize = (job->size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+        out.reserve(dwordSize * 9 + dwordSize / 4 + 1);
+        for (uint32_t i = 0; i < dwordSize; i++)
+        {
+            uint32_t dword = 0;
+            MOS_SecureMemcpy(&dword, sizeof(dword), data + i * sizeof(uint32_t),
+                MOS_MIN(sizeof(uint32_t), job->size - i * sizeof(uint32_t)));
+            for (int32_t shift = 28; shift >= 0; shift -= 4)
+            {
+                out.push_back(hexDigits[(dword >> shift) & 0xf]);
+            }
+            if (job->size % sizeof(uint32_t) && i == dwordSize - 1)
+            {
+                out.push_back('\n');
+            }
+            else
+            {
+                out.push_back(' ');
+                if (i % 4 == 3)
+                {
+                    out.push_back('\n');
+                }
+            }
+        }
+        status = WriteFile(job->filePath, out.data(), out.size());
+        break;
+    }
+    case dumpYuv:
+        status = WriteYuv(job, data, out);
+        if (status == MOS_STATUS_SUCCESS)
+        {
+            status = WriteFile(job->filePath, out.data(), out.size());
+        }
+        break;
+    default:
+        status = MOS_STATUS_INVALID_PARAMETER;
+        break;
+    }
+
+    return status;
+}
+
+MOS_STATUS CodechalDebugDumpWriter::WriteYuv(
+    CodechalDbgDumpJob   *job,
+    uint8_t              *data,
+    std::vector<uint8_t> &out)
+{
+    MOS_SURFACE *surface = &job->surface;
+    CODECHAL_DEBUG_CHK_NULL(data);
+
+    if (surface->dwPitch == 0)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    uint8_t *surfBaseAddr = (uint8_t *)MOS_AllocMemory(job->size);
+    CODECHAL_DEBUG_CHK_NULL(surfBaseAddr);
+
+    // Always use MOS swizzle instead of GMM Cpu blit
+    Mos_SwizzleData(data, surfBaseAddr, surface->TileType, MOS_TILE_LINEAR, job->size / surface->dwPitch, surface->dwPitch, 0);
+
+    uint32_t width  = job->width;
+    uint32_t height = job->height;
+    uint32_t pitch  = job->pitch;
+    uint8_t *end    = surfBaseAddr + job->size;
+
+    // write luma data
+    data = surfBaseAddr + job->offset;
+    for (uint32_t h = 0; h < height && data + width <= end; h++)
+    {
+        out.insert(out.end(), data, data + width);
+        data += pitch;
+    }
+
+    if (surface->Format != Format_A8B8G8R8)
+    {
+        switch (surface->Format)
+        {
+        case Format_NV12:
+        case Format_P010:
+        case Format_P016:
+            height >>= 1;
+            break;
+        case  Format_Y416:
+        case  Format_AUYV:
+        case  Format_R10G10B10A2:
+            height *= 2;
+            break;
+        case  Format_YUY2:
+        case  Format_YUYV:
+        case  Format_YUY2V:
+        case  Format_Y216V:
+        case  Format_YVYU:
+        case  Format_UYVY:
+        case  Format_VYUY:
+        case  Format_Y216: //422 16bit
+        case  Format_Y210: //422 10bit
+        case  Format_P208: //422 8bit
+            break;
+        case Format_422V:
+        case Format_IMC3:
+            height = height / 2;
+            break;
+        case  Format_AYUV:
+        default:
+            height = 0;
+            break;
+        }
+
+        uint8_t *vPlaneData = surfBaseAddr;
+#ifdef LINUX
+        data = surfBaseAddr + surface->UPlaneOffset.iSurfaceOffset;
+        if (surface->Format == Format_422V
+            || surface->Format == Format_IMC3)
+        {
+            vPlaneData = surfBaseAddr + surface->VPlaneOffset.iSurfaceOffset;
+        }
+#else
+        data = surfBaseAddr + surface->UPlaneOffset.iLockSurfaceOffset;
+        if (surface->Format == Format_422V
+            || surface->Format == Format_IMC3)
+        {
+            vPlaneData = surfBaseAddr + surface->VPlaneOffset.iLockSurfaceOffset;
+        }
+#endif
+
+        // write chroma data
+        for (uint32_t h = 0; h < height && data + width <= end; h++)
+        {
+            out.insert(out.end(), data, data + width);
+            data += pitch;
+        }
+
+        // write v planar data
+        if (surface->Format == Format_422V
+            || surface->Format == Format_IMC3)
+        {
+            for (uint32_t h = 0; h < height && vPlaneData + width <= end; h++)
+            {
+                out.insert(out.end(), vPlaneData, vPlaneData + width);
+                vPlaneData += pitch;
+            }
+        }
+    }
+
+    MOS_FreeMemory(surfBaseAddr);
+
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS CodechalDebugDumpWriter::WriteFile(
+    const std::string &filePath,
+    const uint8_t     *data,
+    size_t             size)
+{
+    if (size == 0)
+    {
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    std::vector<uint8_t> frame;
+    std::string          path = filePath;
+    if (m_compress)
+    {
+        CodechalDebugCompress::Lz4Frame(data, size, frame);
+        data = frame.data();
+        size = frame.size();
+        path += ".lz4";
+    }
+
+    std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+    if (ofs.fail())
+    {
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    ofs.write((const char *)data, size);
+    ofs.close();
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void *CodechalDebugDumpWriter::WriterThread(void *data)
+{
+    CodechalDebugDumpWriter *writer = (CodechalDebugDumpWriter *)data;
+    if (writer == nullptr)
+    {
+        return nullptr;
+    }
+
+    while (MOS_WaitSemaphore(writer->m_jobSemaphore, INFINITE) == MOS_STATUS_SUCCESS)
+    {
+        MOS_LockMutex(writer->m_mutex);
+        CodechalDbgDumpJob *job = writer->m_jobs.front();
+        writer->m_jobs.pop_front();
+        MOS_UnlockMutex(writer->m_mutex);
+
+        if (job == nullptr)
+        {
+            break;
+        }
+
+        if (writer->Write(job) != MOS_STATUS_SUCCESS)
+        {
+            CODECHAL_DEBUG_NORMALMESSAGE("Failed to write dump %s.", job->filePath.c_str());
+        }
+        writer->Release(job);
+        MOS_PostSemaphore(writer->m_slotSemaphore, 1);
+    }
+
+    return nullptr;
+}
+
+#endif  // USE_CODECHAL_DEBUG_TOOL
@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     codechal_debug_dump_writer.h
+//! \brief    Defines the writer of CodecHal debug dumps.
+//! \details  Formats, compresses and writes dump files, either inline or on a
+//!           background thread fed by a bounded queue.
+//!
+#ifndef __CODECHAL_DEBUG_DUMP_WRITER_H__
+#define __CODECHAL_DEBUG_DUMP_WRITER_H__
+
+#include "codechal_debug.h"
+#if USE_CODECHAL_DEBUG_TOOL
+#include <deque>
+#include <string>
+#include <vector>
+
+//! \brief  Default and maximum number of dumps queued for the writer thread
+#define CODECHAL_DEBUG_DUMP_QUEUE_DEPTH      16
+#define CODECHAL_DEBUG_DUMP_MAX_QUEUE_DEPTH  256
+
+enum CodechalDbgDumpFormat
+{
+    dumpBinary    = 0,  //!< size bytes as is
+    dump2DBinary  = 1,  //!< height rows of width bytes, pitch apart
+    dumpHexDwords = 2,  //!< size bytes as text dwords
+    dumpYuv       = 3,  //!< tiled surface, deswizzled and written plane by plane
+};
+
+//!
+//! \struct   CodechalDbgDumpJob
+//! \brief    One dump file and the snapshot it is written from
+//!
+struct CodechalDbgDumpJob
+{
+    std::string           filePath;
+    CodechalDbgDumpFormat format  = dumpBinary;
+    uint32_t              size    = 0;          //!< Snapshot size in bytes
+
+    uint8_t              *data    = nullptr;    //!< CPU snapshot, or locked memory when written inline
+    bool                  ownData = false;      //!< data is freed with the job
+
+    // dump2DBinary and dumpYuv layout
+    uint32_t              width   = 0;          //!< Bytes per row
+    uint32_t              height  = 0;
+    uint32_t              pitch   = 0;
+    uint32_t              offset  = 0;          //!< Offset of the first (luma) row
+    MOS_SURFACE           surface = {};         //!< dumpYuv format, tiling and plane offsets
+};
+
+//!
+//! \class    CodechalDebugDumpWriter
+//! \brief    Writes dump jobs to files
+//! \details  Without a writer thread jobs are written by Submit() itself. With
+//!           one, Submit() only queues the job and blocks while the queue is full,
+//!           which bounds the memory held by snapshots. The writer only reads CPU
+//!           memory and never uses an OS interface, all locking stays on the
+//!           submitting thread.
+//!
+class CodechalDebugDumpWriter
+{
+public:
+    CodechalDebugDumpWriter();
+
+    ~CodechalDebugDumpWriter();
+
+    //!
+    //! \brief    Start the writer thread
+    //! \param    [in] queueDepth
+    //!           Maximum number of queued jobs
+    //! \return   MOS_STATUS
+    //!           MOS_STATUS_SUCCESS if success, else fail reason
+    //!
+    MOS_STATUS Start(uint32_t queueDepth);
+
+    //!
+    //! \brief    Write the queued jobs and stop the writer thread
+    //!
+    void Stop();
+
+    bool IsAsync()
+    {
+        return m_async;
+    }
+
+    void SetCompression(bool compress)
+    {
+        m_compress = compress;
+    }
+
+    //!
+    //! \brief    Write a job, or queue it when the writer thread runs
+    //! \details  Takes ownership of job, which must come from MOS_New. A queued
+    //!           job has to own its snapshot.
+    //! \param    [in] job
+    //!           Job to write
+    //! \return   MOS_STATUS
+    //!           MOS_STATUS_SUCCESS if success, else fail reason
+    //!
+    MOS_STATUS Submit(CodechalDbgDumpJob *job);
+
+protected:
+    MOS_STATUS Write(CodechalDbgDumpJob *job);
+
+    MOS_STATUS WriteFile(
+        const std::string &filePath,
+        const uint8_t *    data,
+        size_t             size);
+
+    MOS_STATUS WriteYuv(
+        CodechalDbgDumpJob *job,
+        uint8_t *           data,
+        std::vector<uint8_t> &out);
+
+    void Release(CodechalDbgDumpJob *job);
+
+    static void *WriterThread(void *data);
+
+    bool                             m_compress      = false;
+    uint32_t                         m_queueDepth    = 0;
+
+    bool                             m_async         = false;
+    MOS_THREADHANDLE                 m_thread        = 0;
+    PMOS_MUTEX                       m_mutex         = nullptr;  //!< Guards m_jobs
+    PMOS_SEMAPHORE                   m_jobSemaphore  = nullptr;  //!< Posted once per queued job
+    PMOS_SEMAPHORE                   m_slotSemaphore = nullptr;  //!< Posted once per free queue slot
+    std::deque<CodechalDbgDumpJob *> m_jobs;                     //!< nullptr asks the thread to exit
+
+    uint32_t                         m_jobCount      = 0;
+    uint32_t                         m_stallCount    = 0;        //!< Submits that waited for a free slot
+};
+
+#endif  // USE_CODECHAL_DEBUG_TOOL
+#endif  // __CODECHAL_DEBUG_DUMP_WRITER_H__
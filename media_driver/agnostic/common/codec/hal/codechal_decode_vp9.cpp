@@ -125,6 +125,14 @@ CodechalDecodeVp9 :: ~CodechalDecodeVp9 ()
         m_osInterface,
         &m_resInterProbSaveBuffer);
 
+    m_osInterface->pfnFreeResource(
+        m_osInterface,
+        &m_resProbImageBuffer);
+
+    m_osInterface->pfnFreeResource(
+        m_osInterface,
+        &m_resSegProbStageBuffer);
+
     if (m_picMhwParams.PipeModeSelectParams)
     {
         MOS_Delete(m_picMhwParams.PipeModeSelectParams);
@@ -203,12 +211,14 @@ CodechalDecodeVp9 ::CodechalDecodeVp9(
     MOS_ZeroMemory(&m_resCopyDataBuffer, sizeof(m_resCopyDataBuffer));
     MOS_ZeroMemory(&m_segTreeProbs, sizeof(m_segTreeProbs));
     MOS_ZeroMemory(&m_segPredProbs, sizeof(m_segPredProbs));
-    MOS_ZeroMemory(&m_interProbSaved, sizeof(m_interProbSaved));
     MOS_ZeroMemory(&m_resDmemBuffer, sizeof(m_resDmemBuffer));
     MOS_ZeroMemory(&m_resInterProbSaveBuffer, sizeof(m_resInterProbSaveBuffer));
     MOS_ZeroMemory(&m_probUpdateFlags, sizeof(m_probUpdateFlags));
     MOS_ZeroMemory(&m_resSegmentIdBuffReset, sizeof(m_resSegmentIdBuffReset));
     MOS_ZeroMemory(&m_resHucSharedBuffer, sizeof(m_resHucSharedBuffer));
+    MOS_ZeroMemory(&m_resProbImageBuffer, sizeof(m_resProbImageBuffer));
+    MOS_ZeroMemory(&m_resSegProbStageBuffer, sizeof(m_resSegProbStageBuffer));
+    MOS_ZeroMemory(&m_probImageRanges, sizeof(m_probImageRanges));
     MOS_ZeroMemory(&m_picMhwParams, sizeof(m_picMhwParams));
     MOS_ZeroMemory(&m_destSurface, sizeof(m_destSurface));
     MOS_ZeroMemory(&m_lastRefSurface, sizeof(m_lastRefSurface));
@@ -231,104 +241,198 @@ CodechalDecodeVp9 ::CodechalDecodeVp9(
     m_hcpInUse = true;
 }
 
-MOS_STATUS CodechalDecodeVp9 :: ProbBufferPartialUpdatewithDrv()
+MOS_STATUS CodechalDecodeVp9 :: InitProbImages()
 {
     MOS_STATUS eStatus = MOS_STATUS_SUCCESS;
 
     CODECHAL_DECODE_FUNCTION_ENTER;
 
-    CodechalResLock ResourceLock(m_osInterface, &m_resVp9ProbBuffer[m_frameCtxIdx]);
+    CodechalResLock ResourceLock(m_osInterface, &m_resProbImageBuffer);
     auto data = (uint8_t*)ResourceLock.Lock(CodechalResLock::writeOnly);
     CODECHAL_DECODE_CHK_NULL_RETURN(data);
 
+    // The resets leave some bytes untouched, so run each one over an all-zero
+    // and an all-one copy: the bytes that end up equal are the ones it writes.
+    uint8_t zeroFilled[CODEC_VP9_PROB_MAX_NUM_ELEM];
+    uint8_t oneFilled[CODEC_VP9_PROB_MAX_NUM_ELEM];
+
+    for (uint32_t image = 0; image < CODECHAL_DECODE_VP9_PROB_IMAGE_NUM; image++)
+    {
+        bool setToKey = (image == CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_KEY ||
+                         image == CODECHAL_DECODE_VP9_PROB_IMAGE_DIFF_KEY);
+
+        MOS_ZeroMemory(zeroFilled, sizeof(zeroFilled));
+        MOS_FillMemory(oneFilled, sizeof(oneFilled), 0xff);
+
+        if (image == CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_KEY ||
+            image == CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_INTER)
+        {
+            CODECHAL_DECODE_CHK_STATUS_RETURN(ContextBufferInit(zeroFilled, setToKey));
+            CODECHAL_DECODE_CHK_STATUS_RETURN(ContextBufferInit(oneFilled, setToKey));
+        }
+        else
+        {
+            CODECHAL_DECODE_CHK_STATUS_RETURN(CtxBufDiffInit(zeroFilled, setToKey));
+            CODECHAL_DECODE_CHK_STATUS_RETURN(CtxBufDiffInit(oneFilled, setToKey));
+        }
+
+        PCODECHAL_DECODE_VP9_PROB_RANGES ranges = &m_probImageRanges[image];
+        MOS_ZeroMemory(ranges, sizeof(*ranges));
+        for (uint32_t i = 0; i < CODEC_VP9_PROB_MAX_NUM_ELEM; i++)
+        {
+            if (zeroFilled[i] != oneFilled[i])
+            {
+                continue;
+            }
+
+            uint32_t last = ranges->numRanges - 1;
+            if (ranges->numRanges > 0 &&
+                ranges->offset[last] + ranges->size[last] == i)
+            {
+                ranges->size[last]++;
+                continue;
+            }
+
+            if (ranges->numRanges >= CODECHAL_DECODE_VP9_PROB_MAX_RANGES)
+            {
+                CODECHAL_DECODE_ASSERTMESSAGE("Too many VP9 prob image ranges.");
+                return MOS_STATUS_NO_SPACE;
+            }
+            ranges->offset[ranges->numRanges] = (uint16_t)i;
+            ranges->size[ranges->numRanges]   = 1;
+            ranges->numRanges++;
+        }
+
+        CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
+            data + image * CODEC_VP9_PROB_MAX_NUM_ELEM,
+            CODEC_VP9_PROB_MAX_NUM_ELEM,
+            zeroFilled,
+            CODEC_VP9_PROB_MAX_NUM_ELEM));
+    }
+
+    return eStatus;
+}
+
+MOS_STATUS CodechalDecodeVp9 :: ProbBufUpdatewithHucCopy(
+    PMOS_COMMAND_BUFFER         cmdBuffer)
+{
+    MOS_STATUS eStatus = MOS_STATUS_SUCCESS;
+
+    CODECHAL_DECODE_FUNCTION_ENTER;
+
+    CODECHAL_DECODE_CHK_NULL_RETURN(cmdBuffer);
+
+    if (!m_probUpdateFlags.bSegProbCopy &&
+        !m_probUpdateFlags.bProbSave &&
+        !m_probUpdateFlags.bProbReset &&
+        !m_probUpdateFlags.bProbRestore)
+    {
+        return eStatus;
+    }
+
+    PMOS_RESOURCE probBuffer = &m_resVp9ProbBuffer[m_frameCtxIdx];
+
+    MHW_MI_FLUSH_DW_PARAMS flushDwParams;
+    MOS_ZeroMemory(&flushDwParams, sizeof(flushDwParams));
+
+    // A full reset never touches the seg probs and never comes with a save or
+    // restore, so the partial update order below also covers the full update.
     if (m_probUpdateFlags.bSegProbCopy)
     {
+        uint32_t segProbs[3] = {0};
         CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-            (data + CODEC_VP9_SEG_PROB_OFFSET),
+            (uint8_t *)segProbs,
             7,
             m_probUpdateFlags.SegTreeProbs,
             7));
         CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-            (data + CODEC_VP9_SEG_PROB_OFFSET + 7),
+            (uint8_t *)segProbs + 7,
             3,
             m_probUpdateFlags.SegPredProbs,
             3));
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            MHW_MI_STORE_DATA_PARAMS storeDataParams;
+            MOS_ZeroMemory(&storeDataParams, sizeof(storeDataParams));
+            storeDataParams.pOsResource      = &m_resSegProbStageBuffer;
+            storeDataParams.dwResourceOffset = i * sizeof(uint32_t);
+            storeDataParams.dwValue          = segProbs[i];
+            CODECHAL_DECODE_CHK_STATUS_RETURN(m_miInterface->AddMiStoreDataImmCmd(
+                cmdBuffer,
+                &storeDataParams));
+        }
+        CODECHAL_DECODE_CHK_STATUS_RETURN(m_miInterface->AddMiFlushDwCmd(
+            cmdBuffer,
+            &flushDwParams));
+
+        CODECHAL_DECODE_CHK_STATUS_RETURN(HucCopy(
+            cmdBuffer,                   // cmdBuffer
+            &m_resSegProbStageBuffer,    // presSrc
+            probBuffer,                  // presDst
+            7 + 3,                       // u32CopyLength
+            0,                           // u32CopyInputOffset
+            CODEC_VP9_SEG_PROB_OFFSET)); // u32CopyOutputOffset
     }
 
     if (m_probUpdateFlags.bProbSave)
     {
-        CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-            m_interProbSaved,
-            CODECHAL_VP9_INTER_PROB_SIZE,
-            data + CODEC_VP9_INTER_PROB_OFFSET,
-            CODECHAL_VP9_INTER_PROB_SIZE));
+        CODECHAL_DECODE_CHK_STATUS_RETURN(HucCopy(
+            cmdBuffer,                      // cmdBuffer
+            probBuffer,                     // presSrc
+            &m_resInterProbSaveBuffer,      // presDst
+            CODECHAL_VP9_INTER_PROB_SIZE,   // u32CopyLength
+            CODEC_VP9_INTER_PROB_OFFSET,    // u32CopyInputOffset
+            0));                            // u32CopyOutputOffset
+        CODECHAL_DECODE_CHK_STATUS_RETURN(m_miInterface->AddMiFlushDwCmd(
+            cmdBuffer,
+            &flushDwParams));
     }
 
     if (m_probUpdateFlags.bProbReset)
     {
+        uint32_t image;
         if (m_probUpdateFlags.bResetFull)
         {
-            CODECHAL_DECODE_CHK_STATUS_RETURN(ContextBufferInit(
-                data, (m_probUpdateFlags.bResetKeyDefault ? true : false)));
+            image = m_probUpdateFlags.bResetKeyDefault ?
+                CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_KEY : CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_INTER;
         }
         else
         {
-            CODECHAL_DECODE_CHK_STATUS_RETURN(CtxBufDiffInit(
-                data, (m_probUpdateFlags.bResetKeyDefault ? true : false)));
+            image = m_probUpdateFlags.bResetKeyDefault ?
+                CODECHAL_DECODE_VP9_PROB_IMAGE_DIFF_KEY : CODECHAL_DECODE_VP9_PROB_IMAGE_DIFF_INTER;
         }
+
+        PCODECHAL_DECODE_VP9_PROB_RANGES ranges = &m_probImageRanges[image];
+        for (uint32_t i = 0; i < ranges->numRanges; i++)
+        {
+            CODECHAL_DECODE_CHK_STATUS_RETURN(HucCopy(
+                cmdBuffer,                                                    // cmdBuffer
+                &m_resProbImageBuffer,                                        // presSrc
+                probBuffer,                                                   // presDst
+                ranges->size[i],                                              // u32CopyLength
+                image * CODEC_VP9_PROB_MAX_NUM_ELEM + ranges->offset[i],     // u32CopyInputOffset
+                ranges->offset[i]));                                          // u32CopyOutputOffset
+        }
+        CODECHAL_DECODE_CHK_STATUS_RETURN(m_miInterface->AddMiFlushDwCmd(
+            cmdBuffer,
+            &flushDwParams));
     }
 
     if (m_probUpdateFlags.bProbRestore)
     {
-        CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-            data + CODEC_VP9_INTER_PROB_OFFSET,
-            CODECHAL_VP9_INTER_PROB_SIZE,
-            m_interProbSaved,
-            CODECHAL_VP9_INTER_PROB_SIZE));
+        CODECHAL_DECODE_CHK_STATUS_RETURN(HucCopy(
+            cmdBuffer,                      // cmdBuffer
+            &m_resInterProbSaveBuffer,      // presSrc
+            probBuffer,                     // presDst
+            CODECHAL_VP9_INTER_PROB_SIZE,   // u32CopyLength
+            0,                              // u32CopyInputOffset
+            CODEC_VP9_INTER_PROB_OFFSET));  // u32CopyOutputOffset
     }
 
-    return eStatus;
-}
-
-MOS_STATUS CodechalDecodeVp9 :: ProbBufFullUpdatewithDrv()
-{
-    MOS_STATUS eStatus = MOS_STATUS_SUCCESS;
-
-    CODECHAL_DECODE_FUNCTION_ENTER;
-
-    CodechalResLock ResourceLock(m_osInterface, &m_resVp9ProbBuffer[m_frameCtxIdx]);
-    auto data = (uint8_t*)ResourceLock.Lock(CodechalResLock::writeOnly);
-    CODECHAL_DECODE_CHK_NULL_RETURN(data);
-
-    CODECHAL_DECODE_CHK_STATUS_RETURN(ContextBufferInit(
-        data, (m_probUpdateFlags.bResetKeyDefault ? true : false)));
-    CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-        (data + CODEC_VP9_SEG_PROB_OFFSET),
-        7,
-        m_probUpdateFlags.SegTreeProbs,
-        7));
-    CODECHAL_DECODE_CHK_STATUS_RETURN(MOS_SecureMemcpy(
-        (data + CODEC_VP9_SEG_PROB_OFFSET + 7),
-        3,
-        m_probUpdateFlags.SegPredProbs,
-        3));
-
-    return eStatus;
-}
-
-MOS_STATUS CodechalDecodeVp9 :: ResetSegIdBufferwithDrv()
-{
-    MOS_STATUS eStatus = MOS_STATUS_SUCCESS;
-
-    CODECHAL_DECODE_FUNCTION_ENTER;
-
-    CodechalResLock ResourceLock(m_osInterface, &m_resVp9SegmentIdBuffer);
-    auto data = (uint8_t*)ResourceLock.Lock(CodechalResLock::writeOnly);
-    CODECHAL_DECODE_CHK_NULL_RETURN(data);
-
-    MOS_ZeroMemory(
-        data,
-        m_allocatedWidthInSb * m_allocatedHeightInSb * CODECHAL_CACHELINE_SIZE);
+    CODECHAL_DECODE_CHK_STATUS_RETURN(m_miInterface->AddMiFlushDwCmd(
+        cmdBuffer,
+        &flushDwParams));
 
     return eStatus;
 }
@@ -636,6 +740,21 @@ MOS_STATUS CodechalDecodeVp9 :: AllocateResourcesFixedSizes()
                                                   "VP9HucSharedBuffer"),
         "Failed to allocate VP9 Huc shared Buffer.");
 
+    // VP9 precomputed prob images, one prob buffer per reset type
+    CODECHAL_DECODE_CHK_STATUS_MESSAGE_RETURN(AllocateBuffer(
+                                                  &m_resProbImageBuffer,
+                                                  MOS_ALIGN_CEIL(CODEC_VP9_PROB_MAX_NUM_ELEM * CODECHAL_DECODE_VP9_PROB_IMAGE_NUM, CODECHAL_PAGE_SIZE),
+                                                  "VP9ProbImageBuffer"),
+        "Failed to allocate VP9 prob image Buffer.");
+    CODECHAL_DECODE_CHK_STATUS_RETURN(InitProbImages());
+
+    // VP9 seg tree/pred probs staging buffer written with MI_STORE_DATA_IMM
+    CODECHAL_DECODE_CHK_STATUS_MESSAGE_RETURN(AllocateBuffer(
+                                                  &m_resSegProbStageBuffer,
+                                                  CODECHAL_CACHELINE_SIZE,
+                                                  "VP9SegProbStageBuffer"),
+        "Failed to allocate VP9 seg prob staging Buffer.");
+
     return eStatus;
 }
 
@@ -1665,7 +1784,7 @@ MOS_STATUS CodechalDecodeVp9 :: UpdatePicStateBuffers(
         }
         else
         {
-            CODECHAL_DECODE_CHK_STATUS_RETURN(ResetSegIdBufferwithDrv());
+            CODECHAL_DECODE_CHK_STATUS_RETURN(ResetSegIdBufferwithHucStreamout(cmdBuffe));
         }
     }
 
@@ -1678,14 +1797,7 @@ MOS_STATUS CodechalDecodeVp9 :: UpdatePicStateBuffers(
     }
     else
     {
-        if (m_fullProbBufferUpdate)
-        {
-            CODECHAL_DECODE_CHK_STATUS_RETURN(ProbBufFullUpdatewithDrv());
-        }
-        else
-        {
-            CODECHAL_DECODE_CHK_STATUS_RETURN(ProbBufferPartialUpdatewithDrv());
-        }
+        CODECHAL_DECODE_CHK_STATUS_RETURN(ProbBufUpdatewithHucCopy(cmdBuffe));
     }
 
     CODECHAL_DEBUG_TOOL(
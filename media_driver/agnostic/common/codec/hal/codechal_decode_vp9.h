@@ -49,6 +49,32 @@ typedef struct _CODECHAL_DECODE_VP9_PROB_UPDATE
     uint8_t      SegPredProbs[3];  //!< Segment predict prob buffers
 } CODECHAL_DECODE_VP9_PROB_UPDATE, *PCODECHAL_DECODE_VP9_PROB_UPDATE;
 
+#define CODECHAL_DECODE_VP9_PROB_MAX_RANGES 8  //!< Max byte ranges a prob image reset writes
+
+//!
+//! \enum   CODECHAL_DECODE_VP9_PROB_IMAGE
+//! \brief  Precomputed prob buffer images, one per reset type
+//!
+enum CODECHAL_DECODE_VP9_PROB_IMAGE
+{
+    CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_KEY = 0,  //!< ContextBufferInit() to key defaults
+    CODECHAL_DECODE_VP9_PROB_IMAGE_FULL_INTER,    //!< ContextBufferInit() to inter defaults
+    CODECHAL_DECODE_VP9_PROB_IMAGE_DIFF_KEY,      //!< CtxBufDiffInit() to key defaults
+    CODECHAL_DECODE_VP9_PROB_IMAGE_DIFF_INTER,    //!< CtxBufDiffInit() to inter defaults
+    CODECHAL_DECODE_VP9_PROB_IMAGE_NUM
+};
+
+//!
+//! \struct _CODECHAL_DECODE_VP9_PROB_RANGES
+//! \brief  Byte ranges of the prob buffer written by one prob image reset
+//!
+typedef struct _CODECHAL_DECODE_VP9_PROB_RANGES
+{
+    uint32_t     numRanges;                                     //!< Number of valid ranges
+    uint16_t     offset[CODECHAL_DECODE_VP9_PROB_MAX_RANGES];  //!< Range start in bytes
+    uint16_t     size[CODECHAL_DECODE_VP9_PROB_MAX_RANGES];    //!< Range length in bytes
+} CODECHAL_DECODE_VP9_PROB_RANGES, *PCODECHAL_DECODE_VP9_PROB_RANGES;
+
 //!
 //! \class CodechalDecodeVp9
 //! \brief This class defines the member fields, functions etc used by VP9 decoder.
@@ -258,7 +284,6 @@ public:
     uint8_t m_segTreeProbs[7];                                 //!< saved seg tree probs for pending seg probs copy operation to use
     uint8_t m_segPredProbs[3];                                 //!< saved seg pred probs for pending seg probs copy operation to use
     bool    m_fullProbBufferUpdate;                            //!< indicating if prob buffer is a full buffer update
-    uint8_t m_interProbSaved[CODECHAL_VP9_INTER_PROB_SIZE];    //!< indicating if internal prob buffer saved
 
     uint32_t                        m_dmemBufferSize;          //!< Dmem buffer size
     MOS_RESOURCE                    m_resDmemBuffer;           //!< Handle of Dmem buffer
@@ -266,6 +291,9 @@ public:
     CODECHAL_DECODE_VP9_PROB_UPDATE m_probUpdateFlags;         //!< Prob update flags
     MOS_RESOURCE                    m_resSegmentIdBuffReset;   //!< Handle of segment Id reset buffer
     MOS_RESOURCE                    m_resHucSharedBuffer;      //!< Handle of Huc shared buffer
+    MOS_RESOURCE                    m_resProbImageBuffer;      //!< Handle of precomputed prob images buffer
+    MOS_RESOURCE                    m_resSegProbStageBuffer;   //!< Handle of seg tree/pred probs staging buffer
+    CODECHAL_DECODE_VP9_PROB_RANGES m_probImageRanges[CODECHAL_DECODE_VP9_PROB_IMAGE_NUM];  //!< Bytes written by each prob image
 
 protected:
 
@@ -286,29 +314,27 @@ protected:
     PIC_STATE_MHW_PARAMS            m_picMhwParams;   //!< Picture state params
 
     //!
-    //! \brief    VP9 Prob buffer partial update with driver
-    //! \details  using driver to do the parital prob buffer update
-    //!           for clear decode
+    //! \brief    Build the precomputed prob images
+    //! \details  Run ContextBufferInit()/CtxBufDiffInit() once for key and
+    //!           inter defaults, upload the results to m_resProbImageBuffer
+    //!           and record which bytes each of them writes
     //! \return   MOS_STATUS
     //!           MOS_STATUS_SUCCESS if success, else fail reason
     //!
-    MOS_STATUS ProbBufferPartialUpdatewithDrv();
+    MOS_STATUS InitProbImages();
 
     //!
-    //! \brief    VP9 Prob buffer full update with driver
-    //! \details  full prob buffer udpate in clear decode
-    //! \return   MOS_STATUS
-    //!           MOS_STATUS_SUCCESS if success, else fail reason
-    //!
-    MOS_STATUS ProbBufFullUpdatewithDrv();
-
-    //!
-    //! \brief    VP9 Segment id buffer reset with driver
-    //! \details  VP9 Segment id buffer reset with driver in clear decode
+    //! \brief    VP9 Prob buffer update with Huc copy
+    //! \details  Apply m_probUpdateFlags to the current prob buffer in clear
+    //!           decode using GPU copies from the precomputed prob images,
+    //!           so the prob buffers are never locked on the frame path
+    //! \param    cmdBuffer
+    //!           [in] command buffer to hold HW commands
     //! \return   MOS_STATUS
     //!           MOS_STATUS_SUCCESS if success, else fail reason
     //!
-    MOS_STATUS ResetSegIdBufferwithDrv();
+    MOS_STATUS ProbBufUpdatewithHucCopy(
+        PMOS_COMMAND_BUFFER cmdBuffer);
 
     //!
     //! \brief    VP9 Prob buffer full update with Huc Streamout command
@@ -1466,6 +1466,24 @@ MOS_STATUS CodechalEncoderState::AllocateResources()
         m_encodeStatusBufRcs.wFirstIndex             = 0;
     }
 
+    // Sync buffers for WaitForStatusReport(), only ever written by the GPU
+    allocParamsForBufferLinear.dwBytes  = MHW_CACHELINE_SIZE;
+    allocParamsForBufferLinear.pBufName = "StatusReportSyncBuffer";
+    allocParamsForBufferLinear.bIsPersistent = false;
+    for (uint32_t i = 0; i < CODECHAL_ENCODE_STATUS_SYNC_NUM; i++)
+    {
+        CODECHAL_ENCODE_CHK_STATUS_MESSAGE_RETURN(
+            m_osInterface->pfnAllocateResource(
+                m_osInterface,
+                &allocParamsForBufferLinear,
+                &m_resStatusReportSync[i]),
+            "Failed to allocate Encode eStatus Sync Buffer.");
+
+        CODECHAL_ENCODE_CHK_STATUS_RETURN(
+            m_osInterface->pfnSkipResourceSync(
+            &m_resStatusReportSync[i]));
+    }
+
     if (m_pakEnabled)
     {
         m_stateHeapInterface->pfnSetCmdBufStatusPtr(m_stateHeapInterface, m_encodeStatusBuf.pData);
@@ -2148,6 +2166,16 @@ void CodechalEncoderState::FreeResources()
         m_encodeStatusBufRcs.pEncodeStatus = nullptr;
     }
 
+    for (uint32_t i = 0; i < CODECHAL_ENCODE_STATUS_SYNC_NUM; i++)
+    {
+        if (!Mos_ResourceIsNull(&m_resStatusReportSync[i]))
+        {
+            m_osInterface->pfnFreeResource(
+                m_osInterface,
+                &m_resStatusReportSync[i]);
+        }
+    }
+
     if (m_pakEnabled)
     {
         if (!Mos_ResourceIsNull(&m_resDeblockingFilterRowStoreScratchBuffer))
@@ -3184,6 +3212,8 @@ MOS_STATUS CodechalEncoderState::EndStatusReport(
         cmdBuffer,
         &storeDataParams));
 
+    CODECHAL_ENCODE_CHK_STATUS_RETURN(AddStatusReportSyncCmd(cmdBuffer));
+
     if (encFunctionType == CODECHAL_NUM_MEDIA_STATES && m_inlineEncodeStatusUpdate)
     {
         if (m_currPass < m_numPasses)
@@ -3210,6 +3240,35 @@ MOS_STATUS CodechalEncoderState::EndStatusReport(
     return eStatus;
 }
 
+MOS_STATUS CodechalEncoderState::AddStatusReportSyncCmd(
+    PMOS_COMMAND_BUFFER cmdBuffer)
+{
+    CODECHAL_ENCODE_FUNCTION_ENTER;
+
+    CODECHAL_ENCODE_CHK_NULL_RETURN(cmdBuffer);
+
+    uint32_t index = m_storeData % CODECHAL_ENCODE_STATUS_SYNC_NUM;
+    if (Mos_ResourceIsNull(&m_resStatusReportSync[index]))
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    // The write only makes the batch reference the buffer: waiting on the buffer
+    // then waits for the frame's latest batch on each engine and nothing later.
+    MHW_MI_STORE_DATA_PARAMS storeDataParams;
+    MOS_ZeroMemory(&storeDataParams, sizeof(storeDataParams));
+    storeDataParams.pOsResource      = &m_resStatusReportSync[index];
+    storeDataParams.dwResourceOffset = 0;
+    storeDataParams.dwValue          = m_storeData;
+    CODECHAL_ENCODE_CHK_STATUS_RETURN(m_miInterface->AddMiStoreDataImmCmd(
+        cmdBuffer,
+        &storeDataParams));
+
+    m_statusReportSyncData[index] = m_storeData;
+
+    return MOS_STATUS_SUCCESS;
+}
+
 //!
 //! \brief    Update m_storeData in offset 0 of statusReport.
 //! \details  Add conditonal encode status report to avoid of extra small batch buffer
@@ -3803,6 +3862,8 @@ MOS_STATUS CodechalEncoderState::ResetStatusReport()
             }
         }
 
+        CODECHAL_ENCODE_CHK_STATUS_RETURN(AddStatusReportSyncCmd(&cmdBuffer));
+
         CODECHAL_ENCODE_CHK_STATUS_RETURN(m_miInterface->AddMiBatchBufferEnd(
             &cmdBuffer,
             nullptr));
@@ -3921,6 +3982,46 @@ MOS_STATUS CodechalEncoderState::ReadCounterValue(uint16_t index, EncodeStatusRe
     return eStatus;
 }
 
+MOS_STATUS CodechalEncoderState::WaitForStatusReport(uint32_t timeOutMs)
+{
+    CODECHAL_ENCODE_FUNCTION_ENTER;
+
+    EncodeStatusBuffer* encodeStatusBuf = m_pakEnabled ? &m_encodeStatusBuf : &m_encodeStatusBufRcs;
+    CODECHAL_ENCODE_CHK_NULL_RETURN(encodeStatusBuf->pEncodeStatus);
+
+    if (m_osInterface->pfnWaitOnResourceTimeout == nullptr ||
+        encodeStatusBuf->wFirstIndex == encodeStatusBuf->wCurrIndex)
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    EncodeStatus* encodeStatus =
+        (EncodeStatus*)(encodeStatusBuf->pEncodeStatus +
+        encodeStatusBuf->wFirstIndex * encodeStatusBuf->dwReportSize);
+    uint32_t storeData = encodeStatus->dwStoredData;
+    uint32_t index     = storeData % CODECHAL_ENCODE_STATUS_SYNC_NUM;
+
+    // The buffer was reused by a later frame, or the frame's batches are already
+    // known to be idle and only polling can tell when the report lands
+    if (Mos_ResourceIsNull(&m_resStatusReportSync[index]) ||
+        m_statusReportSyncData[index] != storeData        ||
+        m_statusReportSyncWaited == storeData)
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    MOS_STATUS eStatus = m_osInterface->pfnWaitOnResourceTimeout(
+        m_osInterface,
+        &m_resStatusReportSync[index],
+        timeOutMs);
+    if (eStatus == MOS_STATUS_SUCCESS)
+    {
+        m_statusReportSyncWaited = storeData;
+    }
+
+    return eStatus;
+}
+
 //------------------------------------------------------------------------------
 //| Purpose:    Gets available eStatus report data
 //| Return:     N/A
@@ -129,6 +129,7 @@
 
 // Encode Sizes
 #define CODECHAL_ENCODE_STATUS_NUM                      512
+#define CODECHAL_ENCODE_STATUS_SYNC_NUM                 16
 #define CODECHAL_ENCODE_VME_BBUF_NUM                    2
 #define CODECHAL_ENCODE_MIN_SCALED_SURFACE_SIZE         48
 #define CODECHAL_ENCODE_BRC_PAK_STATISTICS_SIZE         64
@@ -1469,6 +1470,9 @@ public:
     bool                            m_statusQueryReportingEnabled = false;                            //!< Flag to indicate if we support eStatus query reporting on current Platform
     EncodeStatusBuffer              m_encodeStatusBuf = {};                         //!< Stores all the status_query related data for PAK engine
     EncodeStatusBuffer              m_encodeStatusBufRcs = {};                      //!< Stores all the status_query related data for render ring (RCS)
+    MOS_RESOURCE                    m_resStatusReportSync[CODECHAL_ENCODE_STATUS_SYNC_NUM] = {};   //!< Per frame buffers referenced by every batch that ends a status report
+    uint32_t                        m_statusReportSyncData[CODECHAL_ENCODE_STATUS_SYNC_NUM] = {};  //!< Stored data of the frame that last referenced each sync buffer
+    uint32_t                        m_statusReportSyncWaited = 0;                   //!< Stored data of the frame last waited on in WaitForStatusReport()
     MHW_VDBOX_IMAGE_STATUS_CONTROL  m_imgStatusControlBuffer;                       //!< Stores image eStatus control data
     uint32_t                        m_statusReportFeedbackNumber = 0;               //!< Status report feed back number
     bool                            m_frameTrackingEnabled = false;                 //!< Flag to indicate if we enable KMD frame tracking
@@ -1796,6 +1800,19 @@ public:
     //!
     MOS_STATUS GetStatusReport(void *status, uint16_t numStatus) override;
 
+    //!
+    //! \brief  Wait for the oldest outstanding status report
+    //! \details Sleeps until every batch of the frame that completes the oldest
+    //!         report has retired, so callers need not poll the status buffer.
+    //! \param  [in] timeOutMs
+    //!         Time out in ms
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS once the batches are done, MOS_STATUS_STILL_DRAWING on
+    //!         time out, MOS_STATUS_UNIMPLEMENTED if there is nothing to wait on and the
+    //!         caller has to fall back to polling
+    //!
+    MOS_STATUS WaitForStatusReport(uint32_t timeOutMs);
+
     //!
     //! \brief  Get Status Report for the common codec part
     //! \param  [out] encodeStatus
@@ -2062,6 +2079,16 @@ public:
         PMOS_COMMAND_BUFFER cmdBuffer,
         CODECHAL_MEDIA_STATE_TYPE encFunctionType);
 
+    //!
+    //! \brief  Reference the current frame's sync buffer from a batch
+    //! \param  [in, out] cmdBuffer
+    //!         cmdbuffer to send cmds
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS if success, else fail reason
+    //!
+    MOS_STATUS AddStatusReportSyncCmd(
+        PMOS_COMMAND_BUFFER cmdBuffer);
+
     //!
     //! \brief  Set Status Report Parameters
     //! \param  [in] currRefList
@@ -26,6 +26,8 @@ set(TMP_1_SOURCES_
     ${CMAKE_CURRENT_LIST_DIR}/codechal_mmc.cpp
     ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_config_manager.cpp
     ${CMAKE_CURRENT_LIST_DIR}/codechal_debug.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_compress.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_dump_writer.cpp
     ${CMAKE_CURRENT_LIST_DIR}/codechal_allocator.cpp
 )
 
@@ -37,6 +39,8 @@ set(TMP_1_HEADERS_
     ${CMAKE_CURRENT_LIST_DIR}/codechal_mmc.h
     ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_config_manager.h
     ${CMAKE_CURRENT_LIST_DIR}/codechal_debug.h
+    ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_compress.h
+    ${CMAKE_CURRENT_LIST_DIR}/codechal_debug_dump_writer.h
     ${CMAKE_CURRENT_LIST_DIR}/codechal_allocator.h
 )
 
@@ -71,6 +71,24 @@ bool FrameTrackerToken::IsExpired()
     return true;
 }
 
+MOS_STATUS FrameTrackerToken::Wait(uint32_t timeOutMs)
+{
+    if (m_producer == nullptr)
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    for (auto ite = m_holdTrackers.begin(); ite != m_holdTrackers.end(); ite ++)
+    {
+        MOS_STATUS status = m_producer->WaitForTracker(ite->first, ite->second, timeOutMs);
+        if (status != MOS_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+    return MOS_STATUS_SUCCESS;
+}
+
 void FrameTrackerToken::Merge(const FrameTrackerToken *token)
 {
     m_producer = token->m_producer;
@@ -192,3 +210,30 @@ int FrameTrackerProducer::AssignNewTracker()
         return -1;
     }
 }
+
+MOS_STATUS FrameTrackerProducer::WaitForTracker(uint32_t index, uint32_t tracker, uint32_t timeOutMs)
+{
+    CHK_INDEX(index);
+
+    if ((int)(tracker - *GetLatestTrackerAddress(index)) <= 0)
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    if (m_osInterface == nullptr ||
+        m_osInterface->pfnWaitOnResourceTimeout == nullptr ||
+        Mos_ResourceIsNull(&m_resource))
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    MOS_STATUS status = m_osInterface->pfnWaitOnResourceTimeout(m_osInterface, &m_resource, timeOutMs);
+    if (status != MOS_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    // The resource is idle, so a tracker still behind has not been submitted yet
+    return ((int)(tracker - *GetLatestTrackerAddress(index)) <= 0) ?
+        MOS_STATUS_SUCCESS : MOS_STATUS_UNIMPLEMENTED;
+}
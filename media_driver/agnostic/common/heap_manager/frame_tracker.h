@@ -125,6 +125,16 @@ public:
 
     inline void Clear() {m_holdTrackers.clear(); }
 
+    //!
+    //! \brief  Wait until the token expires
+    //! \param  [in] timeOutMs
+    //!         Time out in milliseconds
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS once expired, MOS_STATUS_STILL_DRAWING on time out,
+    //!         MOS_STATUS_UNIMPLEMENTED if the trackers cannot be waited on
+    //!
+    MOS_STATUS Wait(uint32_t timeOutMs);
+
 protected:
     FrameTrackerProducer *m_producer;
     std::map<uint32_t, uint32_t> m_holdTrackers;
@@ -153,6 +163,23 @@ public:
 
     inline uint32_t GetNextTracker(uint32_t index) { return m_counters[index];}
 
+    //!
+    //! \brief   Wait until the GPU has written a tracker value or a later one
+    //! \details Sleeps on the submissions that write the tracker resource instead of
+    //!          polling it. Those are all batches that advance any tracker, so the wait
+    //!          may last until the GPU catches up with the latest of them.
+    //! \param   [in] index
+    //!          Index of the tracker
+    //! \param   [in] tracker
+    //!          Tracker value to wait for
+    //! \param   [in] timeOutMs
+    //!          Time out in milliseconds
+    //! \return  MOS_STATUS
+    //!          MOS_STATUS_SUCCESS once reached, MOS_STATUS_STILL_DRAWING on time out,
+    //!          MOS_STATUS_UNIMPLEMENTED if there is nothing in flight to wait on
+    //!
+    MOS_STATUS WaitForTracker(uint32_t index, uint32_t tracker, uint32_t timeOutMs);
+
     inline MOS_STATUS StepForward(uint32_t index)
     {
         CHK_INDEX(index);
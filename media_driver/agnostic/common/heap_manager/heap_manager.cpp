@@ -216,16 +216,32 @@ MOS_STATUS HeapManager::Wait()
 {
     HEAP_FUNCTION_ENTER_VERBOSE;
 
-    bool blocksUpdated = false;
+    bool     blocksUpdated = false;
+    uint64_t freq = 0, start = 0, current = 0;
 
-    for (auto waitMs = m_waitTimeout; waitMs > 0; waitMs -= m_waitIncrement)
+    MOS_QueryPerformanceFrequency(&freq);
+    MOS_QueryPerformanceCounter(&start);
+
+    // The timeout counts the time actually waited, since the wait on the
+    // oldest submitted block may return well before a whole increment.
+    for (uint64_t waitedMs = 0; waitedMs < m_waitTimeout; )
     {
-        MOS_Sleep(m_waitIncrement);
+        // Sleep until the GPU is done with the oldest submitted block rather than
+        // for a whole increment, unless there is nothing to wait on.
+        uint32_t   waitMs     = (uint32_t)MOS_MIN(m_waitIncrement, m_waitTimeout - waitedMs);
+        MOS_STATUS waitStatus = m_blockManager.WaitForSubmittedBlock(waitMs);
+        if (waitStatus != MOS_STATUS_SUCCESS && waitStatus != MOS_STATUS_STILL_DRAWING)
+        {
+            MOS_Sleep(waitMs);
+        }
         HEAP_CHK_STATUS(m_blockManager.RefreshBlockStates(blocksUpdated));
         if (blocksUpdated)
         {
             break;
         }
+
+        MOS_QueryPerformanceCounter(&current);
+        waitedMs = freq ? (current - start) * 1000 / freq : waitedMs + waitMs;
     }
 
     return (blocksUpdated) ? MOS_STATUS_SUCCESS : MOS_STATUS_CLIENT_AR_NO_SPACE;
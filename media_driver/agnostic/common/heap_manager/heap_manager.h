@@ -200,9 +200,11 @@ private:
     void FreeHeap();
 
     //!
-    //! \brief  Wait for for space to be available in the heap
-    //! \return MOS_STATUS
-    //!         MOS_STATUS_SUCCESS if success, else fail reason
+    //! \brief   Wait for for space to be available in the heap
+    //! \details Blocks on the GPU work holding the oldest submitted block when the
+    //!          tracker producer allows it, otherwise sleeps in fixed increments.
+    //! \return  MOS_STATUS
+    //!          MOS_STATUS_SUCCESS if success, else fail reason
     //!
     MOS_STATUS Wait();
 
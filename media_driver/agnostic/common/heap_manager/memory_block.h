@@ -32,11 +32,17 @@
 #ifndef __MEMORY_BLOCK_H__
 #define __MEMORY_BLOCK_H__
 
+#include <map>
 #include <memory>
 #include <string>
 #include "heap.h"
 #include "frame_tracker.h"
 
+class MemoryBlockInternal;
+
+//! \brief Free blocks keyed by their size, used for best fit lookups
+typedef std::multimap<uint32_t, MemoryBlockInternal *> MemoryBlockSizeIndex;
+
 //! \brief   Describes a block of memory in a heap.
 //! \details For internal use by the MemoryBlockManager only.
 class MemoryBlockInternal
@@ -331,6 +337,8 @@ private:
     MemoryBlockInternal *m_stateNext = nullptr;
     //! \brief State type for the sorted list to which this block belongs, if between lists type is stateCount
     State m_stateListType = State::stateCount;
+    //! \brief Position in the free block size index, only valid while the block is in the free list
+    MemoryBlockSizeIndex::iterator m_sizeIndexPos;
 };
 
 //! \brief Describes a block of memory in a heap.
@@ -24,6 +24,7 @@
 //! \brief    Implements functionalities pertaining to the memory block manager
 //!
 
+#include <algorithm>
 #include "memory_block_manager.h"
 
 MemoryBlockManager::~MemoryBlockManager()
@@ -86,7 +87,8 @@ MOS_STATUS MemoryBlockManager::AcquireSpace(
     }
     if (m_sortedSizes.size() > 1)
     {
-        m_sortedSizes.sort([](SortedSizePair &a, SortedSizePair &b) { return a.m_blockSize > b.m_blockSize; });
+        std::stable_sort(m_sortedSizes.begin(), m_sortedSizes.end(),
+            [](const SortedSizePair &a, const SortedSizePair &b) { return a.m_blockSize > b.m_blockSize; });
     }
 
     if (m_sortedBlockListNumEntries[MemoryBlockInternal::submitted] > m_numSubmissionsForRefresh)
@@ -232,6 +234,33 @@ MOS_STATUS MemoryBlockManager::RefreshBlockStates(bool &blocksUpdated)
     return MOS_STATUS_SUCCESS;
 }
 
+MOS_STATUS MemoryBlockManager::WaitForSubmittedBlock(uint32_t timeOutMs)
+{
+    HEAP_FUNCTION_ENTER_VERBOSE;
+
+    // Only the producer trackers are backed by a resource the GPU writes
+    if (!m_useProducer || m_trackerProducer == nullptr)
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    // Submitted blocks are added at the head, the oldest one completes first
+    auto block = m_sortedBlockList[MemoryBlockInternal::State::submitted];
+    if (block == nullptr)
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+    while (block->m_stateNext != nullptr)
+    {
+        block = block->m_stateNext;
+    }
+
+    FrameTrackerToken *trackerToken = block->GetTrackerToken();
+    HEAP_CHK_NULL(trackerToken);
+
+    return trackerToken->Wait(timeOutMs);
+}
+
 MOS_STATUS MemoryBlockManager::RegisterHeap(uint32_t heapId, uint32_t size)
 {
     HEAP_FUNCTION_ENTER;
@@ -395,53 +424,56 @@ MOS_STATUS MemoryBlockManager::IsSpaceAvailable(
         }
     }
 
-    auto block = m_sortedBlockList[MemoryBlockInternal::State::free];
- 
+    // Replay the best fit placement of AllocateSpace() without modifying the index:
+    // blocks already used by a larger request are skipped, and what is left of them
+    // after the split is tracked on the side.
+    m_fitTakenBlocks.clear();
+    m_fitRemainders.clear();
     for (auto requestIterator = m_sortedSizes.begin();
         requestIterator != m_sortedSizes.end();
         ++requestIterator)
     {
-        if (block == nullptr)
+        uint32_t size = (*requestIterator).m_blockSize;
+
+        auto indexIterator = m_freeBlockIndex.lower_bound(size);
+        while (indexIterator != m_freeBlockIndex.end() &&
+            std::find(m_fitTakenBlocks.begin(), m_fitTakenBlocks.end(), indexIterator->second) != m_fitTakenBlocks.end())
         {
-            // There is no free space available, add up all requested sizes
-            spaceNeeded += (*requestIterator).m_blockSize;
+            ++indexIterator;
         }
-        else
+
+        auto remainderIterator = m_fitRemainders.end();
+        for (auto iterator = m_fitRemainders.begin(); iterator != m_fitRemainders.end(); ++iterator)
         {
-            // Determine whether or not there is space available
-            if ((*requestIterator).m_blockSize > block->GetSize())
+            if (*iterator >= size &&
+                (remainderIterator == m_fitRemainders.end() || *iterator < *remainderIterator))
             {
-                // The requested size is larger than the largest free block size
-                spaceNeeded += (*requestIterator).m_blockSize;
-                continue;
-            }
-            else
-            {
-                // determine if there is enough space in the heaps
-                auto freeBlockSize = block->GetSize();
-                while (requestIterator != m_sortedSizes.end())
-                {
-                    if ((*requestIterator).m_blockSize < freeBlockSize)
-                    {
-                        // if the aligned size fits within the current free block, consider it used
-                        freeBlockSize -= (*requestIterator).m_blockSize;
-                        ++requestIterator;
-                    }
-                    else
-                    {
-                        // if the aligned size does not fit within the curret free block, continue for loop
-                        break;
-                    }
-                }
-                if (requestIterator == m_sortedSizes.end())
-                {
-                    break;
-                }
+                remainderIterator = iterator;
             }
         }
-        if (block != nullptr)
+
+        uint32_t fitSize = 0;
+        if (indexIterator != m_freeBlockIndex.end() &&
+            (remainderIterator == m_fitRemainders.end() || indexIterator->first <= *remainderIterator))
+        {
+            fitSize = indexIterator->first;
+            m_fitTakenBlocks.push_back(indexIterator->second);
+        }
+        else if (remainderIterator != m_fitRemainders.end())
         {
-            block = block->m_stateNext;
+            fitSize = *remainderIterator;
+            m_fitRemainders.erase(remainderIterator);
+        }
+        else
+        {
+            // No free block is large enough for this request
+            spaceNeeded += size;
+            continue;
+        }
+
+        if (fitSize > size)
+        {
+            m_fitRemainders.push_back(fitSize - size);
         }
     }
 
@@ -475,51 +507,43 @@ MOS_STATUS MemoryBlockManager::AllocateSpace(
         requestIterator != m_sortedSizes.end();
         ++requestIterator)
     {
-        bool allocated = false;
-        auto block = m_sortedBlockList[MemoryBlockInternal::State::free];
-        while (block != nullptr)
+        // Best fit: the smallest free block that holds the request
+        auto indexIterator = m_freeBlockIndex.lower_bound((*requestIterator).m_blockSize);
+        if (indexIterator == m_freeBlockIndex.end())
         {
-            if (block->GetSize() >= (*requestIterator).m_blockSize)
-            {
-                auto heap = block->GetHeap();
-                HEAP_CHK_NULL(heap);
-                if (!m_useProducer)
-                {
-                    HEAP_CHK_STATUS(AllocateBlock(
-                        (*requestIterator).m_blockSize,
-                        params.m_trackerId,
-                        params.m_staticBlock,
-                        block));
-                }
-                else
-                {
-                    HEAP_CHK_STATUS(AllocateBlock(
-                        (*requestIterator).m_blockSize,
-                        params.m_trackerIndex,
-                        params.m_trackerId,
-                        params.m_staticBlock,
-                        block));
-                }
-                if ((*requestIterator).m_originalIdx >= m_sortedSizes.size())
-                {
-                    HEAP_ASSERTMESSAGE("Index is out of bounds");
-                    return MOS_STATUS_INVALID_PARAMETER;
-                }
-                HEAP_CHK_STATUS(blocks[(*requestIterator).m_originalIdx].CreateFromInternalBlock(
-                    block,
-                    heap,
-                    heap->m_keepLocked ? heap->m_lockedHeap : nullptr));
-                allocated = true;
-                break;
-            }
-            block = block->m_stateNext;
+            HEAP_ASSERTMESSAGE("No free block was found for the data! This should not occur.");
+            return MOS_STATUS_UNKNOWN;
         }
 
-        if (!allocated)
+        auto block = indexIterator->second;
+        auto heap = block->GetHeap();
+        HEAP_CHK_NULL(heap);
+        if (!m_useProducer)
         {
-            HEAP_ASSERTMESSAGE("No free block was found for the data! This should not occur.");
-            return MOS_STATUS_UNKNOWN;
+            HEAP_CHK_STATUS(AllocateBlock(
+                (*requestIterator).m_blockSize,
+                params.m_trackerId,
+                params.m_staticBlock,
+                block));
         }
+        else
+        {
+            HEAP_CHK_STATUS(AllocateBlock(
+                (*requestIterator).m_blockSize,
+                params.m_trackerIndex,
+                params.m_trackerId,
+                params.m_staticBlock,
+                block));
+        }
+        if ((*requestIterator).m_originalIdx >= m_sortedSizes.size())
+        {
+            HEAP_ASSERTMESSAGE("Index is out of bounds");
+            return MOS_STATUS_INVALID_PARAMETER;
+        }
+        HEAP_CHK_STATUS(blocks[(*requestIterator).m_originalIdx].CreateFromInternalBlock(
+            block,
+            heap,
+            heap->m_keepLocked ? heap->m_lockedHeap : nullptr));
     }
 
     return MOS_STATUS_SUCCESS;
@@ -641,48 +665,8 @@ MOS_STATUS MemoryBlockManager::AddBlockToSortedList(
     switch (state)
     {
         case MemoryBlockInternal::State::free:
-        {
-            bool inserted = false;
-            MemoryBlockInternal *prev = nullptr;
-            while (curr != nullptr)
-            {
-                if (curr->GetSize() <= block->GetSize())
-                {
-                    if (prev)
-                    {
-                        prev->m_stateNext = block;
-                    }
-                    else
-                    {
-                        m_sortedBlockList[state] = block;
-                    }
-                    curr->m_statePrev = block;
-                    block->m_statePrev = prev;
-                    block->m_stateNext = curr;
-                    inserted = true;
-                    break;
-                }
-                prev = curr;
-                curr = curr->m_stateNext;
-            }
-            if (!inserted)
-            {
-                if (prev == nullptr)
-                {
-                    block->m_stateNext = m_sortedBlockList[state];
-                    m_sortedBlockList[state] = block;
-                }
-                else
-                {
-                    block->m_statePrev = prev;
-                    prev->m_stateNext = block;
-                }
-            }
-            block->m_stateListType = state;
-            m_sortedBlockListNumEntries[state]++;
-            m_sortedBlockListSizes[state] += block->GetSize();
-            break;
-        }
+            block->m_sizeIndexPos = m_freeBlockIndex.insert(std::make_pair(block->GetSize(), block));
+            // fall through
         case MemoryBlockInternal::State::allocated:
         case MemoryBlockInternal::State::submitted:
         case MemoryBlockInternal::State::deleted:
@@ -729,6 +713,10 @@ MOS_STATUS MemoryBlockManager::RemoveBlockFromSortedList(
         case MemoryBlockInternal::State::submitted:
         case MemoryBlockInternal::State::deleted:
         {
+            if (state == MemoryBlockInternal::State::free)
+            {
+                m_freeBlockIndex.erase(block->m_sizeIndexPos);
+            }
             if (block->m_statePrev)
             {
                 block->m_statePrev->m_stateNext = block->m_stateNext;
@@ -119,6 +119,15 @@ protected:
     //!
     MOS_STATUS RefreshBlockStates(bool &blocksUpdated);
 
+    //! \brief   Waits until the oldest submitted block may be reclaimed
+    //! \param   [in] timeOutMs
+    //!          Time out in milliseconds
+    //! \return  MOS_STATUS
+    //!          MOS_STATUS_SUCCESS once the block's trackers are reached, MOS_STATUS_STILL_DRAWING
+    //!          on time out, MOS_STATUS_UNIMPLEMENTED if the caller has to poll instead
+    //!
+    MOS_STATUS WaitForSubmittedBlock(uint32_t timeOutMs);
+
     //!
     //! \brief  Stores heap and initializes memory blocks for future use.
     //! \param  [in] heapId
@@ -244,7 +253,8 @@ private:
 
     //!
     //! \brief  Determines whether or not space is available, if not enough space returns
-    //!         the amount short in \a spaceNeeded
+    //!         the amount short in \a spaceNeeded. Follows the same best fit placement
+    //!         as AllocateSpace().
     //! \param  [in] sortedSizes
     //!         Requested block sizes sorted in decending order.
     //! \param  [in] params
@@ -259,7 +269,8 @@ private:
         uint32_t &spaceNeeded);
 
     //!
-    //! \brief  Sets up memory blocks for the requested space
+    //! \brief  Sets up memory blocks for the requested space, each request is placed in
+    //!         the smallest free block that fits it
     //! \param  [in] sortedSizes
     //!         Requested block sizes sorted in decending order with original index saved from params.
     //! \param  [in] params
@@ -419,8 +430,11 @@ private:
     //! \brief List of block pools per heap for heaps in deletion process
     std::list<std::shared_ptr<HeapWithAdjacencyBlockList>> m_deletedHeaps;
     //! \brief Pools of memory blocks sorted by their states based on the state indicated
-    //!        by the latest TrackerId. The free pool is sorted in ascending order.
+    //!        by the latest TrackerId. Blocks are added at the head of each pool, ordering
+    //!        of free blocks by size is kept in \see m_freeBlockIndex.
     MemoryBlockInternal *m_sortedBlockList[MemoryBlockInternal::State::stateCount] = {nullptr};
+    //! \brief Free blocks indexed by size for O(log n) best fit lookups
+    MemoryBlockSizeIndex m_freeBlockIndex;
     //! \brief Number of entries in each sorted block list.
     uint32_t m_sortedBlockListNumEntries[MemoryBlockInternal::State::stateCount] = {0};
     //! \brief Sizes of each block pool.
@@ -440,7 +454,11 @@ private:
     bool m_lockHeapsOnAllocate = false;             //!< All heaps allocated with the keep locked flag.
     
     //! \brief Persistent storage for the sorted sizes used during AcquireSpace()
-    std::list<SortedSizePair> m_sortedSizes;
+    std::vector<SortedSizePair> m_sortedSizes;
+    //! \brief Persistent storage for the free blocks taken while IsSpaceAvailable() simulates the allocation
+    std::vector<MemoryBlockInternal *> m_fitTakenBlocks;
+    //! \brief Persistent storage for the split remainders while IsSpaceAvailable() simulates the allocation
+    std::vector<uint32_t> m_fitRemainders;
     //! \brief TrackerProducer
     FrameTrackerProducer *m_trackerProducer = nullptr;
     //! \bried Whether trackerProducer is set
@@ -22,6 +22,8 @@ set(TMP_SOURCES_
     ${CMAKE_CURRENT_LIST_DIR}/mos_context.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_graphicsresource.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_os.c
+    ${CMAKE_CURRENT_LIST_DIR}/mos_perf_records.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/mos_swizzle.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_debug.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_user_interface.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_utilities.cpp
@@ -41,8 +43,10 @@ set(TMP_HEADERS_
     ${CMAKE_CURRENT_LIST_DIR}/mos_os.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_os_hw.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_os_trace_event.h
+    ${CMAKE_CURRENT_LIST_DIR}/mos_perf_records.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_resource_defs.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_solo_generic.h
+    ${CMAKE_CURRENT_LIST_DIR}/mos_swizzle.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_debug.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_user_feature_keys.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_user_interface.h
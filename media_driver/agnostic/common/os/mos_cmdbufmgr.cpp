@@ -24,15 +24,38 @@
 //! \brief   Container class for the basic command buffer manager
 //!
 #include "mos_cmdbufmgr.h"
-#include <algorithm>
+#include <chrono>
+
+static uint64_t CmdBufMgrElapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
 
 CmdBufMgr::CmdBufMgr()
 {
     MOS_OS_FUNCTION_ENTER;
 
-    m_availableCmdBufPool.clear();
-    m_inUseCmdBufPool.clear();
-    m_initialized = false;
+    m_cmdBufTotalNum = 0;
+    for (uint32_t i = 0; i < m_maxNodeChunkNum; i++)
+    {
+        m_nodeChunks[i] = nullptr;
+    }
+    for (uint32_t i = 0; i < m_binNum; i++)
+    {
+        m_binHeads[i]    = 0;
+        m_binDepth[i]    = 0;
+        m_prewarmSize[i] = 0;
+    }
+    m_prewarmPending = false;
+    m_prewarmExit    = false;
+    m_pickups        = 0;
+    m_poolHits       = 0;
+    m_poolMisses     = 0;
+    m_prewarmAllocs  = 0;
+    m_pickupTimeNs   = 0;
+    m_missTimeNs     = 0;
+    m_initialized    = false;
 }
 
 CmdBufMgr::~CmdBufMgr()
@@ -46,44 +69,152 @@ CmdBufMgr* CmdBufMgr::GetObject()
     return MOS_New(CmdBufMgr);
 }
 
-MOS_STATUS CmdBufMgr::Initialize(OsContext *osContext, uint32_t cmdBufSize)
+uint32_t CmdBufMgr::GetBin(uint32_t size)
 {
-    MOS_STATUS eStatus = MOS_STATUS_SUCCESS;
+    uint32_t bin = 0;
+    while (size >>= 1)
+    {
+        bin++;
+    }
+    return bin;
+}
+
+void CmdBufMgr::PushNode(uint32_t bin, uint32_t index)
+{
+    PoolNode *node = GetNode(index);
+    uint64_t  head = m_binHeads[bin].load(std::memory_order_relaxed);
+    uint64_t  newHead;
+    do
+    {
+        node->next.store((uint32_t)head, std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | (uint64_t)(index + 1);
+    } while (!m_binHeads[bin].compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+
+    m_binDepth[bin]++;
+}
+
+uint32_t CmdBufMgr::PopNode(uint32_t bin)
+{
+    uint64_t head = m_binHeads[bin].load(std::memory_order_acquire);
+    uint64_t newHead;
+    do
+    {
+        uint32_t top = (uint32_t)head;
+        if (top == 0)
+        {
+            return m_invalidIndex;
+        }
+        // Entries are never freed while the pool is alive, the tag catches a concurrent pop and push
+        newHead = (((head >> 32) + 1) << 32) | (uint64_t)GetNode(top - 1)->next.load(std::memory_order_relaxed);
+    } while (!m_binHeads[bin].compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire));
+
+    m_binDepth[bin]--;
+    return (uint32_t)head - 1;
+}
+
+uint32_t CmdBufMgr::AddCmdBuf(uint32_t size, bool inUse)
+{
+    if (m_cmdBufTotalNum.load() >= m_maxPoolSize)
+    {
+        return m_invalidIndex;
+    }
+
+    // The command buffer is allocated before taking a pool entry, outside of any lock
+    auto cmdBuf = CommandBuffer::CreateCmdBuf();
+    if (cmdBuf == nullptr)
+    {
+        MOS_OS_ASSERTMESSAGE("input nullptr returned by CommandBuffer::CreateCmdBuf.");
+        return m_invalidIndex;
+    }
+
+    if (cmdBuf->Allocate(m_osContext, size) != MOS_STATUS_SUCCESS)
+    {
+        MOS_OS_ASSERTMESSAGE("Allocate CmdBuf failed");
+        cmdBuf->Free();
+        MOS_Delete(cmdBuf);
+        return m_invalidIndex;
+    }
+
+    uint32_t index = m_cmdBufTotalNum++;
+    if (index >= m_maxPoolSize)
+    {
+        cmdBuf->Free();
+        MOS_Delete(cmdBuf);
+        return m_invalidIndex;
+    }
+
+    uint32_t  chunkIdx = index / m_nodeChunkSize;
+    PoolNode *chunk    = m_nodeChunks[chunkIdx].load(std::memory_order_acquire);
+    if (chunk == nullptr)
+    {
+        PoolNode *newChunk = MOS_NewArray(PoolNode, m_nodeChunkSize);
+        if (newChunk == nullptr)
+        {
+            cmdBuf->Free();
+            MOS_Delete(cmdBuf);
+            return m_invalidIndex;
+        }
+        for (uint32_t i = 0; i < m_nodeChunkSize; i++)
+        {
+            newChunk[i].cmdBuf = nullptr;
+            newChunk[i].next   = 0;
+            newChunk[i].inUse  = false;
+        }
+        if (!m_nodeChunks[chunkIdx].compare_exchange_strong(chunk, newChunk))
+        {
+            // Another thread installed the chunk first
+            MOS_DeleteArray(newChunk);
+        }
+    }
 
+    PoolNode *node = GetNode(index);
+    node->inUse    = inUse;
+    cmdBuf->SetPoolIndex(index);
+    node->cmdBuf = cmdBuf;
+
+    if (!inUse)
+    {
+        PushNode(GetBin(cmdBuf->GetCmdBufSize()), index);
+    }
+
+    return index;
+}
+
+MOS_STATUS CmdBufMgr::Initialize(OsContext *osContext, uint32_t cmdBufSize)
+{
     MOS_OS_FUNCTION_ENTER;
     MOS_OS_CHK_NULL_RETURN(osContext);
 
     if (!m_initialized)
     {
-        m_osContext          = osContext;
-
-        m_inUsePoolMutex     = MOS_CreateMutex();
-        MOS_OS_CHK_NULL_RETURN(m_inUsePoolMutex);
-
-        m_availablePoolMutex = MOS_CreateMutex();
-        MOS_OS_CHK_NULL_RETURN(m_availablePoolMutex);
+        m_osContext = osContext;
 
         for (uint32_t i = 0; i < m_initBufNum; i++)
         {
-            auto cmdBuf = CommandBuffer::CreateCmdBuf();
-            if (cmdBuf == nullptr)
-            {
-                MOS_OS_ASSERTMESSAGE("input nullptr returned by CommandBuffer::CreateCmdBuf.");
-                return MOS_STATUS_INVALID_HANDLE;
-            }
-
-            eStatus = cmdBuf->Allocate(m_osContext, cmdBufSize);
-            if (eStatus != MOS_STATUS_SUCCESS)
+            if (AddCmdBuf(cmdBufSize, false) == m_invalidIndex)
             {
                 MOS_OS_ASSERTMESSAGE("Allocate CmdBuf#%d failed", i);
                 return MOS_STATUS_INVALID_HANDLE;
             }
+        }
 
-            MOS_LockMutex(m_availablePoolMutex);
-            m_availableCmdBufPool.push_back(cmdBuf);
-            MOS_UnlockMutex(m_availablePoolMutex);
-
-            m_cmdBufTotalNum++;
+        MOS_USER_FEATURE_VALUE_DATA userFeatureData;
+        MOS_ZeroMemory(&userFeatureData, sizeof(userFeatureData));
+        userFeatureData.u32Data = m_defaultPrewarmDepth;
+        MOS_UserFeature_ReadValue_ID(
+            nullptr,
+            __MEDIA_USER_FEATURE_VALUE_CMD_BUFFER_PREWARM_DEPTH_ID,
+            &userFeatureData,
+            nullptr);
+        m_prewarmDepth = userFeatureData.u32Data;
+
+        m_prewarmExit    = false;
+        m_prewarmPending = false;
+        if (m_prewarmDepth > 0)
+        {
+            m_prewarmSemaphore = MOS_CreateSemaphore(0, 1);
+            MOS_OS_CHK_NULL_RETURN(m_prewarmSemaphore);
+            m_prewarmThread = MOS_CreateThread((void *)PrewarmThread, this);
         }
 
         m_initialized = true;
@@ -98,50 +229,61 @@ void CmdBufMgr::CleanUp()
 
     if (m_initialized)
     {
-        CommandBuffer *cmdBuf = nullptr;
-        MOS_LockMutex(m_availablePoolMutex);
-    
-        for (auto& cmdBuf : m_availableCmdBufPool)
+        if (m_prewarmThread)
+        {
+            m_prewarmExit = true;
+            MOS_PostSemaphore(m_prewarmSemaphore, 1);
+            MOS_WaitThread(m_prewarmThread);
+            m_prewarmThread = 0;
+        }
+        MOS_DestroySemaphore(m_prewarmSemaphore);
+        m_prewarmSemaphore = nullptr;
+
+        Stats stats;
+        GetStats(stats);
+        MOS_OS_NORMALMESSAGE("cmd buf pool: %llu pickups, %llu hits, %llu misses, %llu pre-warmed, %llu ns picking up, %llu ns in misses",
+            (unsigned long long)stats.pickups,
+            (unsigned long long)stats.poolHits,
+            (unsigned long long)stats.poolMisses,
+            (unsigned long long)stats.prewarmAllocs,
+            (unsigned long long)stats.pickupTimeNs,
+            (unsigned long long)stats.missTimeNs);
+
+        uint32_t totalNum = MOS_MIN(m_cmdBufTotalNum.load(), m_maxPoolSize);
+        for (uint32_t i = 0; i < totalNum; i++)
         {
-            if (cmdBuf != nullptr)
+            PoolNode *chunk = m_nodeChunks[i / m_nodeChunkSize].load();
+            if (chunk == nullptr || chunk[i % m_nodeChunkSize].cmdBuf == nullptr)
             {
-                cmdBuf->Free();
-                MOS_Delete(cmdBuf);
+                continue;
             }
-            else
+
+            PoolNode *node = &chunk[i % m_nodeChunkSize];
+            if (node->inUse)
             {
-                MOS_OS_ASSERTMESSAGE("Unexpected, found null command buffer!");
+                MOS_OS_ASSERTMESSAGE("Unexpected, command buffer is still in use!");
             }
+            node->cmdBuf->Free();
+            MOS_Delete(node->cmdBuf);
         }
-    
-        // clear available command buffer pool
-        m_availableCmdBufPool.clear();
-        MOS_UnlockMutex(m_availablePoolMutex);
-        MOS_LockMutex(m_inUsePoolMutex);
-    
-        if (!m_inUseCmdBufPool.empty())
+
+        for (uint32_t i = 0; i < m_maxNodeChunkNum; i++)
         {
-            MOS_OS_ASSERTMESSAGE("Unexpected, inUseCmdBufPool is not empty!");
-            for (auto& cmdBuf : m_inUseCmdBufPool)
+            PoolNode *chunk = m_nodeChunks[i].exchange(nullptr);
+            if (chunk)
             {
-                if (cmdBuf != nullptr)
-                {
-                    cmdBuf->Free();
-                    MOS_Delete(cmdBuf);
-                }
+                MOS_DeleteArray(chunk);
             }
         }
-    
-        // clear in-use command buffer pool
-        m_inUseCmdBufPool.clear();
-        MOS_UnlockMutex(m_inUsePoolMutex);
-    
+        for (uint32_t i = 0; i < m_binNum; i++)
+        {
+            m_binHeads[i]    = 0;
+            m_binDepth[i]    = 0;
+            m_prewarmSize[i] = 0;
+        }
+
         m_cmdBufTotalNum = 0;
         m_initialized    = false;
-        MOS_DestroyMutex(m_inUsePoolMutex);
-        m_inUsePoolMutex = nullptr;
-        MOS_DestroyMutex(m_availablePoolMutex);
-        m_availablePoolMutex = nullptr;
     }
 }
 
@@ -155,127 +297,61 @@ CommandBuffer *CmdBufMgr::PickupOneCmdBuf(uint32_t size)
         return nullptr;
     }
 
-    // lock for both in-use and available command buffer pool before pick up
-    MOS_LockMutex(m_inUsePoolMutex);
-    MOS_LockMutex(m_availablePoolMutex);
-
-    CommandBuffer* cmdBuf = nullptr;
-    CommandBuffer* retbuf  = nullptr;
-    MOS_STATUS     eStatus = MOS_STATUS_SUCCESS;
+    auto start = std::chrono::steady_clock::now();
+    m_pickups++;
 
-    if (!m_availableCmdBufPool.empty())
+    uint32_t requestBin = GetBin(size);
+    for (uint32_t bin = requestBin; bin < m_binNum; bin++)
     {
-        cmdBuf = *(m_availableCmdBufPool.begin());
-        if (cmdBuf == nullptr)
+        uint32_t index = PopNode(bin);
+        if (index == m_invalidIndex)
         {
-            MOS_OS_ASSERTMESSAGE("available command buf pool is null.");
-            MOS_UnlockMutex(m_inUsePoolMutex);
-            MOS_UnlockMutex(m_availablePoolMutex);
-            return nullptr;
+            continue;
         }
 
-        // find available buf
-        if (size <= cmdBuf->GetCmdBufSize())
+        PoolNode *node = GetNode(index);
+        // Only the bin of the request itself may hold smaller buffers
+        if (node->cmdBuf->GetCmdBufSize() < size)
         {
-            m_inUseCmdBufPool.push_back(cmdBuf);
-
-            m_availableCmdBufPool.erase(m_availableCmdBufPool.begin());
-
-            MOS_OS_VERBOSEMESSAGE("successfully get available buf from pool");
+            PushNode(bin, index);
+            continue;
         }
-        // available buf  is not large enough, need reallocate
-        else
-        {
-            MOS_OS_VERBOSEMESSAGE("find available buf, but is not large enough");
 
-            cmdBuf = CommandBuffer::CreateCmdBuf();
-            if (cmdBuf == nullptr)
-            {
-                MOS_OS_ASSERTMESSAGE("input nullptr returned by CommandBuffer::CreateCmdBuf.");
-            }
-            else
-            {
-                eStatus = cmdBuf->Allocate(m_osContext, size);
-                if (eStatus != MOS_STATUS_SUCCESS)
-                {
-                    MOS_OS_ASSERTMESSAGE("Allocate CmdBuf failed");
-                }
+        node->inUse = true;
+        m_poolHits++;
+        RequestPrewarm(requestBin, size);
 
-                // directly push into inuse pool
-                m_inUseCmdBufPool.push_back(cmdBuf);
-                m_cmdBufTotalNum++;
-            }
-        }
+        MOS_OS_VERBOSEMESSAGE("successfully get available buf from pool");
+        m_pickupTimeNs += CmdBufMgrElapsedNs(start);
+        return node->cmdBuf;
+    }
+
+    MOS_OS_VERBOSEMESSAGE("No available cmd buf in the pool large enough");
 
-        retbuf = cmdBuf;
+    CommandBuffer *cmdBuf = nullptr;
+    uint32_t       index  = AddCmdBuf(size, true);
+    if (index == m_invalidIndex)
+    {
+        MOS_OS_ASSERTMESSAGE("No availabe cmd buf in pool and allocating a new one failed.");
     }
-    // no available buf in the pool, will allocate in batch
     else
     {
-        MOS_OS_VERBOSEMESSAGE("No more cmd buf in the pool");
-
-        if (m_cmdBufTotalNum < m_maxPoolSize)
-        {
-            MOS_OS_VERBOSEMESSAGE("Increase the cmd buf pool size by %d", m_bufIncStepSize);
-            for (uint32_t i = 0; i < m_bufIncStepSize; i++)
-            {
-                cmdBuf = CommandBuffer::CreateCmdBuf();
-                if (cmdBuf == nullptr)
-                {
-                    MOS_OS_ASSERTMESSAGE("input nullptr returned by CommandBuffer::CreateCmdBuf.");
-                    continue;
-                }
-
-                eStatus = cmdBuf->Allocate(m_osContext, size);
-                if (eStatus != MOS_STATUS_SUCCESS)
-                {
-                    MOS_OS_ASSERTMESSAGE("Allocate CmdBuf#%d failed", i);
-                    cmdBuf->Free();
-                    MOS_Delete(cmdBuf);
-                    continue;
-                }
-
-                if (i == 0)
-                {
-                    // directly push into inuse pool
-                    m_inUseCmdBufPool.push_back(cmdBuf);
-                    retbuf = cmdBuf;
-                }
-                else
-                {
-                    m_availableCmdBufPool.insert(m_availableCmdBufPool.begin(), cmdBuf);
-                }
-                m_cmdBufTotalNum++;
-            }
-            // sort by decent order
-            std::sort(m_availableCmdBufPool.begin(), m_availableCmdBufPool.end(), &CmdBufMgr::GreaterSizeSort);
-        }
-        else
-        {
-            MOS_OS_ASSERTMESSAGE("No availabe cmd buf in pool and the total buf num hit the ceiling, may need wait for a while.");
-            retbuf = nullptr;
-        }
+        cmdBuf = GetNode(index)->cmdBuf;
+        m_poolMisses++;
+        RequestPrewarm(requestBin, size);
     }
 
-    // unlock after got return buffer
-    MOS_UnlockMutex(m_inUsePoolMutex);
-    MOS_UnlockMutex(m_availablePoolMutex);
+    uint64_t elapsed = CmdBufMgrElapsedNs(start);
+    m_missTimeNs   += elapsed;
+    m_pickupTimeNs += elapsed;
 
-    return retbuf;
-}
-
-void CmdBufMgr::UpperInsert(CommandBuffer *cmdBuf)
-{
-    auto it = std::find_if(m_availableCmdBufPool.begin(), m_availableCmdBufPool.end(), [=](CommandBuffer * p1){return p1->GetCmdBufSize() < cmdBuf->GetCmdBufSize();});
-    m_availableCmdBufPool.emplace(it, cmdBuf);
+    return cmdBuf;
 }
 
 MOS_STATUS CmdBufMgr::ReleaseCmdBuf(CommandBuffer *cmdBuf)
 {
     MOS_OS_FUNCTION_ENTER;
 
-    MOS_STATUS     eStatus = MOS_STATUS_SUCCESS;
-
     if (!m_initialized)
     {
         MOS_OS_ASSERTMESSAGE("cmd buf pool need be initialized before buffer release!");
@@ -284,36 +360,18 @@ MOS_STATUS CmdBufMgr::ReleaseCmdBuf(CommandBuffer *cmdBuf)
 
     MOS_OS_CHK_NULL_RETURN(cmdBuf);
 
-    // lock for both in-use and available command buffer pool before release
-    MOS_LockMutex(m_inUsePoolMutex);
-    MOS_LockMutex(m_availablePoolMutex);
-
-    bool           found = false;
-    for (auto iter = m_inUseCmdBufPool.begin(); iter != m_inUseCmdBufPool.end(); iter++)
-    {
-        if (cmdBuf == *iter)
-        {
-            found = true;
-            m_inUseCmdBufPool.erase(iter);
-            break;
-        }
-    }
-
-    if (!found)
+    uint32_t index = cmdBuf->GetPoolIndex();
+    if (index >= MOS_MIN(m_cmdBufTotalNum.load(), m_maxPoolSize) ||
+        GetNode(index)->cmdBuf != cmdBuf ||
+        !GetNode(index)->inUse.exchange(false))
     {
         MOS_OS_ASSERTMESSAGE("Cannot find the specified cmdbuf in inusepool, sth must be wrong!");
-        eStatus = MOS_STATUS_UNKNOWN;
-    }
-    else
-    {
-        UpperInsert(cmdBuf);
+        return MOS_STATUS_UNKNOWN;
     }
 
-    // unlock after release buffer
-    MOS_UnlockMutex(m_inUsePoolMutex);
-    MOS_UnlockMutex(m_availablePoolMutex);
+    PushNode(GetBin(cmdBuf->GetCmdBufSize()), index);
 
-    return eStatus;
+    return MOS_STATUS_SUCCESS;
 }
 
 MOS_STATUS CmdBufMgr::ResizeOneCmdBuf(CommandBuffer *cmdBufToResize, uint32_t newSize)
@@ -330,3 +388,66 @@ MOS_STATUS CmdBufMgr::ResizeOneCmdBuf(CommandBuffer *cmdBufToResize, uint32_t ne
 
     return cmdBufToResize->ReSize(newSize);
 }
+
+void CmdBufMgr::GetStats(Stats &stats)
+{
+    stats.pickups       = m_pickups.load();
+    stats.poolHits      = m_poolHits.load();
+    stats.poolMisses    = m_poolMisses.load();
+    stats.prewarmAllocs = m_prewarmAllocs.load();
+    stats.pickupTimeNs  = m_pickupTimeNs.load();
+    stats.missTimeNs    = m_missTimeNs.load();
+}
+
+void CmdBufMgr::RequestPrewarm(uint32_t bin, uint32_t size)
+{
+    // Pre-warm with the largest size requested from the bin so refilled buffers fit every request
+    uint32_t prewarmSize = m_prewarmSize[bin].load(std::memory_order_relaxed);
+    while (prewarmSize < size &&
+           !m_prewarmSize[bin].compare_exchange_weak(prewarmSize, size, std::memory_order_relaxed))
+    {
+    }
+
+    if (m_prewarmSemaphore != nullptr &&
+        m_binDepth[bin].load(std::memory_order_relaxed) < (int32_t)m_prewarmDepth &&
+        !m_prewarmPending.exchange(true))
+    {
+        MOS_PostSemaphore(m_prewarmSemaphore, 1);
+    }
+}
+
+void *CmdBufMgr::PrewarmThread(void *data)
+{
+    CmdBufMgr *cmdBufMgr = (CmdBufMgr *)data;
+    if (cmdBufMgr == nullptr)
+    {
+        return nullptr;
+    }
+
+    while (MOS_WaitSemaphore(cmdBufMgr->m_prewarmSemaphore, INFINITE) == MOS_STATUS_SUCCESS &&
+           !cmdBufMgr->m_prewarmExit)
+    {
+        cmdBufMgr->m_prewarmPending = false;
+
+        for (uint32_t bin = 0; bin < m_binNum && !cmdBufMgr->m_prewarmExit; bin++)
+        {
+            uint32_t size = cmdBufMgr->m_prewarmSize[bin].load(std::memory_order_relaxed);
+            if (size == 0)
+            {
+                continue;
+            }
+
+            while (cmdBufMgr->m_binDepth[bin].load(std::memory_order_relaxed) < (int32_t)cmdBufMgr->m_prewarmDepth &&
+                   !cmdBufMgr->m_prewarmExit)
+            {
+                if (cmdBufMgr->AddCmdBuf(size, false) == m_invalidIndex)
+                {
+                    break;
+                }
+                cmdBufMgr->m_prewarmAllocs++;
+            }
+        }
+    }
+
+    return nullptr;
+}
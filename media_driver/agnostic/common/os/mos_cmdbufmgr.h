@@ -27,16 +27,35 @@
 #ifndef __COMMAND_BUFFER_MANAGER_H__
 #define __COMMAND_BUFFER_MANAGER_H__
 
+#include <atomic>
 #include "mos_os.h"
 #include "mos_commandbuffer.h"
 #include "mos_gpucontextmgr.h"
 
 //!
 //! \class  CmdBufMgr
+//! \brief  Pool of command buffers shared by the gpu contexts of a media context
+//! \details Available command buffers are kept in lock free stacks, one per power of 2
+//!          size bin. Command buffers are allocated outside of any lock, and a background
+//!          thread refills the bins in use to m_prewarmDepth buffers, read from the
+//!          "Cmd Buffer Prewarm Depth" user feature key.
 //!
 class CmdBufMgr
 {
 public:
+    //!
+    //! \brief  Pool statistics
+    //!
+    struct Stats
+    {
+        uint64_t pickups;          //!< Calls to PickupOneCmdBuf()
+        uint64_t poolHits;         //!< Pickups served from the available pool
+        uint64_t poolMisses;       //!< Pickups which allocated a command buffer
+        uint64_t prewarmAllocs;    //!< Command buffers allocated by the pre-warm thread
+        uint64_t pickupTimeNs;     //!< Total time spent in PickupOneCmdBuf()
+        uint64_t missTimeNs;       //!< Part of pickupTimeNs spent allocating on misses
+    };
+
     //!
     //! \brief  Constructor
     //!
@@ -57,6 +76,7 @@ public:
     //!
     //! \brief    Initialize comamnd buffer manager object
     //! \details  This function mainly create initial cmd buffer as input size
+    //!           and starts the pre-warm thread
     //! \param    [in] osContext
     //!           Pointer to the osContext handle
     //! \param    [in] cmdBufSize
@@ -68,24 +88,20 @@ public:
 
     //!
     //! \brief    Clean up the command buffer manager
-    //! \details  This function mainly celar all allocated comamnd buffer in 
-    //!           available pool and in use pool
+    //! \details  This function stops the pre-warm thread and frees all allocated
+    //!           command buffers, available or in use
     //!
     void CleanUp();
 
     //!
-    //! \brief    Clean up the command buffer manager
-    //! \details  This function will pick up one proper command buffer from 
-    //!           available pool, internal logic in below 3 conditions:
-    //!           1: if available pool has command buffer and its size bigger than
-    //!              required, directly put it into in use pool and return;
-    //!           2: if available pool has command buffer but size smaller than
-    //!              required, only create one command buffer as reqired and put
-    //!              it to in  use pool directly;
-    //!           3: if available pool is empty, will re-allocate bunch of command
-    //!              buffers, buffer number base on m_initBufNum, buffer size
-    //!              base on input required size. After re-allocate, put first buf
-    //!              into inuse pool, remains push to available pool.
+    //! \brief    Pick up one command buffer
+    //! \details  This function will pick up one proper command buffer from
+    //!           available pool, internal logic in below 2 conditions:
+    //!           1: if a bin at or above the size bin of the request has a command
+    //!              buffer large enough, mark it in use and return it;
+    //!           2: otherwise allocate one command buffer of the required size, and
+    //!              let the pre-warm thread refill the bin for the next requests.
+    //!           Safe to call from several threads, no lock is taken.
     //! \param    [in] size
     //!           Required command buffer size
     //! \return   CommandBuffer*
@@ -93,22 +109,12 @@ public:
     //!
     CommandBuffer *PickupOneCmdBuf(uint32_t size);
 
-    //!
-    //! \brief    insert the command buffer into available pool in proper location.
-    //! \details  This function will find a the first cmd buffer which equal or  
-    //!           small cmd buf size in available pool, and then insert it.
-    //! \param    [in] cmdBuf
-    //!           command buffer to be released
-    //!
-    void UpperInsert(CommandBuffer *cmdBuf);
-
     //!
     //! \brief    Release command buffer from in-use status to standby status
-    //! \details  This function designed for situations which need retire or 
-    //!           discard in use command buffer, it directly erase command buf
-    //!           from in use pool and push it to available pool. If the command
-    //!           buffer cannot be found inside in-use pool, some thing must be 
-    //!           wrong.
+    //! \details  This function designed for situations which need retire or
+    //!           discard in use command buffer, it pushes the command buffer back
+    //!           to the bin of its size. If the command buffer is not in use,
+    //!           some thing must be wrong.
     //! \param    [in] cmdBuf
     //!           Command buffer need to be released
     //! \return   MOS_STATUS
@@ -137,46 +143,127 @@ public:
         return m_initialized;
     }
 
+    //!
+    //! \brief    Get pool statistics
+    //! \param    [out] stats
+    //!           Current statistics
+    //!
+    void GetStats(Stats &stats);
+
 private:
+    //! \brief   Pool entry of a command buffer, entries are never freed before CleanUp()
+    struct PoolNode
+    {
+        CommandBuffer         *cmdBuf;  //!< Command buffer, nullptr if the entry is not set up yet
+        std::atomic<uint32_t>  next;    //!< Next entry + 1 in the bin stack, 0 for none
+        std::atomic<bool>      inUse;   //!< Command buffer is picked up
+    };
+
     //!
-    //! \brief    Self define compare method as std:sort input 
-    //! \detail   Command buffer size will be compared 
-    //! \param    [in] a
-    //!           Input command buffer to be compared
-    //! \param    [in] b
-    //!           Input command buffer to be compared
-    //! \return   bool
-    //!           true if a size bigger than b, otherwise false
+    //! \brief    Get the size bin of a command buffer size, floor(log2(size))
+    //!
+    static uint32_t GetBin(uint32_t size);
+
+    //!
+    //! \brief    Get pool entry by index, the entry must have been added
     //!
-    static bool GreaterSizeSort(CommandBuffer *a, CommandBuffer *b)
+    PoolNode *GetNode(uint32_t index)
     {
-        return (a->GetCmdBufSize() > b->GetCmdBufSize());
+        return &m_nodeChunks[index / m_nodeChunkSize].load(std::memory_order_acquire)[index % m_nodeChunkSize];
     }
 
+    //!
+    //! \brief    Allocate a command buffer and add it to the pool
+    //! \param    [in] size
+    //!           Command buffer size
+    //! \param    [in] inUse
+    //!           Add as picked up rather than as available
+    //! \return   uint32_t
+    //!           Pool index of the command buffer, m_invalidIndex if failed
+    //!
+    uint32_t AddCmdBuf(uint32_t size, bool inUse);
+
+    //!
+    //! \brief    Push an available pool entry to its bin
+    //!
+    void PushNode(uint32_t bin, uint32_t index);
+
+    //!
+    //! \brief    Pop an available pool entry from a bin
+    //! \return   uint32_t
+    //!           Pool index, m_invalidIndex if the bin is empty
+    //!
+    uint32_t PopNode(uint32_t bin);
+
+    //!
+    //! \brief    Ask the pre-warm thread to refill a bin with command buffers of at least size
+    //!
+    void RequestPrewarm(uint32_t bin, uint32_t size);
+
+    //!
+    //! \brief    Pre-warm thread entry
+    //!
+    static void *PrewarmThread(void *data);
+
     //! \brief   Max comamnd buffer number for per manager, including all
     //!          command buffer in availble pool and in-use pool
     constexpr static uint32_t m_maxPoolSize = 1098304;
 
-    //! \brief   Current command buffer number in available and in-use pool
-    uint32_t m_cmdBufTotalNum = 0;
+    //! \brief   Number of pool entries allocated at once
+    constexpr static uint32_t m_nodeChunkSize = 1024;
 
-    //! \brief   Command buffer number when bunch of re-allocate
-    constexpr static uint32_t m_bufIncStepSize = 8;
+    //! \brief   Number of pool entry chunks needed for m_maxPoolSize entries
+    constexpr static uint32_t m_maxNodeChunkNum = (m_maxPoolSize + m_nodeChunkSize - 1) / m_nodeChunkSize;
+
+    //! \brief   Number of size bins, one per bit of the size
+    constexpr static uint32_t m_binNum = 32;
+
+    //! \brief   Default of m_prewarmDepth
+    constexpr static uint32_t m_defaultPrewarmDepth = 8;
 
     //! \brief   Initial command buffer number
     constexpr static uint32_t m_initBufNum = 32;
 
-    //! \brief   Sorted List of available command buffer pool
-    std::vector<CommandBuffer *> m_availableCmdBufPool;
+    //! \brief   Invalid pool index
+    constexpr static uint32_t m_invalidIndex = 0xFFFFFFFF;
+
+    //! \brief   Current command buffer number in available and in-use pool
+    std::atomic<uint32_t> m_cmdBufTotalNum;
+
+    //! \brief   Pool entries in chunks of m_nodeChunkSize
+    std::atomic<PoolNode *> m_nodeChunks[m_maxNodeChunkNum];
+
+    //! \brief   Stack head per bin, entry index + 1 in the low 32 bits and an ABA tag in the high 32 bits
+    std::atomic<uint64_t> m_binHeads[m_binNum];
+
+    //! \brief   Number of available command buffers per bin
+    std::atomic<int32_t> m_binDepth[m_binNum];
+
+    //! \brief   Command buffer size the pre-warm thread allocates per bin, 0 if the bin is not in use
+    std::atomic<uint32_t> m_prewarmSize[m_binNum];
+
+    //! \brief   Available command buffers the pre-warm thread keeps in a bin in use, 0 disables it
+    uint32_t m_prewarmDepth = m_defaultPrewarmDepth;
+
+    //! \brief   Pre-warm thread handle
+    MOS_THREADHANDLE m_prewarmThread = 0;
+
+    //! \brief   Semaphore waking up the pre-warm thread
+    PMOS_SEMAPHORE m_prewarmSemaphore = nullptr;
 
-    //! \brief   Mutex for available command buffer pool
-    PMOS_MUTEX m_availablePoolMutex = nullptr;
+    //! \brief   Pre-warm thread has been woken up and not started the refill yet
+    std::atomic<bool> m_prewarmPending;
 
-    //! \brief   List of in used command buffer pool
-    std::vector<CommandBuffer *> m_inUseCmdBufPool;
+    //! \brief   Pre-warm thread should exit
+    std::atomic<bool> m_prewarmExit;
 
-    //! \brief   Mutex for in-use command buffer pool
-    PMOS_MUTEX m_inUsePoolMutex = nullptr;
+    //! \brief   Statistics counters, see Stats
+    std::atomic<uint64_t> m_pickups;
+    std::atomic<uint64_t> m_poolHits;
+    std::atomic<uint64_t> m_poolMisses;
+    std::atomic<uint64_t> m_prewarmAllocs;
+    std::atomic<uint64_t> m_pickupTimeNs;
+    std::atomic<uint64_t> m_missTimeNs;
 
     //! \brief   Flag to indicate cmd buf mgr initialized or not
     bool m_initialized = false;
@@ -122,6 +122,19 @@ public:
     //!
     uint8_t* GetLockAddr() { return m_lockAddr; }
 
+    //!
+    //! \brief    Get the index of the command buffer in its command buffer manager
+    //! \return   uint32_t
+    //!           Pool index, 0xFFFFFFFF if not managed by a pool
+    //!
+    uint32_t GetPoolIndex() { return m_poolIndex; }
+
+    //!
+    //! \brief    Set the index of the command buffer in its command buffer manager
+    //! \params   [in] poolIndex
+    //!
+    void SetPoolIndex(uint32_t poolIndex) { m_poolIndex = poolIndex; }
+
 protected:
     //!
     //! \brief    Set ready to use
@@ -146,5 +159,8 @@ protected:
 
     //! \brief    Command buffer size
     uint32_t          m_size             = 0;
+
+    //! \brief    Index in the command buffer manager pool
+    uint32_t          m_poolIndex        = 0xFFFFFFFF;
 };
 #endif // __MOS_COMMANDBUFFER_H__
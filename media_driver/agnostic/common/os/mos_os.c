@@ -36,12 +36,13 @@
 
 PerfUtility* g_perfutility = PerfUtility::getInstance();
 
-AutoPerfUtility::AutoPerfUtility(std::string tag, std::string comp, std::string level)
+AutoPerfUtility::AutoPerfUtility(const char *tag, const char *comp, const char *level)
 {
     if (PERFUTILITY_IS_ENABLED(comp, level))
     {
-        g_perfutility->startTick(tag);
-        autotag = tag;
+        // The tag may be a temporary, keep only its id
+        tagId = g_perfutility->getTagId(tag);
+        g_perfutility->startTick(tagId);
         bEnable = true;
     }
 }
@@ -50,7 +51,7 @@ AutoPerfUtility::~AutoPerfUtility()
 {
     if (bEnable)
     {
-        g_perfutility->stopTick(autotag);
+        g_perfutility->stopTick(tagId);
     }
 }
 
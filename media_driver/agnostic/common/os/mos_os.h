@@ -27,6 +27,7 @@
 #ifndef __MOS_OS_H__
 #define __MOS_OS_H__
 
+#include <string.h>
 #include "mos_defs.h"
 #include "media_skuwa_specific.h"
 #include "mos_utilities.h"
@@ -64,22 +65,33 @@ extern PerfUtility *g_perfutility;
 #define MOS_DDI    (1 << 16)
 #define MOS_HAL    (1 << 17)
 
-#define PERFUTILITY_IS_ENABLED(sCOMP,sLEVEL)                                                              \
-    (((sCOMP == "DECODE" && sLEVEL == "DDI") && (g_perfutility->dwPerfUtilityIsEnabled & DECODE_DDI)) ||  \
-     ((sCOMP == "DECODE" && sLEVEL == "HAL") && (g_perfutility->dwPerfUtilityIsEnabled & DECODE_HAL)) ||  \
-     ((sCOMP == "ENCODE" && sLEVEL == "DDI") && (g_perfutility->dwPerfUtilityIsEnabled & ENCODE_DDI)) ||  \
-     ((sCOMP == "ENCODE" && sLEVEL == "HAL") && (g_perfutility->dwPerfUtilityIsEnabled & ENCODE_HAL)) ||  \
-     ((sCOMP == "VP" && sLEVEL == "DDI") && (g_perfutility->dwPerfUtilityIsEnabled & VP_DDI)) ||          \
-     ((sCOMP == "VP" && sLEVEL == "HAL") && (g_perfutility->dwPerfUtilityIsEnabled & VP_HAL)) ||          \
-     ((sCOMP == "CP" && sLEVEL == "DDI") && (g_perfutility->dwPerfUtilityIsEnabled & CP_DDI)) ||          \
-     ((sCOMP == "CP" && sLEVEL == "HAL") && (g_perfutility->dwPerfUtilityIsEnabled & CP_HAL)) ||          \
-     ((sCOMP == "MOS" && sLEVEL == "DDI") && (g_perfutility->dwPerfUtilityIsEnabled & MOS_DDI)) ||        \
-     ((sCOMP == "MOS" && sLEVEL == "HAL") && (g_perfutility->dwPerfUtilityIsEnabled & MOS_HAL)))
+//!
+//! \brief    Get the enable bit of a component and level, 0 if unknown
+//!
+static inline int32_t PerfUtilityEnableBit(const char *comp, const char *level)
+{
+    int32_t shift = !strcmp(comp, PERF_DECODE) ? 0  :
+                    !strcmp(comp, PERF_ENCODE) ? 4  :
+                    !strcmp(comp, PERF_VP)     ? 8  :
+                    !strcmp(comp, PERF_CP)     ? 12 :
+                    !strcmp(comp, PERF_MOS)    ? 16 : -1;
+    if (shift < 0)
+    {
+        return 0;
+    }
+    return (!strcmp(level, PERF_LEVEL_DDI) ? DECODE_DDI :
+            !strcmp(level, PERF_LEVEL_HAL) ? DECODE_HAL : 0) << shift;
+}
+
+// Checked for every instrumented scope, so bail out before comparing strings
+#define PERFUTILITY_IS_ENABLED(sCOMP,sLEVEL)                                \
+    (g_perfutility->dwPerfUtilityIsEnabled &&                               \
+     (g_perfutility->dwPerfUtilityIsEnabled & PerfUtilityEnableBit(sCOMP, sLEVEL)))
 
 #define PERF_UTILITY_START(TAG,COMP,LEVEL)                                 \
     do                                                                     \
     {                                                                      \
-        if (PERFUTILITY_IS_ENABLED((std::string)COMP,(std::string)LEVEL))  \
+        if (PERFUTILITY_IS_ENABLED(COMP, LEVEL))                            \
         {                                                                  \
             g_perfutility->startTick(TAG);                                 \
         }                                                                  \
@@ -88,7 +100,7 @@ extern PerfUtility *g_perfutility;
 #define PERF_UTILITY_STOP(TAG, COMP, LEVEL)                                \
     do                                                                     \
     {                                                                      \
-        if (PERFUTILITY_IS_ENABLED((std::string)COMP,(std::string)LEVEL))  \
+        if (PERFUTILITY_IS_ENABLED(COMP, LEVEL))                            \
         {                                                                  \
             g_perfutility->stopTick(TAG);                                  \
         }                                                                  \
@@ -101,7 +113,7 @@ static int perf_count_stop = 0;
     do                                                                     \
     {                                                                      \
         if (perf_count_start == 0                                          \
-            && PERFUTILITY_IS_ENABLED((std::string)COMP,(std::string)LEVEL))  \
+            && PERFUTILITY_IS_ENABLED(COMP, LEVEL))                            \
         {                                                                  \
                 g_perfutility->startTick(TAG);                             \
         }                                                                  \
@@ -112,7 +124,7 @@ static int perf_count_stop = 0;
     do                                                                     \
     {                                                                      \
         if (perf_count_stop == 0                                           \
-            && PERFUTILITY_IS_ENABLED((std::string)COMP,(std::string)LEVEL))  \
+            && PERFUTILITY_IS_ENABLED(COMP, LEVEL))                            \
         {                                                                  \
             g_perfutility->stopTick(TAG);                                  \
         }                                                                  \
@@ -133,12 +145,12 @@ static int perf_count_stop = 0;
 class AutoPerfUtility
 {
 public:
-    AutoPerfUtility(std::string tag, std::string comp, std::string level);
+    AutoPerfUtility(const char *tag, const char *comp, const char *level);
     ~AutoPerfUtility();
 
 private:
     bool bEnable = false;
-    std::string autotag ="intialized";
+    uint32_t tagId = 0;
 };
 
 //!
@@ -493,6 +505,19 @@ typedef struct _MOS_PATCH_ENTRY_PARAMS
     MOS_COMMAND_BUFFER          *cmdBuffer;  //!< command buffer
 } MOS_PATCH_ENTRY_PARAMS, *PMOS_PATCH_ENTRY_PARAMS;
 
+//!
+//! \brief Structure to command template replay parameters
+//!
+typedef struct _MOS_CMD_TEMPLATE_PARAMS
+{
+    uint32_t        resourceCount;      //!< number of resources replaced
+    PMOS_RESOURCE  *recordedResources;  //!< resources registered when the template was recorded
+    PMOS_RESOURCE  *resources;          //!< resources replacing them in this frame
+    uint32_t        dwordCount;         //!< number of dwords rewritten
+    const uint32_t *dwordOffsets;       //!< byte offsets of the dwords from the start of the template
+    const uint32_t *dwordValues;        //!< new values of the dwords
+} MOS_CMD_TEMPLATE_PARAMS, *PMOS_CMD_TEMPLATE_PARAMS;
+
 typedef struct _MOS_GPUCTX_CREATOPTIONS MOS_GPUCTX_CREATOPTIONS, *PMOS_GPUCTX_CREATOPTIONS;
 struct _MOS_GPUCTX_CREATOPTIONS
 {
@@ -1064,6 +1089,24 @@ typedef struct _MOS_INTERFACE
         PMOS_INTERFACE              pOsInterface,
         PMOS_PATCH_ENTRY_PARAMS     pParams);
 
+    // Records the commands from dwStartOffset to the end of the command buffer, with their patch entries
+    MOS_STATUS (* pfnRecordCmdTemplate) (
+        PMOS_INTERFACE              pOsInterface,
+        uint32_t                    dwTemplateId,
+        PMOS_COMMAND_BUFFER         pCmdBuffer,
+        uint32_t                    dwStartOffset);
+
+    // Appends a recorded template to the command buffer; fails without side effects if it cannot
+    MOS_STATUS (* pfnReplayCmdTemplate) (
+        PMOS_INTERFACE              pOsInterface,
+        uint32_t                    dwTemplateId,
+        PMOS_COMMAND_BUFFER         pCmdBuffer,
+        PMOS_CMD_TEMPLATE_PARAMS    pParams);
+
+    void (* pfnInvalidateCmdTemplate) (
+        PMOS_INTERFACE              pOsInterface,
+        uint32_t                    dwTemplateId);
+
 #if MOS_MEDIASOLO_SUPPORTED
     MOS_STATUS (* pfnInitializeMediaSolo) (
         PMOS_INTERFACE              pOsInterface);
@@ -1073,6 +1116,12 @@ typedef struct _MOS_INTERFACE
         PMOS_INTERFACE              pOsInterface,
         PMOS_RESOURCE               pResource);
 
+    // Returns MOS_STATUS_STILL_DRAWING if the GPU is still using the resource after uiTimeOut ms
+    MOS_STATUS (* pfnWaitOnResourceTimeout) (
+        PMOS_INTERFACE              pOsInterface,
+        PMOS_RESOURCE               pResource,
+        uint32_t                    uiTimeOut);
+
     uint32_t (* pfnGetGpuStatusTag) (
         PMOS_INTERFACE              pOsInterface,
         MOS_GPU_CONTEXT             GpuContext);
@@ -0,0 +1,483 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_perf_records.cpp
+//! \brief       Scope timing records behind PerfUtility
+//!
+
+#include "mos_perf_records.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <thread>
+
+static std::atomic<uint64_t> s_perfRecordsInstances{0};
+
+//!
+//! \brief  Live instances by id, so an exiting thread can hand its buffer back
+//!
+struct MosPerfRecordsRegistry
+{
+    std::mutex                                   mutex;
+    std::unordered_map<uint64_t, MosPerfRecords *> instances;
+};
+
+static MosPerfRecordsRegistry &GetPerfRecordsRegistry()
+{
+    // Never destroyed, threads may exit after static destructors have run
+    static MosPerfRecordsRegistry *registry = new MosPerfRecordsRegistry;
+    return *registry;
+}
+
+//!
+//! \brief  Releases the buffer of the calling thread when the thread exits
+//!
+struct MosPerfRecordsThreadExit
+{
+    MosPerfRecordsThreadExit() {}
+    ~MosPerfRecordsThreadExit()
+    {
+        MosPerfRecords::ReleaseCurrentThreadBuffer();
+    }
+};
+
+thread_local uint64_t                       MosPerfRecords::m_threadInstance = 0;
+thread_local MosPerfRecords::ThreadBuffer  *MosPerfRecords::m_threadBuffer   = nullptr;
+
+MosPerfRecords::MosPerfRecords(bool nsTicks) :
+    m_instanceId(s_perfRecordsInstances.fetch_add(1, std::memory_order_relaxed) + 1),
+    m_nsTicks(nsTicks),
+    m_calibrationTicks(GetTicks()),
+    m_calibrationNs(GetMonotonicNs())
+{
+    MosPerfRecordsRegistry &registry = GetPerfRecordsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.instances[m_instanceId] = this;
+}
+
+MosPerfRecords::~MosPerfRecords()
+{
+    {
+        // Threads exiting from now on no longer touch this instance
+        MosPerfRecordsRegistry &registry = GetPerfRecordsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.instances.erase(m_instanceId);
+    }
+
+    for (auto buffer : m_buffers)
+    {
+        DeleteChunks(buffer->head);
+        delete buffer;
+    }
+    m_buffers.clear();
+}
+
+void MosPerfRecords::DeleteChunks(Chunk *chunk)
+{
+    while (chunk)
+    {
+        Chunk *next = chunk->m_next.load(std::memory_order_relaxed);
+        delete chunk;
+        chunk = next;
+    }
+}
+
+MosPerfRecords::ThreadBuffer *MosPerfRecords::GetThreadBuffer()
+{
+    // Keyed by instance id rather than address, so a thread never picks up
+    // the buffer of a destroyed instance.
+    if (m_threadInstance == m_instanceId)
+    {
+        return m_threadBuffer;
+    }
+    return CreateThreadBuffer();
+}
+
+MosPerfRecords::ThreadBuffer *MosPerfRecords::CreateThreadBuffer()
+{
+    static thread_local MosPerfRecordsThreadExit threadExit;
+
+    // A thread records into one instance at a time
+    ReleaseCurrentThreadBuffer();
+
+    ThreadBuffer *buffer = new (std::nothrow) ThreadBuffer;
+    if (buffer == nullptr)
+    {
+        return nullptr;
+    }
+    buffer->head = new (std::nothrow) Chunk(Chunk::m_minSize);
+    if (buffer->head == nullptr || buffer->head->m_records == nullptr)
+    {
+        delete buffer->head;
+        delete buffer;
+        return nullptr;
+    }
+    buffer->tail = buffer->head;
+    buffer->open.reserve(16);
+    buffer->tagCache.resize(64, TagSlot{0, 0, nullptr});
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(buffer);
+    }
+
+    m_threadInstance = m_instanceId;
+    m_threadBuffer   = buffer;
+
+    return buffer;
+}
+
+void MosPerfRecords::ReleaseCurrentThreadBuffer()
+{
+    if (m_threadBuffer == nullptr)
+    {
+        return;
+    }
+
+    {
+        // Held across the release so the owner cannot be destroyed meanwhile
+        MosPerfRecordsRegistry &registry = GetPerfRecordsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.instances.find(m_threadInstance);
+        if (it != registry.instances.end())
+        {
+            it->second->ReleaseThreadBuffer(m_threadBuffer);
+        }
+    }
+
+    m_threadInstance = 0;
+    m_threadBuffer   = nullptr;
+}
+
+void MosPerfRecords::ReleaseThreadBuffer(ThreadBuffer *buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::find(m_buffers.begin(), m_buffers.end(), buffer);
+    if (it != m_buffers.end())
+    {
+        m_buffers.erase(it);
+    }
+
+    // Keep the records, drop the chunk slack and the tag cache
+    size_t count = m_records.size();
+    for (Chunk *chunk = buffer->head; chunk; chunk = chunk->m_next.load(std::memory_order_relaxed))
+    {
+        count += chunk->m_count.load(std::memory_order_relaxed);
+    }
+    m_records.reserve(count);
+    for (Chunk *chunk = buffer->head; chunk; chunk = chunk->m_next.load(std::memory_order_relaxed))
+    {
+        uint32_t chunkCount = chunk->m_count.load(std::memory_order_relaxed);
+        m_records.insert(m_records.end(), chunk->m_records.get(), chunk->m_records.get() + chunkCount);
+    }
+
+    DeleteChunks(buffer->head);
+    delete buffer;
+}
+
+uint32_t MosPerfRecords::GetThreadBufferCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (uint32_t)m_buffers.size();
+}
+
+uint32_t MosPerfRecords::HashTag(const char *tag)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (; *tag; tag++)
+    {
+        hash = (hash ^ (uint8_t)*tag) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t MosPerfRecords::InternTag(const char *tag, const char **name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::string key(tag);
+    auto it = m_tagIds.find(key);
+    if (it == m_tagIds.end())
+    {
+        m_tags.push_back(key);
+        it = m_tagIds.emplace(key, (uint32_t)m_tags.size() - 1).first;
+    }
+
+    *name = m_tags[it->second].c_str();
+    return it->second;
+}
+
+uint32_t MosPerfRecords::GetTagId(const char *tag)
+{
+    ThreadBuffer *buffer = GetThreadBuffer();
+    if (buffer == nullptr)
+    {
+        const char *name = nullptr;
+        return InternTag(tag, &name);
+    }
+    return LookupTag(buffer, tag);
+}
+
+uint32_t MosPerfRecords::LookupTag(ThreadBuffer *buffer, const char *tag)
+{
+    // Tags are mostly literals, so try the caller's pointer before hashing.
+    // The name is still compared as the pointer may be a reused temporary.
+    uintptr_t  key    = (uintptr_t)tag;
+    RecentTag &recent = buffer->recent[(key ^ (key >> 4)) & (ThreadBuffer::m_recentSize - 1)];
+    if (recent.tag == tag && strcmp(recent.name, tag) == 0)
+    {
+        return recent.id;
+    }
+
+    uint32_t    hash = HashTag(tag);
+    uint32_t    mask = (uint32_t)buffer->tagCache.size() - 1;
+    const char *name = nullptr;
+    uint32_t    id   = 0;
+    uint32_t    i    = hash & mask;
+    for (; buffer->tagCache[i].name; i = (i + 1) & mask)
+    {
+        const TagSlot &slot = buffer->tagCache[i];
+        if (slot.hash == hash && strcmp(slot.name, tag) == 0)
+        {
+            name = slot.name;
+            id   = slot.id;
+            break;
+        }
+    }
+
+    if (name == nullptr)
+    {
+        id = InternTag(tag, &name);
+
+        // Keep the cache at most half full
+        if ((buffer->tagCount + 1) * 2 > buffer->tagCache.size())
+        {
+            std::vector<TagSlot> old(buffer->tagCache.size() * 2, TagSlot{0, 0, nullptr});
+            old.swap(buffer->tagCache);
+            mask = (uint32_t)buffer->tagCache.size() - 1;
+            for (const auto &slot : old)
+            {
+                if (slot.name)
+                {
+                    uint32_t j = slot.hash & mask;
+                    while (buffer->tagCache[j].name)
+                    {
+                        j = (j + 1) & mask;
+                    }
+                    buffer->tagCache[j] = slot;
+                }
+            }
+        }
+
+        i = hash & mask;
+        while (buffer->tagCache[i].name)
+        {
+            i = (i + 1) & mask;
+        }
+        buffer->tagCache[i] = TagSlot{hash, id, name};
+        buffer->tagCount++;
+    }
+
+    recent = RecentTag{tag, name, id};
+    return id;
+}
+
+void MosPerfRecords::Begin(uint32_t tagId, uint64_t ticks)
+{
+    ThreadBuffer *buffer = GetThreadBuffer();
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    buffer->open.push_back(OpenScope{tagId, ticks});
+}
+
+void MosPerfRecords::End(uint32_t tagId, uint64_t ticks)
+{
+    ThreadBuffer *buffer = GetThreadBuffer();
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    // Scopes nest, so the match is nearly always the last one
+    size_t i = buffer->open.size();
+    while (i > 0 && buffer->open[i - 1].tagId != tagId)
+    {
+        i--;
+    }
+    if (i == 0)
+    {
+        m_unmatched.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t start = buffer->open[i - 1].start;
+    if (i == buffer->open.size())
+    {
+        buffer->open.pop_back();
+    }
+    else
+    {
+        buffer->open.erase(buffer->open.begin() + (i - 1));
+    }
+
+    Chunk   *tail  = buffer->tail;
+    uint32_t count = tail->m_count.load(std::memory_order_relaxed);
+    if (count == tail->m_size)
+    {
+        // Grow so that threads recording a few scopes stay small
+        uint32_t size  = tail->m_size < Chunk::m_maxSize ? tail->m_size * 2 : Chunk::m_maxSize;
+        Chunk   *chunk = new (std::nothrow) Chunk(size);
+        if (chunk == nullptr || chunk->m_records == nullptr)
+        {
+            delete chunk;
+            return;
+        }
+        tail->m_next.store(chunk, std::memory_order_release);
+        buffer->tail = tail = chunk;
+        count = 0;
+    }
+
+    tail->m_records[count] = Record{tagId, ticks > start ? ticks - start : 0};
+    tail->m_count.store(count + 1, std::memory_order_release);
+}
+
+void MosPerfRecords::BeginShared(uint32_t tagId, uint64_t ticks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sharedOpen.push_back(OpenScope{tagId, ticks});
+}
+
+void MosPerfRecords::EndShared(uint32_t tagId, uint64_t ticks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t i = m_sharedOpen.size();
+    while (i > 0 && m_sharedOpen[i - 1].tagId != tagId)
+    {
+        i--;
+    }
+    if (i == 0)
+    {
+        m_unmatched.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t start = m_sharedOpen[i - 1].start;
+    m_records.push_back(Record{tagId, ticks > start ? ticks - start : 0});
+    m_sharedOpen.erase(m_sharedOpen.begin() + (i - 1));
+}
+
+double MosPerfRecords::Percentile(const std::vector<double> &sorted, uint32_t percent)
+{
+    // Nearest rank
+    size_t rank = (size_t)std::ceil(sorted.size() * percent / 100.0);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+double MosPerfRecords::GetNsPerTick()
+{
+#ifdef MOS_PERF_RECORDS_USE_TSC
+    if (!m_nsTicks)
+    {
+        // Calibrate the TSC against the monotonic clock over the lifetime of
+        // the instance, with at least 10ms between the two samples
+        const uint64_t minNs = 10000000;
+        uint64_t       ns    = GetMonotonicNs() - m_calibrationNs;
+        if (ns < minNs)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(minNs - ns));
+        }
+        uint64_t ticks = GetTicks() - m_calibrationTicks;
+        ns             = GetMonotonicNs() - m_calibrationNs;
+        return ticks ? (double)ns / ticks : 1.0;
+    }
+#endif
+    return 1.0;
+}
+
+void MosPerfRecords::Merge(std::vector<Summary> &summaries)
+{
+    double msPerTick = GetNsPerTick() / 1000000.0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::vector<double>> times(m_tags.size());
+    auto add = [&](const Record &record) {
+        times[record.tagId].push_back(record.ticks * msPerTick);
+    };
+
+    for (const auto &record : m_records)
+    {
+        add(record);
+    }
+    for (auto buffer : m_buffers)
+    {
+        for (Chunk *chunk = buffer->head; chunk; chunk = chunk->m_next.load(std::memory_order_acquire))
+        {
+            uint32_t count = chunk->m_count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                add(chunk->m_records[i]);
+            }
+        }
+    }
+
+    summaries.clear();
+    for (uint32_t id = 0; id < times.size(); id++)
+    {
+        if (times[id].empty())
+        {
+            continue;
+        }
+
+        std::vector<double> sorted(times[id]);
+        std::sort(sorted.begin(), sorted.end());
+
+        Summary summary = {};
+        summary.tag     = m_tags[id];
+        summary.count   = (uint32_t)sorted.size();
+        double sum      = 0;
+        for (auto t : sorted)
+        {
+            sum += t;
+        }
+        summary.avg   = sum / summary.count;
+        summary.min   = sorted.front();
+        summary.max   = sorted.back();
+        summary.p50   = Percentile(sorted, 50);
+        summary.p90   = Percentile(sorted, 90);
+        summary.p99   = Percentile(sorted, 99);
+        summary.times = std::move(times[id]);
+
+        summaries.push_back(std::move(summary));
+    }
+
+    std::sort(summaries.begin(), summaries.end(),
+        [](const Summary &a, const Summary &b) { return a.tag < b.tag; });
+}
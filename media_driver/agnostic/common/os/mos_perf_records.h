@@ -0,0 +1,265 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_perf_records.h
+//! \brief       Scope timing records behind PerfUtility
+//! \details     Tags are interned to ids and every thread appends its records
+//!              to its own chunked buffer, so recording takes no lock once a
+//!              thread has seen a tag. Buffers are merged per tag at dump time.
+//!              Scopes that start and stop on different threads go through a
+//!              process wide list guarded by a mutex instead.
+//!
+#ifndef __MOS_PERF_RECORDS_H__
+#define __MOS_PERF_RECORDS_H__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <time.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define MOS_PERF_RECORDS_USE_TSC 1
+#endif
+
+class MosPerfRecords
+{
+public:
+    //!
+    //! \brief  Per tag statistics, times in ms
+    //!
+    struct Summary
+    {
+        std::string         tag;
+        uint32_t            count;
+        double              avg;
+        double              min;
+        double              max;
+        double              p50;
+        double              p90;
+        double              p99;
+        std::vector<double> times;  //!< All samples, in record order per thread
+    };
+
+    //!
+    //! \brief  Constructor
+    //! \param  [in] nsTicks
+    //!         Timestamps passed in are ns rather than GetTicks() values
+    //!
+    explicit MosPerfRecords(bool nsTicks = false);
+
+    ~MosPerfRecords();
+
+    //!
+    //! \brief  Read the timestamp counter used for records
+    //! \details  The TSC where available, converted to ms at merge time, so a
+    //!           scope costs two counter reads instead of two clock_gettime.
+    //!
+    static inline uint64_t GetTicks()
+    {
+#ifdef MOS_PERF_RECORDS_USE_TSC
+        return __rdtsc();
+#else
+        return GetMonotonicNs();
+#endif
+    }
+
+    //!
+    //! \brief  Read CLOCK_MONOTONIC_RAW in ns
+    //!
+    static inline uint64_t GetMonotonicNs()
+    {
+        struct timespec ts = {};
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    //!
+    //! \brief  Get the id of a tag
+    //! \details  Lock free once the calling thread has looked the tag up before.
+    //! \param  [in] tag
+    //!         Null terminated tag name, only read during the call
+    //! \return uint32_t
+    //!         Tag id
+    //!
+    uint32_t GetTagId(const char *tag);
+
+    //!
+    //! \brief  Open a scope of tag on the calling thread
+    //! \param  [in] tagId
+    //!         Tag id from GetTagId()
+    //! \param  [in] ticks
+    //!         Start timestamp
+    //!
+    void Begin(uint32_t tagId, uint64_t ticks);
+
+    //!
+    //! \brief  Close the innermost open scope of tag on the calling thread
+    //! \details  A close without a matching open on the same thread is counted
+    //!           and dropped.
+    //! \param  [in] tagId
+    //!         Tag id from GetTagId()
+    //! \param  [in] ticks
+    //!         Stop timestamp
+    //!
+    void End(uint32_t tagId, uint64_t ticks);
+
+    //!
+    //! \brief  Open a scope of tag that may be closed on any thread
+    //! \param  [in] tagId
+    //!         Tag id from GetTagId()
+    //! \param  [in] ticks
+    //!         Start timestamp
+    //!
+    void BeginShared(uint32_t tagId, uint64_t ticks);
+
+    //!
+    //! \brief  Close the latest scope of tag opened by BeginShared()
+    //! \details  A close without a matching open is counted and dropped.
+    //! \param  [in] tagId
+    //!         Tag id from GetTagId()
+    //! \param  [in] ticks
+    //!         Stop timestamp
+    //!
+    void EndShared(uint32_t tagId, uint64_t ticks);
+
+    //!
+    //! \brief  Merge the records of all threads per tag
+    //! \details  May run while other threads keep recording; records appended
+    //!           meanwhile may or may not be included.
+    //! \param  [out] summaries
+    //!         One entry per recorded tag, sorted by tag
+    //!
+    void Merge(std::vector<Summary> &summaries);
+
+    //!
+    //! \brief  Number of closes that had no matching open
+    //!
+    uint64_t GetUnmatchedCount()
+    {
+        return m_unmatched.load(std::memory_order_relaxed);
+    }
+
+    //!
+    //! \brief  Number of threads whose buffer is still allocated
+    //!
+    uint32_t GetThreadBufferCount();
+
+protected:
+    struct Record
+    {
+        uint32_t tagId;
+        uint64_t ticks;  //!< Duration
+    };
+
+    struct Chunk
+    {
+        static const uint32_t m_minSize = 64;
+        static const uint32_t m_maxSize = 4096;
+
+        explicit Chunk(uint32_t size) : m_records(new (std::nothrow) Record[size]), m_size(size) {}
+
+        std::unique_ptr<Record[]> m_records;
+        const uint32_t            m_size;
+        std::atomic<uint32_t>     m_count{0};     //!< Published records
+        std::atomic<Chunk *>      m_next{nullptr};
+    };
+
+    struct TagSlot
+    {
+        uint32_t    hash;
+        uint32_t    id;
+        const char *name;  //!< Interned name, nullptr for an empty slot
+    };
+
+    struct RecentTag
+    {
+        const char *tag;   //!< Caller's pointer, confirmed with strcmp on hit
+        const char *name;
+        uint32_t    id;
+    };
+
+    struct OpenScope
+    {
+        uint32_t tagId;
+        uint64_t start;
+    };
+
+    //!
+    //! \brief  Records and tag cache of one thread, only the owner writes it
+    //!
+    struct ThreadBuffer
+    {
+        static const uint32_t m_recentSize = 16;
+
+        Chunk                 *head = nullptr;
+        Chunk                 *tail = nullptr;
+        std::vector<OpenScope> open;
+        std::vector<TagSlot>   tagCache;  //!< Open addressing, power of two size
+        uint32_t               tagCount = 0;
+        RecentTag              recent[m_recentSize] = {};  //!< Keyed by tag pointer
+    };
+
+    ThreadBuffer *GetThreadBuffer();
+
+    ThreadBuffer *CreateThreadBuffer();
+
+    void ReleaseThreadBuffer(ThreadBuffer *buffer);
+
+    static void ReleaseCurrentThreadBuffer();
+
+    friend struct MosPerfRecordsThreadExit;
+
+    static void DeleteChunks(Chunk *chunk);
+
+    uint32_t LookupTag(ThreadBuffer *buffer, const char *tag);
+
+    uint32_t InternTag(const char *tag, const char **name);
+
+    static uint32_t HashTag(const char *tag);
+
+    static double Percentile(const std::vector<double> &sorted, uint32_t percent);
+
+    double GetNsPerTick();
+
+    const uint64_t                            m_instanceId;
+    const bool                                m_nsTicks;
+    const uint64_t                            m_calibrationTicks;  //!< GetTicks() at construction
+    const uint64_t                            m_calibrationNs;     //!< GetMonotonicNs() at construction
+    std::mutex                                m_mutex;       //!< Guards everything below, cold paths only
+    std::deque<std::string>                   m_tags;        //!< Interned names, stable addresses
+    std::unordered_map<std::string, uint32_t> m_tagIds;
+    std::vector<ThreadBuffer *>               m_buffers;
+    std::vector<Record>                       m_records;     //!< Shared scopes and buffers of exited threads
+    std::vector<OpenScope>                    m_sharedOpen;
+    std::atomic<uint64_t>                     m_unmatched{0};
+
+    static thread_local uint64_t     m_threadInstance;  //!< Instance owning m_threadBuffer
+    static thread_local ThreadBuffer *m_threadBuffer;
+};
+
+#endif // __MOS_PERF_RECORDS_H__
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_swizzle.cpp
+//! \brief       Tile line copy between linear and X/Y tiled layouts
+//!
+#include "mos_swizzle.h"
+#include <emmintrin.h>
+
+int32_t Mos_SwizzleSplitBands(
+    uint8_t         *pSrc,
+    uint8_t         *pDst,
+    MOS_TILE_TYPE   SrcTiling,
+    MOS_TILE_TYPE   DstTiling,
+    int32_t         iHeight,
+    int32_t         iPitch,
+    int32_t         iMaxBands,
+    PMOS_SWIZZLE_BAND pBands)
+{
+    bool bToLinear = (SrcTiling == MOS_TILE_Y || SrcTiling == MOS_TILE_X) && DstTiling == MOS_TILE_LINEAR;
+    bool bToTiled  = SrcTiling == MOS_TILE_LINEAR && (DstTiling == MOS_TILE_Y || DstTiling == MOS_TILE_X);
+    if (pBands == nullptr || !(bToLinear || bToTiled) || iPitch <= 0 || iHeight <= 0)
+    {
+        return 0;
+    }
+
+    MOS_TILE_TYPE TileFormat = bToLinear ? SrcTiling : DstTiling;
+    int32_t       iLBits     = (TileFormat == MOS_TILE_Y) ? 5 : 3;
+    int32_t       iLPos      = (TileFormat == MOS_TILE_Y) ? 4 : 9;
+    int32_t       iTileRows  = (iHeight + (1 << iLBits) - 1) >> iLBits;
+    int32_t       iBandCount = MOS_MIN(iMaxBands, MOS_SWIZZLE_MAX_BANDS);
+
+    if ((iPitch & ((1 << iLPos) - 1)) != 0)
+    {
+        return 0;
+    }
+
+    iBandCount = MOS_CLAMP_MIN_MAX(iBandCount, 1, iTileRows);
+
+    for (int32_t i = 0; i < iBandCount; i++)
+    {
+        pBands[i].pSrc      = pSrc;
+        pBands[i].pDst      = pDst;
+        pBands[i].bToLinear = bToLinear;
+        pBands[i].iPitch    = iPitch;
+        pBands[i].iRowStart = (iTileRows * i / iBandCount) << iLBits;
+        pBands[i].iRowEnd   = MOS_MIN((iTileRows * (i + 1) / iBandCount) << iLBits, iHeight);
+        pBands[i].iLBits    = iLBits;
+        pBands[i].iLPos     = iLPos;
+    }
+
+    return iBandCount;
+}
+
+void *Mos_SwizzleBand(void *pData)
+{
+    PMOS_SWIZZLE_BAND pBand      = (PMOS_SWIZZLE_BAND)pData;
+    const int32_t     iLines     = 1 << pBand->iLBits;
+    const int32_t     iSpan      = 1 << pBand->iLPos;
+    const int32_t     iColumns   = pBand->iPitch >> pBand->iLPos;
+    const size_t      tileSize   = (size_t)iSpan << pBand->iLBits;
+
+    for (int32_t y0 = pBand->iRowStart; y0 < pBand->iRowEnd; y0 += iLines)
+    {
+        int32_t  iLineCount = MOS_MIN(iLines, pBand->iRowEnd - y0);
+        size_t   tileRow    = (size_t)(y0 >> pBand->iLBits) * iColumns * tileSize;
+        size_t   linearRow  = (size_t)y0 * pBand->iPitch;
+
+        for (int32_t col = 0; col < iColumns; col++)
+        {
+            uint8_t *pTiled  = (pBand->bToLinear ? pBand->pSrc : pBand->pDst) + tileRow + col * tileSize;
+            uint8_t *pLinear = (pBand->bToLinear ? pBand->pDst : pBand->pSrc) + linearRow + (size_t)col * iSpan;
+
+            for (int32_t line = 0; line < iLineCount; line++, pTiled += iSpan, pLinear += pBand->iPitch)
+            {
+                uint8_t *pFrom = pBand->bToLinear ? pTiled : pLinear;
+                uint8_t *pTo   = pBand->bToLinear ? pLinear : pTiled;
+
+                for (int32_t x = 0; x < iSpan; x += sizeof(__m128i))
+                {
+                    _mm_storeu_si128((__m128i *)(pTo + x), _mm_loadu_si128((const __m128i *)(pFrom + x)));
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_swizzle.h
+//! \brief       Tile line copy between linear and X/Y tiled layouts
+//! \details     Fast path of Mos_SwizzleData and MosUtilities::MosSwizzleData.
+//!              Kept apart from mos_utilities so it can be tested on its own.
+//!
+#ifndef __MOS_SWIZZLE_H__
+#define __MOS_SWIZZLE_H__
+
+#include "mos_defs.h"
+#include "mos_resource_defs.h"
+
+//! Surfaces at least this large are worth splitting into row bands across threads
+#define MOS_SWIZZLE_MT_THRESHOLD    (8 * 1024 * 1024)
+#define MOS_SWIZZLE_MAX_BANDS       4
+
+//!
+//! \brief    Band of tile rows converted by one thread in Mos_SwizzleData
+//!
+typedef struct _MOS_SWIZZLE_BAND
+{
+    uint8_t         *pSrc;
+    uint8_t         *pDst;
+    bool            bToLinear;      //!< Tiled source to linear destination
+    int32_t         iPitch;
+    int32_t         iRowStart;      //!< First line, multiple of the tile height
+    int32_t         iRowEnd;        //!< One past the last line
+    int32_t         iLBits;         //!< Log2 of lines per tile
+    int32_t         iLPos;          //!< Log2 of contiguous bytes per tile line
+} MOS_SWIZZLE_BAND, *PMOS_SWIZZLE_BAND;
+
+//!
+//! \brief    Split a swizzle into bands of whole tile rows
+//! \details  Only X or Y tiled to linear, or linear to X or Y tiled, with a
+//!           pitch that is a multiple of the tile line span can take the tile
+//!           line copy. Other tilings keep the per byte path, and so do other
+//!           pitches: their tile lines would overlap and write order matters.
+//! \param    [in] pSrc
+//!           Pointer to source data
+//! \param    [out] pDst
+//!           Pointer to destination data
+//! \param    [in] SrcTiling
+//!           Source tile type
+//! \param    [in] DstTiling
+//!           Destination tile type
+//! \param    [in] iHeight
+//!           Height
+//! \param    [in] iPitch
+//!           Pitch
+//! \param    [in] iMaxBands
+//!           Bands wanted, at most MOS_SWIZZLE_MAX_BANDS and one per tile row
+//!           are used
+//! \param    [out] pBands
+//!           Array of MOS_SWIZZLE_MAX_BANDS bands
+//! \return   int32_t
+//!           Number of bands filled, 0 if the per byte path must be used
+//!
+int32_t Mos_SwizzleSplitBands(
+    uint8_t         *pSrc,
+    uint8_t         *pDst,
+    MOS_TILE_TYPE   SrcTiling,
+    MOS_TILE_TYPE   DstTiling,
+    int32_t         iHeight,
+    int32_t         iPitch,
+    int32_t         iMaxBands,
+    PMOS_SWIZZLE_BAND pBands);
+
+//!
+//! \brief    Copy one band of a tiled surface from or to linear layout
+//! \details  Walks the tiled side in memory order. Within a tile every line
+//!           is one contiguous span--16 bytes (an OWORD column) for TileY and
+//!           512 bytes for TileX--so each span is moved with OWORD loads and
+//!           stores instead of swizzling each byte. The result is identical
+//!           to translating every byte with Mos_SwizzleOffset without CSX.
+//! \param    [in] pData
+//!           Pointer to the MOS_SWIZZLE_BAND to convert
+//! \return   void *
+//!           Always nullptr, matches the thread entry signature
+//!
+void *Mos_SwizzleBand(void *pData);
+
+#endif // __MOS_SWIZZLE_H__
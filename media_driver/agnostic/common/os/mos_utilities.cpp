@@ -33,6 +33,7 @@
 #include <chrono>
 #endif
 #include "mos_os.h"
+#include "mos_swizzle.h"
 
 #include <fcntl.h>     //open
 
@@ -54,7 +55,6 @@
 #ifdef __cplusplus
 
 std::shared_ptr<PerfUtility> PerfUtility::instance = nullptr;
-std::mutex PerfUtility::perfMutex;
 
 PerfUtility *PerfUtility::getInstance()
 {
@@ -74,14 +74,32 @@ PerfUtility::PerfUtility()
 
 PerfUtility::~PerfUtility()
 {
-    for (const auto &data : records)
-    {
-        if (data.second)
-        {
-            delete data.second;
-        }
-    }
-    records.clear();
+}
+
+uint32_t PerfUtility::getTagId(const char *tag)
+{
+    return records.GetTagId(tag);
+}
+
+void PerfUtility::startTick(const char *tag)
+{
+    // START/STOP pairs such as "First Frame Time" may span threads
+    records.BeginShared(records.GetTagId(tag), MosPerfRecords::GetTicks());
+}
+
+void PerfUtility::stopTick(const char *tag)
+{
+    records.EndShared(records.GetTagId(tag), MosPerfRecords::GetTicks());
+}
+
+void PerfUtility::startTick(uint32_t tagId)
+{
+    records.Begin(tagId, MosPerfRecords::GetTicks());
+}
+
+void PerfUtility::stopTick(uint32_t tagId)
+{
+    records.End(tagId, MosPerfRecords::GetTicks());
 }
 
 void PerfUtility::setupFilePath(char *perfFilePath)
@@ -100,34 +118,37 @@ void PerfUtility::setupFilePath()
 
 void PerfUtility::savePerfData()
 {
-    printPerfSummary();
+    std::vector<MosPerfRecords::Summary> summaries;
+    records.Merge(summaries);
+
+    printPerfSummary(summaries);
 
-    printPerfDetails();
+    printPerfDetails(summaries);
 }
 
-void PerfUtility::printPerfSummary()
+void PerfUtility::printPerfSummary(std::vector<MosPerfRecords::Summary>& summaries)
 {
     std::ofstream fout;
     fout.open(sSummaryFileName);
 
     printHeader(fout);
-    printBody(fout);
+    printBody(fout, summaries);
     fout.close();
 }
 
-void PerfUtility::printPerfDetails()
+void PerfUtility::printPerfDetails(std::vector<MosPerfRecords::Summary>& summaries)
 {
     std::ofstream fout;
     fout.open(sDetailsFileName);
 
-    for (auto data : records)
+    for (auto& data : summaries)
     {
-        fout << getDashString((uint32_t)data.first.length());
-        fout << data.first << std::endl;
-        fout << getDashString((uint32_t)data.first.length());
-        for (auto t : *data.second)
+        fout << getDashString((uint32_t)data.tag.length());
+        fout << data.tag << std::endl;
+        fout << getDashString((uint32_t)data.tag.length());
+        for (auto t : data.times)
         {
-            fout << t.time << std::endl;
+            fout << t << std::endl;
         }
         fout << std::endl;
     }
@@ -143,58 +164,47 @@ void PerfUtility::printHeader(std::ofstream& fout)
     ss << "Hit Count,";
     ss << "Average (ms),";
     ss << "Minimum (ms),";
-    ss << "Maximum (ms)" << std::endl;
+    ss << "Maximum (ms),";
+    ss << "P50 (ms),";
+    ss << "P90 (ms),";
+    ss << "P99 (ms)" << std::endl;
     fout << ss.str();
 }
 
-void PerfUtility::printBody(std::ofstream& fout)
+void PerfUtility::printBody(std::ofstream& fout, std::vector<MosPerfRecords::Summary>& summaries)
 {
-    for (const auto& data : records)
+    for (auto& data : summaries)
     {
-        fout << formatPerfData(data.first, *data.second);
+        fout << formatPerfData(data);
     }
 }
 
-std::string PerfUtility::formatPerfData(std::string tag, std::vector<Tick>& record)
+std::string PerfUtility::formatPerfData(MosPerfRecords::Summary& summary)
 {
     std::stringstream ss;
-    PerfInfo info = {};
-    getPerfInfo(record, &info);
 
-    ss << tag;
+    ss << summary.tag;
     ss << ",";
     ss.precision(3);
     ss.setf(std::ios::fixed, std::ios::floatfield);
 
-    ss << info.count;
+    ss << summary.count;
+    ss << ",";
+    ss << summary.avg;
+    ss << ",";
+    ss << summary.min;
+    ss << ",";
+    ss << summary.max;
     ss << ",";
-    ss << info.avg;
+    ss << summary.p50;
     ss << ",";
-    ss << info.min;
+    ss << summary.p90;
     ss << ",";
-    ss << info.max << std::endl;
+    ss << summary.p99 << std::endl;
 
     return ss.str();
 }
 
-void PerfUtility::getPerfInfo(std::vector<Tick>& record, PerfInfo* info)
-{
-    if (record.size() <= 0)
-        return;
-
-    info->count = (uint32_t)record.size();
-    double sum = 0, max = 0, min = 10000000.0;
-    for (auto t : record)
-    {
-        sum += t.time;
-        max = (max < t.time) ? t.time : max;
-        min = (min > t.time) ? t.time : min;
-    }
-    info->avg = sum / info->count;
-    info->max = max;
-    info->min = min;
-}
-
 void PerfUtility::printFooter(std::ofstream& fout)
 {
     fout << getDashString(80);
@@ -357,6 +367,24 @@ static MOS_USER_FEATURE_VALUE MOSUserFeatureDescFields[__MOS_USER_FEATURE_KEY_MA
         MOS_USER_FEATURE_VALUE_TYPE_UINT32,
         "0",
         "Performance Profiler Multi Process Support"),
+    MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_RING_MODE,
+        "Perf Profiler Ring Mode",
+        __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "General",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT32,
+        "0",
+        "Performance Profiler Ring Buffer Mode with Periodic Output File Drain"),
+    MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_DRAIN_INTERVAL,
+        "Perf Profiler Drain Interval",
+        __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "General",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT32,
+        "100",
+        "Performance Profiler Ring Mode Drain Interval in Milliseconds"),
     MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_1,
         "Perf Profiler Register 1",
         __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
@@ -438,6 +466,60 @@ static MOS_USER_FEATURE_VALUE MOSUserFeatureDescFields[__MOS_USER_FEATURE_KEY_MA
         MOS_USER_FEATURE_VALUE_TYPE_INT32,
         "0",
         "Disable KMD Watchdog"),
+    MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_BO_CACHE_BUDGET_ID,
+        "BO Cache Budget",
+        __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "General",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT32,
+        "512",
+        "Bytes (in MB) of freed buffers the buffer manager keeps for reuse. 0: unbounded."),
+    MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_BO_CACHE_EXPIRE_ID,
+        "BO Cache Expire",
+        __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "General",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT32,
+        "1000",
+        "Milliseconds a freed buffer stays in the buffer manager reuse cache."),
+    MOS_DECLARE_UF_KEY_DBGONLY(__MEDIA_USER_FEATURE_VALUE_BO_CACHE_HITS_ID,
+        "BO Cache Hits",
+        __MEDIA_USER_FEATURE_SUBKEY_INTERNAL,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "Report",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT64,
+        "0",
+        "Report key for buffer allocations served from the reuse cache."),
+    MOS_DECLARE_UF_KEY_DBGONLY(__MEDIA_USER_FEATURE_VALUE_BO_CACHE_MISSES_ID,
+        "BO Cache Misses",
+        __MEDIA_USER_FEATURE_SUBKEY_INTERNAL,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "Report",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT64,
+        "0",
+        "Report key for cacheable buffer allocations that created a new buffer."),
+    MOS_DECLARE_UF_KEY_DBGONLY(__MEDIA_USER_FEATURE_VALUE_BO_CACHE_PEAK_BYTES_ID,
+        "BO Cache Peak Bytes",
+        __MEDIA_USER_FEATURE_SUBKEY_INTERNAL,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "Report",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT64,
+        "0",
+        "Report key for the most bytes the buffer reuse cache held at once."),
+    MOS_DECLARE_UF_KEY(__MEDIA_USER_FEATURE_VALUE_CMD_BUFFER_PREWARM_DEPTH_ID,
+        "Cmd Buffer Prewarm Depth",
+        __MEDIA_USER_FEATURE_SUBKEY_PERFORMANCE,
+        __MEDIA_USER_FEATURE_SUBKEY_REPORT,
+        "General",
+        MOS_USER_FEATURE_TYPE_USER,
+        MOS_USER_FEATURE_VALUE_TYPE_UINT32,
+        "8",
+        "Available command buffers kept ready per size in use. 0: no pre-warming."),
     MOS_DECLARE_UF_KEY_DBGONLY(__MEDIA_USER_FEATURE_VALUE_SINGLE_TASK_PHASE_ENABLE_ID,
         "Single Task Phase Enable",
         __MEDIA_USER_FEATURE_SUBKEY_INTERNAL,
@@ -6654,6 +6736,39 @@ void Mos_SwizzleData(
     int32_t x;
     int32_t y;
 
+#ifndef _MOS_UTILITY_EXT
+    // X and Y tiles are copied a tile line at a time. Other tilings, and
+    // pitches that would make tile lines overlap, keep the per byte path.
+    MOS_SWIZZLE_BAND Bands[MOS_SWIZZLE_MAX_BANDS];
+    int32_t          iMaxBands  = ((int64_t)iPitch * iHeight >= MOS_SWIZZLE_MT_THRESHOLD) ? (int32_t)MOS_GetLogicalCoreNumber() : 1;
+    int32_t          iBandCount = Mos_SwizzleSplitBands(pSrc, pDst, SrcTiling, DstTiling, iHeight, iPitch, iMaxBands, Bands);
+
+    if (iBandCount > 0)
+    {
+        MOS_THREADHANDLE Threads[MOS_SWIZZLE_MAX_BANDS] = {};
+
+        // Band 0 runs on the caller; any band whose thread cannot be
+        // created runs there as well.
+        for (int32_t i = 1; i < iBandCount; i++)
+        {
+            Threads[i] = MOS_CreateThread((void *)Mos_SwizzleBand, &Bands[i]);
+        }
+        Mos_SwizzleBand(&Bands[0]);
+        for (int32_t i = 1; i < iBandCount; i++)
+        {
+            if (Threads[i])
+            {
+                MOS_WaitThread(Threads[i]);
+            }
+            else
+            {
+                Mos_SwizzleBand(&Bands[i]);
+            }
+        }
+        return;
+    }
+#endif
+
     // Translate from one format to another
     for (y = 0, LinearOffset = 0, TileOffset = 0; y < iHeight; y++)
     {
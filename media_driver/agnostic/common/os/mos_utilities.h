@@ -43,33 +43,21 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include "mos_perf_records.h"
 
 #define MOS_MAX_PERF_FILENAME_LEN 260
 
 class PerfUtility
 {
-public:
-    struct Tick
-    {
-        double freq;
-        int64_t start;
-        int64_t stop;
-        double time;
-    };
-    struct PerfInfo
-    {
-        uint32_t count;
-        double avg;
-        double max;
-        double min;
-    };
-
 public:
     static PerfUtility *getInstance();
     ~PerfUtility();
     PerfUtility();
-    void startTick(std::string tag);
-    void stopTick(std::string tag);
+    uint32_t getTagId(const char *tag);
+    void startTick(const char *tag);    // Closed by stopTick(tag) on any thread
+    void stopTick(const char *tag);
+    void startTick(uint32_t tagId);     // Closed by stopTick(tagId) on the same thread
+    void stopTick(uint32_t tagId);
     void savePerfData();
     void setupFilePath(char *perfFilePath);
     void setupFilePath();
@@ -79,19 +67,17 @@ public:
     int32_t dwPerfUtilityIsEnabled;
 
 private:
-    void printPerfSummary();
-    void printPerfDetails();
+    void printPerfSummary(std::vector<MosPerfRecords::Summary>& summaries);
+    void printPerfDetails(std::vector<MosPerfRecords::Summary>& summaries);
     void printHeader(std::ofstream& fout);
-    void printBody(std::ofstream& fout);
+    void printBody(std::ofstream& fout, std::vector<MosPerfRecords::Summary>& summaries);
     void printFooter(std::ofstream& fout);
-    std::string formatPerfData(std::string tag, std::vector<Tick>& record);
-    void getPerfInfo(std::vector<Tick>& record, PerfInfo* info);
+    std::string formatPerfData(MosPerfRecords::Summary& summary);
     std::string getDashString(uint32_t num);
 
 private:
     static std::shared_ptr<PerfUtility> instance;
-    static std::mutex perfMutex;
-    std::map<std::string, std::vector<Tick>*> records;
+    MosPerfRecords records;
 };
 
 //!
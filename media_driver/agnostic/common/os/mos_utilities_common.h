@@ -115,6 +115,8 @@ typedef enum _MOS_USER_FEATURE_VALUE_ID
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_BUFFER_SIZE,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_TIMER_REG,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_ENABLE_MULTI_PROCESS,
+    __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_RING_MODE,
+    __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_DRAIN_INTERVAL,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_1,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_2,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_3,
@@ -124,6 +126,12 @@ typedef enum _MOS_USER_FEATURE_VALUE_ID
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_7,
     __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_REGISTER_8,
     __MEDIA_USER_FEATURE_VALUE_DISABLE_KMD_WATCHDOG_ID,
+    __MEDIA_USER_FEATURE_VALUE_BO_CACHE_BUDGET_ID,
+    __MEDIA_USER_FEATURE_VALUE_BO_CACHE_EXPIRE_ID,
+    __MEDIA_USER_FEATURE_VALUE_BO_CACHE_HITS_ID,
+    __MEDIA_USER_FEATURE_VALUE_BO_CACHE_MISSES_ID,
+    __MEDIA_USER_FEATURE_VALUE_BO_CACHE_PEAK_BYTES_ID,
+    __MEDIA_USER_FEATURE_VALUE_CMD_BUFFER_PREWARM_DEPTH_ID,
     __MEDIA_USER_FEATURE_VALUE_SINGLE_TASK_PHASE_ENABLE_ID,
     __MEDIA_USER_FEATURE_VALUE_AUX_TABLE_16K_GRANULAR_ID,
     __MEDIA_USER_FEATURE_VALUE_MFE_MBENC_ENABLE_ID,
@@ -1186,6 +1186,7 @@ MOS_STATUS RenderHal_AllocateStateHeaps(
     uint32_t                     dwSizeISH;
     uint32_t                     dwSizeMediaState;
     uint32_t                     dwSizeSamplers;
+    uint32_t                     dwKernelIndexSize;
     PMHW_STATE_HEAP              pDshHeap;
     PMHW_STATE_HEAP              pIshHeap;
     int32_t                      i;
@@ -1220,9 +1221,18 @@ MOS_STATUS RenderHal_AllocateStateHeaps(
     //---------------------------------------
     // Setup General State Heap
     //---------------------------------------
+    // Kernel index hash table is kept at most half full
+    dwKernelIndexSize = 1;
+    while (dwKernelIndexSize < 2 * (uint32_t)pSettings->iKernelCount)
+    {
+        dwKernelIndexSize <<= 1;
+    }
+
     // Calculate size of State Heap control structure
     dwSizeAlloc  = MOS_ALIGN_CEIL(sizeof(RENDERHAL_STATE_HEAP)                                       , 16);
     dwSizeAlloc += MOS_ALIGN_CEIL(pSettings->iKernelCount     * sizeof(RENDERHAL_KRN_ALLOCATION)     , 16);
+    dwSizeAlloc += MOS_ALIGN_CEIL(dwKernelIndexSize           * sizeof(int32_t)                      , 16);
+    dwSizeAlloc += MOS_ALIGN_CEIL(pSettings->iKernelCount     * sizeof(int32_t)                      , 16);
     dwSizeAlloc += MOS_ALIGN_CEIL(pSettings->iMediaStateHeaps * sizeof(RENDERHAL_MEDIA_STATE)        , 16);
     dwSizeAlloc += MOS_ALIGN_CEIL(pSettings->iMediaStateHeaps * pSettings->iMediaIDs * sizeof(int32_t)   , 16);
     dwSizeAlloc += MOS_ALIGN_CEIL(pSettings->iSurfaceStates   * sizeof(RENDERHAL_SURFACE_STATE_ENTRY), 16);
@@ -1260,6 +1270,14 @@ MOS_STATUS RenderHal_AllocateStateHeaps(
     pStateHeap->pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION) ptr;
     ptr += MOS_ALIGN_CEIL(pSettings->iKernelCount * sizeof(RENDERHAL_KRN_ALLOCATION), 16);
 
+    // Pointer to Kernel allocation index and free block list
+    pStateHeap->piKernelIndex     = (int32_t*) ptr;
+    pStateHeap->dwKernelIndexMask = dwKernelIndexSize - 1;
+    ptr += MOS_ALIGN_CEIL(dwKernelIndexSize * sizeof(int32_t), 16);
+
+    pStateHeap->piFreeKernelBlocks = (int32_t*) ptr;
+    ptr += MOS_ALIGN_CEIL(pSettings->iKernelCount * sizeof(int32_t), 16);
+
     // Pointer to Media State allocations
     pStateHeap->pMediaStates = (PRENDERHAL_MEDIA_STATE) ptr;
     ptr += MOS_ALIGN_CEIL(pSettings->iMediaStateHeaps * sizeof(RENDERHAL_MEDIA_STATE), 16);
@@ -1926,6 +1944,176 @@ finish:
     return eStatus;
 }
 
+//!
+//! \brief    Hash (KUID, KCID) into the kernel allocation index
+//!
+static inline uint32_t RenderHal_KernelIndexHash(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iKUID,
+    int32_t               iKCID)
+{
+    uint32_t dwHash = (uint32_t)iKUID * 0x9E3779B1 ^ (uint32_t)iKCID * 0x85EBCA77;
+    return (dwHash ^ (dwHash >> 16)) & pStateHeap->dwKernelIndexMask;
+}
+
+//!
+//! \brief    Find kernel allocation by (KUID, KCID)
+//! \return   int32_t
+//!           Kernel allocation index, -1 if not loaded
+//!
+static int32_t RenderHal_FindKernelIndex(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iKUID,
+    int32_t               iKCID)
+{
+    PRENDERHAL_KRN_ALLOCATION pKernelAllocation;
+    uint32_t                  dwSlot;
+
+    dwSlot = RenderHal_KernelIndexHash(pStateHeap, iKUID, iKCID);
+    while (pStateHeap->piKernelIndex[dwSlot])
+    {
+        pKernelAllocation = &pStateHeap->pKernelAllocation[pStateHeap->piKernelIndex[dwSlot] - 1];
+        if (pKernelAllocation->iKUID == iKUID &&
+            pKernelAllocation->iKCID == iKCID)
+        {
+            return pStateHeap->piKernelIndex[dwSlot] - 1;
+        }
+        dwSlot = (dwSlot + 1) & pStateHeap->dwKernelIndexMask;
+    }
+
+    return -1;
+}
+
+//!
+//! \brief    Add kernel allocation to the index, (KUID, KCID) must be set
+//!
+static void RenderHal_InsertKernelIndex(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iKernelAllocationID)
+{
+    PRENDERHAL_KRN_ALLOCATION pKernelAllocation = &pStateHeap->pKernelAllocation[iKernelAllocationID];
+    uint32_t                  dwSlot;
+
+    dwSlot = RenderHal_KernelIndexHash(pStateHeap, pKernelAllocation->iKUID, pKernelAllocation->iKCID);
+    while (pStateHeap->piKernelIndex[dwSlot])
+    {
+        dwSlot = (dwSlot + 1) & pStateHeap->dwKernelIndexMask;
+    }
+    pStateHeap->piKernelIndex[dwSlot] = iKernelAllocationID + 1;
+}
+
+//!
+//! \brief    Remove kernel allocation from the index, before (KUID, KCID) are cleared
+//!
+static void RenderHal_RemoveKernelIndex(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iKernelAllocationID)
+{
+    PRENDERHAL_KRN_ALLOCATION pKernelAllocation = &pStateHeap->pKernelAllocation[iKernelAllocationID];
+    uint32_t                  dwMask = pStateHeap->dwKernelIndexMask;
+    uint32_t                  dwHole, dwSlot, dwHome;
+
+    dwHole = RenderHal_KernelIndexHash(pStateHeap, pKernelAllocation->iKUID, pKernelAllocation->iKCID);
+    while (pStateHeap->piKernelIndex[dwHole] != iKernelAllocationID + 1)
+    {
+        if (pStateHeap->piKernelIndex[dwHole] == 0)
+        {
+            return;
+        }
+        dwHole = (dwHole + 1) & dwMask;
+    }
+
+    // Shift back entries of the same probe sequence so lookups never stop early
+    dwSlot = dwHole;
+    for (;;)
+    {
+        dwSlot = (dwSlot + 1) & dwMask;
+        if (pStateHeap->piKernelIndex[dwSlot] == 0)
+        {
+            break;
+        }
+
+        pKernelAllocation = &pStateHeap->pKernelAllocation[pStateHeap->piKernelIndex[dwSlot] - 1];
+        dwHome = RenderHal_KernelIndexHash(pStateHeap, pKernelAllocation->iKUID, pKernelAllocation->iKCID);
+        if (((dwSlot - dwHome) & dwMask) >= ((dwSlot - dwHole) & dwMask))
+        {
+            pStateHeap->piKernelIndex[dwHole] = pStateHeap->piKernelIndex[dwSlot];
+            dwHole = dwSlot;
+        }
+    }
+    pStateHeap->piKernelIndex[dwHole] = 0;
+}
+
+//!
+//! \brief    Add free kernel allocation holding ISH space to the size sorted free list
+//!
+static void RenderHal_InsertFreeKernelBlock(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iKernelAllocationID)
+{
+    int32_t iSize = pStateHeap->pKernelAllocation[iKernelAllocationID].iSize;
+    int32_t i;
+
+    for (i = pStateHeap->iFreeKernelBlocks;
+         i > 0 && pStateHeap->pKernelAllocation[pStateHeap->piFreeKernelBlocks[i - 1]].iSize > iSize;
+         i--)
+    {
+        pStateHeap->piFreeKernelBlocks[i] = pStateHeap->piFreeKernelBlocks[i - 1];
+    }
+    pStateHeap->piFreeKernelBlocks[i] = iKernelAllocationID;
+    pStateHeap->iFreeKernelBlocks++;
+}
+
+//!
+//! \brief    Take entry at iPosition out of the free list
+//! \return   int32_t
+//!           Kernel allocation index
+//!
+static int32_t RenderHal_RemoveFreeKernelBlock(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iPosition)
+{
+    int32_t iKernelAllocationID = pStateHeap->piFreeKernelBlocks[iPosition];
+    int32_t i;
+
+    pStateHeap->iFreeKernelBlocks--;
+    for (i = iPosition; i < pStateHeap->iFreeKernelBlocks; i++)
+    {
+        pStateHeap->piFreeKernelBlocks[i] = pStateHeap->piFreeKernelBlocks[i + 1];
+    }
+
+    return iKernelAllocationID;
+}
+
+//!
+//! \brief    Find smallest free block that holds iSize bytes
+//! \return   int32_t
+//!           Position in the free list, -1 if no block is large enough
+//!
+static int32_t RenderHal_FindFreeKernelBlock(
+    PRENDERHAL_STATE_HEAP pStateHeap,
+    int32_t               iSize)
+{
+    int32_t iLow  = 0;
+    int32_t iHigh = pStateHeap->iFreeKernelBlocks;
+    int32_t iMid;
+
+    while (iLow < iHigh)
+    {
+        iMid = (iLow + iHigh) / 2;
+        if (pStateHeap->pKernelAllocation[pStateHeap->piFreeKernelBlocks[iMid]].iSize < iSize)
+        {
+            iLow = iMid + 1;
+        }
+        else
+        {
+            iHigh = iMid;
+        }
+    }
+
+    return (iLow < pStateHeap->iFreeKernelBlocks) ? iLow : -1;
+}
+
 //!
 //! \brief    Load Kernel
 //! \details  Load a kernel from cache into GSH; searches for unused space in 
@@ -1963,6 +2151,8 @@ int32_t RenderHal_LoadKernel(
     int32_t iMaxKernels;            // Max number of kernels allowed in GSH
     uint32_t dwOffset;
     int32_t iSize;
+    int32_t i;
+    PRENDERHAL_KERNEL_LOAD_STATS pStats;
     MOS_STATUS eStatus;
 
     iKernelAllocationID = RENDERHAL_KERNEL_LOAD_FAIL;
@@ -1991,33 +2181,19 @@ int32_t RenderHal_LoadKernel(
     iKernelUniqueID = pKernel->iKUID;
     iKernelCacheID  = pKernel->iKCID;
 
-    // Check if kernel is already loaded; Search free allocation index
-    iSearchIndex = -1;
-    iMaxKernels  = pRenderHal->StateHeapSettings.iKernelCount;
-    pKernelAllocation = pStateHeap->pKernelAllocation;
-    for (iKernelAllocationID = 0;
-         iKernelAllocationID < iMaxKernels;
-         iKernelAllocationID++, pKernelAllocation++)
-    {
-        if (pKernelAllocation->iKUID == iKernelUniqueID &&
-            pKernelAllocation->iKCID == iKernelCacheID)
-        {
-            break;
-        }
-
-        if (iSearchIndex < 0 &&
-            pKernelAllocation->dwFlags == RENDERHAL_KERNEL_ALLOCATION_FREE)
-        {
-            iSearchIndex = iKernelAllocationID;
-        }
-    }
+    // Check if kernel is already loaded
+    iMaxKernels         = pRenderHal->StateHeapSettings.iKernelCount;
+    pStats              = &pStateHeap->KernelLoadStats;
+    iKernelAllocationID = RenderHal_FindKernelIndex(pStateHeap, iKernelUniqueID, iKernelCacheID);
 
     // The kernel size to be dumped in oca buffer.
     pStateHeap->iKernelUsedForDump = iKernelSize;
 
     // Kernel already loaded: refresh timer; return allocation index
-    if (iKernelAllocationID < iMaxKernels)
+    if (iKernelAllocationID >= 0)
     {
+        pKernelAllocation = &(pStateHeap->pKernelAllocation[iKernelAllocationID]);
+
         // To reload the kernel forcibly if needed
         if (pKernel->bForceReload)
         {
@@ -2026,66 +2202,70 @@ int32_t RenderHal_LoadKernel(
 
             pKernel->bForceReload = false;
         }
+        pStats->LastResult = RENDERHAL_KERNEL_LOAD_RESULT_HIT;
+        pStats->dwHits++;
         goto finish;
     }
 
-    // Simple allocation: allocation index available, space available
-    if ((iSearchIndex >= 0) &&
+    pStats->dwMisses++;
+    iSize = MOS_ALIGN_CEIL(iKernelSize, pRenderHal->StateHeapSettings.iKernelBlockSize);
+
+    // Simple allocation: allocation index never used, space available at the end of the heap
+    if ((pStateHeap->iKernelAllocEmpty < iMaxKernels) &&
         (pStateHeap->iKernelUsed + iKernelSize <= pStateHeap->iKernelSize))
     {
         // Allocate kernel at the end of the heap
-        iKernelAllocationID = iSearchIndex;
-        pKernelAllocation   = &(pStateHeap->pKernelAllocation[iSearchIndex]);
+        iKernelAllocationID = pStateHeap->iKernelAllocEmpty++;
+        pKernelAllocation   = &(pStateHeap->pKernelAllocation[iKernelAllocationID]);
 
         // Allocate block from the end of the heap
         dwOffset = pStateHeap->dwKernelBase + pStateHeap->iKernelUsed;
-        iSize    = MOS_ALIGN_CEIL(iKernelSize, pRenderHal->StateHeapSettings.iKernelBlockSize);
 
         // Update heap
         pStateHeap->iKernelUsed += iSize;
 
+        pStats->LastResult = RENDERHAL_KERNEL_LOAD_RESULT_APPEND;
+        pStats->dwAppends++;
+
         // Load kernel
         goto loadkernel;
     }
 
-    // Search block from deallocated entry
+    // Search smallest deallocated block the kernel fits in
+    iSearchIndex = RenderHal_FindFreeKernelBlock(pStateHeap, iKernelSize);
     if (iSearchIndex >= 0)
     {
-        int32_t iMinSize = 0;
+        iSearchIndex = RenderHal_RemoveFreeKernelBlock(pStateHeap, iSearchIndex);
 
-        iSearchIndex = -1;
-        pKernelAllocation = pStateHeap->pKernelAllocation;
-        for (iKernelAllocationID = 0;
-             iKernelAllocationID < iMaxKernels;
-             iKernelAllocationID++, pKernelAllocation++)
-        {
-            // Skip allocated/empty entries
-            if (pKernelAllocation->dwFlags != RENDERHAL_KERNEL_ALLOCATION_FREE ||
-                pKernelAllocation->iSize   == 0)
-            {
-                continue;
-            }
+        pStats->LastResult = RENDERHAL_KERNEL_LOAD_RESULT_REUSE;
+        pStats->dwReuses++;
+    }
+    else if ((pStateHeap->iFreeKernelBlocks > 0) &&
+             (pStateHeap->iKernelUsed + iKernelSize <= pStateHeap->iKernelSize))
+    {
+        // All allocation indices used, but space left at the end of the heap:
+        // give up the smallest free block to get an allocation index
+        iKernelAllocationID = RenderHal_RemoveFreeKernelBlock(pStateHeap, 0);
+        pKernelAllocation   = &(pStateHeap->pKernelAllocation[iKernelAllocationID]);
 
-            // Allocate minimum available block
-            if (pKernelAllocation->iSize >= iKernelSize)
-            {
-                if (iSearchIndex < 0 ||
-                    pKernelAllocation->iSize < iMinSize)
-                {
-                    iSearchIndex = iKernelAllocationID;
-                    iMinSize     = pKernelAllocation->iSize;
-                }
-            }
-        }
+        dwOffset = pStateHeap->dwKernelBase + pStateHeap->iKernelUsed;
+        pStateHeap->iKernelUsed += iSize;
+
+        pStats->LastResult = RENDERHAL_KERNEL_LOAD_RESULT_APPEND;
+        pStats->dwAppends++;
+
+        goto loadkernel;
     }
 
     // Did not find block, try to deallocate a kernel not recently used
     if (iSearchIndex < 0)
     {
-        uint32_t dwOldest = 0;
+        uint32_t dwOldest    = 0;
+        int32_t  iOldestSize = 0;
         uint32_t dwLastUsed;
 
-        // Search and deallocate least used kernel
+        // Search and deallocate the kernel not used for the longest time relative to its
+        // block size, so that a large block is only taken over a tight one if it is older
         pKernelAllocation = pStateHeap->pKernelAllocation;
         for (iKernelAllocationID = 0;
              iKernelAllocationID < iMaxKernels;
@@ -2106,13 +2286,20 @@ int32_t RenderHal_LoadKernel(
                 continue;
             }
 
-            // Find kernel not used for the greater amount of time (measured in number of operations)
             // Must not unload recently allocated kernels
             dwLastUsed = (uint32_t)(pStateHeap->dwAccessCounter - pKernelAllocation->dwCount);
-            if (dwLastUsed > dwOldest)
+            if (dwLastUsed == 0)
+            {
+                continue;
+            }
+
+            // dwLastUsed / iSize > dwOldest / iOldestSize
+            if (iSearchIndex < 0 ||
+                (uint64_t)dwLastUsed * iOldestSize > (uint64_t)dwOldest * pKernelAllocation->iSize)
             {
                 iSearchIndex = iKernelAllocationID;
                 dwOldest     = dwLastUsed;
+                iOldestSize  = pKernelAllocation->iSize;
             }
         }
 
@@ -2121,6 +2308,8 @@ int32_t RenderHal_LoadKernel(
         {
             MHW_RENDERHAL_NORMALMESSAGE("Failed to load kernel - no space available in GSH.");
             iKernelAllocationID = RENDERHAL_KERNEL_LOAD_FAIL;
+            pStats->LastResult  = RENDERHAL_KERNEL_LOAD_RESULT_FAIL;
+            pStats->dwFailures++;
             goto finish;
         }
 
@@ -2129,8 +2318,23 @@ int32_t RenderHal_LoadKernel(
         {
             MHW_RENDERHAL_NORMALMESSAGE("Failed to load kernel - no space available in GSH.");
             iKernelAllocationID = RENDERHAL_KERNEL_LOAD_FAIL;
+            pStats->LastResult  = RENDERHAL_KERNEL_LOAD_RESULT_FAIL;
+            pStats->dwFailures++;
             goto finish;
         }
+
+        // Unload put the block in the free list, take it back
+        for (i = 0; i < pStateHeap->iFreeKernelBlocks; i++)
+        {
+            if (pStateHeap->piFreeKernelBlocks[i] == iSearchIndex)
+            {
+                RenderHal_RemoveFreeKernelBlock(pStateHeap, i);
+                break;
+            }
+        }
+
+        pStats->LastResult = RENDERHAL_KERNEL_LOAD_RESULT_EVICT;
+        pStats->dwEvictions++;
     }
 
     // Allocate the entry
@@ -2154,6 +2358,7 @@ loadkernel:
     pKernelAllocation->Params          = *pParameters;
     pKernelAllocation->pKernelEntry    = pKernelEntry;
     pKernelAllocation->iAllocIndex     = iKernelAllocationID;
+    RenderHal_InsertKernelIndex(pStateHeap, iKernelAllocationID);
 
     // Copy kernel data
     MOS_SecureMemcpy(pStateHeap->pIshBuffer + dwOffset, iKernelSize, pKernelPtr, iKernelSize);
@@ -2236,6 +2441,12 @@ MOS_STATUS RenderHal_UnloadKernel(
         pKernelAllocation->pKernelEntry->dwLoaded = 0;
     }
 
+    RenderHal_RemoveKernelIndex(pStateHeap, iKernelAllocationID);
+    if (pKernelAllocation->iSize > 0)
+    {
+        RenderHal_InsertFreeKernelBlock(pStateHeap, iKernelAllocationID);
+    }
+
     // Release kernel entry (Offset/size may be used for reallocation)
     pKernelAllocation->iKID             = -1;
     pKernelAllocation->iKUID            = -1;
@@ -2336,6 +2547,14 @@ void RenderHal_ResetKernels(
         pKernelAllocation->Params           = g_cRenderHal_InitKernelParams;
     }
 
+    // Reset kernel allocation index
+    if (pStateHeap->piKernelIndex)
+    {
+        MOS_ZeroMemory(pStateHeap->piKernelIndex, (pStateHeap->dwKernelIndexMask + 1) * sizeof(int32_t));
+    }
+    pStateHeap->iFreeKernelBlocks = 0;
+    pStateHeap->iKernelAllocEmpty = 0;
+
     // Free Kernel Heap
     pStateHeap->dwAccessCounter = 0;
     pStateHeap->iKernelSize = pRenderHal->StateHeapSettings.iKernelHeapSize;
@@ -785,6 +785,33 @@ typedef struct _RENDERHAL_KRN_ALLOC_LIST
     int32_t                   iCount;                                           // Number of objects
 } RENDERHAL_KRN_ALLOC_LIST, *PRENDERHAL_KRN_ALLOC_LIST;
 
+//!
+//! \brief  Result of the last RenderHal_LoadKernel call
+//!
+typedef enum _RENDERHAL_KERNEL_LOAD_RESULT
+{
+    RENDERHAL_KERNEL_LOAD_RESULT_NONE = 0,
+    RENDERHAL_KERNEL_LOAD_RESULT_HIT,                   //!< Kernel already loaded
+    RENDERHAL_KERNEL_LOAD_RESULT_APPEND,                //!< Loaded at the end of the kernel heap
+    RENDERHAL_KERNEL_LOAD_RESULT_REUSE,                 //!< Loaded into a block freed by an earlier unload
+    RENDERHAL_KERNEL_LOAD_RESULT_EVICT,                 //!< Loaded after unloading another kernel
+    RENDERHAL_KERNEL_LOAD_RESULT_FAIL                   //!< No space available
+} RENDERHAL_KERNEL_LOAD_RESULT;
+
+//!
+//! \brief  Kernel load statistics (legacy ISH)
+//!
+typedef struct _RENDERHAL_KERNEL_LOAD_STATS
+{
+    RENDERHAL_KERNEL_LOAD_RESULT LastResult;                                    // Result of the last load call
+    uint32_t                     dwHits;                                        // Kernel found loaded
+    uint32_t                     dwMisses;                                      // Kernel not loaded (append + reuse + evict + fail)
+    uint32_t                     dwAppends;                                     // Loaded at the end of the heap
+    uint32_t                     dwReuses;                                      // Loaded into a free block
+    uint32_t                     dwEvictions;                                   // Kernels unloaded to make room
+    uint32_t                     dwFailures;                                    // Kernels that could not be loaded
+} RENDERHAL_KERNEL_LOAD_STATS, *PRENDERHAL_KERNEL_LOAD_STATS;
+
 typedef struct _RENDERHAL_MEDIA_STATE *PRENDERHAL_MEDIA_STATE;
 
 typedef struct _RENDERHAL_DYNAMIC_STATE *PRENDERHAL_DYNAMIC_STATE;
@@ -955,6 +982,14 @@ typedef struct _RENDERHAL_STATE_HEAP
     uint32_t                dwAccessCounter;                                    // Incremented when a kernel is loaded/used, for dynamic allocation
     int32_t                 iKernelUsedForDump;                                 // The kernel size to be dumped in oca buffer.
 
+    // Kernel allocation index (legacy ISH)
+    int32_t                 *piKernelIndex;                                     // (KUID, KCID) hash -> allocation index + 1, 0 if empty
+    uint32_t                dwKernelIndexMask;                                  // Hash table size - 1 (power of 2)
+    int32_t                 *piFreeKernelBlocks;                                // Free allocations holding ISH space, sorted by size
+    int32_t                 iFreeKernelBlocks;                                  // Number of free allocations holding ISH space
+    int32_t                 iKernelAllocEmpty;                                  // First allocation never assigned ISH space
+    RENDERHAL_KERNEL_LOAD_STATS KernelLoadStats;                                // Kernel load statistics
+
     // Kernel Spill Area
     uint32_t                dwScratchSpaceSize;                                 // Size of the Scratch Area
     uint32_t                dwScratchSpaceBase;                                 // Base of the Scratch area
@@ -443,8 +443,8 @@ PRENDERHAL_KRN_ALLOCATION RenderHal_DSH_SearchDynamicKernel(PRENDERHAL_INTERFACE
     pStateHeap = (pRenderHal) ? pRenderHal->pStateHeap : nullptr;
     if (pStateHeap)
     {
-        uint16_t wSearchIndex = 0;
-        pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION) pStateHeap->kernelHashTable.Search(iUniqID, iCacheID, wSearchIndex);
+        uint32_t dwSearchIndex = 0;
+        pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION) pStateHeap->kernelHashTable.Search(iUniqID, iCacheID, dwSearchIndex);
     }
 
     return pKernelAllocation;
@@ -468,7 +468,7 @@ PRENDERHAL_KRN_ALLOCATION RenderHal_DSH_AllocateDynamicKernel(PRENDERHAL_INTERFA
 {
     PRENDERHAL_STATE_HEAP      pStateHeap;
     PRENDERHAL_KRN_ALLOCATION  pKernelAllocation = nullptr;
-    uint16_t                   wSearchIndex = 0;
+    uint32_t                   dwSearchIndex = 0;
     MOS_STATUS                 eStatus = MOS_STATUS_SUCCESS;
 
     pStateHeap = (pRenderHal) ? pRenderHal->pStateHeap : nullptr;
@@ -477,7 +477,7 @@ PRENDERHAL_KRN_ALLOCATION RenderHal_DSH_AllocateDynamicKernel(PRENDERHAL_INTERFA
         goto finish;
     }
 
-    pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION)pStateHeap->kernelHashTable.Search(iUniqID, iCacheID, wSearchIndex);
+    pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION)pStateHeap->kernelHashTable.Search(iUniqID, iCacheID, dwSearchIndex);
 
     if (!pKernelAllocation)
     {
@@ -1261,7 +1261,7 @@ PRENDERHAL_KRN_ALLOCATION RenderHal_DSH_LoadDynamicKernel(
     int32_t                      iKernelSize;                // Kernel size
     int32_t                      iKernelUniqueID;            // Kernel unique ID
     int32_t                      iKernelCacheID;             // Kernel cache ID
-    uint16_t                     wSearchIndex = 0;
+    uint32_t                     dwSearchIndex = 0;
     MOS_STATUS                   eStatus = MOS_STATUS_SUCCESS;
 
     MHW_RENDERHAL_CHK_NULL(pRenderHal);
@@ -1285,7 +1285,7 @@ PRENDERHAL_KRN_ALLOCATION RenderHal_DSH_LoadDynamicKernel(
     iKernelUniqueID = pKernel->iKUID;
     iKernelCacheID  = pKernel->iKCID;
 
-    pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION)pStateHeap->kernelHashTable.Search(iKernelUniqueID, iKernelCacheID, wSearchIndex);
+    pKernelAllocation = (PRENDERHAL_KRN_ALLOCATION)pStateHeap->kernelHashTable.Search(iKernelUniqueID, iKernelCacheID, dwSearchIndex);
 
     // Kernel already loaded
     if (pKernelAllocation)
@@ -70,6 +70,13 @@ struct NodeHeader
 
 #define BASE_OF_NODE(perfDataIndex) (sizeof(NodeHeader) + (sizeof(PerfEntry) * perfDataIndex))
 
+#define PERF_NODE_INVALID       0xFFFFFFFF
+
+// Timestamps are stored 8 bytes aligned, so every node's end timestamp spills
+// one dword into the next node. Ring mode keeps that layout in its output.
+static_assert(sizeof(NodeHeader) % 8 == 4 && sizeof(PerfEntry) % 8 == 0,
+    "Unexpected perf node layout");
+
 #define CHK_STATUS_RETURN(_stmt)                   \
 {                                                  \
     MOS_STATUS stmtStatus = (MOS_STATUS)(_stmt);   \
@@ -109,6 +116,7 @@ struct NodeHeader
 MediaPerfProfiler::MediaPerfProfiler()
 {
     MOS_ZeroMemory(&m_perfStoreBuffer, sizeof(m_perfStoreBuffer));
+    MOS_ZeroMemory(m_ringFileName, sizeof(m_ringFileName));
     m_perfDataIndex = 0;
     m_ref           = 0;
     m_initialized   = false;
@@ -175,7 +183,28 @@ void MediaPerfProfiler::Destroy(MediaPerfProfiler* profiler, void* context, MOS_
     {
         if (profiler->m_initialized == true)
         {
-            if(profiler->m_enableProfilerDump)
+            if (profiler->m_ringMode)
+            {
+                // The drain thread never takes m_mutex, so it can be joined here
+                profiler->m_drainStop = true;
+                if (profiler->m_drainThread)
+                {
+                    MOS_WaitThread(profiler->m_drainThread);
+                    profiler->m_drainThread = 0;
+                }
+
+                profiler->DrainCompletedNodes();
+                if (profiler->m_droppedNodes)
+                {
+                    MOS_OS_NORMALMESSAGE("Perf profiler ring was full, %d nodes dropped.", profiler->m_droppedNodes);
+                }
+
+                osInterface->pfnUnlockResource(
+                    osInterface,
+                    &profiler->m_perfStoreBuffer);
+                profiler->m_perfStoreData = nullptr;
+            }
+            else if(profiler->m_enableProfilerDump)
             {
                 profiler->SavePerfData(osInterface);
             }
@@ -276,6 +305,45 @@ MOS_STATUS MediaPerfProfiler::Initialize(void* context, MOS_INTERFACE *osInterfa
         osInterface->pOsContext);
     m_multiprocess = userFeatureData.u32Data;
 
+    // Read ring buffer mode, it streams to the output file so needs the dump
+    MOS_ZeroMemory(&userFeatureData, sizeof(userFeatureData));
+    MOS_UserFeature_ReadValue_ID(
+        nullptr,
+        __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_RING_MODE,
+        &userFeatureData,
+        osInterface->pOsContext);
+    m_ringMode = userFeatureData.u32Data && m_enableProfilerDump;
+
+    MOS_ZeroMemory(&userFeatureData, sizeof(userFeatureData));
+    MOS_UserFeature_ReadValue_ID(
+        nullptr,
+        __MEDIA_USER_FEATURE_VALUE_PERF_PROFILER_DRAIN_INTERVAL,
+        &userFeatureData,
+        osInterface->pOsContext);
+    m_drainInterval = MOS_MAX(userFeatureData.u32Data, 1);
+
+    if (m_ringMode)
+    {
+        // Keep room for the dword the last node's end timestamp spills over
+        uint32_t nodeNum = 0;
+        if (m_bufferSize > sizeof(NodeHeader) + sizeof(uint32_t))
+        {
+            nodeNum = (m_bufferSize - sizeof(NodeHeader) - sizeof(uint32_t)) / sizeof(PerfEntry);
+        }
+        if (nodeNum == 0)
+        {
+            MOS_UnlockMutex(m_mutex);
+            return MOS_STATUS_INVALID_PARAMETER;
+        }
+
+        // Power of two so the slot stays continuous when the index wraps
+        m_ringCapacity = 1;
+        while ((m_ringCapacity << 1) <= nodeNum)
+        {
+            m_ringCapacity <<= 1;
+        }
+    }
+
     // Read memory information register address
     int8_t regIndex = 0;
     for (regIndex = 0; regIndex < 8; regIndex++)
@@ -315,7 +383,7 @@ MOS_STATUS MediaPerfProfiler::Initialize(void* context, MOS_INTERFACE *osInterfa
 
     MOS_LOCK_PARAMS lockFlags;
     MOS_ZeroMemory(&lockFlags, sizeof(MOS_LOCK_PARAMS));
-    lockFlags.WriteOnly   = 1;
+    lockFlags.WriteOnly   = m_ringMode ? 0 : 1;
 
     NodeHeader* header = (NodeHeader*)osInterface->pfnLockResource(
             osInterface,
@@ -339,9 +407,53 @@ MOS_STATUS MediaPerfProfiler::Initialize(void* context, MOS_INTERFACE *osInterfa
         header->perfMode    = UMD_PERF_MODE_TIMING_ONLY;
     }
 
-    osInterface->pfnUnlockResource(
-            osInterface,
-            &m_perfStoreBuffer);
+    if (m_ringMode)
+    {
+        if (m_multiprocess)
+        {
+            int32_t pid       = MOS_GetPid();
+            tm      localtime = {0};
+            MOS_GetLocalTime(&localtime);
+
+            MOS_SecureStringPrint(m_ringFileName, MOS_MAX_PATH_LENGTH + 1, MOS_MAX_PATH_LENGTH + 1, "%s-pid%d-%04d%02d%02d%02d%02d%02d.bin",
+                m_outputFileName, pid, localtime.tm_year + 1900, localtime.tm_mon + 1, localtime.tm_mday, localtime.tm_hour, localtime.tm_min, localtime.tm_sec);
+        }
+        else
+        {
+            MOS_SecureStringPrint(m_ringFileName, MOS_MAX_PATH_LENGTH + 1, MOS_MAX_PATH_LENGTH + 1, "%s", m_outputFileName);
+        }
+
+        // Same file layout as SavePerfData(), the nodes are appended as they complete
+        status = MOS_WriteFileFromPtr(m_ringFileName, header, sizeof(NodeHeader));
+        if (status != MOS_STATUS_SUCCESS)
+        {
+            osInterface->pfnUnlockResource(osInterface, &m_perfStoreBuffer);
+            MOS_UnlockMutex(m_mutex);
+            return status;
+        }
+
+        // The buffer stays mapped so the drain thread needs no OS interface
+        m_perfStoreData = (uint8_t *)header;
+        m_poisonedSlots = std::vector<std::atomic<bool>>(m_ringCapacity);
+        m_perfDataIndex = 0;
+        m_issuedIndex   = 0;
+        m_drainedIndex  = 0;
+        m_drainCarry    = 0;
+        m_droppedNodes  = 0;
+        m_drainStop     = false;
+
+        m_drainThread = MOS_CreateThread((void *)DrainThread, this);
+        if (!m_drainThread)
+        {
+            MOS_OS_ASSERTMESSAGE("Create perf profiler drain thread failed, nodes are drained at destroy only!");
+        }
+    }
+    else
+    {
+        osInterface->pfnUnlockResource(
+                osInterface,
+                &m_perfStoreBuffer);
+    }
 
     m_initialized = true;
 
@@ -450,9 +562,36 @@ MOS_STATUS MediaPerfProfiler::AddPerfCollectStartCmd(void* context,
 
     MOS_LockMutex(m_mutex);
 
+    if (m_ringMode)
+    {
+        // Step over poisoned slots, the drain thread skips their indexes too
+        while (m_perfDataIndex - m_drainedIndex < m_ringCapacity &&
+            m_poisonedSlots[m_perfDataIndex & (m_ringCapacity - 1)])
+        {
+            m_perfDataIndex++;
+        }
+
+        if (m_perfDataIndex - m_drainedIndex >= m_ringCapacity)
+        {
+            // The drain thread is behind, drop the node instead of waiting for it
+            m_droppedNodes++;
+            m_issuedIndex = m_perfDataIndex;
+            MOS_UnlockMutex(m_mutex);
+
+            m_contextIndexMap[context] = PERF_NODE_INVALID;
+            return status;
+        }
+    }
+
     perfDataIndex = m_perfDataIndex;
     m_perfDataIndex++;
 
+    if (m_ringMode)
+    {
+        m_issuedIndex = m_perfDataIndex;
+        perfDataIndex &= m_ringCapacity - 1;
+    }
+
     MOS_UnlockMutex(m_mutex);
 
     m_contextIndexMap[context] = perfDataIndex;
@@ -566,6 +705,10 @@ MOS_STATUS MediaPerfProfiler::AddPerfCollectEndCmd(void* context,
     rcsEngineUsed = MOS_RCS_ENGINE_USED(gpuContext);
 
     perfDataIndex = m_contextIndexMap[context];
+    if (perfDataIndex == PERF_NODE_INVALID)
+    {
+        return status;
+    }
 
     int8_t regIndex = 0;
     for (regIndex = 0; regIndex < 8; regIndex++)
@@ -649,6 +792,88 @@ MOS_STATUS MediaPerfProfiler::SavePerfData(MOS_INTERFACE *osInterface)
     return status;
 }
 
+MOS_STATUS MediaPerfProfiler::DrainCompletedNodes()
+{
+    CHK_NULL_RETURN(m_perfStoreData);
+
+    uint32_t issued  = m_issuedIndex;
+    uint32_t drained = m_drainedIndex;
+
+    m_drainData.clear();
+
+    while (drained != issued)
+    {
+        uint32_t slot      = drained & (m_ringCapacity - 1);
+        uint8_t  *node     = m_perfStoreData + BASE_OF_NODE(slot);
+        uint32_t endOffset = MOS_ALIGN_CEIL(BASE_OF_NODE(slot) + OFFSET_OF(PerfEntry, endTimeClockValue), 8);
+        bool     completed = *(volatile uint64_t *)(m_perfStoreData + endOffset) != 0;
+
+        if (m_poisonedSlots[slot])
+        {
+            // Skipped by AddPerfCollectStartCmd, the late node still owns the
+            // slot until its end timestamp lands
+            if (completed)
+            {
+                MOS_ZeroMemory(node, sizeof(PerfEntry) + sizeof(uint32_t));
+                m_poisonedSlots[slot] = false;
+            }
+            drained++;
+            continue;
+        }
+
+        if (!completed)
+        {
+            if (issued - drained <= m_ringCapacity / 2)
+            {
+                break;
+            }
+            // The GPU may still write the node, so its slot is not handed out
+            // again before the end timestamp lands
+            MOS_OS_NORMALMESSAGE("Perf node %d not completed, skipped and its slot poisoned.", drained);
+            m_poisonedSlots[slot] = true;
+            drained++;
+            continue;
+        }
+        else
+        {
+            // The first dword of an output node carries the spilled half of
+            // the previous node's end timestamp, like in the buffer itself
+            size_t size = m_drainData.size();
+            m_drainData.resize(size + sizeof(PerfEntry));
+            MOS_SecureMemcpy(&m_drainData[size], sizeof(PerfEntry), node, sizeof(PerfEntry));
+            MOS_SecureMemcpy(&m_drainData[size], sizeof(uint32_t), &m_drainCarry, sizeof(uint32_t));
+            m_drainCarry = *(uint32_t *)(node + sizeof(PerfEntry));
+        }
+
+        // Clear the node and its spilled dword before the slot is handed out again
+        MOS_ZeroMemory(node, sizeof(PerfEntry) + sizeof(uint32_t));
+        drained++;
+    }
+
+    MOS_STATUS status = MOS_STATUS_SUCCESS;
+    if (!m_drainData.empty())
+    {
+        status = MOS_AppendFileFromPtr(m_ringFileName, m_drainData.data(), (uint32_t)m_drainData.size());
+    }
+
+    m_drainedIndex = drained;
+
+    return status;
+}
+
+void *MediaPerfProfiler::DrainThread(void *profiler)
+{
+    MediaPerfProfiler *perfProfiler = (MediaPerfProfiler *)profiler;
+
+    while (!perfProfiler->m_drainStop)
+    {
+        MOS_Sleep(perfProfiler->m_drainInterval);
+        perfProfiler->DrainCompletedNodes();
+    }
+
+    return nullptr;
+}
+
 PerfGPUNode MediaPerfProfiler::GpuContextToGpuNode(MOS_GPU_CONTEXT context)
 {
     PerfGPUNode node = PERF_GPU_NODE_UNKNOW;
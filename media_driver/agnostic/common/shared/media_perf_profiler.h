@@ -26,7 +26,9 @@
 #ifndef __MEDIA_PERF_PROFILER_H__
 #define __MEDIA_PERF_PROFILER_H__
 
+#include <atomic>
 #include <map>
+#include <vector>
 #include "mos_os.h"
 #include "mhw_mi.h"
 
@@ -222,6 +224,30 @@ private:
     //!
     MOS_STATUS SavePerfData(MOS_INTERFACE *osInterface);
 
+    //!
+    //! \brief    Append the completed nodes of the ring to the output file
+    //!
+    //! \details  Nodes are drained in issue order and their slots are cleared
+    //!           for reuse. A node that stays incomplete while half of the ring
+    //!           has been issued after it is dropped, so a lost end command
+    //!           cannot stall the ring. Its slot is poisoned and only reused
+    //!           once the late end timestamp has landed.
+    //!
+    //! \return   MOS_STATUS
+    //!           MOS_STATUS_SUCCESS if success, else fail reason
+    //!
+    MOS_STATUS DrainCompletedNodes();
+
+    //!
+    //! \brief    Ring mode drain thread entry
+    //!
+    //! \param    [in] profiler
+    //!           Pointer of profiler
+    //!
+    //! \return   void *
+    //!
+    static void *DrainThread(void *profiler);
+
     //!
     //! \brief    Convert GPU context to GPU node 
     //!
@@ -259,6 +285,20 @@ protected:
     bool                       m_initialized = false;   //!< Indicate whether profiler was initialized
     char                       m_outputFileName[MOS_MAX_PATH_LENGTH + 1];  //!< Name of output file
     bool                       m_enableProfilerDump = true;   //!< Indicate whether enable UMD Profiler dump
+
+    int32_t                    m_ringMode = 0;          //!< Reuse the buffer as a ring drained to the output file
+    uint32_t                   m_drainInterval = 100;   //!< Ring mode drain period in ms
+    uint32_t                   m_ringCapacity = 0;      //!< Number of nodes in the ring, power of two
+    std::atomic<uint32_t>      m_issuedIndex{0};        //!< Ring mode: nodes handed out to command buffers
+    std::atomic<uint32_t>      m_drainedIndex{0};       //!< Ring mode: nodes written out and cleared
+    std::atomic<bool>          m_drainStop{false};      //!< Ring mode: ask the drain thread to exit
+    MOS_THREADHANDLE           m_drainThread = 0;       //!< Ring mode drain thread
+    uint8_t                    *m_perfStoreData = nullptr; //!< Ring mode: persistent mapping of m_perfStoreBuffer
+    uint32_t                   m_drainCarry = 0;        //!< Ring mode: leading dword of the next output node
+    uint32_t                   m_droppedNodes = 0;      //!< Ring mode: nodes skipped because the ring was full
+    std::vector<uint8_t>       m_drainData;             //!< Ring mode: output staging of one drain pass
+    std::vector<std::atomic<bool>> m_poisonedSlots;     //!< Ring mode: slots still owned by a skipped incomplete node
+    char                       m_ringFileName[MOS_MAX_PATH_LENGTH + 1];  //!< Ring mode output file
 };
 
 #endif // __MEDIA_PERF_PROFILER_H__
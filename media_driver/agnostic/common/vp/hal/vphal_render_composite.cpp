@@ -5879,6 +5879,7 @@ MOS_STATUS CompositeState::RenderPhase(
     MHW_GPGPU_WALKER_PARAMS         ComputeWalkerParams     = {};
     PMHW_GPGPU_WALKER_PARAMS        pComputeWalkerParams    = nullptr;
     bool                            bKernelEntryUpdate      = false;
+    bool                            bDiskCacheHit           = false;
     bool                            bColorfill              = false;
     bool                            bEUFusedDispatchFlag    = false;
 
@@ -6141,8 +6142,16 @@ MOS_STATUS CompositeState::RenderPhase(
             iFilterSize,
             1);
 
+        // Kernels built by earlier processes skip search and build
+        bDiskCacheHit = KernelDll_LoadDiskCachedKernel(
+                            pKernelDllState,
+                            pSearchState,
+                            pFilter,
+                            iFilterSize,
+                            dwKernelHash);
+
         // Search kernel
-        if (!pKernelDllState->pfnSearchKernel(pKernelDllState, pSearchState))
+        if (!bDiskCacheHit && !pKernelDllState->pfnSearchKernel(pKernelDllState, pSearchState))
         {
             VPHAL_RENDER_ASSERTMESSAGE("Failed to find a kernel.");
             eStatus = MOS_STATUS_UNKNOWN;
@@ -6150,7 +6159,7 @@ MOS_STATUS CompositeState::RenderPhase(
         }
 
         // Build kernel
-        if (!pKernelDllState->pfnBuildKernel(pKernelDllState, pSearchState))
+        if (!bDiskCacheHit && !pKernelDllState->pfnBuildKernel(pKernelDllState, pSearchState))
         {
             VPHAL_RENDER_ASSERTMESSAGE("Failed to build kernel.");
             eStatus = MOS_STATUS_UNKNOWN;
@@ -6171,6 +6180,16 @@ MOS_STATUS CompositeState::RenderPhase(
             eStatus = MOS_STATUS_UNKNOWN;
             goto finish;
         }
+
+        if (!bDiskCacheHit)
+        {
+            KernelDll_StoreDiskCachedKernel(
+                pKernelDllState,
+                pSearchState,
+                pFilter,
+                iFilterSize,
+                dwKernelHash);
+        }
     }
     else
     {
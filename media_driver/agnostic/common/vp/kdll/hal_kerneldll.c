@@ -3458,6 +3458,7 @@ void KernelDll_ReleaseStates(Kdll_State *pState)
     VPHAL_RENDER_FUNCTION_ENTER;
 
     if (!pState) return;
+    KernelDll_ReleaseDiskCache(pState);
     KernelDll_ReleaseAdditionalCacheEntries(&pState->KernelCache);
     MOS_FreeMemory(pState->ComponentKernelCache.pCache);
     MOS_FreeMemory(pState->CmFcPatchCache.pCache);
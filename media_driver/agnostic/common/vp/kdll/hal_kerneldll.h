@@ -629,6 +629,9 @@ typedef struct tagKdll_State
     // Colorfill
     VPHAL_CSPACE            colorfill_cspace;       // Selected colorfill Color Space by Kdll
 
+    // Persistent combined kernel cache (OS specific)
+    void                    *pDiskCache;            // Disk cache state, nullptr until first lookup
+
     // Start kernel search
     void                 (* pfnStartKernelSearch)(PKdll_State       pState,
                                                   PKdll_SearchState pSearchState,
@@ -863,6 +866,25 @@ bool KernelDll_SearchKernel(
 // Build kernel in SearchState
 bool KernelDll_BuildKernel(Kdll_State *pState, Kdll_SearchState *pSearchState);
 
+// Load combined kernel from persistent cache, output is in pSearchState
+bool KernelDll_LoadDiskCachedKernel(
+    Kdll_State       *pState,
+    Kdll_SearchState *pSearchState,
+    Kdll_FilterEntry *pFilter,
+    int32_t           iFilterSize,
+    uint32_t          dwHash);
+
+// Store combined kernel built in pSearchState to persistent cache
+void KernelDll_StoreDiskCachedKernel(
+    Kdll_State       *pState,
+    Kdll_SearchState *pSearchState,
+    Kdll_FilterEntry *pFilter,
+    int32_t           iFilterSize,
+    uint32_t          dwHash);
+
+// Release persistent cache state
+void KernelDll_ReleaseDiskCache(Kdll_State *pState);
+
 bool KernelDll_SetupCSC(
     Kdll_State       *pState,
     Kdll_SearchState *pSearchState);
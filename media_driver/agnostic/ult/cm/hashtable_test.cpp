@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../common/cm/cm_hal_hashtable.h"
+
+static void *ToData(uintptr_t value)
+{
+    return reinterpret_cast<void *>(value);
+}
+
+class HashTableTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        m_table = CmHashTable();
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Init());
+    }
+
+    void TearDown() override
+    {
+        m_table.Free();
+    }
+
+    CmHashTable m_table;
+};
+
+TEST_F(HashTableTest, RegisterSearchUnregister)
+{
+    uint32_t handle = 0;
+
+    EXPECT_EQ(nullptr, m_table.Search(7, 1, handle));
+    EXPECT_EQ(0u, handle);
+
+    ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(7, 1, ToData(71)));
+    ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(7, 2, ToData(72)));
+    ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(8, -1, ToData(80)));
+
+    EXPECT_EQ(ToData(72), m_table.Search(7, 2, handle));
+    EXPECT_EQ(ToData(72), m_table.GetData(handle));
+    EXPECT_EQ(ToData(80), m_table.Search(8, -1, handle));
+    EXPECT_EQ(nullptr, m_table.Search(7, 3, handle));
+
+    // A negative CacheID matches any CacheID
+    void *data = m_table.Search(7, -1, handle);
+    EXPECT_TRUE(data == ToData(71) || data == ToData(72));
+
+    EXPECT_EQ(ToData(71), m_table.Unregister(7, 1));
+    EXPECT_EQ(nullptr, m_table.Unregister(7, 1));
+    EXPECT_EQ(ToData(72), m_table.Search(7, -1, handle));
+    EXPECT_EQ(2u, m_table.GetCount());
+}
+
+TEST_F(HashTableTest, HandlesStableAcrossGrowth)
+{
+    const uint32_t kernelCount = 20000;
+    std::vector<uint32_t> handles(kernelCount);
+
+    for (uint32_t i = 0; i < kernelCount; i++)
+    {
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(i, i & 3, ToData(i + 1)));
+        ASSERT_EQ(ToData(i + 1), m_table.Search(i, i & 3, handles[i]));
+    }
+
+    for (uint32_t i = 0; i < kernelCount; i++)
+    {
+        EXPECT_EQ(ToData(i + 1), m_table.GetData(handles[i]));
+    }
+    EXPECT_EQ(kernelCount, m_table.GetCount());
+}
+
+TEST_F(HashTableTest, RandomChurn)
+{
+    std::mt19937                                       rng(0x5eed);
+    std::map<std::pair<int32_t, int32_t>, uintptr_t>   live;
+    uint32_t                                           handle = 0;
+
+    for (int i = 0; i < 500000; i++)
+    {
+        int32_t uniqID  = rng() % 8192;
+        int32_t cacheID = rng() % 4;
+        auto    key     = std::make_pair(uniqID, cacheID);
+        auto    it      = live.find(key);
+
+        if (it != live.end())
+        {
+            ASSERT_EQ(ToData(it->second), m_table.Search(uniqID, cacheID, handle));
+            ASSERT_EQ(ToData(it->second), m_table.Unregister(uniqID, cacheID));
+            live.erase(it);
+        }
+        else
+        {
+            ASSERT_EQ(nullptr, m_table.Search(uniqID, cacheID, handle));
+            ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(uniqID, cacheID, ToData(i + 1)));
+            live[key] = i + 1;
+        }
+    }
+
+    EXPECT_EQ(live.size(), m_table.GetCount());
+    for (auto &entry : live)
+    {
+        EXPECT_EQ(ToData(entry.second), m_table.Search(entry.first.first, entry.first.second, handle));
+    }
+}
+
+// Search latency as the number of registered kernels grows
+TEST_F(HashTableTest, LookupLatency)
+{
+    const uint32_t lookupCount = 1000000;
+    uint32_t       registered  = 0;
+    uint32_t       handle      = 0;
+
+    for (uint32_t kernelCount : {100u, 1000u, 10000u})
+    {
+        for (; registered < kernelCount; registered++)
+        {
+            ASSERT_EQ(MOS_STATUS_SUCCESS, m_table.Register(registered * 7919, 0, ToData(registered + 1)));
+        }
+
+        uintptr_t found = 0;
+        auto      start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < lookupCount; i++)
+        {
+            found += (uintptr_t)m_table.Search((i % kernelCount) * 7919, 0, handle);
+        }
+        auto   end = std::chrono::steady_clock::now();
+        double hit = std::chrono::duration<double, std::nano>(end - start).count() / lookupCount;
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < lookupCount; i++)
+        {
+            found += (uintptr_t)m_table.Search((i % kernelCount) * 7919 + 1, 0, handle);
+        }
+        end         = std::chrono::steady_clock::now();
+        double miss = std::chrono::duration<double, std::nano>(end - start).count() / lookupCount;
+
+        EXPECT_NE(0u, found);
+        RecordProperty("HitNs" + std::to_string(kernelCount), std::to_string(hit));
+        RecordProperty("MissNs" + std::to_string(kernelCount), std::to_string(miss));
+    }
+}
@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../../common/cm/cm_task_ring.h"
+
+using CMRT_UMD::CmTaskInternal;
+using CMRT_UMD::CmTaskRing;
+
+// The ring never dereferences the tasks, so plain integers stand in for them
+static CmTaskInternal *ToTask(uintptr_t value)
+{
+    return reinterpret_cast<CmTaskInternal *>(value);
+}
+
+TEST(TaskRingTest, FifoFullEmpty)
+{
+    CmTaskRing ring;
+    ASSERT_TRUE(ring.Init(5));
+    EXPECT_EQ(8u, ring.GetCapacity());
+    EXPECT_TRUE(ring.IsEmpty());
+    EXPECT_EQ(nullptr, ring.Pop());
+
+    // Wrap around several times
+    for (uintptr_t round = 0; round < 4; round++)
+    {
+        for (uintptr_t i = 1; i <= 8; i++)
+        {
+            EXPECT_TRUE(ring.Push(ToTask(round * 8 + i)));
+        }
+        EXPECT_FALSE(ring.Push(ToTask(100)));
+        EXPECT_EQ(8u, ring.GetCount());
+
+        for (uintptr_t i = 1; i <= 8; i++)
+        {
+            EXPECT_EQ(ToTask(round * 8 + i), ring.Pop());
+        }
+        EXPECT_EQ(nullptr, ring.Pop());
+        EXPECT_TRUE(ring.IsEmpty());
+    }
+}
+
+TEST(TaskRingTest, MultipleProducers)
+{
+    // Tag values with the producer in bits 24+ so they fit a 32-bit pointer
+    const uintptr_t producerShift = 24;
+    const uintptr_t taskMask      = (uintptr_t(1) << producerShift) - 1;
+    const uintptr_t producerCount = 4;
+    const uintptr_t taskCount     = 200000;
+
+    CmTaskRing ring;
+    ASSERT_TRUE(ring.Init(64));
+
+    std::vector<std::thread> producers;
+    for (uintptr_t p = 0; p < producerCount; p++)
+    {
+        producers.push_back(std::thread([&ring, p, producerShift, taskCount]() {
+            for (uintptr_t i = 1; i <= taskCount; i++)
+            {
+                while (!ring.Push(ToTask((p << producerShift) | i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+
+    // Every producer's tasks come out complete and in its own order
+    std::vector<uintptr_t> lastSeen(producerCount, 0);
+    for (uintptr_t popped = 0; popped < producerCount * taskCount;)
+    {
+        CmTaskInternal *task = ring.Pop();
+        if (task == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        uintptr_t value = reinterpret_cast<uintptr_t>(task);
+        uintptr_t p     = value >> producerShift;
+        ASSERT_LT(p, producerCount);
+        ASSERT_EQ(lastSeen[p] + 1, value & taskMask);
+        lastSeen[p] = value & taskMask;
+        popped++;
+    }
+
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_TRUE(ring.IsEmpty());
+}
+
+// Hand-off cost from an enqueuing thread to the flush thread
+TEST(TaskRingTest, HandOffLatency)
+{
+    const uintptr_t taskCount = 200000;
+
+    CmTaskRing ring;
+    ASSERT_TRUE(ring.Init(256));
+
+    auto start = std::chrono::steady_clock::now();
+    for (uintptr_t i = 1; i <= taskCount; i++)
+    {
+        ring.Push(ToTask(i));
+        ring.Pop();
+    }
+    auto   end         = std::chrono::steady_clock::now();
+    double uncontended = std::chrono::duration<double, std::nano>(end - start).count() / taskCount;
+
+    std::thread consumer([&ring, taskCount]() {
+        for (uintptr_t popped = 0; popped < taskCount;)
+        {
+            if (ring.Pop() != nullptr)
+            {
+                popped++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    start = std::chrono::steady_clock::now();
+    for (uintptr_t i = 1; i <= taskCount; i++)
+    {
+        while (!ring.Push(ToTask(i)))
+        {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    end = std::chrono::steady_clock::now();
+    double crossThread = std::chrono::duration<double, std::nano>(end - start).count() / taskCount;
+
+    RecordProperty("PushPopNs", std::to_string(uncontended));
+    RecordProperty("CrossThreadNs", std::to_string(crossThread));
+    EXPECT_TRUE(ring.IsEmpty());
+}
@@ -28,6 +28,7 @@
 #define MEDIADRIVER_LINUX_COMMON_CM_CMCSYNC_H_
 
 #include "cm_debug.h"
+#include <time.h>
 
 namespace CMRT_UMD
 {
@@ -75,9 +76,62 @@ public:
     }
 
 private:
+    friend class CCondition;
     pthread_mutex_t m_criticalSection;
 };
 
+class CCondition
+{
+public:
+    CCondition()
+    {
+        int32_t ret = 0;
+        ret = pthread_cond_init(&m_condition, nullptr);
+        if (ret != 0)
+        {
+            CM_ASSERTMESSAGE("Error: Failed in pthread_cond_init.");
+        }
+    }
+
+    ~CCondition()
+    {
+        int32_t ret = 0;
+        ret = pthread_cond_destroy(&m_condition);
+        if (ret != 0)
+        {
+            CM_ASSERTMESSAGE("Error: Failed in pthread_cond_destroy.");
+        }
+    }
+
+    // refSync must be acquired; returns false on timeout
+    bool Wait(CSync &refSync, uint32_t timeOutMs)
+    {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeOutMs / 1000;
+        deadline.tv_nsec += (timeOutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        return pthread_cond_timedwait(&m_condition, &refSync.m_criticalSection, &deadline) == 0;
+    }
+
+    void Broadcast()
+    {
+        int32_t ret = 0;
+        ret = pthread_cond_broadcast(&m_condition);
+        if (ret != 0)
+        {
+            CM_ASSERTMESSAGE("Error: Failed in pthread_cond_broadcast.");
+        }
+    }
+
+private:
+    pthread_cond_t m_condition;
+};
+
 class CLock
 {
 public:
@@ -84,6 +84,14 @@ CM_RT_API int32_t CmEventRT::WaitForTaskFinished(uint32_t timeOutMs)
         goto finish;
 
     //Make sure task flushed
+    if (m_queue->IsAsyncFlush())
+    {
+        result = m_queue->WaitForTaskFlushed(this, timeOutMs);
+        if (result != CM_SUCCESS)
+        {
+            goto finish;
+        }
+    }
     while ( m_status == CM_STATUS_QUEUED )
     {
         m_queue->FlushTaskWithoutSync();  //Flush none if 1st task NOT finished yet
@@ -117,6 +125,34 @@ finish:
     return result;
 }
 
+//*-----------------------------------------------------------------------------
+//! Wait on the batch buffer of the flushed task without querying the status
+//! or flushing the queue.
+//! INPUT:
+//!     Timeout in Milliseconds
+//! OUTPUT:
+//!     CM_SUCCESS:  if the batch buffer is idle
+//!     CM_EXCEED_MAX_TIMEOUT:  if timeout in synchoinization system call.
+//*-----------------------------------------------------------------------------
+int32_t CmEventRT::WaitForTaskFence(uint32_t timeOutMs)
+{
+    if (m_osSignalTriggered || m_osData == nullptr)
+    {
+        return CM_SUCCESS;
+    }
+
+    MOS_LINUX_BO *buffer_object = reinterpret_cast<MOS_LINUX_BO*>(m_osData);
+    int result = mos_gem_bo_wait(buffer_object, 1000000LL*timeOutMs);
+    mos_gem_bo_clear_relocs(buffer_object, 0);
+    if (result)
+    {
+        return CM_EXCEED_MAX_TIMEOUT;
+    }
+
+    m_osSignalTriggered = true;
+    return CM_SUCCESS;
+}
+
 //*-----------------------------------------------------------------------------
 //! Unreference the bo in linux.
 //! INPUT:
@@ -248,11 +248,21 @@ VAStatus DdiMediaDecode::DecodeCombineBitstream(DDI_MEDIA_CONTEXT *mediaCtx)
     /* As it is checked in previous caller, it is skipped. */
     bufMgr = &(m_ddiDecodeCtx->BufMgr);
 
+    uint32_t frameSize = 0;
+    if (bufMgr->dwNumSliceData > 0)
+    {
+        frameSize = bufMgr->pSliceData[bufMgr->dwNumSliceData - 1].uiOffset +
+                    bufMgr->pSliceData[bufMgr->dwNumSliceData - 1].uiLength;
+        UpdateBsSizeHint(frameSize);
+    }
+
     if (bufMgr && (bufMgr->bIsSliceOverSize == false))
     {
         return VA_STATUS_SUCCESS;
     }
 
+    m_bsOverSizeCount++;
+
     PDDI_MEDIA_BUFFER newBitstreamBuffer;
     //allocate a new bit stream buffer
     newBitstreamBuffer = (DDI_MEDIA_BUFFER *)MOS_AllocAndZeroMemory(sizeof(DDI_MEDIA_BUFFER));
@@ -262,7 +272,8 @@ VAStatus DdiMediaDecode::DecodeCombineBitstream(DDI_MEDIA_CONTEXT *mediaCtx)
         return VA_STATUS_ERROR_DECODING_ERROR;
     }
 
-    newBitstreamBuffer->iSize     = m_ddiDecodeCtx->DecodeParams.m_dataSize;
+    // Replace the slot with one that fits the following frames as well
+    newBitstreamBuffer->iSize     = MOS_MAX(MOS_MAX(m_ddiDecodeCtx->DecodeParams.m_dataSize, frameSize), m_bsSizeHint);
     newBitstreamBuffer->uiType    = VASliceDataBufferType;
     newBitstreamBuffer->format    = Media_Format_Buffer;
     newBitstreamBuffer->uiOffset  = 0;
@@ -313,6 +324,7 @@ VAStatus DdiMediaDecode::DecodeCombineBitstream(DDI_MEDIA_CONTEXT *mediaCtx)
                 bufMgr->pBitStreamBase[bufMgr->dwBitstreamIndex] + bufMgr->pSliceData[slcInd].uiOffset,
                 bufMgr->pSliceData[slcInd].uiLength);
         }
+        m_bsCopiedBytes += bufMgr->pSliceData[slcInd].uiLength;
     }
 
     //free original buffers
@@ -337,9 +349,23 @@ VAStatus DdiMediaDecode::DecodeCombineBitstream(DDI_MEDIA_CONTEXT *mediaCtx)
     return VA_STATUS_SUCCESS;
 }
 
+void DdiMediaDecode::UpdateBsSizeHint(uint32_t frameSize)
+{
+    // Follow growth at once with some headroom, but shrink slowly so that a run of
+    // small frames does not leave the next large one to overflow.
+    uint32_t size = MOS_ALIGN_CEIL(frameSize + (frameSize >> 2), MOS_PAGE_SIZE);
+    m_bsSizeHint  = MOS_MAX(size, m_bsSizeHint - (m_bsSizeHint >> 4));
+}
+
 void DdiMediaDecode::DestroyContext(VADriverContextP ctx)
 {
     Codechal *codecHal;
+
+    if (m_bsOverSizeCount)
+    {
+        DDI_NORMALMESSAGE("%u frames overflowed the bitstream buffer, %llu bytes copied to combine them",
+            m_bsOverSizeCount, (unsigned long long)m_bsCopiedBytes);
+    }
     /* as they are already checked in caller, this is skipped */
     codecHal = m_ddiDecodeCtx->pCodecHal;
 
@@ -526,15 +552,19 @@ VAStatus DdiMediaDecode::AllocBsBuffer(
         bsBufObj ->pMediaCtx       = m_ddiDecodeCtx->pMediaCtx;
         bsBufBaseAddr              = bufMgr->pBitStreamBase[bufMgr->dwBitstreamIndex];
 
+        // Size the buffer for the whole frame, not just its first slice, so that
+        // the remaining slices are written in place instead of being combined later.
+        uint32_t bsSize = MOS_MAX(buf->iSize, m_bsSizeHint);
+
         if(bsBufBaseAddr == nullptr)
         {
             createBsBuffer = true;
-            if (buf->iSize > bsBufObj->iSize)
+            if (bsSize > bsBufObj->iSize)
             {
-                bsBufObj->iSize = buf->iSize;
+                bsBufObj->iSize = bsSize;
             }
         }
-        else if(buf->iSize > bsBufObj->iSize)
+        else if(bsSize > bsBufObj->iSize)
         {
            //free bo
             DdiMediaUtil_UnlockBuffer(bsBufObj);
@@ -542,7 +572,7 @@ VAStatus DdiMediaDecode::AllocBsBuffer(
             bsBufBaseAddr = nullptr;
 
             createBsBuffer = true;
-            bsBufObj->iSize = buf->iSize;
+            bsBufObj->iSize = bsSize;
         }
 
         if (createBsBuffer)
@@ -437,6 +437,16 @@ protected:
     //!           VA_STATUS_SUCCESS if success, else fail reason
     VAStatus InitDummyReference(DecodePipelineAdapter& decoder);
 
+    //! \brief    Update the expected bitstream size
+    //! \details  Bitstream buffers are sized from recent frames so that the
+    //!           slices of a frame are normally written in place.
+    //!
+    //! \param    [in] frameSize
+    //!           Bitstream size of the frame just submitted
+    //!
+    //! \return   void
+    void UpdateBsSizeHint(uint32_t frameSize);
+
     //! \brief  the type of decode base class
     MOS_SURFACE                 m_destSurface;          //!<Destination Surface structure
     uint32_t                    m_groupIndex;           //!<global Group
@@ -449,6 +459,9 @@ protected:
     uint32_t                    m_sliceCtrlBufNum;      //!<Slice control Buffer Number
     uint32_t                    m_decProcessingType;    //!<Decode Processing type
     CodechalSetting             *m_codechalSettings = nullptr;    //!<Codechal Settings
+    uint32_t                    m_bsSizeHint = 0;       //!<Expected bitstream size of the next frame
+    uint32_t                    m_bsOverSizeCount = 0;  //!<Frames whose slices overflowed the bitstream buffer
+    uint64_t                    m_bsCopiedBytes = 0;    //!<Bytes copied to combine the overflowed frames
 
 #ifdef _DECODE_PROCESSING_SUPPORTED
     VAProcPipelineParameterBuffer *m_procBuf = nullptr; //!< Process parameters for vp sfc input
@@ -27,6 +27,7 @@
 #include "media_libva_util.h"
 #include "media_libva_common.h"
 #include "media_ddi_encode_base.h"
+#include <chrono>
 
 DdiEncodeBase::DdiEncodeBase()
     :DdiMediaBase()
@@ -170,7 +171,7 @@ VAStatus DdiEncodeBase::StatusReport(
     uint32_t size         = 0;
     int32_t  index        = 0;
     uint32_t status       = 0;
-    uint32_t timeOutCount = 0;
+    uint32_t waitTime     = 0;
     VAStatus eStatus      = VA_STATUS_SUCCESS;
 
     // Get encoded frame information from status buffer queue.
@@ -262,13 +263,10 @@ VAStatus DdiEncodeBase::StatusReport(
                 break;
             }
             // Wait until encode PAK complete, sometimes we application detect encoded buffer object is Idle, may Enc done, but Pak not.
-            uint32_t maxTimeOut                               = 100000;  //set max sleep times to 100000 = 1s, other wise return error.
-            if (timeOutCount < maxTimeOut)
+            uint32_t maxTimeOut                               = 1000000;  //set max wait time to 1s, other wise return error.
+            if (waitTime < maxTimeOut)
             {
-                //sleep 10 us to wait encode complete, it won't impact the performance.
-                uint32_t sleepTime                            = 10;      //sleep 10 us when encode is not complete.
-                usleep(sleepTime);
-                timeOutCount++;
+                waitTime += WaitForStatusReport(maxTimeOut - waitTime);
                 continue;
             }
             else
@@ -315,9 +313,8 @@ VAStatus DdiEncodeBase::EncStatusReport(
 
     EncodeStatusReport* encodeStatusReport = (EncodeStatusReport*)m_encodeCtx->pEncodeStatusReport;
     uint16_t numStatus    = 1;
-    uint32_t maxTimeOut   = 500000;  //set max sleep times to 500000 = 5s, other wise return error.
-    uint32_t sleepTime    = 10;  //sleep 10 us when encode is not complete.
-    uint32_t timeOutCount = 0;
+    uint32_t maxTimeOut   = 5000000;  //set max wait time to 5s, other wise return error.
+    uint32_t waitTime     = 0;
 
     //when this function is called, there must be a frame is ready, will wait until get the right information.
     while (1)
@@ -339,11 +336,9 @@ VAStatus DdiEncodeBase::EncStatusReport(
         else if (CODECHAL_STATUS_INCOMPLETE == encodeStatusReport[0].CodecStatus)
         {
             // Wait until encode PAK complete, sometimes we application detect encoded buffer object is Idle, may Enc done, but Pak not.
-            if (timeOutCount < maxTimeOut)
+            if (waitTime < maxTimeOut)
             {
-                //sleep 10 us to wait encode complete, it won't impact the performance.
-                usleep(sleepTime);
-                timeOutCount++;
+                waitTime += WaitForStatusReport(maxTimeOut - waitTime);
                 continue;
             }
             else
@@ -375,9 +370,8 @@ VAStatus DdiEncodeBase::PreEncStatusReport(
 
     EncodeStatusReport* encodeStatusReport = (EncodeStatusReport*)m_encodeCtx->pEncodeStatusReport;
     uint16_t numStatus    = 1;
-    uint32_t maxTimeOut   = 500000;  //set max sleep times to 500000 = 5s, other wise return error.
-    uint32_t sleepTime    = 10;  //sleep 10 us when encode is not complete.
-    uint32_t timeOutCount = 0;
+    uint32_t maxTimeOut   = 5000000;  //set max wait time to 5s, other wise return error.
+    uint32_t waitTime     = 0;
 
     //when this function is called, there must be a frame is ready, will wait until get the right information.
     while (1)
@@ -399,11 +393,9 @@ VAStatus DdiEncodeBase::PreEncStatusReport(
         else if (CODECHAL_STATUS_INCOMPLETE == encodeStatusReport[0].CodecStatus)
         {
             // Wait until encode PAK complete, sometimes we application detect encoded buffer object is Idle, may Enc done, but Pak not.
-            if (timeOutCount < maxTimeOut)
+            if (waitTime < maxTimeOut)
             {
-                //sleep 10 us to wait encode complete, it won't impact the performance.
-                usleep(sleepTime);
-                timeOutCount++;
+                waitTime += WaitForStatusReport(maxTimeOut - waitTime);
                 continue;
             }
             else
@@ -426,6 +418,29 @@ VAStatus DdiEncodeBase::PreEncStatusReport(
     return VA_STATUS_SUCCESS;
 }
 
+uint32_t DdiEncodeBase::WaitForStatusReport(uint32_t timeOutUs)
+{
+    const uint32_t sleepTime = 10;  //sleep 10 us when the frame's batches are unknown or already done.
+
+    auto start = std::chrono::steady_clock::now();
+
+    CodechalEncoderState *encoder = dynamic_cast<CodechalEncoderState *>(m_encodeCtx->pCodecHal);
+    MOS_STATUS mosStatus = MOS_STATUS_UNIMPLEMENTED;
+    if (encoder != nullptr)
+    {
+        mosStatus = encoder->WaitForStatusReport(MOS_MAX(timeOutUs / 1000, 1));
+    }
+
+    // Nothing to sleep on, back off briefly instead of spinning on the status buffer.
+    if (mosStatus != MOS_STATUS_SUCCESS && mosStatus != MOS_STATUS_STILL_DRAWING)
+    {
+        usleep(sleepTime);
+    }
+
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return (uint32_t)MOS_MAX(waited, 1);
+}
+
 VAStatus DdiEncodeBase::RemoveFromStatusReportQueue(DDI_MEDIA_BUFFER *buf)
 {
     VAStatus eStatus = VA_STATUS_SUCCESS;
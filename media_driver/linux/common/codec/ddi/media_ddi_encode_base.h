@@ -135,6 +135,20 @@ public:
         DDI_MEDIA_BUFFER *mediaBuf,
         void             **buf);
 
+    //!
+    //! \brief    Wait for the oldest pending encode status report.
+    //!
+    //! \details  Sleeps until the frame's batches complete when the encoder can
+    //!           tell which they are, otherwise for one short polling interval.
+    //!
+    //! \param    [in] timeOutUs
+    //!           Upper bound of the wait in us
+    //!
+    //! \return   uint32_t
+    //!           Time spent waiting in us, at least 1
+    //!
+    uint32_t WaitForStatusReport(uint32_t timeOutUs);
+
     //!
     //! \brief    Remove Report Status from status report list.
     //!
@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     media_ddi_encode_mfe.cpp
+//! \brief    Worker threads used by multi-frame encode submission
+//!
+
+#include "media_ddi_encode_mfe.h"
+
+MOS_STATUS DdiEncodeMfeWorkers::Create(uint32_t workerNum)
+{
+    if (!m_threads.empty())
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    m_exit           = false;
+    m_startSemaphore = MOS_CreateSemaphore(0, workerNum);
+    m_doneSemaphore  = MOS_CreateSemaphore(0, workerNum);
+    if (m_startSemaphore == nullptr || m_doneSemaphore == nullptr)
+    {
+        Destroy();
+        return MOS_STATUS_NO_SPACE;
+    }
+
+    for (uint32_t i = 0; i < workerNum; i++)
+    {
+        MOS_THREADHANDLE thread = MOS_CreateThread((void *)WorkerThread, this);
+        if (!thread)
+        {
+            // Run with whatever was started
+            break;
+        }
+        m_threads.push_back(thread);
+    }
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void DdiEncodeMfeWorkers::Destroy()
+{
+    if (!m_threads.empty())
+    {
+        m_exit = true;
+        MOS_PostSemaphore(m_startSemaphore, (uint32_t)m_threads.size());
+        for (auto thread : m_threads)
+        {
+            MOS_WaitThread(thread);
+        }
+        m_threads.clear();
+    }
+
+    if (m_startSemaphore)
+    {
+        MOS_DestroySemaphore(m_startSemaphore);
+        m_startSemaphore = nullptr;
+    }
+    if (m_doneSemaphore)
+    {
+        MOS_DestroySemaphore(m_doneSemaphore);
+        m_doneSemaphore = nullptr;
+    }
+}
+
+void DdiEncodeMfeWorkers::RunJobs()
+{
+    for (uint32_t i = m_next++; i < m_count; i = m_next++)
+    {
+        m_status[i] = m_func(m_data, i);
+    }
+}
+
+void DdiEncodeMfeWorkers::Run(uint32_t count, JobFunc func, void *data, MOS_STATUS *status)
+{
+    uint32_t wake = MOS_MIN((uint32_t)m_threads.size(), count > 0 ? count - 1 : 0);
+
+    if (wake == 0)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            status[i] = func(data, i);
+        }
+        return;
+    }
+
+    // The semaphore post publishes the batch to the workers
+    m_func   = func;
+    m_data   = data;
+    m_status = status;
+    m_count  = count;
+    m_next   = 0;
+
+    MOS_PostSemaphore(m_startSemaphore, wake);
+    RunJobs();
+
+    for (uint32_t i = 0; i < wake; i++)
+    {
+        MOS_WaitSemaphore(m_doneSemaphore, INFINITE);
+    }
+}
+
+void *DdiEncodeMfeWorkers::WorkerThread(void *data)
+{
+    DdiEncodeMfeWorkers *workers = (DdiEncodeMfeWorkers *)data;
+    if (workers == nullptr)
+    {
+        return nullptr;
+    }
+
+    while (MOS_WaitSemaphore(workers->m_startSemaphore, INFINITE) == MOS_STATUS_SUCCESS &&
+           !workers->m_exit)
+    {
+        workers->RunJobs();
+        MOS_PostSemaphore(workers->m_doneSemaphore, 1);
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,112 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     media_ddi_encode_mfe.h
+//! \brief    Worker threads used by multi-frame encode submission
+//!
+
+#ifndef __MEDIA_DDI_ENCODE_MFE_H__
+#define __MEDIA_DDI_ENCODE_MFE_H__
+
+#include <atomic>
+#include <vector>
+#include "mos_utilities.h"
+
+//! \brief  Upper bound of PAK worker threads per MFE context
+#define DDI_ENCODE_MFE_MAX_PAK_WORKERS  15
+
+//!
+//! \class  DdiEncodeMfeWorkers
+//! \brief  Runs a batch of independent jobs on a fixed set of threads
+//! \details  The calling thread takes part in the batch, so a pool without
+//!           workers degrades to a plain loop. Jobs are claimed in index order.
+//!
+class DdiEncodeMfeWorkers
+{
+public:
+    //!
+    //! \brief  Job callback
+    //! \param  [in] data
+    //!         Caller data passed to Run()
+    //! \param  [in] index
+    //!         Job index in [0, count)
+    //! \return MOS_STATUS
+    //!
+    typedef MOS_STATUS (*JobFunc)(void *data, uint32_t index);
+
+    DdiEncodeMfeWorkers() {}
+
+    ~DdiEncodeMfeWorkers()
+    {
+        Destroy();
+    }
+
+    //!
+    //! \brief  Start the worker threads
+    //! \param  [in] workerNum
+    //!         Number of threads besides the calling one
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS if success, else fail reason
+    //!
+    MOS_STATUS Create(uint32_t workerNum);
+
+    //!
+    //! \brief  Stop and join the worker threads
+    //!
+    void Destroy();
+
+    //!
+    //! \brief  Run func(data, i) for every i in [0, count) and wait for all of them
+    //! \param  [in] count
+    //!         Number of jobs
+    //! \param  [in] func
+    //!         Job callback, called concurrently for different indices
+    //! \param  [in] data
+    //!         Passed to every call of func
+    //! \param  [out] status
+    //!         Array of count entries, receives the result of each job
+    //!
+    void Run(uint32_t count, JobFunc func, void *data, MOS_STATUS *status);
+
+    uint32_t GetWorkerNum()
+    {
+        return (uint32_t)m_threads.size();
+    }
+
+private:
+    void RunJobs();
+
+    static void *WorkerThread(void *data);
+
+    std::vector<MOS_THREADHANDLE> m_threads;
+    PMOS_SEMAPHORE                m_startSemaphore = nullptr;   //!< One post per worker woken for a batch
+    PMOS_SEMAPHORE                m_doneSemaphore  = nullptr;   //!< One post per woken worker done with a batch
+    volatile bool                 m_exit           = false;
+
+    JobFunc                       m_func           = nullptr;
+    void                          *m_data          = nullptr;
+    MOS_STATUS                    *m_status        = nullptr;
+    uint32_t                      m_count          = 0;
+    std::atomic<uint32_t>         m_next{0};                    //!< Next job index to claim
+};
+
+#endif // __MEDIA_DDI_ENCODE_MFE_H__
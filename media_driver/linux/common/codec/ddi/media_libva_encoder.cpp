@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include "media_libva_encoder.h"
 #include "media_ddi_encode_base.h"
+#include "media_ddi_encode_mfe.h"
 #include "media_libva_util.h"
 #include "media_libva_caps.h"
 #include "media_ddi_factory.h"
@@ -631,6 +632,35 @@ VAStatus DdiEncode_EndPicture(VADriverContextP ctx, VAContextID context)
     return vaStatus;
 }
 
+//!
+//! \brief    Reset the part of the MFE shared state that is rebuilt by every submission
+//! \details  The CM objects, kernel resources and surface index arrays are created
+//!           once by the sub contexts and are kept, as is the capacity of encoders.
+//!
+static void DdiEncode_MfeResetSharedState(MfeSharedState *sharedState)
+{
+    sharedState->pHwInterface         = nullptr;
+    sharedState->pOsInterface         = nullptr;
+    sharedState->pMfeMbEncKernelState = nullptr;
+    sharedState->dwPicWidthInMB       = 0;
+    sharedState->dwPicHeightInMB      = 0;
+    sharedState->sliceHeight          = 0;
+    sharedState->maxTheadWidth        = 0;
+    sharedState->maxTheadHeight       = 0;
+    sharedState->encoders.clear();
+}
+
+//!
+//! \brief    Run PAK of one MFE sub context, called on the MFE worker threads
+//!
+static MOS_STATUS DdiEncode_MfeExecutePak(void *data, uint32_t index)
+{
+    PDDI_ENCODE_CONTEXT encodeContext = ((PDDI_ENCODE_CONTEXT *)data)[index];
+    CodechalEncoderState *encoder     = dynamic_cast<CodechalEncoderState *>(encodeContext->pCodecHal);
+
+    return encoder->Execute(&encodeContext->EncodeParams);
+}
+
 VAStatus DdiEncode_MfeSubmit(
     VADriverContextP    ctx,
     VAMFContextID      mfe_context,
@@ -676,26 +706,24 @@ VAStatus DdiEncode_MfeSubmit(
         validContextNumber++;
     }
 
-    CmDevice *device = encodeMfeContext->mfeEncodeSharedState->pCmDev;
-    CmTask   *task   = encodeMfeContext->mfeEncodeSharedState->pCmTask;
-    CmQueue  *queue  = encodeMfeContext->mfeEncodeSharedState->pCmQueue;
-    CodechalEncodeMdfKernelResource *resMbencKernel = encodeMfeContext->mfeEncodeSharedState->resMbencKernel;
-    SurfaceIndex *vmeSurface    = encodeMfeContext->mfeEncodeSharedState->vmeSurface;
-    SurfaceIndex *commonSurface = encodeMfeContext->mfeEncodeSharedState->commonSurface;
-
-
-    MOS_ZeroMemory(encodeMfeContext->mfeEncodeSharedState, sizeof(MfeSharedState));
+    if (validContextNumber > 1 && encodeMfeContext->pakWorkers == nullptr)
+    {
+        uint32_t coreNum   = MOS_GetLogicalCoreNumber();
+        uint32_t workerNum = MOS_MIN(coreNum > 1 ? coreNum - 1 : 0, DDI_ENCODE_MFE_MAX_PAK_WORKERS);
 
-    encodeMfeContext->mfeEncodeSharedState->pCmDev   = device;
-    encodeMfeContext->mfeEncodeSharedState->pCmTask  = task;
-    encodeMfeContext->mfeEncodeSharedState->pCmQueue = queue;
-    encodeMfeContext->mfeEncodeSharedState->resMbencKernel = resMbencKernel;
-    encodeMfeContext->mfeEncodeSharedState->vmeSurface     = vmeSurface;
-    encodeMfeContext->mfeEncodeSharedState->commonSurface  = commonSurface;
+        DdiEncodeMfeWorkers *pakWorkers = MOS_New(DdiEncodeMfeWorkers);
+        if (pakWorkers != nullptr && pakWorkers->Create(workerNum) != MOS_STATUS_SUCCESS)
+        {
+            MOS_Delete(pakWorkers);
+        }
+        // Without workers PAK simply runs on this thread
+        encodeMfeContext->pakWorkers = pakWorkers;
+    }
 
-    encodeMfeContext->mfeEncodeSharedState->encoders.clear();
+    DdiEncode_MfeResetSharedState(encodeMfeContext->mfeEncodeSharedState);
 
-    // Call Enc functions for all the sub contexts
+    // Call Enc functions for all the sub contexts. They stay in submission order:
+    // the first stream sets up the shared kernel state and the last one submits it.
     MOS_STATUS status = MOS_STATUS_SUCCESS;
     for (int32_t i = 0; i < validContextNumber; i++)
     {
@@ -721,7 +749,8 @@ VAStatus DdiEncode_MfeSubmit(
         }
     }
 
-    // Call Pak functions for all the sub contexts
+    // Call Pak functions for all the sub contexts. Each sub context builds and submits
+    // its own command buffers on its own GPU context, so they are run in parallel.
     for (int32_t i = 0; i < validContextNumber; i++)
     {
         encodeContext  = encodeContexts[i];
@@ -733,10 +762,25 @@ VAStatus DdiEncode_MfeSubmit(
         {
             encodeContext->EncodeParams.ExecCodecFunction = CODECHAL_FUNCTION_FEI_PAK;
         }
+    }
 
-        CodechalEncoderState *encoder = dynamic_cast<CodechalEncoderState *>(encodeContext->pCodecHal);
-        status = encoder->Execute(&encodeContext->EncodeParams);
-        if (MOS_STATUS_SUCCESS != status)
+    std::vector<MOS_STATUS> pakStatus(validContextNumber, MOS_STATUS_SUCCESS);
+    if (encodeMfeContext->pakWorkers)
+    {
+        encodeMfeContext->pakWorkers->Run(validContextNumber, DdiEncode_MfeExecutePak, encodeContexts.data(), pakStatus.data());
+    }
+    else
+    {
+        for (int32_t i = 0; i < validContextNumber; i++)
+        {
+            pakStatus[i] = DdiEncode_MfeExecutePak(encodeContexts.data(), i);
+        }
+    }
+
+    // Report the first failing sub context in submission order
+    for (int32_t i = 0; i < validContextNumber; i++)
+    {
+        if (MOS_STATUS_SUCCESS != pakStatus[i])
         {
             DDI_ASSERTMESSAGE("DDI:Failed in Execute Pak!");
             return VA_STATUS_ERROR_ENCODING_ERROR;
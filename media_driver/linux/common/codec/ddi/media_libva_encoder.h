@@ -86,6 +86,7 @@ typedef struct _DDI_ENCODE_STATUS_REPORT_INFO_BUF
 } DDI_ENCODE_STATUS_REPORT_INFO_BUF;
 
 class DdiEncodeBase;
+class DdiEncodeMfeWorkers;
 
 typedef struct _DDI_ENCODE_CONTEXT
 {
@@ -181,6 +182,7 @@ typedef struct _DDI_ENCODE_MFE_CONTEXT
     uint32_t                         currentStreamId;               // Current allocated id, increased monotonically
     MfeSharedState                   *mfeEncodeSharedState;         // Keep shared state across sub contexts
     bool                             isFEI;                         // Support legacy only or FEI only
+    DdiEncodeMfeWorkers              *pakWorkers;                   // Run PAK of the sub contexts in parallel, created on first submission
 }DDI_ENCODE_MFE_CONTEXT, *PDDI_ENCODE_MFE_CONTEXT;
 
 static __inline PDDI_ENCODE_CONTEXT DdiEncode_GetEncContextFromPVOID (void *encCtx)
@@ -21,6 +21,7 @@
 set(TMP_1_SOURCES_
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_decode_base.cpp
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_encode_base.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/media_ddi_encode_mfe.cpp
     ${CMAKE_CURRENT_LIST_DIR}/media_libva_decoder.cpp
     ${CMAKE_CURRENT_LIST_DIR}/media_libva_encoder.cpp
 )
@@ -28,6 +29,7 @@ set(TMP_1_SOURCES_
 set(TMP_1_HEADERS_
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_decode_base.h
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_encode_base.h
+    ${CMAKE_CURRENT_LIST_DIR}/media_ddi_encode_mfe.h
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_decode_const.h
     ${CMAKE_CURRENT_LIST_DIR}/media_libva_decoder.h
     ${CMAKE_CURRENT_LIST_DIR}/media_ddi_encode_const.h
@@ -43,6 +43,7 @@
 #include "media_libva_util.h"
 #include "media_libva_decoder.h"
 #include "media_libva_encoder.h"
+#include "media_ddi_encode_mfe.h"
 #if !defined(ANDROID) && defined(X11_FOUND)
 #include "media_libva_putsurface_linux.h"
 #endif
@@ -1735,7 +1736,7 @@ VAStatus DdiMedia__Initialize (
             FreeForMediaContext(mediaCtx);
             return VA_STATUS_ERROR_INVALID_PARAMETER;
         }
-        mos_bufmgr_gem_enable_reuse(mediaCtx->pDrmBufMgr);
+        Mos_Specific_EnableBufmgrReuse(mediaCtx->pDrmBufMgr);
 
         //Latency reducation:replace HWGetDeviceID to get device using ioctl from drm.
         mediaCtx->iDeviceId = mos_bufmgr_gem_get_devid(mediaCtx->pDrmBufMgr);
@@ -2048,6 +2049,7 @@ static VAStatus DdiMedia_Terminate (
         }
 
         // destroy libdrm buffer manager
+        Mos_Specific_ReportBufmgrReuse(mediaCtx->pDrmBufMgr);
         mos_bufmgr_destroy(mediaCtx->pDrmBufMgr);
 
         // Destroy memory allocated to store Media System Info
@@ -2803,6 +2805,8 @@ static VAStatus DdiMedia_DestoryMfeContext (
     encodeMfeContext->mfeEncodeSharedState->encoders.clear();
     encodeMfeContext->mfeEncodeSharedState->encoders.shrink_to_fit();
 
+    MOS_Delete(encodeMfeContext->pakWorkers);
+
     DdiMediaUtil_DestroyMutex(&encodeMfeContext->encodeMfeMutex);
     MOS_FreeMemory(encodeMfeContext->mfeEncodeSharedState);
     MOS_FreeMemory(encodeMfeContext);
@@ -115,10 +115,22 @@ MediaLibvaCaps::MediaLibvaCaps(DDI_MEDIA_CONTEXT *mediaCtx)
     {
         m_isEntryptSupported = m_CapsCp->IsDecEncryptionSupported(m_mediaCtx);
     }
+
+    memset(m_profileEntryIdx, -1, sizeof(m_profileEntryIdx));
+    for (uint32_t i = 0; i < m_maxProfileIdx; i++)
+    {
+        m_profileSupported[i] = false;
+    }
+    for (uint32_t i = 0; i < m_numCodecTypes; i++)
+    {
+        m_loaded[i] = false;
+    }
+    DdiMediaUtil_InitMutex(&m_loadMutex);
 }
 
 MediaLibvaCaps::~MediaLibvaCaps()
 {
+    DdiMediaUtil_DestroyMutex(&m_loadMutex);
     FreeAttributeList();
     Delete_MediaLibvaCapsCpInterface(m_CapsCp);
     m_CapsCp = nullptr;
@@ -188,52 +200,39 @@ VAStatus MediaLibvaCaps::GetProfileEntrypointFromConfigId(
     DDI_CHK_NULL(entrypoint, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
     DDI_CHK_NULL(profileTableIdx, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
     CodecType codecType;
+    std::vector<int8_t> *configEntry = nullptr;
 
     int32_t configOffset = 0;
-    if((configId < (DDI_CODEC_GEN_CONFIG_ATTRIBUTES_DEC_BASE + m_decConfigs.size())) )
+    if (configId < DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE)
     {
         configOffset = configId - DDI_CODEC_GEN_CONFIG_ATTRIBUTES_DEC_BASE;
         codecType = videoDecode;
+        configEntry = &m_decConfigEntry;
     }
-    else if( (configId >= DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE) && (configId < (DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE + m_encConfigs.size())) )
+    else if (configId < DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE)
     {
         configOffset = configId - DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE;
         codecType = videoEncode;
+        configEntry = &m_encConfigEntry;
     }
-    else if( (configId >= DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE) && (configId < (DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE + m_vpConfigs.size())))
+    else
     {
         configOffset = configId - DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE;
         codecType = videoProcess;
-    }
-    else
-    {
-        return VA_STATUS_ERROR_INVALID_CONFIG;
+        configEntry = &m_vpConfigEntry;
     }
 
-    int32_t i;
-    for (i = 0; i < m_profileEntryCount; i++)
-    {
-        if (CheckEntrypointCodecType(m_profileEntryTbl[i].m_entrypoint, codecType))
-        {
-            int32_t configStart = m_profileEntryTbl[i].m_configStartIdx;
-            int32_t configEnd = m_profileEntryTbl[i].m_configStartIdx + m_profileEntryTbl[i].m_configNum;
-            if (configOffset >= configStart && configOffset < configEnd)
-            {
-                break;
-            }
-        }
-    }
+    DDI_CHK_RET(LoadProfileEntrypoints(codecType), "Failed to load caps!");
 
-    if (i == m_profileEntryCount)
+    if (configOffset >= (int32_t)configEntry->size() || (*configEntry)[configOffset] < 0)
     {
         return VA_STATUS_ERROR_INVALID_CONFIG;
     }
-    else
-    {
-        *entrypoint  = m_profileEntryTbl[i].m_entrypoint;
-        *profile = m_profileEntryTbl[i].m_profile;
-        *profileTableIdx = i;
-    }
+
+    int32_t i = (*configEntry)[configOffset];
+    *entrypoint  = m_profileEntryTbl[i].m_entrypoint;
+    *profile = m_profileEntryTbl[i].m_profile;
+    *profileTableIdx = i;
     return VA_STATUS_SUCCESS;
 }
 
@@ -254,13 +253,136 @@ VAStatus MediaLibvaCaps::AddProfileEntry(
     m_profileEntryTbl[m_profileEntryCount].m_attributes = attributeList;
     m_profileEntryTbl[m_profileEntryCount].m_configStartIdx = configStartIdx;
     m_profileEntryTbl[m_profileEntryCount].m_configNum = configNum;
+
+    // The first entry of a combination wins, like the old linear search
+    int32_t profileIdx = (int32_t)profile + 1;
+    if (profileIdx >= 0 && profileIdx < m_maxProfileIdx)
+    {
+        m_profileSupported[profileIdx] = true;
+        if ((uint32_t)entrypoint < m_maxEntrypointIdx && m_profileEntryIdx[profileIdx][entrypoint] < 0)
+        {
+            m_profileEntryIdx[profileIdx][entrypoint] = (int8_t)m_profileEntryCount;
+        }
+    }
+
+    std::vector<int8_t> *configEntry = nullptr;
+    if (CheckEntrypointCodecType(entrypoint, videoDecode))
+    {
+        configEntry = &m_decConfigEntry;
+    }
+    else if (CheckEntrypointCodecType(entrypoint, videoEncode))
+    {
+        configEntry = &m_encConfigEntry;
+    }
+    else if (CheckEntrypointCodecType(entrypoint, videoProcess))
+    {
+        configEntry = &m_vpConfigEntry;
+    }
+    if (configEntry && configStartIdx >= 0 && configNum > 0)
+    {
+        if (configEntry->size() < (size_t)(configStartIdx + configNum))
+        {
+            configEntry->resize(configStartIdx + configNum, -1);
+        }
+        for (int32_t i = configStartIdx; i < configStartIdx + configNum; i++)
+        {
+            if ((*configEntry)[i] < 0)
+            {
+                (*configEntry)[i] = (int8_t)m_profileEntryCount;
+            }
+        }
+    }
+
     m_profileEntryCount++;
 
     return VA_STATUS_SUCCESS;
 }
 
+VAStatus MediaLibvaCaps::LoadProfileEntrypoints(CodecType codecType)
+{
+    if (m_loaded[codecType])
+    {
+        return VA_STATUS_SUCCESS;
+    }
+
+    DdiMediaUtil_LockGuard guard(&m_loadMutex);
+    if (m_loaded[codecType])
+    {
+        return VA_STATUS_SUCCESS;
+    }
+
+    VAStatus status = VA_STATUS_SUCCESS;
+    switch (codecType)
+    {
+        case videoDecode:
+            status = LoadDecodeProfileEntrypoints();
+            break;
+        case videoEncode:
+            status = LoadEncodeProfileEntrypoints();
+            break;
+        case videoProcess:
+            status = LoadVpProfileEntrypoints();
+            break;
+        default:
+            return VA_STATUS_ERROR_INVALID_PARAMETER;
+    }
+
+    // A failed load is not retried, it would add the loaded entries again
+    m_loaded[codecType] = true;
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    return VA_STATUS_SUCCESS;
+}
+
+VAStatus MediaLibvaCaps::LoadProfileEntrypoints()
+{
+    DDI_CHK_RET(LoadProfileEntrypoints(videoDecode), "Failed to initialize Caps!");
+    DDI_CHK_RET(LoadProfileEntrypoints(videoEncode), "Failed to initialize Caps!");
+    DDI_CHK_RET(LoadProfileEntrypoints(videoProcess), "Failed to initialize Caps!");
+    return VA_STATUS_SUCCESS;
+}
+
 int32_t MediaLibvaCaps::GetProfileTableIdx(VAProfile profile, VAEntrypoint entrypoint)
 {
+    CodecType codecTypes[m_numCodecTypes] = {videoDecode, videoEncode, videoProcess};
+    for (uint32_t i = 0; i < m_numCodecTypes; i++)
+    {
+        if (CheckEntrypointCodecType(entrypoint, codecTypes[i]))
+        {
+            if (LoadProfileEntrypoints(codecTypes[i]) != VA_STATUS_SUCCESS)
+            {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    int32_t idx = FindProfileTableIdx(profile, entrypoint);
+    if (idx >= 0)
+    {
+        return idx;
+    }
+
+    // Telling an unsupported profile from an unsupported entrypoint needs
+    // every codec type
+    if (LoadProfileEntrypoints() != VA_STATUS_SUCCESS)
+    {
+        return idx;
+    }
+    return FindProfileTableIdx(profile, entrypoint);
+}
+
+int32_t MediaLibvaCaps::FindProfileTableIdx(VAProfile profile, VAEntrypoint entrypoint)
+{
+    int32_t profileIdx = (int32_t)profile + 1;
+    if (profileIdx >= 0 && profileIdx < m_maxProfileIdx && (uint32_t)entrypoint < m_maxEntrypointIdx)
+    {
+        if (m_profileEntryIdx[profileIdx][entrypoint] >= 0)
+        {
+            return m_profileEntryIdx[profileIdx][entrypoint];
+        }
+        return m_profileSupported[profileIdx] ? -2 : -1;
+    }
+
     // initialize ret value to "invalid profile"
     int32_t ret = -1;
     for (int32_t i = 0; i < m_profileEntryCount; i++)
@@ -329,7 +451,8 @@ VAStatus MediaLibvaCaps::SetAttribute(
         VAConfigAttribType type,
         uint32_t value)
 {
-    int32_t idx = GetProfileTableIdx(profile, entrypoint);
+    // Only called while loading, so the entry must not trigger another load
+    int32_t idx = FindProfileTableIdx(profile, entrypoint);
     DDI_CHK_LARGER(idx, -1, "Didn't find the profile table", VA_STATUS_ERROR_INVALID_PARAMETER);
 
     auto attribList = m_profileEntryTbl[idx].m_attributes;
@@ -395,7 +518,7 @@ VAStatus MediaLibvaCaps::CheckEncRTFormat(
 
     EncodeFormat format = Others;
     EncodeType type = entrypoint == VAEntrypointEncSliceLP ? Vdenc : DualPipe;
-    struct EncodeFormatTable* encodeFormatTable = m_encodeFormatTable;
+    const struct EncodeFormatTable* encodeFormatTable = m_encodeFormatTable;
 
     if(IsAvcProfile(profile))
     {
@@ -1905,8 +2028,21 @@ VAStatus MediaLibvaCaps::LoadNoneProfileEntrypoints()
     uint32_t configStartIdx = m_vpConfigs.size();
     AddVpConfig(0);
     AddProfileEntry(VAProfileNone, VAEntrypointVideoProc, attributeList, configStartIdx, 1);
+    return status;
+}
+
+VAStatus MediaLibvaCaps::LoadNoneEncProfileEntrypoints()
+{
+    VAStatus status = VA_STATUS_SUCCESS;
+
+    AttribMap *attributeList = nullptr;
+
+    // Stats shares the attributes of VideoProc, but has its own copy so the
+    // vp and encode loaders do not touch each other's tables
+    status = CreateVpAttributes(VAProfileNone, VAEntrypointVideoProc, &attributeList);
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
 
-    configStartIdx = m_encConfigs.size();
+    uint32_t configStartIdx = m_encConfigs.size();
     AddEncConfig(VA_RC_NONE);
     AddProfileEntry(VAProfileNone, VAEntrypointStats, attributeList,
             configStartIdx, 1);
@@ -2287,6 +2423,7 @@ VAStatus MediaLibvaCaps::QueryConfigProfiles(
 {
     DDI_CHK_NULL(profileList, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
     DDI_CHK_NULL(numProfiles, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
+    DDI_CHK_RET(LoadProfileEntrypoints(), "Failed to load caps!");
     std::set<int32_t> profiles;
     int32_t i;
     for (i = 0; i < m_profileEntryCount; i++)
@@ -2314,13 +2451,21 @@ VAStatus MediaLibvaCaps::QueryConfigEntrypoints(
 {
     DDI_CHK_NULL(entrypointList, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
     DDI_CHK_NULL(numEntrypoints, "Null pointer", VA_STATUS_ERROR_INVALID_PARAMETER);
+    DDI_CHK_RET(LoadProfileEntrypoints(), "Failed to load caps!");
+    // The table is in load order, which depends on the queries so far. List
+    // the codec types in a fixed order instead, decode first as before.
+    CodecType codecTypes[m_numCodecTypes] = {videoDecode, videoProcess, videoEncode};
     int32_t j = 0;
-    for (int32_t i = 0; i < m_profileEntryCount; i++)
+    for (uint32_t k = 0; k < m_numCodecTypes; k++)
     {
-        if (m_profileEntryTbl[i].m_profile == profile)
+        for (int32_t i = 0; i < m_profileEntryCount; i++)
         {
-            entrypointList[j] = m_profileEntryTbl[i].m_entrypoint;
-            j++;
+            if (m_profileEntryTbl[i].m_profile == profile &&
+                CheckEntrypointCodecType(m_profileEntryTbl[i].m_entrypoint, codecTypes[k]))
+            {
+                entrypointList[j] = m_profileEntryTbl[i].m_entrypoint;
+                j++;
+            }
         }
     }
     *numEntrypoints = j;
@@ -3307,18 +3452,33 @@ std::string MediaLibvaCaps::GetEncodeCodecKey(VAProfile profile, VAEntrypoint en
 
 bool MediaLibvaCaps::IsDecConfigId(VAConfigID configId)
 {
+    // The config vector is only complete and stable once its codec type is loaded
+    if (LoadProfileEntrypoints(videoDecode) != VA_STATUS_SUCCESS)
+    {
+        return false;
+    }
     return ((configId >= DDI_CODEC_GEN_CONFIG_ATTRIBUTES_DEC_BASE) &&
             (configId < (DDI_CODEC_GEN_CONFIG_ATTRIBUTES_DEC_BASE + m_decConfigs.size())));
 }
 
 bool MediaLibvaCaps::IsEncConfigId(VAConfigID configId)
 {
+    // The config vector is only complete and stable once its codec type is loaded
+    if (LoadProfileEntrypoints(videoEncode) != VA_STATUS_SUCCESS)
+    {
+        return false;
+    }
     return ((configId >= DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE) &&
             (configId < (DDI_CODEC_GEN_CONFIG_ATTRIBUTES_ENC_BASE + m_encConfigs.size())));
 }
 
 bool MediaLibvaCaps::IsVpConfigId(VAConfigID configId)
 {
+    // The config vector is only complete and stable once its codec type is loaded
+    if (LoadProfileEntrypoints(videoProcess) != VA_STATUS_SUCCESS)
+    {
+        return false;
+    }
     return ((configId >= DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE) &&
             (configId < (DDI_VP_GEN_CONFIG_ATTRIBUTES_BASE + m_vpConfigs.size())));
 }
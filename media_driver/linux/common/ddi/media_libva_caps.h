@@ -29,6 +29,8 @@
 
 #include "va/va.h"
 
+#include <pthread.h>
+#include <atomic>
 #include <vector>
 #include <map>
 
@@ -772,6 +774,9 @@ protected:
 
     static const uint16_t m_maxProfiles = 17; //!< Maximum number of supported profiles
     static const uint16_t m_maxProfileEntries = 64; //!< Maximum number of supported profile & entrypoint combinations
+    static const uint16_t m_maxProfileIdx = 64; //!< Size of the profile dimension of m_profileEntryIdx
+    static const uint16_t m_maxEntrypointIdx = 32; //!< Size of the entrypoint dimension of m_profileEntryIdx
+    static const uint32_t m_numCodecTypes = 3; //!< Number of CodecType values
     static const uint32_t m_numVpSurfaceAttr = 17; //!< Number of VP surface attributes
     static const uint32_t m_numJpegSurfaceAttr = 7; //!< Number of JPEG surface attributes
     static const uint32_t m_numJpegEncSurfaceAttr = 4; //!< Number of JPEG encode surface attributes
@@ -820,14 +825,30 @@ protected:
     //!
     //! \brief  Store all the supported encode format
     //!
-    struct EncodeFormatTable* m_encodeFormatTable = nullptr;
+    const struct EncodeFormatTable* m_encodeFormatTable = nullptr;
     uint32_t m_encodeFormatCount = 0;
 
     //!
     //! \brief  Store all the profile and entrypoint combinations
     //!
     ProfileEntrypoint m_profileEntryTbl[m_maxProfileEntries];
-    uint16_t m_profileEntryCount = 0; //!< Count valid entries in m_profileEntryTbl
+    std::atomic<uint16_t> m_profileEntryCount{0}; //!< Count valid entries in m_profileEntryTbl, raised after the entry is written
+
+    //!
+    //! \brief  Index in m_profileEntryTbl by [profile + 1][entrypoint], -1 if not supported
+    //!
+    int8_t m_profileEntryIdx[m_maxProfileIdx][m_maxEntrypointIdx];
+    std::atomic<bool> m_profileSupported[m_maxProfileIdx]; //!< If any entrypoint of [profile + 1] is supported
+
+    //!
+    //! \brief  Index in m_profileEntryTbl of each decode, encode and vp config
+    //!
+    std::vector<int8_t> m_decConfigEntry;
+    std::vector<int8_t> m_encConfigEntry;
+    std::vector<int8_t> m_vpConfigEntry;
+
+    std::atomic<bool> m_loaded[m_numCodecTypes]; //!< If the profiles of each CodecType are loaded
+    pthread_mutex_t m_loadMutex; //!< Serializes loading of the codec types
 
     //!
     //! \brief  Store attribute list pointers
@@ -947,6 +968,7 @@ protected:
 
     //!
     //! \brief    Return the index in m_profileEntryTble by given profile and entrypoint
+    //! \details  Loads the codec type of the entrypoint first if needed
     //!
     //! \param    [in] profile
     //!           Specify VAProfile
@@ -955,10 +977,25 @@ protected:
     //!           Specify VAEntrypoint
     //!
     //! \return   int32_t
-    //!           Equal or bigger than zero if success, otherwise return -1
+    //!           Equal or bigger than zero if success, -2 if the profile is supported
+    //!           but the entrypoint is not, otherwise return -1
     //!
     int32_t GetProfileTableIdx(VAProfile profile, VAEntrypoint entrypoint);
 
+    //!
+    //! \brief    Look up the index in m_profileEntryTbl without loading anything
+    //!
+    //! \param    [in] profile
+    //!           Specify VAProfile
+    //!
+    //! \param    [in] entrypoint
+    //!           Specify VAEntrypoint
+    //!
+    //! \return   int32_t
+    //!           Same as GetProfileTableIdx
+    //!
+    int32_t FindProfileTableIdx(VAProfile profile, VAEntrypoint entrypoint);
+
     //!
     //! \brief    Create attributes map
     //!
@@ -1180,19 +1217,58 @@ protected:
     virtual VAStatus LoadHevcEncProfileEntrypoints();
 
     //!
-    //! \brief    Initialize none profiles, entrypoints and attributes
+    //! \brief    Initialize none profile vp entrypoints and attributes
     //!
     VAStatus LoadNoneProfileEntrypoints();
 
+    //!
+    //! \brief    Initialize none profile stats entrypoints and attributes
+    //! \details  Called by the encode loader, as the stats entrypoint takes
+    //!           encode config IDs
+    //!
+    VAStatus LoadNoneEncProfileEntrypoints();
+
     //!
     //! \brief    Initialize Advanced decode profiles, entrypoints and attributes
     //!
     virtual VAStatus LoadAdvancedDecProfileEntrypoints();
 
     //!
-    //! \brief    Initialize encode/decode/vp profiles, entrypoints and attributes
+    //! \brief    Initialize decode profiles, entrypoints and attributes
+    //!
+    virtual VAStatus LoadDecodeProfileEntrypoints() = 0;
+
+    //!
+    //! \brief    Initialize encode profiles, entrypoints and attributes
+    //!
+    virtual VAStatus LoadEncodeProfileEntrypoints() = 0;
+
+    //!
+    //! \brief    Initialize vp profiles, entrypoints and attributes
+    //!
+    virtual VAStatus LoadVpProfileEntrypoints() = 0;
+
+    //!
+    //! \brief    Load the profiles, entrypoints and attributes of one codec type
+    //! \details  Each codec type is loaded on its first query and kept until the
+    //!           caps are destroyed. Config IDs stay stable as the config
+    //!           vectors only grow.
+    //!
+    //! \param    [in] codecType
+    //!           Codec type to load
+    //!
+    //! \return   VAStatus
+    //!           VA_STATUS_SUCCESS if success
+    //!
+    VAStatus LoadProfileEntrypoints(CodecType codecType);
+
+    //!
+    //! \brief    Load the profiles, entrypoints and attributes of all codec types
+    //!
+    //! \return   VAStatus
+    //!           VA_STATUS_SUCCESS if success
     //!
-    virtual VAStatus LoadProfileEntrypoints() = 0;
+    VAStatus LoadProfileEntrypoints();
 
     //!
     //! \brief    Create decode config by given attributes
@@ -29,6 +29,9 @@
  * list handling. No list looping yet.
  */
 
+#ifndef LIBDRM_LISTS_H
+#define LIBDRM_LISTS_H
+
 #include <stddef.h>
 
 #if defined(__cplusplus)
@@ -123,3 +126,5 @@ typedef struct _drmMMListHead
 #if defined(__cplusplus)
 }
 #endif
+
+#endif /* LIBDRM_LISTS_H */
@@ -55,6 +55,7 @@ typedef struct mos_bufmgr MOS_BUFMGR;
 #define MEMZONE_DEVICE_START  (1ull << 40)
 #define MEMZONE_TOTAL         (1ull << 48)
 #define PAGE_SIZE_64K         (1ull << 16)
+#define PAGE_SIZE_2M          (1ull << 21)
 #define PAGE_SIZE_4G          (1ull << 32)
 #define ARRAY_INIT_SIZE       5
 
@@ -215,6 +216,22 @@ void mos_bufmgr_gem_enable_softpin(struct mos_bufmgr *bufmgr);
 void mos_bufmgr_gem_set_vma_cache_size(struct mos_bufmgr *bufmgr,
                          int limit);
 int mos_bufmgr_gem_get_memory_info(struct mos_bufmgr *bufmgr, char *info, uint32_t length);
+struct mos_vma_heap_stats;
+int mos_bufmgr_gem_get_vma_stats(struct mos_bufmgr *bufmgr, struct mos_vma_heap_stats *stats);
+
+struct mos_bufmgr_cache_stats {
+    uint64_t hits;              /* allocations served from the reuse cache */
+    uint64_t misses;            /* cacheable allocations that created a new BO */
+    uint64_t expired;           /* BOs released for age */
+    uint64_t evicted;           /* BOs released to meet the byte budget */
+    uint64_t purged;            /* cached BOs the kernel had already reclaimed */
+    uint64_t cached_bytes;
+    uint64_t cached_count;
+    uint64_t peak_cached_bytes;
+};
+int mos_bufmgr_gem_set_cache_limits(struct mos_bufmgr *bufmgr, uint64_t high_watermark,
+                         uint64_t low_watermark, uint32_t expire_ms);
+int mos_bufmgr_gem_get_cache_stats(struct mos_bufmgr *bufmgr, struct mos_bufmgr_cache_stats *stats);
 int mos_gem_bo_map_unsynchronized(struct mos_linux_bo *bo);
 int mos_gem_bo_map_gtt(struct mos_linux_bo *bo);
 int mos_gem_bo_unmap_gtt(struct mos_linux_bo *bo);
@@ -382,7 +399,7 @@ drm_export int do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_cont
      unsigned int flags, int *fence);
 
 drm_export void mos_gem_bo_free(struct mos_linux_bo *bo);
-drm_export void mos_gem_bo_unreference_final(struct mos_linux_bo *bo, time_t time);
+drm_export void mos_gem_bo_unreference_final(struct mos_linux_bo *bo, uint64_t time);
 drm_export int mos_gem_bo_map(struct mos_linux_bo *bo, int write_enable);
 drm_export int map_gtt(struct mos_linux_bo *bo);
 drm_export int mos_gem_bo_unmap(struct mos_linux_bo *bo);
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * @file mos_vma.h
+ *
+ * GPU virtual address range allocator used to assign softpin offsets.
+ *
+ * Free ranges ("holes") are kept in size-segregated free lists, one list per
+ * power-of-two number of 64K pages, and are additionally indexed by their
+ * start and end page so that a freed range is coalesced with its neighbours
+ * in constant time.
+ */
+
+#ifndef MOS_VMA_H
+#define MOS_VMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "libdrm_lists.h"
+
+#define MOS_VMA_PAGE_SIZE       (1ull << 16)
+#define MOS_VMA_2M_SIZE         (1ull << 21)
+#define MOS_VMA_NUM_BINS        64
+
+struct mos_vma_hole;
+
+struct mos_vma_heap_stats {
+    /** Total size of the managed range in bytes */
+    uint64_t total_size;
+    /** Bytes currently handed out */
+    uint64_t used_size;
+    /** High watermark of used_size */
+    uint64_t peak_used_size;
+    /** Size of the largest free range in bytes */
+    uint64_t largest_hole;
+    /** Number of free ranges */
+    uint64_t hole_count;
+    /** Number of outstanding allocations */
+    uint64_t alloc_count;
+    /** Number of failed allocations */
+    uint64_t fail_count;
+    /**
+     * External fragmentation in 1/1000 units:
+     * 1000 * (1 - largest_hole / free_size), 0 when the free space is one range.
+     */
+    uint32_t fragmentation;
+};
+
+struct mos_vma_heap {
+    /** Holes bucketed by floor(log2(pages)) */
+    drmMMListHead bins[MOS_VMA_NUM_BINS];
+    /** Bit i set when bins[i] is not empty */
+    uint64_t bin_mask;
+
+    /** Hash chains of holes keyed by their first and by their end page */
+    struct mos_vma_hole **by_start;
+    struct mos_vma_hole **by_end;
+    uint32_t index_bits;
+
+    uint64_t start;
+    uint64_t size;
+
+    uint64_t used_size;
+    uint64_t peak_used_size;
+    uint64_t hole_count;
+    uint64_t alloc_count;
+    uint64_t fail_count;
+};
+
+/**
+ * Initialize @heap to manage [start, start + size). Both must be 64K aligned.
+ * Returns 0 on success or -ENOMEM.
+ */
+int
+mos_vma_heap_init(struct mos_vma_heap *heap, uint64_t start, uint64_t size);
+
+void
+mos_vma_heap_finish(struct mos_vma_heap *heap);
+
+/**
+ * Allocate @size bytes aligned to @alignment (power of two, at least 64K).
+ * Returns the offset, or 0 when the heap cannot satisfy the request.
+ */
+uint64_t
+mos_vma_heap_alloc(struct mos_vma_heap *heap, uint64_t size, uint64_t alignment);
+
+/**
+ * Return a range previously obtained from mos_vma_heap_alloc() with the same
+ * @size, coalescing it with adjacent free ranges.
+ */
+void
+mos_vma_heap_free(struct mos_vma_heap *heap, uint64_t offset, uint64_t size);
+
+void
+mos_vma_heap_get_stats(struct mos_vma_heap *heap, struct mos_vma_heap_stats *stats);
+
+#endif /* MOS_VMA_H */
@@ -51,6 +51,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <poll.h>
+#include <time.h>
 
 #include "errno.h"
 #ifndef ETIME
@@ -60,6 +62,7 @@
 #include "libdrm_lists.h"
 #include "mos_bufmgr.h"
 #include "mos_bufmgr_priv.h"
+#include "mos_vma.h"
 #include "string.h"
 
 #include "i915_drm.h"
@@ -107,6 +110,8 @@
                  (devid) == PCI_CHIP_I915_GM)
 
 struct mos_gem_bo_bucket {
+    /** Protects head; buckets are locked independently of bufmgr_gem->lock */
+    pthread_mutex_t lock;
     drmMMListHead head;
     unsigned long size;
 };
@@ -122,16 +127,32 @@ struct mos_bufmgr_gem {
 
     pthread_mutex_t lock;
 
+    /** Validation list of the legacy execbuffer path, under lock */
     struct drm_i915_gem_exec_object *exec_objects;
-    struct drm_i915_gem_exec_object2 *exec2_objects;
     struct mos_linux_bo **exec_bos;
     int exec_size;
     int exec_count;
 
+    /** Idle execbuffer2 validation lists, one is taken per submission */
+    pthread_mutex_t exec_list_lock;
+    struct mos_exec_list *exec_lists;
+
     /** Array of lists of cached gem objects of power-of-two sizes */
     struct mos_gem_bo_bucket cache_bucket[14 * 4];
     int num_buckets;
-    time_t time;
+    /** Monotonic time in ms of the last cache sweep */
+    uint64_t time;
+
+    /**
+     * All cached BOs across buckets, oldest first. cache_lock protects
+     * cache_lru and cache_stats and nests inside a bucket lock.
+     */
+    pthread_mutex_t cache_lock;
+    drmMMListHead cache_lru;
+    uint64_t cache_high_watermark;
+    uint64_t cache_low_watermark;
+    uint32_t cache_expire_ms;
+    struct mos_bufmgr_cache_stats cache_stats;
 
     drmMMListHead managers;
 
@@ -157,12 +178,74 @@ struct mos_bufmgr_gem {
     } userptr_active;
 
     // manage address for softpin buffer object
-    uint64_t head_offset;
+    pthread_mutex_t vma_lock;
+    struct mos_vma_heap vma_heap;
     bool use_softpin;
+
+    /**
+     * Out-fences of execbuffer2 submissions whose sync_file is still open,
+     * oldest first. fence_lock protects this list, every mos_gem_fence and
+     * the fence slots of all BOs.
+     */
+    pthread_mutex_t fence_lock;
+    drmMMListHead fences;
+    int fence_count;
+    bool has_exec_fence;
 } mos_bufmgr_gem;
 
 #define DRM_INTEL_RELOC_FENCE (1<<0)
 
+/**
+ * Validation list for one execbuffer2 submission.
+ *
+ * Each submitting thread builds its own list, so BOs are deduplicated
+ * through the slots map rather than bo_gem->validate_index, and the same
+ * BO may be validated by several submissions at once.
+ */
+struct mos_exec_list {
+    struct mos_exec_list *next;
+    struct drm_i915_gem_exec_object2 *objects;
+    struct mos_linux_bo **bos;
+    int count;
+    int size;
+    /** Open-addressed BO -> objects[] index map, -1 marks a free slot */
+    int *slots;
+    uint32_t slot_mask;
+    bool has_error;
+};
+
+/** Upper bound on sync_file descriptors kept open for fence tracking */
+#define MOS_GEM_MAX_OPEN_FENCES     128
+/** Engines a BO is tracked on at once before falling back to GEM_WAIT */
+#define MOS_GEM_BO_FENCE_SLOTS      4
+
+/**
+ * Out-fence of one execbuffer2 submission, shared by every BO on its
+ * validation list.
+ */
+struct mos_gem_fence {
+    /** Link in bufmgr_gem->fences while fd is open and not yet signalled */
+    drmMMListHead link;
+    /** References from BO slots, the open list and waiters */
+    int refcount;
+    /** Threads polling fd; it is only closed once this drops to 0 */
+    int waiters;
+    /** sync_file of the submission, -1 once closed */
+    int fd;
+    bool signalled;
+    /**
+     * The fd was closed before the fence was seen to signal, so the
+     * state of the submission is unknown.
+     */
+    bool expired;
+};
+
+struct mos_gem_fence_slot {
+    /** Context id and engine selector the fence was submitted on */
+    uint64_t engine;
+    struct mos_gem_fence *fence;
+};
+
 struct mos_reloc_target {
     struct mos_linux_bo *bo;
     int flags;
@@ -201,7 +284,8 @@ struct mos_bo_gem {
     uint32_t swizzle_mode;
     unsigned long stride;
 
-    time_t free_time;
+    /** Monotonic time in ms when the BO entered the reuse cache */
+    uint64_t free_time;
 
     /** Array passed to the DRM containing relocation information. */
     struct drm_i915_gem_relocation_entry *relocs;
@@ -233,6 +317,8 @@ struct mos_bo_gem {
 
     /** BO cache list */
     drmMMListHead head;
+    /** Link in bufmgr_gem->cache_lru while cached */
+    drmMMListHead lru;
 
     /**
      * Boolean of whether this BO and its children have been included in
@@ -263,6 +349,10 @@ struct mos_bo_gem {
      * This is only valid when reusable, since non-reusable
      * buffers are those that have been shared wth other
      * processes, so we don't know their state.
+     *
+     * Only set under fence_lock while fence_seq still has the value it had
+     * when the wait or busy query started, so a submission racing with the
+     * query leaves the buffer busy. Read without a lock.
      */
     bool idle;
 
@@ -285,11 +375,32 @@ struct mos_bo_gem {
      */
     bool is_softpin;
 
+    /**
+     * Size of the range reserved from vma_heap for this buffer, 0 when
+     * the softpin offset was not handed out by the bufmgr.
+     */
+    uint64_t softpin_va_size;
+
     /*
     * Whether to remove the dependency of this bo in exebuf.
     */
     bool exec_async;
 
+    /**
+     * Last out-fence of each engine that executed this buffer. Submissions
+     * on one engine of one context complete in order, so only the newest
+     * fence per engine is kept.
+     */
+    struct mos_gem_fence_slot fences[MOS_GEM_BO_FENCE_SLOTS];
+    /**
+     * Set when the buffer was submitted without a tracked fence, so its
+     * fences do not describe all outstanding work; cleared once GEM_WAIT
+     * finds the buffer idle.
+     */
+    bool fence_untracked;
+    /** Bumped on every submission and fence attach, under fence_lock */
+    uint32_t fence_seq;
+
     /**
      * Size in bytes of this buffer and its relocation descendents.
      *
@@ -330,7 +441,7 @@ mos_gem_bo_set_tiling_internal(struct mos_linux_bo *bo,
                      uint32_t stride);
 
 static void mos_gem_bo_unreference_locked_timed(struct mos_linux_bo *bo,
-                              time_t time);
+                              uint64_t time);
 
 static void mos_gem_bo_unreference(struct mos_linux_bo *bo);
 
@@ -339,6 +450,15 @@ static inline struct mos_bo_gem *to_bo_gem(struct mos_linux_bo *bo)
         return (struct mos_bo_gem *)bo;
 }
 
+static inline uint64_t
+mos_gem_get_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 static unsigned long
 mos_gem_bo_tile_size(struct mos_bufmgr_gem *bufmgr_gem, unsigned long size,
                uint32_t *tiling_mode)
@@ -383,30 +503,47 @@ mos_gem_bo_tile_pitch(struct mos_bufmgr_gem *bufmgr_gem,
     return ROUND_UP_TO(pitch, tile_width);
 }
 
+/*
+ * Buckets are laid out by init_cache_buckets() as 4K, 8K, 12K followed by
+ * four quarter steps per power of two starting at 16K, so the smallest
+ * bucket that fits can be computed directly instead of searched for.
+ */
 static struct mos_gem_bo_bucket *
 mos_gem_bo_bucket_for_size(struct mos_bufmgr_gem *bufmgr_gem,
                  unsigned long size)
 {
     int i;
 
-    for (i = 0; i < bufmgr_gem->num_buckets; i++) {
-        struct mos_gem_bo_bucket *bucket =
-            &bufmgr_gem->cache_bucket[i];
-        if (bucket->size >= size) {
-            return bucket;
-        }
+    if (size <= 3 * 4096) {
+        i = size ? (size - 1) / 4096 : 0;
+    } else if (size <= 4 * 4096) {
+        i = 3;
+    } else {
+        /* size lies in (2^order, 2^(order + 1)] */
+        int order = (int)(sizeof(unsigned long) * 8 - 1) - __builtin_clzl(size - 1);
+        unsigned long base = 1ul << order;
+        unsigned long quarter = base >> 2;
+
+        i = 3 + 4 * (order - 14) + (int)((size - base + quarter - 1) / quarter);
     }
 
-    return nullptr;
+    if (i >= bufmgr_gem->num_buckets)
+        return nullptr;
+
+    assert(bufmgr_gem->cache_bucket[i].size >= size);
+    assert(i == 0 || bufmgr_gem->cache_bucket[i - 1].size < size);
+
+    return &bufmgr_gem->cache_bucket[i];
 }
 
 static void
-mos_gem_dump_validation_list(struct mos_bufmgr_gem *bufmgr_gem)
+mos_gem_dump_validation_list(struct mos_bufmgr_gem *bufmgr_gem,
+                   struct mos_linux_bo **exec_bos, int exec_count)
 {
     int i, j;
 
-    for (i = 0; i < bufmgr_gem->exec_count; i++) {
-        struct mos_linux_bo *bo = bufmgr_gem->exec_bos[i];
+    for (i = 0; i < exec_count; i++) {
+        struct mos_linux_bo *bo = exec_bos[i];
         struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
 
         if (bo_gem->relocs == nullptr || bo_gem->softpin_target == nullptr) {
@@ -517,188 +654,183 @@ mos_add_validate_buffer(struct mos_linux_bo *bo)
     bufmgr_gem->exec_count++;
 }
 
-static void
-mos_add_validate_buffer2(struct mos_linux_bo *bo, int need_fence)
+static inline uint32_t
+mos_exec_list_hash(struct mos_linux_bo *bo)
 {
-    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)bo->bufmgr;
-    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)bo;
-    int index;
-    struct drm_i915_gem_exec_object2 *exec2_objects;
-    struct mos_linux_bo **exec_bos;
-    int flags = 0;
+    return (uint32_t)((((uint64_t)(uintptr_t)bo >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+}
 
-    if (need_fence)
-        flags |= EXEC_OBJECT_NEEDS_FENCE;
-    if (bo_gem->pad_to_size)
-        flags |= EXEC_OBJECT_PAD_TO_SIZE;
-    if (bo_gem->use_48b_address_range)
-        flags |= EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
-    if (bo_gem->is_softpin)
-        flags |= EXEC_OBJECT_PINNED;
-    if (bo_gem->exec_async)
-        flags |= EXEC_OBJECT_ASYNC;
+static int
+mos_exec_list_lookup(struct mos_exec_list *list, struct mos_linux_bo *bo)
+{
+    uint32_t slot;
 
-    if (bo_gem->validate_index != -1) {
-        bufmgr_gem->exec2_objects[bo_gem->validate_index].flags |= flags;
-        return;
+    if (list->slots == nullptr)
+        return -1;
+
+    for (slot = mos_exec_list_hash(bo) & list->slot_mask;
+         list->slots[slot] != -1;
+         slot = (slot + 1) & list->slot_mask) {
+        if (list->bos[list->slots[slot]] == bo)
+            return list->slots[slot];
     }
 
-    /* Extend the array of validation entries as necessary. */
-    if (bufmgr_gem->exec_count == bufmgr_gem->exec_size) {
-        int new_size = bufmgr_gem->exec_size * 2;
+    return -1;
+}
 
-        if (new_size == 0)
-            new_size = ARRAY_INIT_SIZE;
-        exec2_objects = (struct drm_i915_gem_exec_object2 *)
-                realloc(bufmgr_gem->exec2_objects,
-                    sizeof(*bufmgr_gem->exec2_objects) * new_size);
-        if (!exec2_objects)
-            return;
+static void
+mos_exec_list_insert_slot(struct mos_exec_list *list, int index)
+{
+    uint32_t slot = mos_exec_list_hash(list->bos[index]) & list->slot_mask;
 
-        bufmgr_gem->exec2_objects = exec2_objects;
+    while (list->slots[slot] != -1)
+        slot = (slot + 1) & list->slot_mask;
+    list->slots[slot] = index;
+}
 
-        exec_bos = (struct mos_linux_bo **)realloc(bufmgr_gem->exec_bos,
-                sizeof(*bufmgr_gem->exec_bos) * new_size);
-        if (!exec_bos)
-            return;
+static int
+mos_exec_list_grow(struct mos_exec_list *list)
+{
+    int new_size = list->size ? list->size * 2 : 64;
+    uint32_t new_slots = 1;
+    struct drm_i915_gem_exec_object2 *objects;
+    struct mos_linux_bo **bos;
+    int *slots;
+    int i;
 
-        bufmgr_gem->exec_bos = exec_bos;
-        bufmgr_gem->exec_size = new_size;
-    }
+    /* Keep the map at most half full */
+    while (new_slots < (uint32_t)new_size * 2)
+        new_slots <<= 1;
 
-    index = bufmgr_gem->exec_count;
-    bo_gem->validate_index = index;
-    /* Fill in array entry */
-    bufmgr_gem->exec2_objects[index].handle = bo_gem->gem_handle;
-    bufmgr_gem->exec2_objects[index].relocation_count = bo_gem->reloc_count;
-    bufmgr_gem->exec2_objects[index].relocs_ptr = (uintptr_t)bo_gem->relocs;
-    bufmgr_gem->exec2_objects[index].alignment = bo->align;
-    bufmgr_gem->exec2_objects[index].offset = bo_gem->is_softpin ?
-        bo->offset64 : 0;
-    bufmgr_gem->exec_bos[index] = bo;
-    bufmgr_gem->exec2_objects[index].flags = flags;
-    bufmgr_gem->exec2_objects[index].rsvd1 = 0;
-    bufmgr_gem->exec2_objects[index].pad_to_size = bo_gem->pad_to_size;
-    bufmgr_gem->exec2_objects[index].rsvd2 = 0;
-    bufmgr_gem->exec_count++;
+    objects = (struct drm_i915_gem_exec_object2 *)realloc(list->objects,
+            sizeof(*list->objects) * new_size);
+    if (!objects)
+        return -ENOMEM;
+    list->objects = objects;
+
+    bos = (struct mos_linux_bo **)realloc(list->bos,
+            sizeof(*list->bos) * new_size);
+    if (!bos)
+        return -ENOMEM;
+    list->bos = bos;
+
+    slots = (int *)malloc(sizeof(*slots) * new_slots);
+    if (!slots)
+        return -ENOMEM;
+    memset(slots, 0xff, sizeof(*slots) * new_slots);
+
+    free(list->slots);
+    list->slots = slots;
+    list->slot_mask = new_slots - 1;
+    list->size = new_size;
+
+    for (i = 0; i < list->count; i++)
+        mos_exec_list_insert_slot(list, i);
+
+    return 0;
 }
 
+/**
+ * Adds the given buffer to the validation list of this submission, or
+ * merges @flags into its existing entry.
+ */
 static void
-mos_add_reloc_objects(struct mos_reloc_target reloc_target)
+mos_exec_list_add(struct mos_exec_list *list, struct mos_linux_bo *bo,
+                  uint64_t flags, uint64_t offset)
 {
-    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)reloc_target.bo->bufmgr;
-    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)reloc_target.bo;
+    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)bo;
     int index;
-    struct drm_i915_gem_exec_object2 *exec2_objects;
-    struct mos_linux_bo **exec_bos;
 
-    if (bo_gem->validate_index != -1) {
-        bufmgr_gem->exec2_objects[bo_gem->validate_index].flags |= reloc_target.flags;
+    index = mos_exec_list_lookup(list, bo);
+    if (index != -1) {
+        list->objects[index].flags |= flags;
         return;
     }
 
     /* Extend the array of validation entries as necessary. */
-    if (bufmgr_gem->exec_count == bufmgr_gem->exec_size) {
-        int new_size = bufmgr_gem->exec_size * 2;
+    if (list->count == list->size && mos_exec_list_grow(list)) {
+        list->has_error = true;
+        return;
+    }
 
-        if (new_size == 0)
-            new_size = ARRAY_INIT_SIZE;
-        exec2_objects = (struct drm_i915_gem_exec_object2 *)
-                realloc(bufmgr_gem->exec2_objects,
-                    sizeof(*bufmgr_gem->exec2_objects) * new_size);
-        if (!exec2_objects)
-        {
-            MOS_DBG("realloc exec2_objects failed!\n");
-            return;
-        }
+    index = list->count++;
+    list->bos[index] = bo;
+    mos_exec_list_insert_slot(list, index);
 
-        bufmgr_gem->exec2_objects = exec2_objects;
+    /* Fill in array entry */
+    list->objects[index].handle           = bo_gem->gem_handle;
+    list->objects[index].relocation_count = bo_gem->reloc_count;
+    list->objects[index].relocs_ptr       = (uintptr_t)bo_gem->relocs;
+    list->objects[index].alignment        = bo->align;
+    list->objects[index].offset           = offset;
+    list->objects[index].flags            = flags;
+    list->objects[index].rsvd1            = 0;
+    list->objects[index].pad_to_size      = bo_gem->pad_to_size;
+    list->objects[index].rsvd2            = 0;
+}
 
-        exec_bos = (struct mos_linux_bo **)realloc(bufmgr_gem->exec_bos,
-                sizeof(*bufmgr_gem->exec_bos) * new_size);
-        if (!exec_bos)
-        {
-            MOS_DBG("realloc exec_bo failed!\n");
-            return;
-        }
+static struct mos_exec_list *
+mos_exec_list_get(struct mos_bufmgr_gem *bufmgr_gem)
+{
+    struct mos_exec_list *list;
 
-        bufmgr_gem->exec_bos = exec_bos;
-        bufmgr_gem->exec_size = new_size;
-    }
+    pthread_mutex_lock(&bufmgr_gem->exec_list_lock);
+    list = bufmgr_gem->exec_lists;
+    if (list)
+        bufmgr_gem->exec_lists = list->next;
+    pthread_mutex_unlock(&bufmgr_gem->exec_list_lock);
 
-    index = bufmgr_gem->exec_count;
-    bo_gem->validate_index = index;
-    /* Fill in array entry */
-    bufmgr_gem->exec2_objects[index].handle           = bo_gem->gem_handle;
-    bufmgr_gem->exec2_objects[index].relocation_count = bo_gem->reloc_count;
-    bufmgr_gem->exec2_objects[index].relocs_ptr       = (uintptr_t)bo_gem->relocs;
-    bufmgr_gem->exec2_objects[index].alignment        = reloc_target.bo->align;
-    bufmgr_gem->exec2_objects[index].offset           = 0;
-    bufmgr_gem->exec_bos[index]                       = reloc_target.bo;
-    bufmgr_gem->exec2_objects[index].flags            = reloc_target.flags;
-    bufmgr_gem->exec2_objects[index].rsvd1            = 0;
-    bufmgr_gem->exec2_objects[index].pad_to_size      = bo_gem->pad_to_size;
-    bufmgr_gem->exec2_objects[index].rsvd2            = 0;
-    bufmgr_gem->exec_count++;
+    if (list == nullptr)
+        list = (struct mos_exec_list *)calloc(1, sizeof(*list));
+
+    return list;
 }
 
 static void
-mos_add_softpin_objects(struct mos_softpin_target softpin_target)
+mos_exec_list_put(struct mos_bufmgr_gem *bufmgr_gem, struct mos_exec_list *list)
 {
-    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)softpin_target.bo->bufmgr;
-    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)softpin_target.bo;
-    int index;
-    struct drm_i915_gem_exec_object2 *exec2_objects;
-    struct mos_linux_bo **exec_bos;
-
-    if (bo_gem->validate_index != -1) {
-        bufmgr_gem->exec2_objects[bo_gem->validate_index].flags |= softpin_target.flags;
-        return;
-    }
-
-    /* Extend the array of validation entries as necessary. */
-    if (bufmgr_gem->exec_count == bufmgr_gem->exec_size) {
-        int new_size = bufmgr_gem->exec_size * 2;
+    if (list->slots)
+        memset(list->slots, 0xff, sizeof(*list->slots) * (list->slot_mask + 1));
+    list->count = 0;
+    list->has_error = false;
+
+    pthread_mutex_lock(&bufmgr_gem->exec_list_lock);
+    list->next = bufmgr_gem->exec_lists;
+    bufmgr_gem->exec_lists = list;
+    pthread_mutex_unlock(&bufmgr_gem->exec_list_lock);
+}
 
-        if (new_size == 0)
-            new_size = ARRAY_INIT_SIZE;
-        exec2_objects = (struct drm_i915_gem_exec_object2 *)
-                realloc(bufmgr_gem->exec2_objects,
-                    sizeof(*bufmgr_gem->exec2_objects) * new_size);
-        if (!exec2_objects)
-        {
-            MOS_DBG("realloc exec2_objects failed!\n");
-            return;
-        }
+static void
+mos_add_validate_buffer2(struct mos_exec_list *list, struct mos_linux_bo *bo, int need_fence)
+{
+    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)bo;
+    int flags = 0;
 
-        bufmgr_gem->exec2_objects = exec2_objects;
+    if (need_fence)
+        flags |= EXEC_OBJECT_NEEDS_FENCE;
+    if (bo_gem->pad_to_size)
+        flags |= EXEC_OBJECT_PAD_TO_SIZE;
+    if (bo_gem->use_48b_address_range)
+        flags |= EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
+    if (bo_gem->is_softpin)
+        flags |= EXEC_OBJECT_PINNED;
+    if (bo_gem->exec_async)
+        flags |= EXEC_OBJECT_ASYNC;
 
-        exec_bos = (struct mos_linux_bo **)realloc(bufmgr_gem->exec_bos,
-                sizeof(*bufmgr_gem->exec_bos) * new_size);
-        if (!exec_bos)
-        {
-            MOS_DBG("realloc exec_bo failed!\n");
-            return;
-        }
+    mos_exec_list_add(list, bo, flags, bo_gem->is_softpin ? bo->offset64 : 0);
+}
 
-        bufmgr_gem->exec_bos = exec_bos;
-        bufmgr_gem->exec_size = new_size;
-    }
+static void
+mos_add_reloc_objects(struct mos_exec_list *list, struct mos_reloc_target reloc_target)
+{
+    mos_exec_list_add(list, reloc_target.bo, reloc_target.flags, 0);
+}
 
-    index = bufmgr_gem->exec_count;
-    bo_gem->validate_index = index;
-    /* Fill in array entry */
-    bufmgr_gem->exec2_objects[index].handle           = bo_gem->gem_handle;
-    bufmgr_gem->exec2_objects[index].relocation_count = bo_gem->reloc_count;
-    bufmgr_gem->exec2_objects[index].relocs_ptr       = (uintptr_t)bo_gem->relocs;
-    bufmgr_gem->exec2_objects[index].alignment        = softpin_target.bo->align;
-    bufmgr_gem->exec2_objects[index].offset           = softpin_target.bo->offset64;
-    bufmgr_gem->exec2_objects[index].flags            = softpin_target.flags;
-    bufmgr_gem->exec2_objects[index].pad_to_size      = bo_gem->pad_to_size;
-    bufmgr_gem->exec2_objects[index].rsvd1            = 0;
-    bufmgr_gem->exec2_objects[index].rsvd2            = 0;
-    bufmgr_gem->exec_bos[index]                       = softpin_target.bo;
-    bufmgr_gem->exec_count++;
+static void
+mos_add_softpin_objects(struct mos_exec_list *list, struct mos_softpin_target softpin_target)
+{
+    mos_exec_list_add(list, softpin_target.bo, softpin_target.flags,
+                      softpin_target.bo->offset64);
 }
 
 #define RELOC_BUF_SIZE(x) ((I915_RELOC_HEADER + x * I915_RELOC0_STRIDE) * \
@@ -753,23 +885,62 @@ mos_setup_reloc_list(struct mos_linux_bo *bo)
     return 0;
 }
 
+static uint32_t
+mos_gem_bo_get_fence_seq(struct mos_bufmgr_gem *bufmgr_gem,
+                         struct mos_bo_gem *bo_gem)
+{
+    uint32_t fence_seq;
+
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    fence_seq = bo_gem->fence_seq;
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+
+    return fence_seq;
+}
+
+/**
+ * Marks the buffer idle after a wait or busy query that started at
+ * @fence_seq. If it was submitted again meanwhile it stays busy.
+ */
+static void
+mos_gem_bo_mark_idle(struct mos_bufmgr_gem *bufmgr_gem,
+                     struct mos_bo_gem *bo_gem, uint32_t fence_seq)
+{
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    if (bo_gem->fence_seq == fence_seq)
+        __atomic_store_n(&bo_gem->idle, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+}
+
+/** Marks the buffers of a submission busy. Called with fence_lock held. */
+static void
+mos_gem_bo_mark_busy_locked(struct mos_bo_gem *bo_gem)
+{
+    __atomic_store_n(&bo_gem->idle, false, __ATOMIC_RELEASE);
+    bo_gem->fence_seq++;
+}
+
 static int
 mos_gem_bo_busy(struct mos_linux_bo *bo)
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
     struct drm_i915_gem_busy busy;
+    uint32_t fence_seq;
     int ret;
 
-    if (bo_gem->reusable && bo_gem->idle)
+    if (bo_gem->reusable && __atomic_load_n(&bo_gem->idle, __ATOMIC_ACQUIRE))
         return false;
 
+    fence_seq = mos_gem_bo_get_fence_seq(bufmgr_gem, bo_gem);
+
     memclear(busy);
     busy.handle = bo_gem->gem_handle;
 
     ret = drmIoctl(bufmgr_gem->fd, DRM_IOCTL_I915_GEM_BUSY, &busy);
     if (ret == 0) {
-        bo_gem->idle = !busy.busy;
+        if (!busy.busy)
+            mos_gem_bo_mark_idle(bufmgr_gem, bo_gem, fence_seq);
         return busy.busy;
     } else {
         return false;
@@ -801,7 +972,40 @@ mos_gem_bo_madvise(struct mos_linux_bo *bo, int madv)
          madv);
 }
 
-/* drop the oldest entries that have been purged by the kernel */
+/* Called with bucket->lock held */
+static void
+mos_gem_bo_cache_add(struct mos_bufmgr_gem *bufmgr_gem,
+                    struct mos_gem_bo_bucket *bucket,
+                    struct mos_bo_gem *bo_gem)
+{
+    DRMLISTADDTAIL(&bo_gem->head, &bucket->head);
+
+    pthread_mutex_lock(&bufmgr_gem->cache_lock);
+    DRMLISTADDTAIL(&bo_gem->lru, &bufmgr_gem->cache_lru);
+    /* cached_bytes is also read without cache_lock for the budget check */
+    __atomic_add_fetch(&bufmgr_gem->cache_stats.cached_bytes, bo_gem->bo.size, __ATOMIC_RELAXED);
+    bufmgr_gem->cache_stats.cached_count++;
+    if (bufmgr_gem->cache_stats.cached_bytes > bufmgr_gem->cache_stats.peak_cached_bytes)
+        bufmgr_gem->cache_stats.peak_cached_bytes = bufmgr_gem->cache_stats.cached_bytes;
+    pthread_mutex_unlock(&bufmgr_gem->cache_lock);
+}
+
+/* Called with the lock of the bucket holding bo_gem */
+static void
+mos_gem_bo_cache_remove(struct mos_bufmgr_gem *bufmgr_gem,
+                    struct mos_bo_gem *bo_gem)
+{
+    DRMLISTDEL(&bo_gem->head);
+
+    pthread_mutex_lock(&bufmgr_gem->cache_lock);
+    DRMLISTDEL(&bo_gem->lru);
+    __atomic_sub_fetch(&bufmgr_gem->cache_stats.cached_bytes, bo_gem->bo.size, __ATOMIC_RELAXED);
+    bufmgr_gem->cache_stats.cached_count--;
+    pthread_mutex_unlock(&bufmgr_gem->cache_lock);
+}
+
+/* drop the oldest entries that have been purged by the kernel,
+ * called with bucket->lock held */
 static void
 mos_gem_bo_cache_purge_bucket(struct mos_bufmgr_gem *bufmgr_gem,
                     struct mos_gem_bo_bucket *bucket)
@@ -815,8 +1019,9 @@ mos_gem_bo_cache_purge_bucket(struct mos_bufmgr_gem *bufmgr_gem,
             (bufmgr_gem, bo_gem, I915_MADV_DONTNEED))
             break;
 
-        DRMLISTDEL(&bo_gem->head);
+        mos_gem_bo_cache_remove(bufmgr_gem, bo_gem);
         mos_gem_bo_free(&bo_gem->bo);
+        __atomic_fetch_add(&bufmgr_gem->cache_stats.purged, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -856,10 +1061,12 @@ mos_gem_bo_alloc_internal(struct mos_bufmgr *bufmgr,
         bo_size = bucket->size;
     }
 
-    pthread_mutex_lock(&bufmgr_gem->lock);
     /* Get a buffer out of the cache if available */
 retry:
     alloc_from_cache = false;
+    if (bucket != nullptr) {
+        pthread_mutex_lock(&bucket->lock);
+    }
     if (bucket != nullptr && !DRMLISTEMPTY(&bucket->head)) {
         if (for_render) {
             /* Allocate new render-target BOs from the tail (MRU)
@@ -868,7 +1075,7 @@ retry:
              */
             bo_gem = DRMLISTENTRY(struct mos_bo_gem,
                           bucket->head.prev, head);
-            DRMLISTDEL(&bo_gem->head);
+            mos_gem_bo_cache_remove(bufmgr_gem, bo_gem);
             alloc_from_cache = true;
             bo_gem->bo.align = alignment;
         } else {
@@ -884,7 +1091,7 @@ retry:
                           bucket->head.next, head);
             if (!mos_gem_bo_busy(&bo_gem->bo)) {
                 alloc_from_cache = true;
-                DRMLISTDEL(&bo_gem->head);
+                mos_gem_bo_cache_remove(bufmgr_gem, bo_gem);
             }
         }
 
@@ -894,18 +1101,28 @@ retry:
                 mos_gem_bo_free(&bo_gem->bo);
                 mos_gem_bo_cache_purge_bucket(bufmgr_gem,
                                     bucket);
-                goto retry;
-            }
-
-            if (mos_gem_bo_set_tiling_internal(&bo_gem->bo,
-                                 tiling_mode,
-                                 stride)) {
-                mos_gem_bo_free(&bo_gem->bo);
+                pthread_mutex_unlock(&bucket->lock);
+                __atomic_fetch_add(&bufmgr_gem->cache_stats.purged, 1, __ATOMIC_RELAXED);
                 goto retry;
             }
         }
     }
-    pthread_mutex_unlock(&bufmgr_gem->lock);
+    if (bucket != nullptr) {
+        pthread_mutex_unlock(&bucket->lock);
+        __atomic_fetch_add(alloc_from_cache ?
+                           &bufmgr_gem->cache_stats.hits :
+                           &bufmgr_gem->cache_stats.misses,
+                           1, __ATOMIC_RELAXED);
+    }
+
+    /* The BO is off the cache list, so retiling needs no lock */
+    if (alloc_from_cache &&
+        mos_gem_bo_set_tiling_internal(&bo_gem->bo,
+                             tiling_mode,
+                             stride)) {
+        mos_gem_bo_free(&bo_gem->bo);
+        goto retry;
+    }
 
     if (!alloc_from_cache) {
         struct drm_i915_gem_create create;
@@ -1293,6 +1510,169 @@ mos_bo_gem_create_from_name(struct mos_bufmgr *bufmgr,
     return &bo_gem->bo;
 }
 
+static void
+mos_gem_fence_unreference_locked(struct mos_gem_fence *fence)
+{
+    if (--fence->refcount > 0)
+        return;
+
+    if (fence->fd >= 0)
+        close(fence->fd);
+    free(fence);
+}
+
+/**
+ * Take @fence off the open list, either because it signalled or to bound
+ * the number of open fds. The fd is closed now unless a waiter is still
+ * polling it, in which case the last waiter closes it.
+ *
+ * A fence is on the open list as long as it is neither signalled nor
+ * expired. Called with fence_lock held.
+ */
+static void
+mos_gem_fence_retire_locked(struct mos_bufmgr_gem *bufmgr_gem,
+                            struct mos_gem_fence *fence, bool signalled)
+{
+    DRMLISTDEL(&fence->link);
+    bufmgr_gem->fence_count--;
+
+    if (signalled)
+        fence->signalled = true;
+    else
+        fence->expired = true;
+
+    if (fence->waiters == 0) {
+        close(fence->fd);
+        fence->fd = -1;
+    }
+    mos_gem_fence_unreference_locked(fence);
+}
+
+/**
+ * Keep at most MOS_GEM_MAX_OPEN_FENCES sync_files open. The oldest fences
+ * are polled in one batch and the signalled ones retired; if none has
+ * signalled the oldest is expired, so BOs waiting on it use GEM_WAIT.
+ */
+static void
+mos_gem_fence_trim_locked(struct mos_bufmgr_gem *bufmgr_gem)
+{
+    struct mos_gem_fence *batch[16];
+    struct pollfd pfd[16];
+    struct mos_gem_fence *fence;
+    int count = 0, i;
+
+    if (bufmgr_gem->fence_count <= MOS_GEM_MAX_OPEN_FENCES)
+        return;
+
+    DRMLISTFOREACHENTRY(fence, &bufmgr_gem->fences, link) {
+        if (count == 16)
+            break;
+        batch[count] = fence;
+        pfd[count].fd = fence->fd;
+        pfd[count].events = POLLIN;
+        pfd[count].revents = 0;
+        count++;
+    }
+
+    if (poll(pfd, count, 0) > 0) {
+        for (i = 0; i < count; i++) {
+            if (pfd[i].revents && !(pfd[i].revents & POLLNVAL))
+                mos_gem_fence_retire_locked(bufmgr_gem, batch[i], true);
+        }
+    }
+
+    if (bufmgr_gem->fence_count > MOS_GEM_MAX_OPEN_FENCES) {
+        mos_gem_fence_retire_locked(bufmgr_gem,
+            DRMLISTENTRY(struct mos_gem_fence, bufmgr_gem->fences.next, link),
+            false);
+    }
+}
+
+static void
+mos_gem_bo_attach_fence_locked(struct mos_bo_gem *bo_gem, uint64_t engine,
+                               struct mos_gem_fence *fence)
+{
+    struct mos_gem_fence_slot *slot = nullptr;
+    int i;
+
+    /* Replace the fence of the same engine, else take a free slot or one
+     * whose fence already signalled.
+     */
+    for (i = 0; i < MOS_GEM_BO_FENCE_SLOTS; i++) {
+        struct mos_gem_fence_slot *cur = &bo_gem->fences[i];
+
+        if (cur->fence && cur->engine == engine) {
+            slot = cur;
+            break;
+        }
+        if (slot == nullptr && (cur->fence == nullptr || cur->fence->signalled))
+            slot = cur;
+    }
+
+    bo_gem->fence_seq++;
+    if (slot == nullptr) {
+        bo_gem->fence_untracked = true;
+        return;
+    }
+
+    if (slot->fence)
+        mos_gem_fence_unreference_locked(slot->fence);
+    fence->refcount++;
+    slot->engine = engine;
+    slot->fence = fence;
+}
+
+/**
+ * Record the out-fence @fd of a submission on every BO of @list. Takes
+ * ownership of @fd; -1 marks the BOs untracked.
+ */
+static void
+mos_gem_track_fence(struct mos_bufmgr_gem *bufmgr_gem,
+                    struct mos_exec_list *list, uint64_t engine, int fd)
+{
+    struct mos_gem_fence *fence = nullptr;
+    int i;
+
+    if (fd >= 0) {
+        fence = (struct mos_gem_fence *)calloc(1, sizeof(*fence));
+        if (fence == nullptr)
+            close(fd);
+    }
+
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    if (fence == nullptr) {
+        for (i = 0; i < list->count; i++)
+            to_bo_gem(list->bos[i])->fence_untracked = true;
+        pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+        return;
+    }
+
+    fence->fd = fd;
+    fence->refcount = 1;
+    DRMLISTADDTAIL(&fence->link, &bufmgr_gem->fences);
+    bufmgr_gem->fence_count++;
+
+    for (i = 0; i < list->count; i++)
+        mos_gem_bo_attach_fence_locked(to_bo_gem(list->bos[i]), engine, fence);
+
+    mos_gem_fence_trim_locked(bufmgr_gem);
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+}
+
+static void
+mos_gem_bo_clear_fences_locked(struct mos_bo_gem *bo_gem)
+{
+    int i;
+
+    for (i = 0; i < MOS_GEM_BO_FENCE_SLOTS; i++) {
+        if (bo_gem->fences[i].fence) {
+            mos_gem_fence_unreference_locked(bo_gem->fences[i].fence);
+            bo_gem->fences[i].fence = nullptr;
+        }
+    }
+    bo_gem->fence_untracked = false;
+}
+
 drm_export void
 mos_gem_bo_free(struct mos_linux_bo *bo)
 {
@@ -1322,6 +1702,20 @@ mos_gem_bo_free(struct mos_linux_bo *bo)
             bo_gem->gem_handle, bo_gem->name, strerror(errno));
     }
 
+    /* Give the softpin address range back once the handle is closed */
+    if (bo_gem->softpin_va_size) {
+        pthread_mutex_lock(&bufmgr_gem->vma_lock);
+        mos_vma_heap_free(&bufmgr_gem->vma_heap, bo->offset64,
+                          bo_gem->softpin_va_size);
+        pthread_mutex_unlock(&bufmgr_gem->vma_lock);
+    }
+
+    if (bufmgr_gem->has_exec_fence) {
+        pthread_mutex_lock(&bufmgr_gem->fence_lock);
+        mos_gem_bo_clear_fences_locked(bo_gem);
+        pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+    }
+
     free(bo);
 }
 
@@ -1342,38 +1736,89 @@ mos_gem_bo_mark_mmaps_incoherent(struct mos_linux_bo *bo)
 #endif
 }
 
-/** Frees all cached buffers significantly older than @time. */
+#define MOS_BO_CACHE_SWEEP_INTERVAL_MS          100
+#define MOS_BO_CACHE_DEFAULT_EXPIRE_MS          1000
+#define MOS_BO_CACHE_DEFAULT_HIGH_WATERMARK     (512ull * 1024 * 1024)
+#define MOS_BO_CACHE_DEFAULT_LOW_WATERMARK      (384ull * 1024 * 1024)
+
+/**
+ * Frees cached buffers older than cache_expire_ms at @time, plus the least
+ * recently freed ones across all buckets while the cache is above its high
+ * watermark, until it drops to the low watermark.
+ */
 static void
-mos_gem_cleanup_bo_cache(struct mos_bufmgr_gem *bufmgr_gem, time_t time)
+mos_gem_bo_cache_evict(struct mos_bufmgr_gem *bufmgr_gem, uint64_t time)
 {
-    int i;
+    struct mos_bo_gem *bo_gem, *tmp;
+    drmMMListHead evicted;
+    bool over_budget;
 
-    if (bufmgr_gem->time == time)
-        return;
+    DRMINITLISTHEAD(&evicted);
 
-    for (i = 0; i < bufmgr_gem->num_buckets; i++) {
-        struct mos_gem_bo_bucket *bucket =
-            &bufmgr_gem->cache_bucket[i];
+    pthread_mutex_lock(&bufmgr_gem->cache_lock);
+    over_budget = bufmgr_gem->cache_high_watermark &&
+        bufmgr_gem->cache_stats.cached_bytes > bufmgr_gem->cache_high_watermark;
 
-        while (!DRMLISTEMPTY(&bucket->head)) {
-            struct mos_bo_gem *bo_gem;
+    DRMLISTFOREACHENTRYSAFE(bo_gem, tmp, &bufmgr_gem->cache_lru, lru) {
+        struct mos_gem_bo_bucket *bucket;
+        /* @time may be older than free_time when it was taken on another thread */
+        bool expired = time >= bo_gem->free_time &&
+            time - bo_gem->free_time > bufmgr_gem->cache_expire_ms;
 
-            bo_gem = DRMLISTENTRY(struct mos_bo_gem,
-                          bucket->head.next, head);
-            if (time - bo_gem->free_time <= 1)
-                break;
+        if (!expired &&
+            !(over_budget && bufmgr_gem->cache_stats.cached_bytes > bufmgr_gem->cache_low_watermark))
+            break;
+
+        /* Bucket locks nest outside cache_lock, so only try; a BO whose
+         * bucket is busy is left for the next sweep.
+         */
+        bucket = mos_gem_bo_bucket_for_size(bufmgr_gem, bo_gem->bo.size);
+        if (pthread_mutex_trylock(&bucket->lock) != 0)
+            continue;
+        DRMLISTDEL(&bo_gem->head);
+        pthread_mutex_unlock(&bucket->lock);
 
-            DRMLISTDEL(&bo_gem->head);
+        DRMLISTDEL(&bo_gem->lru);
+        __atomic_sub_fetch(&bufmgr_gem->cache_stats.cached_bytes, bo_gem->bo.size, __ATOMIC_RELAXED);
+        bufmgr_gem->cache_stats.cached_count--;
+        if (expired)
+            bufmgr_gem->cache_stats.expired++;
+        else
+            bufmgr_gem->cache_stats.evicted++;
 
-            mos_gem_bo_free(&bo_gem->bo);
-        }
+        DRMLISTADDTAIL(&bo_gem->lru, &evicted);
+    }
+    pthread_mutex_unlock(&bufmgr_gem->cache_lock);
+
+    DRMLISTFOREACHENTRYSAFE(bo_gem, tmp, &evicted, lru) {
+        DRMLISTDEL(&bo_gem->lru);
+        mos_gem_bo_free(&bo_gem->bo);
+    }
+}
+
+/** Expires cached buffers periodically, or right away when over budget. */
+static void
+mos_gem_cleanup_bo_cache(struct mos_bufmgr_gem *bufmgr_gem, uint64_t time)
+{
+    uint64_t last = __atomic_load_n(&bufmgr_gem->time, __ATOMIC_RELAXED);
+    bool over_budget = bufmgr_gem->cache_high_watermark &&
+        __atomic_load_n(&bufmgr_gem->cache_stats.cached_bytes, __ATOMIC_RELAXED) >
+        bufmgr_gem->cache_high_watermark;
+
+    if (!over_budget) {
+        /* Only one caller per interval does the sweep */
+        if (time < last || time - last < MOS_BO_CACHE_SWEEP_INTERVAL_MS ||
+            !__atomic_compare_exchange_n(&bufmgr_gem->time, &last, time, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return;
     }
 
-    bufmgr_gem->time = time;
+    mos_gem_bo_cache_evict(bufmgr_gem, time);
 }
 
+/* @time is a CLOCK_MONOTONIC timestamp in milliseconds */
 drm_export void
-mos_gem_bo_unreference_final(struct mos_linux_bo *bo, time_t time)
+mos_gem_bo_unreference_final(struct mos_linux_bo *bo, uint64_t time)
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
@@ -1434,14 +1879,16 @@ mos_gem_bo_unreference_final(struct mos_linux_bo *bo, time_t time)
         bo_gem->name = nullptr;
         bo_gem->validate_index = -1;
 
-        DRMLISTADDTAIL(&bo_gem->head, &bucket->head);
+        pthread_mutex_lock(&bucket->lock);
+        mos_gem_bo_cache_add(bufmgr_gem, bucket, bo_gem);
+        pthread_mutex_unlock(&bucket->lock);
     } else {
         mos_gem_bo_free(bo);
     }
 }
 
 static void mos_gem_bo_unreference_locked_timed(struct mos_linux_bo *bo,
-                              time_t time)
+                              uint64_t time)
 {
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
 
@@ -1459,15 +1906,29 @@ static void mos_gem_bo_unreference(struct mos_linux_bo *bo)
     if (atomic_add_unless(&bo_gem->refcount, -1, 1)) {
         struct mos_bufmgr_gem *bufmgr_gem =
             (struct mos_bufmgr_gem *) bo->bufmgr;
-        struct timespec time;
+        uint64_t time = mos_gem_get_time_ms();
 
-        clock_gettime(CLOCK_MONOTONIC, &time);
+        /* A BO that was never flinked/exported and references no other
+         * BOs cannot be looked up or reached by anyone else once its last
+         * reference is gone, so it goes back to its bucket without the
+         * global lock.
+         */
+        if (bo_gem->reusable &&
+            DRMLISTEMPTY(&bo_gem->name_list) &&
+            bo_gem->reloc_count == 0 &&
+            bo_gem->softpin_target_count == 0) {
+            if (atomic_dec_and_test(&bo_gem->refcount)) {
+                mos_gem_bo_unreference_final(bo, time);
+                mos_gem_cleanup_bo_cache(bufmgr_gem, time);
+            }
+            return;
+        }
 
         pthread_mutex_lock(&bufmgr_gem->lock);
 
         if (atomic_dec_and_test(&bo_gem->refcount)) {
-            mos_gem_bo_unreference_final(bo, time.tv_sec);
-            mos_gem_cleanup_bo_cache(bufmgr_gem, time.tv_sec);
+            mos_gem_bo_unreference_final(bo, time);
+            mos_gem_cleanup_bo_cache(bufmgr_gem, time);
         }
 
         pthread_mutex_unlock(&bufmgr_gem->lock);
@@ -2005,6 +2466,120 @@ mos_gem_bo_wait_rendering(struct mos_linux_bo *bo)
     mos_gem_bo_start_gtt_access(bo, 1);
 }
 
+/**
+ * Waits on the tracked out-fences of @bo_gem with ppoll() rather than a GEM
+ * ioctl; fences already seen to signal cost nothing.
+ *
+ * Returns 0 once every fence has signalled, -ETIME on timeout, or -EAGAIN
+ * when the fences do not cover all work on the buffer and the caller has
+ * to fall back to DRM_IOCTL_I915_GEM_WAIT.
+ */
+static int
+mos_gem_bo_wait_fences(struct mos_bufmgr_gem *bufmgr_gem,
+                       struct mos_bo_gem *bo_gem, int64_t timeout_ns)
+{
+    struct mos_gem_fence *pending[MOS_GEM_BO_FENCE_SLOTS];
+    struct pollfd pfd[MOS_GEM_BO_FENCE_SLOTS];
+    struct timespec deadline, now, remaining;
+    int count = 0, done = 0, ret = 0, i;
+
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    if (bo_gem->fence_untracked)
+        ret = -EAGAIN;
+    for (i = 0; ret == 0 && i < MOS_GEM_BO_FENCE_SLOTS; i++) {
+        struct mos_gem_fence *fence = bo_gem->fences[i].fence;
+
+        if (fence == nullptr || fence->signalled)
+            continue;
+        if (fence->expired) {
+            ret = -EAGAIN;
+            break;
+        }
+        fence->refcount++;
+        fence->waiters++;
+        pending[count] = fence;
+        pfd[count].fd = fence->fd;
+        pfd[count].events = POLLIN;
+        pfd[count].revents = 0;
+        count++;
+    }
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+
+    if (ret == 0 && count > 0 && timeout_ns >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ns / 1000000000;
+        deadline.tv_nsec += timeout_ns % 1000000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    while (ret == 0 && done < count) {
+        struct timespec *tsp = nullptr;
+        int n;
+
+        if (timeout_ns >= 0) {
+            int64_t left;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left = (int64_t)(deadline.tv_sec - now.tv_sec) * 1000000000 +
+                   (deadline.tv_nsec - now.tv_nsec);
+            if (left < 0)
+                left = 0;
+            remaining.tv_sec = left / 1000000000;
+            remaining.tv_nsec = left % 1000000000;
+            tsp = &remaining;
+        }
+
+        n = ppoll(pfd, count, tsp, nullptr);
+        if (n < 0) {
+            if (errno != EINTR)
+                ret = -EAGAIN;
+            continue;
+        }
+        if (n == 0) {
+            ret = -ETIME;
+            break;
+        }
+
+        for (i = 0; i < count; i++) {
+            if (pfd[i].revents == 0)
+                continue;
+            if (pfd[i].revents & POLLNVAL) {
+                ret = -EAGAIN;
+                break;
+            }
+            /* Negative fds are ignored by ppoll() */
+            pfd[i].fd = -1;
+            pfd[i].revents = POLLIN;
+            done++;
+        }
+    }
+
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    for (i = 0; i < count; i++) {
+        struct mos_gem_fence *fence = pending[i];
+
+        fence->waiters--;
+        if (pfd[i].fd < 0 && !fence->signalled) {
+            if (fence->expired)
+                fence->signalled = true;
+            else
+                mos_gem_fence_retire_locked(bufmgr_gem, fence, true);
+        }
+        if (fence->waiters == 0 && fence->fd >= 0 &&
+            (fence->signalled || fence->expired)) {
+            close(fence->fd);
+            fence->fd = -1;
+        }
+        mos_gem_fence_unreference_locked(fence);
+    }
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+
+    return ret;
+}
+
 /**
  * Waits on a BO for the given amount of time.
  *
@@ -2039,8 +2614,29 @@ mos_gem_bo_wait(struct mos_linux_bo *bo, int64_t timeout_ns)
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
     struct drm_i915_gem_wait wait;
+    bool track = bufmgr_gem->has_exec_fence && bo_gem->reusable;
+    uint32_t fence_seq = 0;
     int ret;
 
+    /* Buffers shared with other processes may have work we never saw */
+    if (bo_gem->reusable && __atomic_load_n(&bo_gem->idle, __ATOMIC_ACQUIRE))
+        return 0;
+
+    /* A submission on another thread during the wait bumps fence_seq, and
+     * then the buffer must not be marked idle when the wait returns.
+     */
+    if (bo_gem->reusable)
+        fence_seq = mos_gem_bo_get_fence_seq(bufmgr_gem, bo_gem);
+
+    if (track) {
+        ret = mos_gem_bo_wait_fences(bufmgr_gem, bo_gem, timeout_ns);
+        if (ret != -EAGAIN) {
+            if (ret == 0)
+                mos_gem_bo_mark_idle(bufmgr_gem, bo_gem, fence_seq);
+            return ret;
+        }
+    }
+
     if (!bufmgr_gem->has_wait_timeout) {
         MOS_DBG("%s:%d: Timed wait is not supported. Falling back to "
             "infinite wait\n", __FILE__, __LINE__);
@@ -2059,6 +2655,19 @@ mos_gem_bo_wait(struct mos_linux_bo *bo, int64_t timeout_ns)
     if (ret == -1)
         return -errno;
 
+    /* Idle now, so the fences can be trusted again unless the buffer was
+     * submitted while we waited.
+     */
+    if (bo_gem->reusable && ret == 0) {
+        pthread_mutex_lock(&bufmgr_gem->fence_lock);
+        if (bo_gem->fence_seq == fence_seq) {
+            if (track)
+                mos_gem_bo_clear_fences_locked(bo_gem);
+            __atomic_store_n(&bo_gem->idle, true, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+    }
+
     return ret;
 }
 
@@ -2099,9 +2708,18 @@ mos_bufmgr_gem_destroy(struct mos_bufmgr *bufmgr)
     struct drm_gem_close close_bo;
     int i, ret;
 
-    free(bufmgr_gem->exec2_objects);
     free(bufmgr_gem->exec_objects);
     free(bufmgr_gem->exec_bos);
+    while (bufmgr_gem->exec_lists) {
+        struct mos_exec_list *list = bufmgr_gem->exec_lists;
+
+        bufmgr_gem->exec_lists = list->next;
+        free(list->objects);
+        free(list->bos);
+        free(list->slots);
+        free(list);
+    }
+    pthread_mutex_destroy(&bufmgr_gem->exec_list_lock);
     pthread_mutex_destroy(&bufmgr_gem->lock);
 
     /* Free any cached buffer objects we were going to reuse */
@@ -2113,11 +2731,24 @@ mos_bufmgr_gem_destroy(struct mos_bufmgr *bufmgr)
         while (!DRMLISTEMPTY(&bucket->head)) {
             bo_gem = DRMLISTENTRY(struct mos_bo_gem,
                           bucket->head.next, head);
-            DRMLISTDEL(&bo_gem->head);
+            mos_gem_bo_cache_remove(bufmgr_gem, bo_gem);
 
             mos_gem_bo_free(&bo_gem->bo);
         }
+        pthread_mutex_destroy(&bucket->lock);
     }
+    pthread_mutex_destroy(&bufmgr_gem->cache_lock);
+
+    mos_vma_heap_finish(&bufmgr_gem->vma_heap);
+    pthread_mutex_destroy(&bufmgr_gem->vma_lock);
+
+    /* Close what is left open by BOs that were never freed */
+    while (!DRMLISTEMPTY(&bufmgr_gem->fences)) {
+        mos_gem_fence_retire_locked(bufmgr_gem,
+            DRMLISTENTRY(struct mos_gem_fence, bufmgr_gem->fences.next, link),
+            false);
+    }
+    pthread_mutex_destroy(&bufmgr_gem->fence_lock);
 
     /* Release userptr bo kept hanging around for optimisation. */
     if (bufmgr_gem->userptr_active.ptr) {
@@ -2197,6 +2828,8 @@ do_bo_emit_reloc(struct mos_linux_bo *bo, uint32_t offset,
         bo_gem->reloc_tree_fences += target_bo_gem->reloc_tree_fences;
     }
 
+    /* The exec list walk of a concurrent submission reads this array */
+    pthread_mutex_lock(&bufmgr_gem->lock);
     bo_gem->reloc_target_info[bo_gem->reloc_count].bo = target_bo;
     if (target_bo != bo)
         mos_gem_bo_reference(target_bo);
@@ -2214,6 +2847,7 @@ do_bo_emit_reloc(struct mos_linux_bo *bo, uint32_t offset,
     bo_gem->relocs[bo_gem->reloc_count].write_domain = write_domain;
     bo_gem->relocs[bo_gem->reloc_count].presumed_offset = target_bo->offset64;
     bo_gem->reloc_count++;
+    pthread_mutex_unlock(&bufmgr_gem->lock);
 
     return 0;
 }
@@ -2273,6 +2907,8 @@ do_bo_emit_reloc2(struct mos_linux_bo *bo, uint32_t offset,
     if (target_bo_gem->exec_async)
         flags |= EXEC_OBJECT_ASYNC;
 
+    /* The exec list walk of a concurrent submission reads this array */
+    pthread_mutex_lock(&bufmgr_gem->lock);
     if (target_bo != bo)
         mos_gem_bo_reference(target_bo);
 
@@ -2286,6 +2922,7 @@ do_bo_emit_reloc2(struct mos_linux_bo *bo, uint32_t offset,
     bo_gem->relocs[bo_gem->reloc_count].write_domain = write_domain;
     bo_gem->relocs[bo_gem->reloc_count].presumed_offset = presumed_offset;
     bo_gem->reloc_count++;
+    pthread_mutex_unlock(&bufmgr_gem->lock);
 
     return 0;
 }
@@ -2311,6 +2948,8 @@ mos_gem_bo_set_exec_object_async(struct mos_linux_bo *bo, struct mos_linux_bo *t
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
     struct mos_bo_gem *target_bo_gem = (struct mos_bo_gem *) target_bo;
     int i;
+
+    pthread_mutex_lock(&bufmgr_gem->lock);
     for (i = 0; i < bo_gem->reloc_count; i++)
     {
         if (bo_gem->reloc_target_info[i].bo == target_bo)
@@ -2328,6 +2967,7 @@ mos_gem_bo_set_exec_object_async(struct mos_linux_bo *bo, struct mos_linux_bo *t
             break;
         }
     }
+    pthread_mutex_unlock(&bufmgr_gem->lock);
 }
 
 static int
@@ -2349,33 +2989,42 @@ mos_gem_bo_add_softpin_target(struct mos_linux_bo *bo, struct mos_linux_bo *targ
     if (target_bo_gem == bo_gem)
         return -EINVAL;
 
+    int flags = EXEC_OBJECT_PINNED;
+    if (target_bo_gem->pad_to_size)
+        flags |= EXEC_OBJECT_PAD_TO_SIZE;
+    if (target_bo_gem->use_48b_address_range)
+        flags |= EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
+    if (target_bo_gem->exec_async)
+        flags |= EXEC_OBJECT_ASYNC;
+    if (write_flag)
+        flags |= EXEC_OBJECT_WRITE;
+
+    /* The exec list walk of a concurrent submission reads this array, so
+     * it may only move under the bufmgr lock.
+     */
+    pthread_mutex_lock(&bufmgr_gem->lock);
     if (bo_gem->softpin_target_count == bo_gem->softpin_target_size) {
         int new_size = bo_gem->softpin_target_size * 2;
+        struct mos_softpin_target *softpin_target;
         if (new_size == 0)
             new_size = bufmgr_gem->max_relocs;
 
-        bo_gem->softpin_target = (struct mos_softpin_target *)realloc(bo_gem->softpin_target, new_size *
+        softpin_target = (struct mos_softpin_target *)realloc(bo_gem->softpin_target, new_size *
                 sizeof(struct mos_softpin_target));
-        if (!bo_gem->softpin_target)
+        if (!softpin_target) {
+            pthread_mutex_unlock(&bufmgr_gem->lock);
             return -ENOMEM;
+        }
 
+        bo_gem->softpin_target = softpin_target;
         bo_gem->softpin_target_size = new_size;
     }
 
-    int flags = EXEC_OBJECT_PINNED;
-    if (target_bo_gem->pad_to_size)
-        flags |= EXEC_OBJECT_PAD_TO_SIZE;
-    if (target_bo_gem->use_48b_address_range)
-        flags |= EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
-    if (target_bo_gem->exec_async)
-        flags |= EXEC_OBJECT_ASYNC;
-    if (write_flag)
-        flags |= EXEC_OBJECT_WRITE;
-
     bo_gem->softpin_target[bo_gem->softpin_target_count].bo = target_bo;
     bo_gem->softpin_target[bo_gem->softpin_target_count].flags = flags;
     mos_gem_bo_reference(target_bo);
     bo_gem->softpin_target_count++;
+    pthread_mutex_unlock(&bufmgr_gem->lock);
 
     return 0;
 }
@@ -2457,9 +3106,7 @@ mos_gem_bo_clear_relocs(struct mos_linux_bo *bo, int start)
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
     int i;
-    struct timespec time;
-
-    clock_gettime(CLOCK_MONOTONIC, &time);
+    uint64_t time = mos_gem_get_time_ms();
 
     assert(bo_gem->reloc_count >= start);
 
@@ -2471,14 +3118,14 @@ mos_gem_bo_clear_relocs(struct mos_linux_bo *bo, int start)
         if (&target_bo_gem->bo != bo) {
             bo_gem->reloc_tree_fences -= target_bo_gem->reloc_tree_fences;
             mos_gem_bo_unreference_locked_timed(&target_bo_gem->bo,
-                                  time.tv_sec);
+                                  time);
         }
     }
     bo_gem->reloc_count = start;
 
     for (i = 0; i < bo_gem->softpin_target_count; i++) {
         struct mos_bo_gem *target_bo_gem = (struct mos_bo_gem *) bo_gem->softpin_target[i].bo;
-        mos_gem_bo_unreference_locked_timed(&target_bo_gem->bo, time.tv_sec);
+        mos_gem_bo_unreference_locked_timed(&target_bo_gem->bo, time);
     }
     bo_gem->softpin_target_count = 0;
 
@@ -2517,7 +3164,7 @@ mos_gem_bo_process_reloc(struct mos_linux_bo *bo)
 }
 
 static void
-mos_gem_bo_process_reloc2(struct mos_linux_bo *bo)
+mos_gem_bo_process_reloc2(struct mos_exec_list *list, struct mos_linux_bo *bo)
 {
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)bo;
     int i;
@@ -2535,10 +3182,10 @@ mos_gem_bo_process_reloc2(struct mos_linux_bo *bo)
         mos_gem_bo_mark_mmaps_incoherent(bo);
 
         /* Continue walking the tree depth-first. */
-        mos_gem_bo_process_reloc2(target_bo);
+        mos_gem_bo_process_reloc2(list, target_bo);
 
         /* Add the target to the validate list */
-        mos_add_reloc_objects(bo_gem->reloc_target_info[i]);
+        mos_add_reloc_objects(list, bo_gem->reloc_target_info[i]);
     }
 
     for (i = 0; i < bo_gem->softpin_target_count; i++) {
@@ -2548,8 +3195,8 @@ mos_gem_bo_process_reloc2(struct mos_linux_bo *bo)
             continue;
 
         mos_gem_bo_mark_mmaps_incoherent(bo);
-        mos_gem_bo_process_reloc2(target_bo);
-        mos_add_softpin_objects(bo_gem->softpin_target[i]);
+        mos_gem_bo_process_reloc2(list, target_bo);
+        mos_add_softpin_objects(list, bo_gem->softpin_target[i]);
     }
 }
 
@@ -2576,17 +3223,19 @@ mos_update_buffer_offsets(struct mos_bufmgr_gem *bufmgr_gem)
     }
 }
 
+/* Called with bufmgr_gem->lock held, it guards the context offset list */
 static void
-mos_update_buffer_offsets2 (struct mos_bufmgr_gem *bufmgr_gem, mos_linux_context *ctx, mos_linux_bo *cmd_bo)
+mos_update_buffer_offsets2 (struct mos_bufmgr_gem *bufmgr_gem, struct mos_exec_list *list,
+                mos_linux_context *ctx, mos_linux_bo *cmd_bo)
 {
     int i;
 
-    for (i = 0; i < bufmgr_gem->exec_count; i++) {
-        struct mos_linux_bo *bo = bufmgr_gem->exec_bos[i];
+    for (i = 0; i < list->count; i++) {
+        struct mos_linux_bo *bo = list->bos[i];
         struct mos_bo_gem *bo_gem = (struct mos_bo_gem *)bo;
 
         /* Update the buffer offset */
-        if (bufmgr_gem->exec2_objects[i].offset != bo->offset64) {
+        if (list->objects[i].offset != bo->offset64) {
             /* If we're seeing softpinned object here it means that the kernel
              * has relocated our object... Indicating a programming error
              */
@@ -2595,10 +3244,10 @@ mos_update_buffer_offsets2 (struct mos_bufmgr_gem *bufmgr_gem, mos_linux_context
                 bo_gem->gem_handle, bo_gem->name,
                 upper_32_bits(bo->offset64),
                 lower_32_bits(bo->offset64),
-                upper_32_bits(bufmgr_gem->exec2_objects[i].offset),
-                lower_32_bits(bufmgr_gem->exec2_objects[i].offset));
-            bo->offset64 = bufmgr_gem->exec2_objects[i].offset;
-            bo->offset = bufmgr_gem->exec2_objects[i].offset;
+                upper_32_bits(list->objects[i].offset),
+                lower_32_bits(list->objects[i].offset));
+            bo->offset64 = list->objects[i].offset;
+            bo->offset = list->objects[i].offset;
         }
 
         if (cmd_bo != bo) {
@@ -2669,16 +3318,20 @@ mos_gem_bo_exec(struct mos_linux_bo *bo, int used,
     mos_update_buffer_offsets(bufmgr_gem);
 
     if (bufmgr_gem->bufmgr.debug)
-        mos_gem_dump_validation_list(bufmgr_gem);
+        mos_gem_dump_validation_list(bufmgr_gem, bufmgr_gem->exec_bos,
+                           bufmgr_gem->exec_count);
 
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
     for (i = 0; i < bufmgr_gem->exec_count; i++) {
         struct mos_bo_gem *bo_gem = to_bo_gem(bufmgr_gem->exec_bos[i]);
-        bo_gem->idle = false;
+        mos_gem_bo_mark_busy_locked(bo_gem);
+        bo_gem->fence_untracked = true;
 
         /* Disconnect the buffer from the validate list */
         bo_gem->validate_index = -1;
         bufmgr_gem->exec_bos[i] = nullptr;
     }
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
     bufmgr_gem->exec_count = 0;
     pthread_mutex_unlock(&bufmgr_gem->lock);
 
@@ -2693,6 +3346,7 @@ do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_context *ctx,
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)bo->bufmgr;
     struct drm_i915_gem_execbuffer2 execbuf;
+    struct mos_exec_list *list;
     int ret = 0;
     int i;
 
@@ -2719,18 +3373,33 @@ do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_context *ctx,
         break;
     }
 
+    list = mos_exec_list_get(bufmgr_gem);
+    if (list == nullptr)
+        return -ENOMEM;
+
+    /* Update indices and set up the validate list. The list belongs to this
+     * submission only, but the reloc and softpin target arrays it is built
+     * from are shared with other threads emitting relocs, so walk them under
+     * the bufmgr lock. The ioctl itself runs unlocked.
+     */
     pthread_mutex_lock(&bufmgr_gem->lock);
-    /* Update indices and set up the validate list. */
-    mos_gem_bo_process_reloc2(bo);
+    mos_gem_bo_process_reloc2(list, bo);
 
     /* Add the batch buffer to the validation list.  There are no relocations
      * pointing to it.
      */
-    mos_add_validate_buffer2(bo, 0);
+    mos_add_validate_buffer2(list, bo, 0);
+    pthread_mutex_unlock(&bufmgr_gem->lock);
+
+    if (list->has_error) {
+        MOS_DBG("failed to grow validation list!\n");
+        mos_exec_list_put(bufmgr_gem, list);
+        return -ENOMEM;
+    }
 
     memclear(execbuf);
-    execbuf.buffers_ptr = (uintptr_t)bufmgr_gem->exec2_objects;
-    execbuf.buffer_count = bufmgr_gem->exec_count;
+    execbuf.buffers_ptr = (uintptr_t)list->objects;
+    execbuf.buffer_count = list->count;
     execbuf.batch_start_offset = 0;
     execbuf.batch_len = used;
     execbuf.cliprects_ptr = (uintptr_t)cliprects;
@@ -2751,6 +3420,9 @@ do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_context *ctx,
     {
         execbuf.rsvd2 = -1;
     }
+    /* Every submission returns an out-fence for mos_gem_bo_wait() */
+    if (bufmgr_gem->has_exec_fence)
+        execbuf.flags |= I915_EXEC_FENCE_OUT;
 
     if (bufmgr_gem->no_exec)
         goto skip_execution;
@@ -2763,17 +3435,19 @@ do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_context *ctx,
         if (ret == -ENOSPC) {
             MOS_DBG("Execbuffer fails to pin. "
                 "Estimate: %u. Actual: %u. Available: %u\n",
-                mos_gem_estimate_batch_space(bufmgr_gem->exec_bos,
-                                   bufmgr_gem->exec_count),
-                mos_gem_compute_batch_space(bufmgr_gem->exec_bos,
-                                  bufmgr_gem->exec_count),
+                mos_gem_estimate_batch_space(list->bos,
+                                   list->count),
+                mos_gem_compute_batch_space(list->bos,
+                                  list->count),
                 (unsigned int) bufmgr_gem->gtt_size);
         }
     }
 
     if (ctx != nullptr)
     {
-        mos_update_buffer_offsets2(bufmgr_gem, ctx, bo);
+        pthread_mutex_lock(&bufmgr_gem->lock);
+        mos_update_buffer_offsets2(bufmgr_gem, list, ctx, bo);
+        pthread_mutex_unlock(&bufmgr_gem->lock);
     }
 
     if(flags & I915_EXEC_FENCE_OUT)
@@ -2781,21 +3455,29 @@ do_exec2(struct mos_linux_bo *bo, int used, struct mos_linux_context *ctx,
         *fence = execbuf.rsvd2 >> 32;
     }
 
-skip_execution:
-    if (bufmgr_gem->bufmgr.debug)
-        mos_gem_dump_validation_list(bufmgr_gem);
+    if (ret == 0 && bufmgr_gem->has_exec_fence) {
+        int fence_fd = execbuf.rsvd2 >> 32;
+        uint64_t engine = ((uint64_t)(ctx ? ctx->ctx_id : 0) << 32) |
+                          (flags & (I915_EXEC_RING_MASK | I915_EXEC_BSD_MASK));
 
-    for (i = 0; i < bufmgr_gem->exec_count; i++) {
-        struct mos_bo_gem *bo_gem = to_bo_gem(bufmgr_gem->exec_bos[i]);
+        /* The caller owns the fd it asked for */
+        if (flags & I915_EXEC_FENCE_OUT)
+            fence_fd = fcntl(fence_fd, F_DUPFD_CLOEXEC, 0);
+        mos_gem_track_fence(bufmgr_gem, list, engine, fence_fd);
+    }
 
-        bo_gem->idle = false;
+skip_execution:
+    if (bufmgr_gem->bufmgr.debug)
+        mos_gem_dump_validation_list(bufmgr_gem, list->bos, list->count);
 
-        /* Disconnect the buffer from the validate list */
-        bo_gem->validate_index = -1;
-        bufmgr_gem->exec_bos[i] = nullptr;
-    }
-    bufmgr_gem->exec_count = 0;
-    pthread_mutex_unlock(&bufmgr_gem->lock);
+    /* After the fence is tracked, so a waiter that saw the old fence_seq
+     * cannot mark these buffers idle once this returns.
+     */
+    pthread_mutex_lock(&bufmgr_gem->fence_lock);
+    for (i = 0; i < list->count; i++)
+        mos_gem_bo_mark_busy_locked(to_bo_gem(list->bos[i]));
+    pthread_mutex_unlock(&bufmgr_gem->fence_lock);
+    mos_exec_list_put(bufmgr_gem, list);
 
     return ret;
 }
@@ -2967,19 +3649,26 @@ mos_gem_bo_set_softpin(MOS_LINUX_BO *bo)
 {
     int ret = 0;
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
-    uint64_t offset = bufmgr_gem->head_offset;
-
-    // if offset is over 48b address range, return error
-    if (offset > MEMZONE_TOTAL)
-    {
-        MOS_DBG("softpin failed: address over 48b range");
-        return -EINVAL;
-    }
+    struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
 
     if (!mos_gem_bo_is_softpin(bo))
     {
-        // update the head_offset, need to be 64K aligned
-        bufmgr_gem->head_offset += MOS_ALIGN_CEIL(bo->size, PAGE_SIZE_64K);
+        // 64K aligned, and 2M aligned for large BOs so the kernel can use 2M GTT pages
+        uint64_t size = MOS_ALIGN_CEIL(bo->size, PAGE_SIZE_64K);
+        uint64_t alignment = size >= PAGE_SIZE_2M ? PAGE_SIZE_2M : PAGE_SIZE_64K;
+        uint64_t offset;
+
+        pthread_mutex_lock(&bufmgr_gem->vma_lock);
+        offset = mos_vma_heap_alloc(&bufmgr_gem->vma_heap, size, alignment);
+        pthread_mutex_unlock(&bufmgr_gem->vma_lock);
+
+        // heap exhausted within the 48b address range, return error
+        if (offset == 0)
+        {
+            MOS_DBG("softpin failed: no free range of 0x%lx in 48b address space\n", size);
+            return -ENOSPC;
+        }
+        bo_gem->softpin_va_size = size;
 
         // softpin the BO to the given offset
         ret = mos_gem_bo_set_softpin_offset(bo, offset);
@@ -3138,6 +3827,55 @@ mos_gem_bo_flink(struct mos_linux_bo *bo, uint32_t * name)
  * size is only bounded by how many buffers of that size we've managed to have
  * in flight at once.
  */
+/**
+ * Sets the byte budget and expiry of the BO reuse cache.
+ *
+ * Once the cached bytes exceed \p high_watermark the least recently freed
+ * BOs are released until no more than \p low_watermark remain. A zero
+ * high watermark leaves the cache unbounded. Cached BOs are released after
+ * \p expire_ms regardless of the budget.
+ */
+int
+mos_bufmgr_gem_set_cache_limits(struct mos_bufmgr *bufmgr,
+                                uint64_t high_watermark,
+                                uint64_t low_watermark,
+                                uint32_t expire_ms)
+{
+    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bufmgr;
+
+    if (bufmgr == nullptr || low_watermark > high_watermark)
+        return -EINVAL;
+
+    pthread_mutex_lock(&bufmgr_gem->cache_lock);
+    bufmgr_gem->cache_high_watermark = high_watermark;
+    bufmgr_gem->cache_low_watermark = low_watermark;
+    bufmgr_gem->cache_expire_ms = expire_ms;
+    pthread_mutex_unlock(&bufmgr_gem->cache_lock);
+
+    mos_gem_bo_cache_evict(bufmgr_gem, mos_gem_get_time_ms());
+
+    return 0;
+}
+
+/**
+ * Reports BO reuse cache hit/miss/eviction counters and current occupancy.
+ */
+int
+mos_bufmgr_gem_get_cache_stats(struct mos_bufmgr *bufmgr,
+                               struct mos_bufmgr_cache_stats *stats)
+{
+    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bufmgr;
+
+    if (bufmgr == nullptr || stats == nullptr)
+        return -EINVAL;
+
+    pthread_mutex_lock(&bufmgr_gem->cache_lock);
+    *stats = bufmgr_gem->cache_stats;
+    pthread_mutex_unlock(&bufmgr_gem->cache_lock);
+
+    return 0;
+}
+
 void
 mos_bufmgr_gem_enable_reuse(struct mos_bufmgr *bufmgr)
 {
@@ -3400,6 +4138,7 @@ add_bucket(struct mos_bufmgr_gem *bufmgr_gem, int size)
 
     assert(i < ARRAY_SIZE(bufmgr_gem->cache_bucket));
 
+    pthread_mutex_init(&bufmgr_gem->cache_bucket[i].lock, nullptr);
     DRMINITLISTHEAD(&bufmgr_gem->cache_bucket[i].head);
     bufmgr_gem->cache_bucket[i].size = size;
     bufmgr_gem->num_buckets++;
@@ -3410,7 +4149,9 @@ init_cache_buckets(struct mos_bufmgr_gem *bufmgr_gem)
 {
     unsigned long size, cache_max_size = 64 * 1024 * 1024;
 
-    /* OK, so power of two buckets was too wasteful of memory.
+    /* Keep mos_gem_bo_bucket_for_size() in sync with this layout.
+     *
+     * OK, so power of two buckets was too wasteful of memory.
      * Give 3 other sizes between each power of two, to hopefully
      * cover things accurately enough.  (The alternative is
      * probably to just go for exact matching of sizes, and assume
@@ -3835,6 +4576,24 @@ mos_bufmgr_gem_get_memory_info(struct mos_bufmgr *bufmgr, char *info, uint32_t l
     return 0;
 }
 
+/**
+ * Reports occupancy and fragmentation of the softpin address space.
+ */
+int
+mos_bufmgr_gem_get_vma_stats(struct mos_bufmgr *bufmgr, struct mos_vma_heap_stats *stats)
+{
+    struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)bufmgr;
+
+    if (bufmgr == nullptr || stats == nullptr)
+        return -EINVAL;
+
+    pthread_mutex_lock(&bufmgr_gem->vma_lock);
+    mos_vma_heap_get_stats(&bufmgr_gem->vma_heap, stats);
+    pthread_mutex_unlock(&bufmgr_gem->vma_lock);
+
+    return 0;
+}
+
 void mos_bufmgr_gem_enable_softpin(struct mos_bufmgr *bufmgr)
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)bufmgr;
@@ -3875,6 +4634,16 @@ mos_bufmgr_gem_init(int fd, int batch_size)
         goto exit;
     }
 
+    // start at 64K, since 0 will be regarded as nullptr in some condition
+    if (pthread_mutex_init(&bufmgr_gem->vma_lock, nullptr) != 0 ||
+        mos_vma_heap_init(&bufmgr_gem->vma_heap, MEMZONE_SYS_START,
+                          MEMZONE_TOTAL - MEMZONE_SYS_START) != 0) {
+        pthread_mutex_destroy(&bufmgr_gem->lock);
+        free(bufmgr_gem);
+        bufmgr_gem = nullptr;
+        goto exit;
+    }
+
     memclear(aperture);
     ret = drmIoctl(bufmgr_gem->fd,
                DRM_IOCTL_I915_GEM_GET_APERTURE,
@@ -3896,6 +4665,9 @@ mos_bufmgr_gem_init(int fd, int batch_size)
     bufmgr_gem->pci_device = get_pci_device_id(bufmgr_gem);
 
     if (bufmgr_gem->pci_device == 0) {
+        mos_vma_heap_finish(&bufmgr_gem->vma_heap);
+        pthread_mutex_destroy(&bufmgr_gem->vma_lock);
+        pthread_mutex_destroy(&bufmgr_gem->lock);
         free(bufmgr_gem);
         bufmgr_gem = nullptr;
         goto exit;
@@ -3947,6 +4719,10 @@ mos_bufmgr_gem_init(int fd, int batch_size)
         bufmgr_gem->bufmgr.bo_add_softpin_target = mos_gem_bo_add_softpin_target;
     }
 
+    gp.param = I915_PARAM_HAS_EXEC_FENCE;
+    ret = drmIoctl(bufmgr_gem->fd, DRM_IOCTL_I915_GETPARAM, &gp);
+    bufmgr_gem->has_exec_fence = (ret == 0) && (*gp.value > 0);
+
     gp.param = I915_PARAM_HAS_EXEC_ASYNC;
     ret = drmIoctl(bufmgr_gem->fd, DRM_IOCTL_I915_GETPARAM, &gp);
     if (ret == 0 && *gp.value > 0) {
@@ -4016,10 +4792,20 @@ mos_bufmgr_gem_init(int fd, int batch_size)
     DRMINITLISTHEAD(&bufmgr_gem->named);
     init_cache_buckets(bufmgr_gem);
 
+    pthread_mutex_init(&bufmgr_gem->exec_list_lock, nullptr);
+    bufmgr_gem->exec_lists = nullptr;
+
+    pthread_mutex_init(&bufmgr_gem->cache_lock, nullptr);
+    DRMINITLISTHEAD(&bufmgr_gem->cache_lru);
+    bufmgr_gem->cache_high_watermark = MOS_BO_CACHE_DEFAULT_HIGH_WATERMARK;
+    bufmgr_gem->cache_low_watermark = MOS_BO_CACHE_DEFAULT_LOW_WATERMARK;
+    bufmgr_gem->cache_expire_ms = MOS_BO_CACHE_DEFAULT_EXPIRE_MS;
+
+    pthread_mutex_init(&bufmgr_gem->fence_lock, nullptr);
+    DRMINITLISTHEAD(&bufmgr_gem->fences);
+
     DRMLISTADD(&bufmgr_gem->managers, &bufmgr_list);
 
-    // init head_offset to 64K, since 0 will be regarded as nullptr in some condition
-    bufmgr_gem->head_offset = MEMZONE_SYS_START;
     bufmgr_gem->use_softpin = false;
 
 exit:
@@ -0,0 +1,357 @@
+/*
+ * Copyright © 2020 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "mos_vma.h"
+
+#define MOS_VMA_INDEX_MIN_BITS  6
+
+struct mos_vma_hole {
+    /** Link in heap->bins[bin] */
+    drmMMListHead link;
+    struct mos_vma_hole *next_by_start;
+    struct mos_vma_hole *next_by_end;
+    uint64_t offset;
+    uint64_t size;
+    int bin;
+};
+
+static inline uint64_t
+mos_vma_align(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline int
+mos_vma_bin(uint64_t size)
+{
+    return 63 - __builtin_clzll(size / MOS_VMA_PAGE_SIZE);
+}
+
+static inline uint64_t
+mos_vma_hash(uint32_t bits, uint64_t addr)
+{
+    return ((addr / MOS_VMA_PAGE_SIZE) * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+}
+
+static int
+mos_vma_index_resize(struct mos_vma_heap *heap, uint32_t bits)
+{
+    struct mos_vma_hole **by_start, **by_end;
+    struct mos_vma_hole *hole;
+    int i;
+
+    by_start = (struct mos_vma_hole **)calloc(1ull << bits, sizeof(*by_start));
+    by_end = (struct mos_vma_hole **)calloc(1ull << bits, sizeof(*by_end));
+    if (by_start == nullptr || by_end == nullptr) {
+        free(by_start);
+        free(by_end);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < MOS_VMA_NUM_BINS; i++) {
+        DRMLISTFOREACHENTRY(hole, &heap->bins[i], link) {
+            uint64_t hs = mos_vma_hash(bits, hole->offset);
+            uint64_t he = mos_vma_hash(bits, hole->offset + hole->size);
+
+            hole->next_by_start = by_start[hs];
+            by_start[hs] = hole;
+            hole->next_by_end = by_end[he];
+            by_end[he] = hole;
+        }
+    }
+
+    free(heap->by_start);
+    free(heap->by_end);
+    heap->by_start = by_start;
+    heap->by_end = by_end;
+    heap->index_bits = bits;
+
+    return 0;
+}
+
+static void
+mos_vma_hole_link(struct mos_vma_heap *heap, struct mos_vma_hole *hole)
+{
+    uint64_t hs, he;
+
+    /* Keep the chains short; a failed resize only costs lookup time. */
+    if (heap->hole_count >= (1ull << heap->index_bits))
+        mos_vma_index_resize(heap, heap->index_bits + 1);
+
+    hole->bin = mos_vma_bin(hole->size);
+    DRMLISTADD(&hole->link, &heap->bins[hole->bin]);
+    heap->bin_mask |= 1ull << hole->bin;
+
+    hs = mos_vma_hash(heap->index_bits, hole->offset);
+    he = mos_vma_hash(heap->index_bits, hole->offset + hole->size);
+    hole->next_by_start = heap->by_start[hs];
+    heap->by_start[hs] = hole;
+    hole->next_by_end = heap->by_end[he];
+    heap->by_end[he] = hole;
+
+    heap->hole_count++;
+}
+
+static void
+mos_vma_hole_unlink(struct mos_vma_heap *heap, struct mos_vma_hole *hole)
+{
+    struct mos_vma_hole **pp;
+
+    DRMLISTDEL(&hole->link);
+    if (DRMLISTEMPTY(&heap->bins[hole->bin]))
+        heap->bin_mask &= ~(1ull << hole->bin);
+
+    pp = &heap->by_start[mos_vma_hash(heap->index_bits, hole->offset)];
+    while (*pp != hole)
+        pp = &(*pp)->next_by_start;
+    *pp = hole->next_by_start;
+
+    pp = &heap->by_end[mos_vma_hash(heap->index_bits, hole->offset + hole->size)];
+    while (*pp != hole)
+        pp = &(*pp)->next_by_end;
+    *pp = hole->next_by_end;
+
+    heap->hole_count--;
+}
+
+static struct mos_vma_hole *
+mos_vma_hole_starting_at(struct mos_vma_heap *heap, uint64_t offset)
+{
+    struct mos_vma_hole *hole;
+
+    hole = heap->by_start[mos_vma_hash(heap->index_bits, offset)];
+    while (hole && hole->offset != offset)
+        hole = hole->next_by_start;
+
+    return hole;
+}
+
+static struct mos_vma_hole *
+mos_vma_hole_ending_at(struct mos_vma_heap *heap, uint64_t end)
+{
+    struct mos_vma_hole *hole;
+
+    hole = heap->by_end[mos_vma_hash(heap->index_bits, end)];
+    while (hole && hole->offset + hole->size != end)
+        hole = hole->next_by_end;
+
+    return hole;
+}
+
+int
+mos_vma_heap_init(struct mos_vma_heap *heap, uint64_t start, uint64_t size)
+{
+    struct mos_vma_hole *hole;
+    int i;
+
+    assert((start & (MOS_VMA_PAGE_SIZE - 1)) == 0);
+    assert((size & (MOS_VMA_PAGE_SIZE - 1)) == 0);
+
+    memset(heap, 0, sizeof(*heap));
+    for (i = 0; i < MOS_VMA_NUM_BINS; i++)
+        DRMINITLISTHEAD(&heap->bins[i]);
+
+    heap->start = start;
+    heap->size = size;
+
+    if (mos_vma_index_resize(heap, MOS_VMA_INDEX_MIN_BITS))
+        return -ENOMEM;
+
+    hole = (struct mos_vma_hole *)calloc(1, sizeof(*hole));
+    if (hole == nullptr) {
+        mos_vma_heap_finish(heap);
+        return -ENOMEM;
+    }
+    hole->offset = start;
+    hole->size = size;
+    mos_vma_hole_link(heap, hole);
+
+    return 0;
+}
+
+void
+mos_vma_heap_finish(struct mos_vma_heap *heap)
+{
+    struct mos_vma_hole *hole, *tmp;
+    int i;
+
+    for (i = 0; i < MOS_VMA_NUM_BINS; i++) {
+        DRMLISTFOREACHENTRYSAFE(hole, tmp, &heap->bins[i], link) {
+            DRMLISTDEL(&hole->link);
+            free(hole);
+        }
+    }
+
+    free(heap->by_start);
+    free(heap->by_end);
+    heap->by_start = nullptr;
+    heap->by_end = nullptr;
+    heap->bin_mask = 0;
+    heap->hole_count = 0;
+}
+
+uint64_t
+mos_vma_heap_alloc(struct mos_vma_heap *heap, uint64_t size, uint64_t alignment)
+{
+    struct mos_vma_hole *hole;
+    uint64_t mask;
+
+    if (alignment < MOS_VMA_PAGE_SIZE)
+        alignment = MOS_VMA_PAGE_SIZE;
+    assert((alignment & (alignment - 1)) == 0);
+
+    size = mos_vma_align(size ? size : 1, MOS_VMA_PAGE_SIZE);
+    if (size > heap->size) {
+        heap->fail_count++;
+        return 0;
+    }
+
+    /* Every hole in a bin above the request's own bin is large enough by
+     * size alone; holes in the request's bin have to be checked.
+     */
+    mask = heap->bin_mask & (~0ull << mos_vma_bin(size));
+    while (mask) {
+        int bin = __builtin_ctzll(mask);
+
+        DRMLISTFOREACHENTRY(hole, &heap->bins[bin], link) {
+            uint64_t hole_start = hole->offset;
+            uint64_t hole_end = hole->offset + hole->size;
+            uint64_t offset = mos_vma_align(hole_start, alignment);
+
+            if (offset + size > hole_end)
+                continue;
+
+            mos_vma_hole_unlink(heap, hole);
+
+            /* Keep the leading remainder in the existing node, and the
+             * trailing remainder in it too if there is no leading one.
+             */
+            if (offset > hole_start) {
+                hole->size = offset - hole_start;
+                mos_vma_hole_link(heap, hole);
+                hole = nullptr;
+            }
+            if (offset + size < hole_end) {
+                if (hole == nullptr)
+                    hole = (struct mos_vma_hole *)calloc(1, sizeof(*hole));
+                /* On allocation failure the trailing range is simply lost. */
+                if (hole != nullptr) {
+                    hole->offset = offset + size;
+                    hole->size = hole_end - hole->offset;
+                    mos_vma_hole_link(heap, hole);
+                    hole = nullptr;
+                }
+            }
+            free(hole);
+
+            heap->used_size += size;
+            if (heap->used_size > heap->peak_used_size)
+                heap->peak_used_size = heap->used_size;
+            heap->alloc_count++;
+
+            return offset;
+        }
+
+        mask &= mask - 1;
+    }
+
+    heap->fail_count++;
+    return 0;
+}
+
+void
+mos_vma_heap_free(struct mos_vma_heap *heap, uint64_t offset, uint64_t size)
+{
+    struct mos_vma_hole *prev, *next;
+
+    size = mos_vma_align(size ? size : 1, MOS_VMA_PAGE_SIZE);
+
+    assert(offset >= heap->start);
+    assert(offset + size <= heap->start + heap->size);
+    assert(mos_vma_hole_starting_at(heap, offset) == nullptr);
+
+    prev = mos_vma_hole_ending_at(heap, offset);
+    next = mos_vma_hole_starting_at(heap, offset + size);
+
+    if (prev) {
+        mos_vma_hole_unlink(heap, prev);
+        prev->size += size;
+        if (next) {
+            mos_vma_hole_unlink(heap, next);
+            prev->size += next->size;
+            free(next);
+        }
+        mos_vma_hole_link(heap, prev);
+    } else if (next) {
+        mos_vma_hole_unlink(heap, next);
+        next->offset = offset;
+        next->size += size;
+        mos_vma_hole_link(heap, next);
+    } else {
+        struct mos_vma_hole *hole;
+
+        hole = (struct mos_vma_hole *)calloc(1, sizeof(*hole));
+        if (hole == nullptr)
+            return;
+        hole->offset = offset;
+        hole->size = size;
+        mos_vma_hole_link(heap, hole);
+    }
+
+    heap->used_size -= size;
+    heap->alloc_count--;
+}
+
+void
+mos_vma_heap_get_stats(struct mos_vma_heap *heap, struct mos_vma_heap_stats *stats)
+{
+    struct mos_vma_hole *hole;
+    uint64_t free_size;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->total_size = heap->size;
+    stats->used_size = heap->used_size;
+    stats->peak_used_size = heap->peak_used_size;
+    stats->hole_count = heap->hole_count;
+    stats->alloc_count = heap->alloc_count;
+    stats->fail_count = heap->fail_count;
+
+    if (heap->bin_mask) {
+        int bin = 63 - __builtin_clzll(heap->bin_mask);
+
+        DRMLISTFOREACHENTRY(hole, &heap->bins[bin], link) {
+            if (hole->size > stats->largest_hole)
+                stats->largest_hole = hole->size;
+        }
+    }
+
+    free_size = heap->size - heap->used_size;
+    if (free_size)
+        stats->fragmentation = (uint32_t)(1000 - stats->largest_hole * 1000 / free_size);
+}
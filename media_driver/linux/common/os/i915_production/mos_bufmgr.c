@@ -4134,6 +4134,20 @@ mos_bufmgr_gem_get_memory_info(struct mos_bufmgr *bufmgr, char *info, uint32_t l
     return 0;
 }
 
+/* The reuse cache of this bufmgr has no budget or counters */
+int
+mos_bufmgr_gem_set_cache_limits(struct mos_bufmgr *bufmgr, uint64_t high_watermark,
+                                uint64_t low_watermark, uint32_t expire_ms)
+{
+    return -ENOSYS;
+}
+
+int
+mos_bufmgr_gem_get_cache_stats(struct mos_bufmgr *bufmgr, struct mos_bufmgr_cache_stats *stats)
+{
+    return -ENOSYS;
+}
+
 void mos_bufmgr_gem_enable_softpin(struct mos_bufmgr *bufmgr)
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *)bufmgr;
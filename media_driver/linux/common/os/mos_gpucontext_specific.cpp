@@ -136,6 +136,17 @@ MOS_STATUS GpuContextSpecific::Init(OsContext *osContext,
     m_writeModeList = (bool *)MOS_AllocAndZeroMemory(sizeof(bool) * ALLOCATIONLIST_SIZE);
     MOS_OS_CHK_NULL_RETURN(m_writeModeList);
 
+    m_resIndex = (ResourceIndexSlot *)MOS_AllocAndZeroMemory(sizeof(ResourceIndexSlot) * GPU_CONTEXT_RES_INDEX_SIZE);
+    MOS_OS_CHK_NULL_RETURN(m_resIndex);
+    m_resIndexGeneration = 1;
+
+    m_softpinTargetHead = (int32_t *)MOS_AllocAndZeroMemory(sizeof(int32_t) * ALLOCATIONLIST_SIZE);
+    MOS_OS_CHK_NULL_RETURN(m_softpinTargetHead);
+
+    m_allocationBoOffsets = (uint64_t *)MOS_AllocAndZeroMemory(sizeof(uint64_t) * ALLOCATIONLIST_SIZE);
+    MOS_OS_CHK_NULL_RETURN(m_allocationBoOffsets);
+    m_softpinTargets.reserve(ALLOCATIONLIST_SIZE);
+
     m_GPUStatusTag = 1;
 
     m_createOptionEnhanced = (MOS_GPUCTX_CREATOPTIONS_ENHANCED*)MOS_AllocAndZeroMemory(sizeof(MOS_GPUCTX_CREATOPTIONS_ENHANCED));
@@ -396,7 +407,11 @@ void GpuContextSpecific::Clear()
     MOS_SafeFreeMemory(m_patchLocationList);
     MOS_SafeFreeMemory(m_attachedResources);
     MOS_SafeFreeMemory(m_writeModeList);
+    MOS_SafeFreeMemory(m_resIndex);
+    MOS_SafeFreeMemory(m_softpinTargetHead);
+    MOS_SafeFreeMemory(m_allocationBoOffsets);
     MOS_SafeFreeMemory(m_createOptionEnhanced);
+    m_cmdTemplates.clear();
 
     for (int i=0; i<MAX_ENGINE_INSTANCE_NUM; i++)
     {
@@ -417,18 +432,20 @@ MOS_STATUS GpuContextSpecific::RegisterResource(
     MOS_OS_CHK_NULL_RETURN(osResource);
 
     MOS_OS_CHK_NULL_RETURN(m_attachedResources);
+    MOS_OS_CHK_NULL_RETURN(m_resIndex);
 
-    PMOS_RESOURCE registeredResources = m_attachedResources;
-    uint32_t      allocationIndex     = 0;
-
-    for ( allocationIndex = 0; allocationIndex < m_resCount; allocationIndex++, registeredResources++)
+    // Find the bo in the index, or the empty slot it goes to
+    uint32_t slotMask = GPU_CONTEXT_RES_INDEX_SIZE - 1;
+    uint32_t slot     = (uint32_t)(((uintptr_t)osResource->bo >> 6) * 0x9E3779B1u) & slotMask;
+    while (m_resIndex[slot].generation == m_resIndexGeneration &&
+           m_resIndex[slot].bo != osResource->bo)
     {
-        if (osResource->bo == registeredResources->bo)
-        {
-            break;
-        }
+        slot = (slot + 1) & slotMask;
     }
 
+    uint32_t allocationIndex = (m_resIndex[slot].generation == m_resIndexGeneration) ?
+                               m_resIndex[slot].allocationIndex : m_resCount;
+
     // Allocation list to be updated
     if (allocationIndex < m_maxNumAllocations)
     {
@@ -436,6 +453,9 @@ MOS_STATUS GpuContextSpecific::RegisterResource(
         if (allocationIndex == m_resCount)
         {
             m_resCount++;
+            m_resIndex[slot].bo              = osResource->bo;
+            m_resIndex[slot].allocationIndex = allocationIndex;
+            m_resIndex[slot].generation      = m_resIndexGeneration;
         }
 
         // Set allocation
@@ -461,6 +481,62 @@ MOS_STATUS GpuContextSpecific::RegisterResource(
     return MOS_STATUS_SUCCESS;
 }
 
+uint32_t GpuContextSpecific::LookupResourceIndex(MOS_LINUX_BO *bo)
+{
+    uint32_t slotMask = GPU_CONTEXT_RES_INDEX_SIZE - 1;
+    uint32_t slot     = (uint32_t)(((uintptr_t)bo >> 6) * 0x9E3779B1u) & slotMask;
+    while (m_resIndex[slot].generation == m_resIndexGeneration)
+    {
+        if (m_resIndex[slot].bo == bo)
+        {
+            return m_resIndex[slot].allocationIndex;
+        }
+        slot = (slot + 1) & slotMask;
+    }
+
+    return m_maxNumAllocations;
+}
+
+void GpuContextSpecific::ResetResourceIndex()
+{
+    if (m_resIndex == nullptr)
+    {
+        return;
+    }
+
+    m_resIndexGeneration++;
+    if (m_resIndexGeneration == 0)
+    {
+        // Stale slots could alias the new generation after wrap around
+        MOS_ZeroMemory(m_resIndex, sizeof(ResourceIndexSlot) * GPU_CONTEXT_RES_INDEX_SIZE);
+        m_resIndexGeneration = 1;
+    }
+}
+
+void GpuContextSpecific::AddSoftpinTarget(
+    MOS_LINUX_BO *cmdBo,
+    uint32_t      allocationIndex,
+    MOS_LINUX_BO *targetBo,
+    bool          writeFlag)
+{
+    for (int32_t i = m_softpinTargetHead[allocationIndex]; i >= 0; i = m_softpinTargets[i].next)
+    {
+        if (m_softpinTargets[i].cmdBo == cmdBo)
+        {
+            m_softpinTargets[i].write |= writeFlag;
+            return;
+        }
+    }
+
+    SoftpinTarget target;
+    target.cmdBo    = cmdBo;
+    target.targetBo = targetBo;
+    target.write    = writeFlag;
+    target.next     = m_softpinTargetHead[allocationIndex];
+    m_softpinTargetHead[allocationIndex] = (int32_t)m_softpinTargets.size();
+    m_softpinTargets.push_back(target);
+}
+
 MOS_STATUS GpuContextSpecific::SetPatchEntry(
     PMOS_INTERFACE          osInterface,
     PMOS_PATCH_ENTRY_PARAMS params)
@@ -498,6 +574,155 @@ MOS_STATUS GpuContextSpecific::SetPatchEntry(
     return MOS_STATUS_SUCCESS;
 }
 
+MOS_STATUS GpuContextSpecific::RecordCmdTemplate(
+    PMOS_INTERFACE      osInterface,
+    uint32_t            templateId,
+    PMOS_COMMAND_BUFFER cmdBuffer,
+    uint32_t            startOffset)
+{
+    MOS_OS_FUNCTION_ENTER;
+
+    MOS_OS_CHK_NULL_RETURN(osInterface);
+    MOS_OS_CHK_NULL_RETURN(cmdBuffer);
+    MOS_OS_CHK_NULL_RETURN(cmdBuffer->pCmdBase);
+    MOS_OS_CHK_NULL_RETURN(m_patchLocationList);
+
+    m_cmdTemplates.erase(templateId);
+
+    uint32_t endOffset = (uint32_t)cmdBuffer->iOffset;
+    if (startOffset > endOffset)
+    {
+        MOS_OS_ASSERTMESSAGE("Template starts past the end of the command buffer.");
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    // HM keeps its own state per patch, which a replay would not rebuild
+    if (osInterface->osCpInterface && osInterface->osCpInterface->IsHMEnabled())
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    CmdTemplate          cmdTemplate;
+    std::vector<int32_t> templateIndex(m_numAllocations, -1);
+    for (uint32_t patchIndex = 0; patchIndex < m_currentNumPatchLocations; patchIndex++)
+    {
+        PATCHLOCATIONLIST patch = m_patchLocationList[patchIndex];
+
+        // Commands patched into nested batch buffers would be lost on replay
+        if (patch.cmdBo != nullptr && patch.cmdBo != cmdBuffer->OsResource.bo)
+        {
+            return MOS_STATUS_UNIMPLEMENTED;
+        }
+        if (patch.PatchOffset < startOffset || patch.PatchOffset >= endOffset)
+        {
+            continue;
+        }
+        if (patch.AllocationIndex >= m_numAllocations)
+        {
+            MOS_OS_ASSERTMESSAGE("Patch entry points at an unregistered allocation.");
+            return MOS_STATUS_INVALID_PARAMETER;
+        }
+
+        int32_t &index = templateIndex[patch.AllocationIndex];
+        if (index < 0)
+        {
+            index = (int32_t)cmdTemplate.resources.size();
+            cmdTemplate.resources.push_back(m_attachedResources[patch.AllocationIndex]);
+            cmdTemplate.writes.push_back(m_writeModeList[patch.AllocationIndex]);
+        }
+        patch.AllocationIndex = index;
+        patch.PatchOffset    -= startOffset;
+        patch.cmdBo           = nullptr;
+        cmdTemplate.patches.push_back(patch);
+    }
+
+    uint8_t *cmds = (uint8_t *)cmdBuffer->pCmdBase;
+    cmdTemplate.cmds.assign(cmds + startOffset, cmds + endOffset);
+    m_cmdTemplates[templateId] = std::move(cmdTemplate);
+
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS GpuContextSpecific::ReplayCmdTemplate(
+    PMOS_INTERFACE           osInterface,
+    uint32_t                 templateId,
+    PMOS_COMMAND_BUFFER      cmdBuffer,
+    PMOS_CMD_TEMPLATE_PARAMS params)
+{
+    MOS_OS_FUNCTION_ENTER;
+
+    MOS_OS_CHK_NULL_RETURN(osInterface);
+    MOS_OS_CHK_NULL_RETURN(cmdBuffer);
+    MOS_OS_CHK_NULL_RETURN(cmdBuffer->pCmdPtr);
+    MOS_OS_CHK_NULL_RETURN(m_patchLocationList);
+
+    auto it = m_cmdTemplates.find(templateId);
+    if (it == m_cmdTemplates.end())
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+    CmdTemplate &cmdTemplate = it->second;
+
+    // Check everything that can fail before touching the command buffer
+    uint32_t size = (uint32_t)cmdTemplate.cmds.size();
+    if ((int32_t)size > cmdBuffer->iRemaining ||
+        m_currentNumPatchLocations + cmdTemplate.patches.size() > m_maxPatchLocationsize ||
+        m_resCount + cmdTemplate.resources.size() > m_maxNumAllocations)
+    {
+        return MOS_STATUS_NO_SPACE;
+    }
+    if (params)
+    {
+        for (uint32_t i = 0; i < params->dwordCount; i++)
+        {
+            if (params->dwordOffsets[i] + sizeof(uint32_t) > size)
+            {
+                MOS_OS_ASSERTMESSAGE("Template dword rewrite is out of range.");
+                return MOS_STATUS_INVALID_PARAMETER;
+            }
+        }
+    }
+
+    m_cmdTemplateIndex.resize(cmdTemplate.resources.size());
+    for (uint32_t i = 0; i < cmdTemplate.resources.size(); i++)
+    {
+        PMOS_RESOURCE resource = &cmdTemplate.resources[i];
+        for (uint32_t j = 0; params && j < params->resourceCount; j++)
+        {
+            if (params->recordedResources[j]->bo == resource->bo)
+            {
+                resource = params->resources[j];
+                break;
+            }
+        }
+        MOS_OS_CHK_STATUS_RETURN(RegisterResource(resource, cmdTemplate.writes[i]));
+        m_cmdTemplateIndex[i] = resource->iAllocationIndex[m_gpuContext];
+    }
+
+    uint32_t baseOffset = (uint32_t)cmdBuffer->iOffset;
+    uint8_t *cmds       = (uint8_t *)cmdBuffer->pCmdPtr;
+    MOS_SecureMemcpy(cmds, cmdBuffer->iRemaining, cmdTemplate.cmds.data(), size);
+    for (uint32_t i = 0; params && i < params->dwordCount; i++)
+    {
+        *(uint32_t *)(cmds + params->dwordOffsets[i]) = params->dwordValues[i];
+    }
+
+    for (auto &patch : cmdTemplate.patches)
+    {
+        PATCHLOCATIONLIST &entry = m_patchLocationList[m_currentNumPatchLocations++];
+        entry                 = patch;
+        entry.AllocationIndex = m_cmdTemplateIndex[patch.AllocationIndex];
+        entry.PatchOffset    += baseOffset;
+        entry.cmdBo           = cmdBuffer->OsResource.bo;
+    }
+
+    cmdBuffer->pCmdPtr    += size / sizeof(uint32_t);
+    cmdBuffer->iOffset    += size;
+    cmdBuffer->iRemaining -= size;
+
+    return MOS_STATUS_SUCCESS;
+}
+
 MOS_STATUS GpuContextSpecific::GetCommandBuffer(
     PMOS_COMMAND_BUFFER comamndBuffer,
     uint32_t            flags)
@@ -866,6 +1091,26 @@ MOS_STATUS GpuContextSpecific::SubmitCommandBuffer(
     std::vector<PMOS_RESOURCE> mappedResList;
     std::vector<MOS_LINUX_BO *> skipSyncBoList;
 
+    // Resolve the offset of every allocation once rather than once per patch
+    m_softpinTargets.clear();
+    for (uint32_t allocIdx = 0; allocIdx < m_numAllocations; allocIdx++)
+    {
+        auto res = (PMOS_RESOURCE)m_allocationList[allocIdx].hAllocation;
+        m_allocationBoOffsets[allocIdx] = (res && res->bo) ? res->bo->offset64 : 0;
+        m_softpinTargetHead[allocIdx]   = -1;
+    }
+    for (auto &item_ctx : osContext->contextOffsetList)
+    {
+        if (item_ctx.intel_context == osContext->intel_context)
+        {
+            uint32_t allocIdx = LookupResourceIndex(item_ctx.target_bo);
+            if (allocIdx < m_numAllocations)
+            {
+                m_allocationBoOffsets[allocIdx] = item_ctx.offset64;
+            }
+        }
+    }
+
     // Now, the patching will be done, based on the patch list.
     for (uint32_t patchIndex = 0; patchIndex < m_currentNumPatchLocations; patchIndex++)
     {
@@ -889,17 +1134,14 @@ MOS_STATUS GpuContextSpecific::SubmitCommandBuffer(
                 it++;
             }
 
-            for(auto allocIdx = 0; allocIdx < m_numAllocations && (!isSecondaryCmdBuf); allocIdx++)
+            uint32_t allocIdx = isSecondaryCmdBuf ? m_numAllocations : LookupResourceIndex(tempCmdBo);
+            if (allocIdx < m_numAllocations)
             {
                 auto tempRes = (PMOS_RESOURCE)m_allocationList[allocIdx].hAllocation;
-                if (tempCmdBo == tempRes->bo)
-                {
-                    GraphicsResource::LockParams param;
-                    param.m_writeRequest = true;
-                    tempRes->pGfxResource->Lock(m_osContext, param);
-                    mappedResList.push_back(tempRes);
-                    break;
-                }
+                GraphicsResource::LockParams param;
+                param.m_writeRequest = true;
+                tempRes->pGfxResource->Lock(m_osContext, param);
+                mappedResList.push_back(tempRes);
             }
         }
 
@@ -920,19 +1162,8 @@ MOS_STATUS GpuContextSpecific::SubmitCommandBuffer(
             currentPatch,
             resource));
 
-        uint64_t boOffset = alloc_bo->offset64;
-        if (alloc_bo != tempCmdBo)
-        {
-            auto item_ctx = osContext->contextOffsetList.begin();
-            for (; item_ctx != osContext->contextOffsetList.end(); item_ctx++)
-            {
-                if (item_ctx->intel_context == osContext->intel_context && item_ctx->target_bo == alloc_bo)
-                {
-                    boOffset = item_ctx->offset64;
-                    break;
-                }
-            }
-        }
+        uint64_t boOffset = (alloc_bo != tempCmdBo) ?
+                            m_allocationBoOffsets[currentPatch->AllocationIndex] : alloc_bo->offset64;
 
         if (osContext->bUse64BitRelocs)
         {
@@ -975,7 +1206,8 @@ MOS_STATUS GpuContextSpecific::SubmitCommandBuffer(
         {
             if (alloc_bo != tempCmdBo)
             {
-                ret = mos_bo_add_softpin_target(tempCmdBo, alloc_bo, currentPatch->uiWriteOperation);
+                // Added to the exec list once per bo after all patches are walked
+                AddSoftpinTarget(tempCmdBo, currentPatch->AllocationIndex, alloc_bo, currentPatch->uiWriteOperation);
             }
         }
         else
@@ -1000,6 +1232,19 @@ MOS_STATUS GpuContextSpecific::SubmitCommandBuffer(
         }
     }
 
+    for (auto &target : m_softpinTargets)
+    {
+        ret = mos_bo_add_softpin_target(target.cmdBo, target.targetBo, target.write);
+        if (ret != 0)
+        {
+            MOS_OS_ASSERTMESSAGE("Error adding softpin target alloc_bo = 0x%x, cmd_bo = 0x%x.",
+                (uintptr_t)target.targetBo,
+                (uintptr_t)target.cmdBo);
+            return MOS_STATUS_UNKNOWN;
+        }
+    }
+    m_softpinTargets.clear();
+
     for(auto res: mappedResList)
     {
         res->pGfxResource->Unlock(m_osContext);
@@ -1313,6 +1558,7 @@ if (osInterface->bDumpCommandBuffer)
     m_currentNumPatchLocations = 0;
     MOS_ZeroMemory(m_patchLocationList, sizeof(PATCHLOCATIONLIST) * m_maxNumAllocations);
     m_resCount = 0;
+    ResetResourceIndex();
 
     MOS_ZeroMemory(m_writeModeList, sizeof(bool) * m_maxNumAllocations);
 finish:
@@ -1423,6 +1669,7 @@ void GpuContextSpecific::ResetGpuContextStatus()
 
     MOS_ZeroMemory(m_attachedResources, sizeof(MOS_RESOURCE) * ALLOCATIONLIST_SIZE);
     m_resCount = 0;
+    ResetResourceIndex();
 
     MOS_ZeroMemory(m_writeModeList, sizeof(bool) * ALLOCATIONLIST_SIZE);
 
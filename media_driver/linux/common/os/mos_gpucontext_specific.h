@@ -35,6 +35,9 @@
 #define ENGINE_INSTANCE_SELECT_VEBOX_INSTANCE_SHIFT          8
 #define ENGINE_INSTANCE_SELECT_VDBOX_INSTANCE_SHIFT          0
 
+//! \brief    Number of slots in the bo to allocation index map, power of 2 and at least twice ALLOCATIONLIST_SIZE
+#define GPU_CONTEXT_RES_INDEX_SIZE                           (ALLOCATIONLIST_SIZE * 2)
+
 //!
 //! \class  GpuContextSpecific
 //! \brief  Linux/Android specific gpu context 
@@ -123,6 +126,62 @@ public:
         PMOS_INTERFACE          osInterface,
         PMOS_PATCH_ENTRY_PARAMS params);
 
+    //!
+    //! \brief    Record command template
+    //! \details  Keeps the commands from startOffset to the end of the command
+    //!           buffer, the patch entries inside them and the resources they
+    //!           point at, so the same commands can be replayed on later frames
+    //!           without being built again. The client invalidates the template
+    //!           before freeing any resource it recorded.
+    //! \param    [in] osInterface
+    //!           Pointer to OS interface structure
+    //! \param    [in] templateId
+    //!           Template to record, replacing any template with the same id
+    //! \param    [in] cmdBuffer
+    //!           Command buffer holding the commands
+    //! \param    [in] startOffset
+    //!           Offset in bytes of the first command to record
+    //! \return   MOS_STATUS
+    //!           Return MOS_STATUS_SUCCESS if successful, MOS_STATUS_UNIMPLEMENTED
+    //!           if the commands cannot be replayed
+    //!
+    MOS_STATUS RecordCmdTemplate(
+        PMOS_INTERFACE      osInterface,
+        uint32_t            templateId,
+        PMOS_COMMAND_BUFFER cmdBuffer,
+        uint32_t            startOffset);
+
+    //!
+    //! \brief    Replay command template
+    //! \details  Appends the commands of a recorded template to the command
+    //!           buffer and registers its resources and patch entries, swapping
+    //!           in the resources and dwords that change per frame. Addresses
+    //!           are still resolved when the command buffer is submitted.
+    //! \param    [in] osInterface
+    //!           Pointer to OS interface structure
+    //! \param    [in] templateId
+    //!           Template to replay
+    //! \param    [in, out] cmdBuffer
+    //!           Command buffer to append the commands to
+    //! \param    [in] params
+    //!           Per frame changes, nullptr for none
+    //! \return   MOS_STATUS
+    //!           Return MOS_STATUS_SUCCESS if successful. On failure nothing is
+    //!           appended and the caller builds the commands instead
+    //!
+    MOS_STATUS ReplayCmdTemplate(
+        PMOS_INTERFACE           osInterface,
+        uint32_t                 templateId,
+        PMOS_COMMAND_BUFFER      cmdBuffer,
+        PMOS_CMD_TEMPLATE_PARAMS params);
+
+    //!
+    //! \brief    Invalidate command template
+    //! \param    [in] templateId
+    //!           Template to drop
+    //!
+    void InvalidateCmdTemplate(uint32_t templateId) { m_cmdTemplates.erase(templateId); }
+
     void ReturnCommandBuffer(
         PMOS_COMMAND_BUFFER cmdBuffer,
         uint32_t            flags);
@@ -221,6 +280,39 @@ protected:
         PMOS_GPUCTX_CREATOPTIONS option,
         __u64 &caps);
 
+    //!
+    //! \brief    Look up the allocation index of a bo registered to the current command buffer
+    //! \param    [in] bo
+    //!           Bo to look up
+    //! \return   uint32_t
+    //!           Allocation index, or m_maxNumAllocations if the bo is not registered
+    //!
+    uint32_t LookupResourceIndex(MOS_LINUX_BO *bo);
+
+    //!
+    //! \brief    Drop all entries of the bo to allocation index map
+    //! \return   void
+    //!
+    void ResetResourceIndex();
+
+    //!
+    //! \brief    Record a softpin target of a command buffer bo, merging repeated targets
+    //! \param    [in] cmdBo
+    //!           Command buffer bo
+    //! \param    [in] allocationIndex
+    //!           Allocation index of the target
+    //! \param    [in] targetBo
+    //!           Target bo
+    //! \param    [in] writeFlag
+    //!           Whether the target is written
+    //! \return   void
+    //!
+    void AddSoftpinTarget(
+        MOS_LINUX_BO *cmdBo,
+        uint32_t      allocationIndex,
+        MOS_LINUX_BO *targetBo,
+        bool          writeFlag);
+
 #if (_DEBUG || _RELEASE_INTERNAL)
     bool SelectEngineInstanceByUser(struct i915_engine_class_instance *engineMap,
         uint32_t *engineNum, uint32_t userEngineInstance, MOS_GPU_NODE gpuNode);
@@ -264,6 +356,39 @@ private:
     PMOS_RESOURCE m_attachedResources = nullptr;  //!< Pointer to resources list
     bool         *m_writeModeList     = nullptr;  //!< Write mode
 
+    //! \brief    Open addressed map from bo to allocation index for the current command buffer
+    struct ResourceIndexSlot
+    {
+        MOS_LINUX_BO *bo;               //!< Registered bo
+        uint32_t      allocationIndex;  //!< Index in m_allocationList
+        uint32_t      generation;       //!< Slot is in use only when equal to m_resIndexGeneration
+    };
+    ResourceIndexSlot *m_resIndex           = nullptr;
+    uint32_t           m_resIndexGeneration = 1;  //!< Bumped to empty the map in O(1)
+
+    //! \brief    Softpin targets of the command buffer being submitted, one entry per cmd bo and target bo
+    struct SoftpinTarget
+    {
+        MOS_LINUX_BO *cmdBo;      //!< Command buffer bo
+        MOS_LINUX_BO *targetBo;   //!< Target bo
+        bool          write;      //!< Target is written by any patch
+        int32_t       next;       //!< Next entry of the same allocation, -1 for none
+    };
+    std::vector<SoftpinTarget> m_softpinTargets;
+    int32_t  *m_softpinTargetHead   = nullptr;  //!< First m_softpinTargets entry per allocation index, -1 for none
+    uint64_t *m_allocationBoOffsets = nullptr;  //!< Gpu address per allocation index resolved at submission
+
+    //! \brief    Recorded command templates
+    struct CmdTemplate
+    {
+        std::vector<uint8_t>           cmds;       //!< Recorded commands
+        std::vector<MOS_RESOURCE>      resources;  //!< Resources the patches point at, in order of first use
+        std::vector<bool>              writes;     //!< Write mode of each resource
+        std::vector<PATCHLOCATIONLIST> patches;    //!< Patches indexing resources, offsets relative to cmds
+    };
+    std::map<uint32_t, CmdTemplate> m_cmdTemplates;
+    std::vector<uint32_t>           m_cmdTemplateIndex;  //!< Allocation index of each template resource while replaying
+
     //! \brief    GPU Status tag
     uint32_t m_GPUStatusTag = 0;
 
@@ -29,6 +29,7 @@
 #include "mos_util_debug.h"
 #include "mos_resource_defs.h"
 #include <unistd.h>
+#include <errno.h>
 #include <dlfcn.h>
 #include "hwinfo_linux.h"
 #include "media_fourcc.h"
@@ -108,6 +109,63 @@ bool SetupApoMosSwitch(int32_t fd)
     return false;
 }
 
+void Mos_Specific_EnableBufmgrReuse(
+    MOS_BUFMGR             *bufmgr)
+{
+    MOS_USER_FEATURE_VALUE_DATA userFeatureData;
+    uint64_t                    budget;
+    uint32_t                    expireMs;
+
+    if (bufmgr == nullptr)
+    {
+        return;
+    }
+
+    mos_bufmgr_gem_enable_reuse(bufmgr);
+
+    MOS_ZeroMemory(&userFeatureData, sizeof(userFeatureData));
+    MOS_UserFeature_ReadValue_ID(
+        nullptr,
+        __MEDIA_USER_FEATURE_VALUE_BO_CACHE_BUDGET_ID,
+        &userFeatureData,
+        nullptr);
+    budget = (uint64_t)userFeatureData.u32Data * 1024 * 1024;
+
+    MOS_ZeroMemory(&userFeatureData, sizeof(userFeatureData));
+    MOS_UserFeature_ReadValue_ID(
+        nullptr,
+        __MEDIA_USER_FEATURE_VALUE_BO_CACHE_EXPIRE_ID,
+        &userFeatureData,
+        nullptr);
+    expireMs = userFeatureData.u32Data;
+
+    // Trim to three quarters of the budget once it is exceeded
+    mos_bufmgr_gem_set_cache_limits(bufmgr, budget, budget / 4 * 3, expireMs);
+}
+
+void Mos_Specific_ReportBufmgrReuse(
+    MOS_BUFMGR             *bufmgr)
+{
+#if (_DEBUG || _RELEASE_INTERNAL)
+    struct mos_bufmgr_cache_stats     stats;
+    MOS_USER_FEATURE_VALUE_WRITE_DATA userFeatureWriteData[3];
+
+    if (bufmgr == nullptr || mos_bufmgr_gem_get_cache_stats(bufmgr, &stats) != 0)
+    {
+        return;
+    }
+
+    MOS_ZeroMemory(userFeatureWriteData, sizeof(userFeatureWriteData));
+    userFeatureWriteData[0].ValueID       = __MEDIA_USER_FEATURE_VALUE_BO_CACHE_HITS_ID;
+    userFeatureWriteData[0].Value.u64Data = stats.hits;
+    userFeatureWriteData[1].ValueID       = __MEDIA_USER_FEATURE_VALUE_BO_CACHE_MISSES_ID;
+    userFeatureWriteData[1].Value.u64Data = stats.misses;
+    userFeatureWriteData[2].ValueID       = __MEDIA_USER_FEATURE_VALUE_BO_CACHE_PEAK_BYTES_ID;
+    userFeatureWriteData[2].Value.u64Data = stats.peak_cached_bytes;
+    MOS_UserFeature_WriteValues_ID(nullptr, userFeatureWriteData, 3, nullptr);
+#endif
+}
+
 
 //!
 //! \brief    Clear Gpu Context
@@ -3403,6 +3461,110 @@ MOS_STATUS Mos_Specific_SetPatchEntry(
     return eStatus;
 }
 
+//!
+//! \brief    Record command template
+//! \details  Records the commands from dwStartOffset to the end of the command
+//!           buffer so they can be replayed on later frames. Only the
+//!           modularized GPU context keeps templates
+//! \param    PMOS_INTERFACE pOsInterface
+//!           [in] Pointer to OS interface structure
+//! \param    uint32_t dwTemplateId
+//!           [in] Template to record
+//! \param    PMOS_COMMAND_BUFFER pCmdBuffer
+//!           [in] Command buffer holding the commands
+//! \param    uint32_t dwStartOffset
+//!           [in] Offset in bytes of the first command to record
+//! \return   MOS_STATUS
+//!           Return MOS_STATUS_SUCCESS if successful, otherwise failed
+//!
+MOS_STATUS Mos_Specific_RecordCmdTemplate(
+    PMOS_INTERFACE              pOsInterface,
+    uint32_t                    dwTemplateId,
+    PMOS_COMMAND_BUFFER         pCmdBuffer,
+    uint32_t                    dwStartOffset)
+{
+    MOS_OS_FUNCTION_ENTER;
+
+    MOS_OS_CHK_NULL_RETURN(pOsInterface);
+
+    if (pOsInterface->apoMosEnabled ||
+        !pOsInterface->modularizedGpuCtxEnabled ||
+        Mos_Solo_IsEnabled(nullptr))
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    auto gpuContext = Linux_GetGpuContext(pOsInterface, pOsInterface->CurrentGpuContextHandle);
+    MOS_OS_CHK_NULL_RETURN(gpuContext);
+
+    return gpuContext->RecordCmdTemplate(pOsInterface, dwTemplateId, pCmdBuffer, dwStartOffset);
+}
+
+//!
+//! \brief    Replay command template
+//! \details  Appends the commands of a recorded template to the command buffer
+//! \param    PMOS_INTERFACE pOsInterface
+//!           [in] Pointer to OS interface structure
+//! \param    uint32_t dwTemplateId
+//!           [in] Template to replay
+//! \param    PMOS_COMMAND_BUFFER pCmdBuffer
+//!           [in/out] Command buffer to append the commands to
+//! \param    PMOS_CMD_TEMPLATE_PARAMS pParams
+//!           [in] Per frame changes, nullptr for none
+//! \return   MOS_STATUS
+//!           Return MOS_STATUS_SUCCESS if successful, otherwise failed and nothing is appended
+//!
+MOS_STATUS Mos_Specific_ReplayCmdTemplate(
+    PMOS_INTERFACE              pOsInterface,
+    uint32_t                    dwTemplateId,
+    PMOS_COMMAND_BUFFER         pCmdBuffer,
+    PMOS_CMD_TEMPLATE_PARAMS    pParams)
+{
+    MOS_OS_FUNCTION_ENTER;
+
+    MOS_OS_CHK_NULL_RETURN(pOsInterface);
+
+    if (pOsInterface->apoMosEnabled ||
+        !pOsInterface->modularizedGpuCtxEnabled ||
+        Mos_Solo_IsEnabled(nullptr))
+    {
+        return MOS_STATUS_UNIMPLEMENTED;
+    }
+
+    auto gpuContext = Linux_GetGpuContext(pOsInterface, pOsInterface->CurrentGpuContextHandle);
+    MOS_OS_CHK_NULL_RETURN(gpuContext);
+
+    return gpuContext->ReplayCmdTemplate(pOsInterface, dwTemplateId, pCmdBuffer, pParams);
+}
+
+//!
+//! \brief    Invalidate command template
+//! \param    PMOS_INTERFACE pOsInterface
+//!           [in] Pointer to OS interface structure
+//! \param    uint32_t dwTemplateId
+//!           [in] Template to drop
+//! \return   void
+//!
+void Mos_Specific_InvalidateCmdTemplate(
+    PMOS_INTERFACE              pOsInterface,
+    uint32_t                    dwTemplateId)
+{
+    MOS_OS_FUNCTION_ENTER;
+
+    if (pOsInterface == nullptr ||
+        pOsInterface->apoMosEnabled ||
+        !pOsInterface->modularizedGpuCtxEnabled)
+    {
+        return;
+    }
+
+    auto gpuContext = Linux_GetGpuContext(pOsInterface, pOsInterface->CurrentGpuContextHandle);
+    if (gpuContext)
+    {
+        gpuContext->InvalidateCmdTemplate(dwTemplateId);
+    }
+}
+
 //!
 //! \brief    Update resource usage type
 //! \details  update the resource usage for cache policy
@@ -6032,6 +6194,45 @@ MOS_STATUS Mos_Specific_WaitForBBCompleteNotifyEvent(
     return MOS_STATUS_SUCCESS;
 }
 
+//!
+//! \brief    Waits until the GPU is done with a resource
+//! \details  Sleeps in the kernel on the buffer's outstanding submissions instead
+//!           of polling, and gives up after the time out
+//! \param    PMOS_INTERFACE pOsInterface
+//!           [in] Pointer to OS Interface
+//! \param    PMOS_RESOURCE pOsResource
+//!           [in] Resource to wait on
+//! \param    uint32_t uiTimeOut
+//!           [in] Time out in ms
+//! \return   MOS_STATUS
+//!           MOS_STATUS_SUCCESS once the resource is idle, MOS_STATUS_STILL_DRAWING
+//!           on time out, otherwise error
+//!
+MOS_STATUS Mos_Specific_WaitOnResourceTimeout(
+    PMOS_INTERFACE     pOsInterface,
+    PMOS_RESOURCE      pOsResource,
+    uint32_t           uiTimeOut)
+{
+    int32_t ret;
+
+    MOS_OS_CHK_NULL_RETURN(pOsInterface);
+    MOS_OS_CHK_NULL_RETURN(pOsResource);
+    MOS_OS_CHK_NULL_RETURN(pOsResource->bo);
+
+    ret = mos_gem_bo_wait(pOsResource->bo, (int64_t)uiTimeOut * 1000000);
+    if (ret == -ETIME)
+    {
+        return MOS_STATUS_STILL_DRAWING;
+    }
+    else if (ret != 0)
+    {
+        MOS_OS_ASSERTMESSAGE("Failed to wait on resource, ret = %d.", ret);
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    return MOS_STATUS_SUCCESS;
+}
+
 MOS_STATUS Mos_Specific_WaitAllCmdCompletion_Os(
     PMOS_INTERFACE pOsInterface)
 {
@@ -7387,6 +7588,9 @@ MOS_STATUS Mos_Specific_InitInterface(
     pOsInterface->pfnGetIndirectState                       = Mos_Specific_GetIndirectState;
     pOsInterface->pfnGetIndirectStatePointer                = Mos_Specific_GetIndirectStatePointer;
     pOsInterface->pfnSetPatchEntry                          = Mos_Specific_SetPatchEntry;
+    pOsInterface->pfnRecordCmdTemplate                      = Mos_Specific_RecordCmdTemplate;
+    pOsInterface->pfnReplayCmdTemplate                      = Mos_Specific_ReplayCmdTemplate;
+    pOsInterface->pfnInvalidateCmdTemplate                  = Mos_Specific_InvalidateCmdTemplate;
 
     pOsInterface->pfnLoadLibrary                            = Mos_Specific_LoadLibrary;
     pOsInterface->pfnFreeLibrary                            = Mos_Specific_FreeLibrary;
@@ -7438,6 +7642,7 @@ MOS_STATUS Mos_Specific_InitInterface(
 
     pOsInterface->pfnRegisterBBCompleteNotifyEvent          = Mos_Specific_RegisterBBCompleteNotifyEvent;
     pOsInterface->pfnWaitForBBCompleteNotifyEvent           = Mos_Specific_WaitForBBCompleteNotifyEvent;
+    pOsInterface->pfnWaitOnResourceTimeout                  = Mos_Specific_WaitOnResourceTimeout;
     pOsInterface->pfnCachePolicyGetMemoryObject             = Mos_Specific_CachePolicyGetMemoryObject;
     pOsInterface->pfnCachePolicyGetL1Config                 = Mos_Specific_CachePolicyGetL1Config;
     pOsInterface->pfnSetCpuCacheability                     = Mos_Specific_SetCpuCacheability;
@@ -927,6 +927,28 @@ MOS_STATUS Mos_Specific_IsResourceReleasable(
     PMOS_INTERFACE         pOsInterface,
     PMOS_RESOURCE          pOsResource);
 
+//!
+//! \brief    Enable BO reuse on a new buffer manager
+//! \details  Applies the "BO Cache Budget" and "BO Cache Expire" user
+//!           features to the reuse cache of the buffer manager
+//! \param    MOS_BUFMGR *bufmgr
+//!           [in] Buffer manager
+//! \return   void
+//!
+void Mos_Specific_EnableBufmgrReuse(
+    MOS_BUFMGR             *bufmgr);
+
+//!
+//! \brief    Report BO reuse cache statistics
+//! \details  Writes the reuse cache counters of a buffer manager to the
+//!           report user features, called before it is destroyed
+//! \param    MOS_BUFMGR *bufmgr
+//!           [in] Buffer manager
+//! \return   void
+//!
+void Mos_Specific_ReportBufmgrReuse(
+    MOS_BUFMGR             *bufmgr);
+
 #if (_DEBUG || _RELEASE_INTERNAL)
 MOS_LINUX_BO * Mos_GetNopCommandBuffer_Linux(
     PMOS_INTERFACE        pOsInterface);
@@ -60,55 +60,6 @@ static MediaUserSettingsMgr *vpUserFeatureExt    = nullptr;
 #endif
 
 
-#ifdef __cplusplus
-
-void PerfUtility::startTick(std::string tag)
-{
-    std::lock_guard<std::mutex> lock(perfMutex);
-    Tick newTick = {};
-    struct timespec ts = {};
-
-    // get start tick count
-    clock_gettime(CLOCK_REALTIME, &ts);
-    newTick.start = int(ts.tv_sec * 1000000) + int(ts.tv_nsec / 1000); // us
-
-    std::vector<Tick> *perf = nullptr;
-    std::map<std::string, std::vector<Tick>*>::iterator it;
-    it = records.find(tag);
-    if (it == records.end())
-    {
-        perf = new std::vector<Tick>;
-        perf->push_back(newTick);
-        records[tag] = perf;
-    }
-    else
-    {
-        it->second->push_back(newTick);
-    }
-}
-
-void PerfUtility::stopTick(std::string tag)
-{
-    std::lock_guard<std::mutex> lock(perfMutex);
-    struct timespec ts = {};
-    std::map<std::string, std::vector<Tick>*>::iterator it;
-    it = records.find(tag);
-    if (it == records.end())
-    {
-        // should not happen
-        return;
-    }
-
-    // get stop tick count
-    clock_gettime(CLOCK_REALTIME, &ts);
-    it->second->back().stop = int(ts.tv_sec * 1000000) + int(ts.tv_nsec / 1000); // us
-
-    // calculate time interval
-    it->second->back().time = double(it->second->back().stop - it->second->back().start) / 1000.0; // ms
-}
-
-#endif // __cplusplus
-
 //!
 //! \brief Linux specific user feature define, used in MOS_UserFeature_ParsePath
 //!        They can be unified with the win definitions, since they are identical.
@@ -729,49 +680,6 @@ static MOS_STATUS _UserFeature_Set(MOS_PUF_KEYLIST *pKeyList, MOS_UF_KEY NewKey)
     return MOS_STATUS_SUCCESS;
 }
 
-/*----------------------------------------------------------------------------
-| Name      : _UserFeature_Query
-| Purpose   : This function query a key's value and return matched key node
-|             content just with matched value content.
-| Arguments : pKeyList      [in] Key linked list.
-|             NewKey        [in] New key content with matched value.
-| Returns   : MOS_STATUS_SUCCESS         Operation success.
-|             MOS_STATUS_UNKNOWN         Can't find key or value in User Feature File.
-| Comments  :
-\---------------------------------------------------------------------------*/
-static MOS_STATUS _UserFeature_Query(MOS_PUF_KEYLIST pKeyList, MOS_UF_KEY *NewKey)
-{
-    int32_t       iPos;
-    MOS_UF_VALUE  *pValueArray;
-    MOS_UF_KEY    *Key;
-
-    iPos         = -1;
-    pValueArray  = nullptr;
-
-    // can't find key in user feature
-    if ( (Key = _UserFeature_FindKey(pKeyList, NewKey->pcKeyName)) == nullptr )
-    {
-        return MOS_STATUS_UNKNOWN;
-    }
-
-    // can't find Value in the key
-    if ( (iPos = _UserFeature_FindValue(*Key, NewKey->pValueArray[0].pcValueName)) == NOT_FOUND)
-    {
-        return MOS_STATUS_UNKNOWN;
-    }
-
-    //get key content from user feature
-    MOS_SecureMemcpy(NewKey->pValueArray[0].ulValueBuf,
-                     Key->pValueArray[iPos].ulValueLen,
-                     Key->pValueArray[iPos].ulValueBuf,
-                     Key->pValueArray[iPos].ulValueLen);
-
-    NewKey->pValueArray[0].ulValueLen    =  Key->pValueArray[iPos].ulValueLen;
-    NewKey->pValueArray[0].ulValueType   =  Key->pValueArray[iPos].ulValueType;
-
-    return MOS_STATUS_SUCCESS;
-}
-
 static MOS_STATUS _UserFeature_ReadNextTokenFromFile(FILE *pFile, const char *szFormat, char  *szToken)
 {
     size_t nTokenSize = 0;
@@ -1229,6 +1137,7 @@ static MOS_STATUS _UserFeature_SetValue(
     if ( ( eStatus = _UserFeature_Set(&pKeyList, NewKey)) == MOS_STATUS_SUCCESS )
     {
         eStatus = _UserFeature_DumpDataToFile(szUserFeatureFile, pKeyList);
+        MosUtilitiesSpecificNext::m_userFeatureStore.Invalidate();
     }
 
     _UserFeature_FreeKeyList(pKeyList);
@@ -1259,47 +1168,13 @@ static MOS_STATUS _UserFeature_QueryValue(
     void                *pData,
     int32_t             *nDataSize)
 {
-    MOS_UF_KEY          NewKey;
-    MOS_UF_VALUE        NewValue;
-    size_t              nKeyLen, nValueLen;
-    MOS_STATUS          eStatus;
-    MOS_PUF_KEYLIST     pKeyList;
-    char                strTempKey[MAX_USERFEATURE_LINE_LENGTH];
-    char                strTempValueName[MAX_USERFEATURE_LINE_LENGTH];
-
-    eStatus   = MOS_STATUS_UNKNOWN;
-    pKeyList   = nullptr;
-
     if ( (strKey == nullptr) || (pcValueName == nullptr))
     {
         return MOS_STATUS_INVALID_PARAMETER;
     }
-    MOS_ZeroMemory(NewValue.pcValueName, MAX_USERFEATURE_LINE_LENGTH);
-    MOS_SecureStrcpy(NewValue.pcValueName, MAX_USERFEATURE_LINE_LENGTH, pcValueName);
-    NewValue.ulValueBuf     = pData;
-
-    MOS_ZeroMemory(NewKey.pcKeyName, MAX_USERFEATURE_LINE_LENGTH);
-    MOS_SecureStrcpy(NewKey.pcKeyName, MAX_USERFEATURE_LINE_LENGTH, strKey);
-    NewKey.pValueArray = &NewValue;
-    NewKey.ulValueNum = 1;
-
-    if ( (eStatus = _UserFeature_DumpFile(szUserFeatureFile, &pKeyList)) == MOS_STATUS_SUCCESS)
-    {
-        if ( (eStatus = _UserFeature_Query(pKeyList, &NewKey)) == MOS_STATUS_SUCCESS )
-        {
-            if(uiValueType != nullptr)
-            {
-                *uiValueType = NewKey.pValueArray[0].ulValueType;
-            }
-            if (nDataSize != nullptr)
-            {
-                *nDataSize   = NewKey.pValueArray[0].ulValueLen;
-            }
-        }
-    }
-    _UserFeature_FreeKeyList(pKeyList);
 
-    return eStatus;
+    return MosUtilitiesSpecificNext::m_userFeatureStore.QueryValue(
+        szUserFeatureFile, strKey, pcValueName, uiValueType, pData, nDataSize);
 }
 
 /*----------------------------------------------------------------------------
@@ -1314,36 +1189,7 @@ static MOS_STATUS _UserFeature_QueryValue(
 \---------------------------------------------------------------------------*/
 static MOS_STATUS _UserFeature_GetKeyIdbyName(const char  *pcKeyName, void **pUFKey)
 {
-    MOS_PUF_KEYLIST     pKeyList;
-    int32_t             iResult;
-    MOS_STATUS          eStatus;
-    MOS_PUF_KEYLIST     pTempNode;
-
-    pKeyList   = nullptr;
-    iResult    = -1;
-
-    if ( (eStatus = _UserFeature_DumpFile(szUserFeatureFile, &pKeyList)) !=
-        MOS_STATUS_SUCCESS )
-    {
-        _UserFeature_FreeKeyList(pKeyList);
-        return eStatus;
-    }
-
-    eStatus   = MOS_STATUS_INVALID_PARAMETER;
-
-    for(pTempNode=pKeyList; pTempNode; pTempNode=pTempNode->pNext)
-    {
-        iResult = strcmp(pTempNode->pElem->pcKeyName, pcKeyName);
-        if ( iResult == 0 )
-        {
-            *pUFKey = pTempNode->pElem->UFKey;
-            eStatus = MOS_STATUS_SUCCESS;
-            break;
-        }
-    }
-    _UserFeature_FreeKeyList(pKeyList);
-
-    return eStatus;
+    return MosUtilitiesSpecificNext::m_userFeatureStore.GetKeyIdByName(szUserFeatureFile, pcKeyName, pUFKey);
 }
 
 /*----------------------------------------------------------------------------
@@ -1358,12 +1204,8 @@ static MOS_STATUS _UserFeature_GetKeyIdbyName(const char  *pcKeyName, void **pUF
 \---------------------------------------------------------------------------*/
 static MOS_STATUS _UserFeature_GetKeyNamebyId(void  *UFKey, char  *pcKeyName)
 {
-    MOS_PUF_KEYLIST     pKeyList;
-    MOS_PUF_KEYLIST     pTempNode;
     MOS_STATUS          eStatus;
 
-    pKeyList   = nullptr;
-
     switch((uintptr_t)UFKey)
     {
     case UFKEY_INTERNAL:
@@ -1375,25 +1217,7 @@ static MOS_STATUS _UserFeature_GetKeyNamebyId(void  *UFKey, char  *pcKeyName)
         eStatus = MOS_STATUS_SUCCESS;
         break;
     default:
-        if ( (eStatus = _UserFeature_DumpFile(szUserFeatureFile, &pKeyList)) !=
-            MOS_STATUS_SUCCESS )
-        {
-            _UserFeature_FreeKeyList(pKeyList);
-            return eStatus;
-        }
-
-        eStatus   = MOS_STATUS_UNKNOWN;
-
-        for(pTempNode=pKeyList;pTempNode;pTempNode=pTempNode->pNext)
-        {
-            if(pTempNode->pElem->UFKey == UFKey)
-            {
-                MOS_SecureStrcpy(pcKeyName, MAX_USERFEATURE_LINE_LENGTH, pTempNode->pElem->pcKeyName);
-                eStatus = MOS_STATUS_SUCCESS;
-                break;
-            }
-        }
-        _UserFeature_FreeKeyList(pKeyList);
+        eStatus = MosUtilitiesSpecificNext::m_userFeatureStore.GetKeyNameById(szUserFeatureFile, UFKey, pcKeyName);
         break;
     }
 
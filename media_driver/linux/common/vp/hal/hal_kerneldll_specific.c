@@ -0,0 +1,551 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     hal_kerneldll_specific.c
+//! \brief    Persistent cache of combined kernels for the Kernel Dll
+//! \details  Combined kernels built by KernelDll_SearchKernel/KernelDll_BuildKernel are
+//!           appended to a file under $INTEL_MEDIA_KDLL_CACHE_DIR, so that new processes
+//!           skip the rule search and kernel build for combinations seen before.
+//!           The file is named after a hash of the component kernels, rule tables and
+//!           driver version and commit, every record is checksummed, and the file is
+//!           mapped lazily on first lookup.
+//!           The file is published with its header already written, and appends from
+//!           concurrent processes are serialized with flock().
+//!
+#include "hal_kerneldll.h"
+#include "vphal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KDLL_DISK_CACHE_MAGIC       0x434c444b      // "KDLC"
+#define KDLL_DISK_CACHE_VERSION     1
+#define KDLL_DISK_CACHE_MAX_INDEX   4096
+
+typedef struct tagKdll_DiskCacheHeader
+{
+    uint32_t dwMagic;               // KDLL_DISK_CACHE_MAGIC
+    uint32_t dwVersion;             // KDLL_DISK_CACHE_VERSION
+    uint32_t dwBinaryHash;          // Hash of kernels, rules and driver version
+    uint32_t dwFilterEntrySize;     // sizeof(Kdll_FilterEntry)
+    uint32_t dwCscParamsSize;       // sizeof(Kdll_CSC_Params)
+    uint32_t dwReserved[3];
+} Kdll_DiskCacheHeader;
+
+// Record layout: header, original filter, modified filter, CSC params, kernel
+typedef struct tagKdll_DiskCacheRecord
+{
+    uint32_t dwSize;                // Record size including this header
+    uint32_t dwChecksum;            // FNV-1a of the record payload
+    uint32_t dwHash;                // Hash of the original filter
+    int32_t  iFilterSize;           // Original filter size
+    int32_t  iModifiedFilterSize;   // Filter size after search
+    int32_t  iKernelSize;           // Combined kernel size
+    int32_t  colorfill_cspace;      // Intermediate color space for colorfill
+    uint32_t dwReserved;
+} Kdll_DiskCacheRecord;
+
+typedef struct tagKdll_DiskCache
+{
+    bool                  bInitialized;     // Lookup attempted
+    bool                  bEnabled;         // Cache directory is set and usable
+    char                  szPath[MOS_MAX_PATH_LENGTH + 1];
+    uint32_t              dwBinaryHash;
+    uint8_t              *pMapped;          // Mapped file, nullptr if none
+    size_t                MappedSize;
+    int32_t               iIndexCount;
+    uint32_t              dwIndexHash[KDLL_DISK_CACHE_MAX_INDEX];
+    uint32_t              dwIndexOffset[KDLL_DISK_CACHE_MAX_INDEX];
+} Kdll_DiskCache;
+
+//--------------------------------------------------------------
+// KernelDll_DiskCacheBlobHash - FNV-1a over 64 bit words in 4 interleaved lanes
+//                               (the byte wise KernelDll_SimpleHash takes ~2ms per MB
+//                               of component kernels, on every process start)
+//--------------------------------------------------------------
+static uint32_t KernelDll_DiskCacheBlobHash(const void *pData, int32_t iSize)
+{
+    static const uint64_t k = 0x100000001b3ULL;
+    uint64_t       lane[4]  = { 0xcbf29ce484222325ULL, 0xcbf29ce484222325ULL ^ 1, 0xcbf29ce484222325ULL ^ 2, 0xcbf29ce484222325ULL ^ 3 };
+    const uint8_t *p        = (const uint8_t *)pData;
+    uint64_t       word;
+    int32_t        i;
+
+    if (!pData || iSize <= 0)
+    {
+        return 0;
+    }
+
+    for (; iSize >= 32; iSize -= 32, p += 32)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            memcpy(&word, p + i * sizeof(word), sizeof(word));
+            lane[i] = (lane[i] ^ word) * k;
+        }
+    }
+
+    lane[0] ^= KernelDll_SimpleHash((void *)p, iSize);
+
+    return KernelDll_SimpleHash(lane, sizeof(lane));
+}
+
+//--------------------------------------------------------------
+// KernelDll_DiskCacheRuleTableHash - Hash of a rule table up to and including its EOF rule
+//--------------------------------------------------------------
+static uint32_t KernelDll_DiskCacheRuleTableHash(const Kdll_RuleEntry *pRules)
+{
+    int32_t iCount = 0;
+
+    if (!pRules)
+    {
+        return 0;
+    }
+
+    while (pRules[iCount++].id != RID_Op_EOF)
+    {
+    }
+
+    return KernelDll_SimpleHash((void *)pRules, iCount * (int32_t)sizeof(Kdll_RuleEntry));
+}
+
+//--------------------------------------------------------------
+// KernelDll_DiskCacheBinaryHash - Hash of everything a combined kernel depends on
+//--------------------------------------------------------------
+static uint32_t KernelDll_DiskCacheBinaryHash(Kdll_State *pState)
+{
+    uint32_t hash[8];
+
+    hash[0] = KernelDll_DiskCacheBlobHash(pState->ComponentKernelCache.pCache, pState->ComponentKernelCache.iCacheSize);
+    hash[1] = pState->bEnableCMFC ?
+              KernelDll_DiskCacheBlobHash(pState->CmFcPatchCache.pCache, pState->CmFcPatchCache.iCacheSize) : 0;
+    hash[2] = pState->pCustomKernelCache ?
+              KernelDll_DiskCacheBlobHash(pState->pCustomKernelCache->pCache, pState->pCustomKernelCache->iCacheSize) : 0;
+#ifdef MEDIA_VERSION
+    hash[3] = KernelDll_SimpleHash((void *)MEDIA_VERSION, (int32_t)strlen(MEDIA_VERSION));
+#else
+    hash[3] = 0;
+#endif
+#ifdef MEDIA_VERSION_DETAILS
+    hash[4] = KernelDll_SimpleHash((void *)MEDIA_VERSION_DETAILS, (int32_t)strlen(MEDIA_VERSION_DETAILS));
+#else
+    hash[4] = 0;
+#endif
+    hash[5] = KernelDll_DiskCacheRuleTableHash(pState->pRuleTableDefault);
+    hash[6] = KernelDll_DiskCacheRuleTableHash(pState->pRuleTableCustom);
+    hash[7] = pState->bEnableCMFC ? 1 : 0;
+
+    return KernelDll_SimpleHash(hash, sizeof(hash));
+}
+
+//--------------------------------------------------------------
+// KernelDll_GetDiskCache - Get disk cache state, set it up on first use
+//--------------------------------------------------------------
+static Kdll_DiskCache *KernelDll_GetDiskCache(Kdll_State *pState)
+{
+    Kdll_DiskCache *pCache = (Kdll_DiskCache *)pState->pDiskCache;
+    const char     *szDir;
+
+    if (pCache)
+    {
+        return pCache->bEnabled ? pCache : nullptr;
+    }
+
+    pCache = (Kdll_DiskCache *)MOS_AllocAndZeroMemory(sizeof(Kdll_DiskCache));
+    if (!pCache)
+    {
+        return nullptr;
+    }
+    pState->pDiskCache = pCache;
+
+    szDir = getenv("INTEL_MEDIA_KDLL_CACHE_DIR");
+    if (!szDir || !szDir[0] || !pState->ComponentKernelCache.pCache)
+    {
+        return nullptr;
+    }
+
+    pCache->dwBinaryHash = KernelDll_DiskCacheBinaryHash(pState);
+    if (snprintf(pCache->szPath, sizeof(pCache->szPath), "%s/kdll_%08x.bin", szDir, pCache->dwBinaryHash) >= (int)sizeof(pCache->szPath))
+    {
+        return nullptr;
+    }
+    pCache->bEnabled = true;
+
+    return pCache;
+}
+
+//--------------------------------------------------------------
+// KernelDll_MapDiskCache - Map the cache file and index its records
+//--------------------------------------------------------------
+static void KernelDll_MapDiskCache(Kdll_DiskCache *pCache)
+{
+    Kdll_DiskCacheHeader *pHeader;
+    Kdll_DiskCacheRecord *pRecord;
+    struct stat           st;
+    size_t                offset;
+    int                   fd;
+
+    pCache->bInitialized = true;
+
+    fd = open(pCache->szPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    // Records are appended under an exclusive lock, so every byte below the
+    // size seen under a shared lock belongs to a complete record
+    flock(fd, LOCK_SH);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Kdll_DiskCacheHeader))
+    {
+        close(fd);
+        return;
+    }
+    flock(fd, LOCK_UN);
+
+    pCache->pMapped = (uint8_t *)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pCache->pMapped == MAP_FAILED)
+    {
+        pCache->pMapped = nullptr;
+        return;
+    }
+    pCache->MappedSize = st.st_size;
+
+    pHeader = (Kdll_DiskCacheHeader *)pCache->pMapped;
+    if (pHeader->dwMagic           != KDLL_DISK_CACHE_MAGIC   ||
+        pHeader->dwVersion         != KDLL_DISK_CACHE_VERSION ||
+        pHeader->dwBinaryHash      != pCache->dwBinaryHash    ||
+        pHeader->dwFilterEntrySize != sizeof(Kdll_FilterEntry) ||
+        pHeader->dwCscParamsSize   != sizeof(Kdll_CSC_Params))
+    {
+        VPHAL_RENDER_NORMALMESSAGE("Kernel disk cache %s does not match this driver, ignored.", pCache->szPath);
+        munmap(pCache->pMapped, pCache->MappedSize);
+        pCache->pMapped    = nullptr;
+        pCache->MappedSize = 0;
+        return;
+    }
+
+    // Index valid records, stop at the first truncated or corrupted one
+    offset = sizeof(Kdll_DiskCacheHeader);
+    while (offset + sizeof(Kdll_DiskCacheRecord) <= pCache->MappedSize &&
+           pCache->iIndexCount < KDLL_DISK_CACHE_MAX_INDEX)
+    {
+        pRecord = (Kdll_DiskCacheRecord *)(pCache->pMapped + offset);
+        if (pRecord->dwSize < sizeof(Kdll_DiskCacheRecord) ||
+            pRecord->dwSize > pCache->MappedSize - offset ||
+            pRecord->iFilterSize < 1 || pRecord->iFilterSize > DL_MAX_SEARCH_FILTER_SIZE ||
+            pRecord->iModifiedFilterSize < 1 || pRecord->iModifiedFilterSize > DL_MAX_SEARCH_FILTER_SIZE ||
+            pRecord->iKernelSize < 1 || pRecord->iKernelSize > DL_MAX_KERNEL_SIZE ||
+            pRecord->dwSize != sizeof(Kdll_DiskCacheRecord) +
+                               (pRecord->iFilterSize + pRecord->iModifiedFilterSize) * sizeof(Kdll_FilterEntry) +
+                               sizeof(Kdll_CSC_Params) + pRecord->iKernelSize ||
+            pRecord->dwChecksum != KernelDll_SimpleHash(pRecord + 1, pRecord->dwSize - sizeof(Kdll_DiskCacheRecord)))
+        {
+            VPHAL_RENDER_NORMALMESSAGE("Kernel disk cache %s has an invalid record, later records ignored.", pCache->szPath);
+            break;
+        }
+
+        pCache->dwIndexHash[pCache->iIndexCount]   = pRecord->dwHash;
+        pCache->dwIndexOffset[pCache->iIndexCount] = (uint32_t)offset;
+        pCache->iIndexCount++;
+
+        offset += pRecord->dwSize;
+    }
+}
+
+//--------------------------------------------------------------
+// KernelDll_LoadDiskCachedKernel - Fill search state with a kernel from the disk cache
+//--------------------------------------------------------------
+bool KernelDll_LoadDiskCachedKernel(
+    Kdll_State       *pState,
+    Kdll_SearchState *pSearchState,
+    Kdll_FilterEntry *pFilter,
+    int32_t           iFilterSize,
+    uint32_t          dwHash)
+{
+    Kdll_DiskCache       *pCache;
+    Kdll_DiskCacheRecord *pRecord;
+    uint8_t              *ptr;
+    int32_t               i;
+
+    VPHAL_RENDER_FUNCTION_ENTER;
+
+    if (!pState || !pSearchState || !pFilter)
+    {
+        return false;
+    }
+
+    pCache = KernelDll_GetDiskCache(pState);
+    if (!pCache)
+    {
+        return false;
+    }
+
+    if (!pCache->bInitialized)
+    {
+        KernelDll_MapDiskCache(pCache);
+    }
+
+    for (i = 0; i < pCache->iIndexCount; i++)
+    {
+        if (pCache->dwIndexHash[i] != dwHash)
+        {
+            continue;
+        }
+
+        pRecord = (Kdll_DiskCacheRecord *)(pCache->pMapped + pCache->dwIndexOffset[i]);
+        ptr     = (uint8_t *)(pRecord + 1);
+        if (pRecord->iFilterSize != iFilterSize ||
+            memcmp(ptr, pFilter, iFilterSize * sizeof(Kdll_FilterEntry)) != 0)
+        {
+            continue;
+        }
+        ptr += iFilterSize * sizeof(Kdll_FilterEntry);
+
+        // Same output as KernelDll_SearchKernel + KernelDll_BuildKernel
+        pSearchState->iFilterSize = pRecord->iModifiedFilterSize;
+        MOS_SecureMemcpy(pSearchState->Filter, sizeof(pSearchState->Filter), ptr, pRecord->iModifiedFilterSize * sizeof(Kdll_FilterEntry));
+        ptr += pRecord->iModifiedFilterSize * sizeof(Kdll_FilterEntry);
+
+        MOS_SecureMemcpy(&pSearchState->CscParams, sizeof(Kdll_CSC_Params), ptr, sizeof(Kdll_CSC_Params));
+        ptr += sizeof(Kdll_CSC_Params);
+
+        pSearchState->KernelSize  = pRecord->iKernelSize;
+        pSearchState->KernelCount = 0;
+        MOS_SecureMemcpy(pSearchState->Kernel, sizeof(pSearchState->Kernel), ptr, pRecord->iKernelSize);
+
+        pState->colorfill_cspace = (VPHAL_CSPACE)pRecord->colorfill_cspace;
+
+        VPHAL_RENDER_NORMALMESSAGE("Combined kernel loaded from disk cache.");
+        return true;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------
+// KernelDll_CreateDiskCacheFile - Publish an empty cache file with its header
+//--------------------------------------------------------------
+static bool KernelDll_CreateDiskCacheFile(Kdll_DiskCache *pCache)
+{
+    Kdll_DiskCacheHeader header;
+    char                 szTemp[MOS_MAX_PATH_LENGTH + 1];
+    bool                 bWritten;
+    int                  fd;
+
+    if (snprintf(szTemp, sizeof(szTemp), "%s.%d.tmp", pCache->szPath, (int)getpid()) >= (int)sizeof(szTemp))
+    {
+        return false;
+    }
+
+    fd = open(szTemp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    MOS_ZeroMemory(&header, sizeof(header));
+    header.dwMagic           = KDLL_DISK_CACHE_MAGIC;
+    header.dwVersion         = KDLL_DISK_CACHE_VERSION;
+    header.dwBinaryHash      = pCache->dwBinaryHash;
+    header.dwFilterEntrySize = sizeof(Kdll_FilterEntry);
+    header.dwCscParamsSize   = sizeof(Kdll_CSC_Params);
+    bWritten = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+    close(fd);
+
+    // link() fails instead of replacing a file another process published first
+    if (bWritten && link(szTemp, pCache->szPath) != 0 && errno != EEXIST)
+    {
+        bWritten = false;
+    }
+    unlink(szTemp);
+
+    return bWritten;
+}
+
+//--------------------------------------------------------------
+// KernelDll_DiskCacheFindRecord - Check whether the locked cache file has a record
+//                                 for the filter, and count its records
+//--------------------------------------------------------------
+static bool KernelDll_DiskCacheFindRecord(
+    int                   fd,
+    size_t                fileSize,
+    Kdll_DiskCacheRecord *pNew,
+    Kdll_FilterEntry     *pFilter,
+    int32_t              *piCount)
+{
+    Kdll_DiskCacheRecord record;
+    Kdll_FilterEntry     filter[DL_MAX_SEARCH_FILTER_SIZE];
+    size_t               offset   = sizeof(Kdll_DiskCacheHeader);
+    size_t               fltBytes = pNew->iFilterSize * sizeof(Kdll_FilterEntry);
+
+    *piCount = 0;
+    while (offset + sizeof(record) <= fileSize &&
+           pread(fd, &record, sizeof(record), offset) == (ssize_t)sizeof(record) &&
+           record.dwSize >= sizeof(record) && record.dwSize <= fileSize - offset)
+    {
+        if (record.dwHash == pNew->dwHash &&
+            record.iFilterSize == pNew->iFilterSize &&
+            pread(fd, filter, fltBytes, offset + sizeof(record)) == (ssize_t)fltBytes &&
+            memcmp(filter, pFilter, fltBytes) == 0)
+        {
+            return true;
+        }
+
+        (*piCount)++;
+        offset += record.dwSize;
+    }
+
+    return false;
+}
+
+//--------------------------------------------------------------
+// KernelDll_StoreDiskCachedKernel - Append a built kernel to the disk cache
+//--------------------------------------------------------------
+void KernelDll_StoreDiskCachedKernel(
+    Kdll_State       *pState,
+    Kdll_SearchState *pSearchState,
+    Kdll_FilterEntry *pFilter,
+    int32_t           iFilterSize,
+    uint32_t          dwHash)
+{
+    Kdll_DiskCache       *pCache;
+    Kdll_DiskCacheRecord *pRecord;
+    uint8_t              *pData;
+    uint8_t              *ptr;
+    uint32_t              dwSize;
+    struct stat           st;
+    int                   fd;
+    int32_t               i;
+    int32_t               iCount;
+
+    VPHAL_RENDER_FUNCTION_ENTER;
+
+    if (!pState || !pSearchState || !pFilter || pSearchState->KernelSize <= 0)
+    {
+        return;
+    }
+
+    // Procamp coefficients depend on per process procamp versions, keep those kernels in memory only
+    for (i = 0; i < DL_CSC_MAX; i++)
+    {
+        if (pSearchState->CscParams.Matrix[i].bInUse &&
+            pSearchState->CscParams.Matrix[i].iProcampID != DL_PROCAMP_DISABLED)
+        {
+            return;
+        }
+    }
+
+    pCache = KernelDll_GetDiskCache(pState);
+    if (!pCache || pCache->iIndexCount >= KDLL_DISK_CACHE_MAX_INDEX)
+    {
+        return;
+    }
+
+    dwSize = sizeof(Kdll_DiskCacheRecord) +
+             (iFilterSize + pSearchState->iFilterSize) * sizeof(Kdll_FilterEntry) +
+             sizeof(Kdll_CSC_Params) + pSearchState->KernelSize;
+    pData = (uint8_t *)MOS_AllocAndZeroMemory(dwSize);
+    if (!pData)
+    {
+        return;
+    }
+
+    pRecord = (Kdll_DiskCacheRecord *)pData;
+    ptr     = (uint8_t *)(pRecord + 1);
+    MOS_SecureMemcpy(ptr, iFilterSize * sizeof(Kdll_FilterEntry), pFilter, iFilterSize * sizeof(Kdll_FilterEntry));
+    ptr += iFilterSize * sizeof(Kdll_FilterEntry);
+    MOS_SecureMemcpy(ptr, pSearchState->iFilterSize * sizeof(Kdll_FilterEntry), pSearchState->Filter, pSearchState->iFilterSize * sizeof(Kdll_FilterEntry));
+    ptr += pSearchState->iFilterSize * sizeof(Kdll_FilterEntry);
+    MOS_SecureMemcpy(ptr, sizeof(Kdll_CSC_Params), &pSearchState->CscParams, sizeof(Kdll_CSC_Params));
+    ptr += sizeof(Kdll_CSC_Params);
+    MOS_SecureMemcpy(ptr, pSearchState->KernelSize, pSearchState->Kernel, pSearchState->KernelSize);
+
+    pRecord->dwSize              = dwSize;
+    pRecord->dwHash              = dwHash;
+    pRecord->iFilterSize         = iFilterSize;
+    pRecord->iModifiedFilterSize = pSearchState->iFilterSize;
+    pRecord->iKernelSize         = pSearchState->KernelSize;
+    pRecord->colorfill_cspace    = pState->colorfill_cspace;
+    pRecord->dwChecksum          = KernelDll_SimpleHash(pRecord + 1, dwSize - sizeof(Kdll_DiskCacheRecord));
+
+    fd = open(pCache->szPath, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT && KernelDll_CreateDiskCacheFile(pCache))
+    {
+        fd = open(pCache->szPath, O_RDWR | O_APPEND | O_CLOEXEC);
+    }
+
+    if (fd >= 0)
+    {
+        // Another process may have stored the same kernel since the file was mapped
+        if (flock(fd, LOCK_EX) == 0 &&
+            fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Kdll_DiskCacheHeader) &&
+            !KernelDll_DiskCacheFindRecord(fd, st.st_size, pRecord, pFilter, &iCount) &&
+            iCount < KDLL_DISK_CACHE_MAX_INDEX)
+        {
+            if (write(fd, pData, dwSize) != (ssize_t)dwSize)
+            {
+                // Drop a partial record, it would hide every record appended after it
+                VPHAL_RENDER_NORMALMESSAGE("Failed to write kernel disk cache record.");
+                if (ftruncate(fd, st.st_size) != 0)
+                {
+                    VPHAL_RENDER_NORMALMESSAGE("Failed to truncate kernel disk cache %s.", pCache->szPath);
+                }
+            }
+        }
+        close(fd);
+    }
+    else
+    {
+        VPHAL_RENDER_NORMALMESSAGE("Failed to open kernel disk cache %s.", pCache->szPath);
+    }
+
+    MOS_FreeMemory(pData);
+}
+
+//--------------------------------------------------------------
+// KernelDll_ReleaseDiskCache - Unmap and free the disk cache state
+//--------------------------------------------------------------
+void KernelDll_ReleaseDiskCache(Kdll_State *pState)
+{
+    Kdll_DiskCache *pCache;
+
+    if (!pState || !pState->pDiskCache)
+    {
+        return;
+    }
+
+    pCache = (Kdll_DiskCache *)pState->pDiskCache;
+    if (pCache->pMapped)
+    {
+        munmap(pCache->pMapped, pCache->MappedSize);
+    }
+    MOS_FreeMemory(pCache);
+    pState->pDiskCache = nullptr;
+}
@@ -19,6 +19,7 @@
 # OTHER DEALINGS IN THE SOFTWARE.
 
 set(TMP_SOURCES_
+    ${CMAKE_CURRENT_LIST_DIR}/hal_kerneldll_specific.c
     ${CMAKE_CURRENT_LIST_DIR}/vphal_common_specific.c
     ${CMAKE_CURRENT_LIST_DIR}/vphal_render_common_specific.c
 )
@@ -44,12 +44,6 @@ public:
         return;
     }
 
-    virtual VAStatus Init()
-    {
-        LoadProfileEntrypoints();
-        return VA_STATUS_SUCCESS;
-    }
-
     virtual VAStatus QueryImageFormats(VAImageFormat *formatList, int32_t *num_formats);
 
     virtual uint32_t GetImageFormatsMaxNum();
@@ -69,7 +63,9 @@ protected:
             VAConfigAttribType type,
             unsigned int *value);
 
-    virtual VAStatus LoadProfileEntrypoints();
+    virtual VAStatus LoadDecodeProfileEntrypoints();
+    virtual VAStatus LoadEncodeProfileEntrypoints();
+    virtual VAStatus LoadVpProfileEntrypoints();
     virtual VAStatus LoadVp9EncProfileEntrypoints();
     virtual VAStatus CheckEncodeResolution(
             VAProfile profile,
@@ -32,7 +32,7 @@
 MediaLibvaCapsG10Cnl::MediaLibvaCapsG10Cnl(DDI_MEDIA_CONTEXT *mediaCtx) : MediaLibvaCapsG10(mediaCtx)
 {
     // CNL supported Encode format
-    static struct EncodeFormatTable encodeFormatTableCNL[] =
+    static constexpr struct EncodeFormatTable encodeFormatTableCNL[] =
     {
         {AVC, DualPipe, VA_RT_FORMAT_YUV420},
         {AVC, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV422 | VA_RT_FORMAT_YUV444},
@@ -41,7 +41,7 @@ MediaLibvaCapsG10Cnl::MediaLibvaCapsG10Cnl(DDI_MEDIA_CONTEXT *mediaCtx) : MediaL
         {VP9, DualPipe, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV420_10BPP},
         {VP9, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV420_10BPP | VA_RT_FORMAT_YUV422 | VA_RT_FORMAT_YUV444 |VA_RT_FORMAT_RGB32 | VA_RT_FORMAT_RGB32_10BPP},
     };
-    m_encodeFormatTable = (struct EncodeFormatTable*)(&encodeFormatTableCNL[0]);
+    m_encodeFormatTable = &encodeFormatTableCNL[0];
     m_encodeFormatCount = sizeof(encodeFormatTableCNL)/sizeof(struct EncodeFormatTable);
 
     return;
@@ -42,7 +42,7 @@ public:
     MediaLibvaCapsG11(DDI_MEDIA_CONTEXT *mediaCtx) : MediaLibvaCaps(mediaCtx)
     {
         // ICL supported Encode format
-        static struct EncodeFormatTable encodeFormatTableICL[] =
+        static constexpr struct EncodeFormatTable encodeFormatTableICL[] =
         {
             {AVC, DualPipe, VA_RT_FORMAT_YUV420},
             {AVC, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV422 | VA_RT_FORMAT_YUV444},
@@ -50,18 +50,12 @@ public:
             {HEVC, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV420_10BPP | VA_RT_FORMAT_YUV444 | VA_RT_FORMAT_YUV444_10 | VA_RT_FORMAT_RGB32 | VA_RT_FORMAT_RGB32_10BPP},
             {VP9, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV420_10BPP | VA_RT_FORMAT_YUV444 | VA_RT_FORMAT_YUV444_10 | VA_RT_FORMAT_RGB32 | VA_RT_FORMAT_RGB32_10BPP},
         };
-        m_encodeFormatTable = (struct EncodeFormatTable*)(&encodeFormatTableICL[0]);
+        m_encodeFormatTable = &encodeFormatTableICL[0];
         m_encodeFormatCount = sizeof(encodeFormatTableICL)/sizeof(struct EncodeFormatTable);
 
         return;
     }
 
-    //!
-    virtual VAStatus Init() override
-    {
-        return LoadProfileEntrypoints();
-    }
-
     virtual VAStatus QueryImageFormats(VAImageFormat *formatList, int32_t *num_formats) override;
 
     virtual uint32_t GetImageFormatsMaxNum() override;
@@ -174,7 +168,9 @@ protected:
             VAConfigAttribType type,
             unsigned int *value) override;
 
-    virtual VAStatus LoadProfileEntrypoints() override;
+    virtual VAStatus LoadDecodeProfileEntrypoints() override;
+    virtual VAStatus LoadEncodeProfileEntrypoints() override;
+    virtual VAStatus LoadVpProfileEntrypoints() override;
     virtual VAStatus LoadVp9EncProfileEntrypoints() override;
     virtual VAStatus LoadHevcEncProfileEntrypoints() override;
 
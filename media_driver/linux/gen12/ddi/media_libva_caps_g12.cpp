@@ -766,44 +766,57 @@ VAStatus MediaLibvaCapsG12::LoadVp9EncProfileEntrypoints()
     return status;
 }
 
-VAStatus MediaLibvaCapsG12::LoadProfileEntrypoints()
+VAStatus MediaLibvaCapsG12::LoadDecodeProfileEntrypoints()
 {
     VAStatus status = VA_STATUS_SUCCESS;
     status = LoadAvcDecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadAvcEncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadAvcEncLpProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadMpeg2DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadMpeg2EncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVc1DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadJpegDecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadJpegEncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadHevcDecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadVp8DecProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadVp9DecProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadAv1DecProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    return status;
+}
+
+VAStatus MediaLibvaCapsG12::LoadEncodeProfileEntrypoints()
+{
+    VAStatus status = VA_STATUS_SUCCESS;
+    status = LoadAvcEncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadAvcEncLpProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadMpeg2EncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadJpegEncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadHevcEncProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadHevcEncLpProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadVp8DecProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVp8EncProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadVp9DecProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVp9EncProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadAv1DecProfileEntrypoints();
+    status = LoadNoneEncProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
+    return status;
+}
+
+VAStatus MediaLibvaCapsG12::LoadVpProfileEntrypoints()
+{
+    VAStatus status = VA_STATUS_SUCCESS;
     status = LoadNoneProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-
     return status;
 }
 
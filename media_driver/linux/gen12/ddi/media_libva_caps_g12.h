@@ -43,7 +43,7 @@ public:
     MediaLibvaCapsG12(DDI_MEDIA_CONTEXT *mediaCtx) : MediaLibvaCaps(mediaCtx)
     {
         // TGL supported Encode format
-        static struct EncodeFormatTable encodeFormatTableTGL[] =
+        static constexpr struct EncodeFormatTable encodeFormatTableTGL[] =
         {
             {AVC, DualPipe, VA_RT_FORMAT_YUV420},
             {AVC, Vdenc, VA_RT_FORMAT_YUV420 | VA_RT_FORMAT_YUV422 | VA_RT_FORMAT_YUV444},
@@ -56,17 +56,11 @@ public:
              VA_RT_FORMAT_YUV444 | VA_RT_FORMAT_YUV444_10 | VA_RT_FORMAT_RGB32 |
              VA_RT_FORMAT_RGB32_10BPP},
         };
-        m_encodeFormatTable = (struct EncodeFormatTable*)(&encodeFormatTableTGL[0]);
+        m_encodeFormatTable = &encodeFormatTableTGL[0];
         m_encodeFormatCount = sizeof(encodeFormatTableTGL)/sizeof(struct EncodeFormatTable);
         return;
     }
 
-    //!
-    virtual VAStatus Init() override
-    {
-        return LoadProfileEntrypoints();
-    }
-
     virtual VAStatus QueryImageFormats(VAImageFormat *formatList, int32_t *num_formats) override;
 
     virtual uint32_t GetImageFormatsMaxNum() override;
@@ -215,7 +209,9 @@ protected:
                                                VAConfigAttribType type,
                                                unsigned int *value) override;
 
-    virtual VAStatus LoadProfileEntrypoints() override;
+    virtual VAStatus LoadDecodeProfileEntrypoints() override;
+    virtual VAStatus LoadEncodeProfileEntrypoints() override;
+    virtual VAStatus LoadVpProfileEntrypoints() override;
     virtual VAStatus LoadJpegDecProfileEntrypoints();
     virtual VAStatus LoadVp9EncProfileEntrypoints() override;
     virtual VAStatus LoadHevcEncProfileEntrypoints() override;
@@ -231,31 +231,47 @@ VAStatus MediaLibvaCapsG8::GetPlatformSpecificAttrib(
     return status;
 }
 
-VAStatus MediaLibvaCapsG8::LoadProfileEntrypoints()
+VAStatus MediaLibvaCapsG8::LoadDecodeProfileEntrypoints()
 {
     VAStatus status = VA_STATUS_SUCCESS;
     status = LoadAvcDecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadAvcEncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadMpeg2DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadMpeg2EncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVc1DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadJpegDecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadJpegEncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVp8DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
-    status = LoadVp8EncProfileEntrypoints();
-    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVp9DecProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
+    return status;
+}
+
+VAStatus MediaLibvaCapsG8::LoadEncodeProfileEntrypoints()
+{
+    VAStatus status = VA_STATUS_SUCCESS;
+    status = LoadAvcEncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadMpeg2EncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadJpegEncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+    status = LoadVp8EncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
     status = LoadVp9EncProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
+#if !defined(_FULL_OPEN_SOURCE) && defined(ENABLE_KERNELS)
+    status = LoadNoneEncProfileEntrypoints();
+    DDI_CHK_RET(status, "Failed to initialize Caps!");
+#endif
+    return status;
+}
+
+VAStatus MediaLibvaCapsG8::LoadVpProfileEntrypoints()
+{
+    VAStatus status = VA_STATUS_SUCCESS;
 #if !defined(_FULL_OPEN_SOURCE) && defined(ENABLE_KERNELS)
     status = LoadNoneProfileEntrypoints();
     DDI_CHK_RET(status, "Failed to initialize Caps!");
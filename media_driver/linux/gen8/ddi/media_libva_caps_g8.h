@@ -41,7 +41,6 @@ public:
     //!
     MediaLibvaCapsG8(DDI_MEDIA_CONTEXT *mediaCtx) : MediaLibvaCaps(mediaCtx)
     {
-        LoadProfileEntrypoints();
         return;
     }
 
@@ -60,13 +59,29 @@ protected:
             VAConfigAttribType type,
             uint32_t *value);
 
-    //! 
-    //! \brief  Load profile entry points
-    //! 
+    //!
+    //! \brief  Load decode profile entry points
+    //!
+    //! \return VAStatus
+    //!     Return VA_STATUS_SUCCESS if call success, else fail reason
+    //!
+    virtual VAStatus LoadDecodeProfileEntrypoints();
+
+    //!
+    //! \brief  Load encode profile entry points
+    //!
+    //! \return VAStatus
+    //!     Return VA_STATUS_SUCCESS if call success, else fail reason
+    //!
+    virtual VAStatus LoadEncodeProfileEntrypoints();
+
+    //!
+    //! \brief  Load video processing profile entry points
+    //!
     //! \return VAStatus
     //!     Return VA_STATUS_SUCCESS if call success, else fail reason
     //!
-    VAStatus LoadProfileEntrypoints();
+    virtual VAStatus LoadVpProfileEntrypoints();
 
     //! 
     //! \brief  Query AVC ROI maximum number
@@ -44,12 +44,6 @@ public:
         return;
     }
 
-    virtual VAStatus Init()
-    {
-        LoadProfileEntrypoints();
-        return VA_STATUS_SUCCESS;
-    }
-
     virtual VAStatus QueryImageFormats(VAImageFormat *formatList, int32_t *num_formats);
 
     virtual uint32_t GetImageFormatsMaxNum();
@@ -64,13 +58,29 @@ protected:
             VAConfigAttribType type,
             unsigned int *value);
 
-    //! 
-    //! \brief  Load profile entry points
-    //! 
+    //!
+    //! \brief  Load decode profile entry points
+    //!
+    //! \return VAStatus
+    //!     Return VA_STATUS_SUCCESS if call success, else fail reason
+    //!
+    virtual VAStatus LoadDecodeProfileEntrypoints();
+
+    //!
+    //! \brief  Load encode profile entry points
+    //!
+    //! \return VAStatus
+    //!     Return VA_STATUS_SUCCESS if call success, else fail reason
+    //!
+    virtual VAStatus LoadEncodeProfileEntrypoints();
+
+    //!
+    //! \brief  Load video processing profile entry points
+    //!
     //! \return VAStatus
     //!     Return VA_STATUS_SUCCESS if call success, else fail reason
     //!
-    VAStatus LoadProfileEntrypoints();
+    virtual VAStatus LoadVpProfileEntrypoints();
 
     //! 
     //! \brief  Query AVC ROI maximum number
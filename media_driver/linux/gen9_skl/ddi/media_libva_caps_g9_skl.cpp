@@ -32,13 +32,13 @@
 MediaLibvaCapsG9Skl::MediaLibvaCapsG9Skl(DDI_MEDIA_CONTEXT *mediaCtx) : MediaLibvaCapsG9(mediaCtx)
 {
     // SKL supported Encode format
-    static struct EncodeFormatTable encodeFormatTableSKL[] =
+    static constexpr struct EncodeFormatTable encodeFormatTableSKL[] =
     {
         {AVC, DualPipe, VA_RT_FORMAT_YUV420},
         {AVC, Vdenc, VA_RT_FORMAT_YUV420},
         {HEVC, DualPipe, VA_RT_FORMAT_YUV420},
     };
-    m_encodeFormatTable = (struct EncodeFormatTable*)(&encodeFormatTableSKL[0]);
+    m_encodeFormatTable = &encodeFormatTableSKL[0];
     m_encodeFormatCount = sizeof(encodeFormatTableSKL)/sizeof(struct EncodeFormatTable);
 
     return;
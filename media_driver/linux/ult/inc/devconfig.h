@@ -75,6 +75,25 @@ struct DeviceConfig
 
 typedef struct DeviceConfig DeviceConfig_t;
 
+//!
+//! \brief GEM object emulation of the mock drmIoctl
+//! \details Off by default, so the mock only answers the queries above. When
+//!          enabled, GEM_CREATE/MMAP/EXECBUFFER2/WAIT/BUSY behave like a
+//!          null GPU that finishes every batch execLatencyUs after submit,
+//!          and execbuffer2 out-fences are timerfds that fire at that time.
+//!          Used by ULTs that link the real mos_bufmgr.
+//!
+struct DrmMockGem
+{
+    bool     enabled;
+    bool     hasExecFence;     // I915_PARAM_HAS_EXEC_FENCE
+    uint32_t execLatencyUs;    // batch duration on the mock GPU
+    uint32_t ioctlCount;       // ioctls handled while enabled
+    uint32_t waitCount;        // DRM_IOCTL_I915_GEM_WAIT calls
+};
+
+extern DrmMockGem g_drmMockGem;
+
 typedef enum
 {
     igfxSKLAKE     = 0,
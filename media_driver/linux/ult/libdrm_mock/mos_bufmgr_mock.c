@@ -1403,7 +1403,7 @@ mos_gem_cleanup_bo_cache(struct mos_bufmgr_gem *bufmgr_gem, time_t time)
 }
 
 drm_export void
-mos_gem_bo_unreference_final(struct mos_linux_bo *bo, time_t time)
+mos_gem_bo_unreference_final(struct mos_linux_bo *bo, uint64_t time)
 {
     struct mos_bufmgr_gem *bufmgr_gem = (struct mos_bufmgr_gem *) bo->bufmgr;
     struct mos_bo_gem *bo_gem = (struct mos_bo_gem *) bo;
@@ -53,6 +53,8 @@
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <stdarg.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
 #ifdef HAVE_SYS_MKDEV_H
 # include <sys/mkdev.h> /* defines major(), minor(), and makedev() on Solaris */
 #endif
@@ -177,10 +179,167 @@ drmIoctl(int fd, unsigned long request, void *arg)
 }
 #else
 #include "devconfig.h"
+
+DrmMockGem g_drmMockGem = {};
+
+/* Only handles exist on the mock GPU, plus when each stops being busy */
+#define MOCK_GEM_MAX_HANDLES    (1 << 16)
+static uint64_t mock_gem_busy_until[MOCK_GEM_MAX_HANDLES];
+static uint32_t mock_gem_next_handle;
+
+static uint64_t mock_gem_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t *mock_gem_busy_slot(uint32_t handle)
+{
+    return &mock_gem_busy_until[handle & (MOCK_GEM_MAX_HANDLES - 1)];
+}
+
+static void mock_gem_sleep_until(uint64_t ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        ;
+}
+
+/* Returns true when the request is one the GEM emulation answers */
+static bool
+mock_gem_ioctl(int fd, unsigned long request, void *arg, int *ret)
+{
+    *ret = 0;
+    switch (request)
+    {
+        case DRM_IOCTL_I915_GETPARAM:
+        {
+            drm_i915_getparam_t *gp = (drm_i915_getparam_t *)arg;
+            if (gp->param != I915_PARAM_HAS_EXEC_FENCE)
+                return false;
+            *(int *)(gp->value) = g_drmMockGem.hasExecFence;
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_CREATE:
+        {
+            struct drm_i915_gem_create *create = (struct drm_i915_gem_create *)arg;
+            create->handle = __atomic_add_fetch(&mock_gem_next_handle, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(mock_gem_busy_slot(create->handle), 0, __ATOMIC_RELAXED);
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_MMAP:
+        {
+            struct drm_i915_gem_mmap *mmap_arg = (struct drm_i915_gem_mmap *)arg;
+            void *ptr = mmap(nullptr, mmap_arg->size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+            {
+                errno = ENOMEM;
+                *ret = -1;
+                break;
+            }
+            mmap_arg->addr_ptr = (uintptr_t)ptr;
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_MADVISE:
+        {
+            struct drm_i915_gem_madvise *madv = (struct drm_i915_gem_madvise *)arg;
+            madv->retained = 1;
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_SET_TILING:
+        {
+            struct drm_i915_gem_set_tiling *tiling = (struct drm_i915_gem_set_tiling *)arg;
+            tiling->swizzle_mode = I915_BIT_6_SWIZZLE_NONE;
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_GET_TILING:
+        {
+            struct drm_i915_gem_get_tiling *tiling = (struct drm_i915_gem_get_tiling *)arg;
+            tiling->tiling_mode  = I915_TILING_NONE;
+            tiling->swizzle_mode = I915_BIT_6_SWIZZLE_NONE;
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_EXECBUFFER2:
+        case DRM_IOCTL_I915_GEM_EXECBUFFER2_WR:
+        {
+            struct drm_i915_gem_execbuffer2 *execbuf = (struct drm_i915_gem_execbuffer2 *)arg;
+            struct drm_i915_gem_exec_object2 *objects =
+                (struct drm_i915_gem_exec_object2 *)(uintptr_t)execbuf->buffers_ptr;
+            uint64_t done = mock_gem_now_ns() + (uint64_t)g_drmMockGem.execLatencyUs * 1000;
+            uint32_t i;
+
+            for (i = 0; i < execbuf->buffer_count; i++)
+                __atomic_store_n(mock_gem_busy_slot(objects[i].handle), done, __ATOMIC_RELEASE);
+
+            if (execbuf->flags & I915_EXEC_FENCE_OUT)
+            {
+                struct itimerspec its = {};
+                int fence = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+                its.it_value.tv_sec  = done / 1000000000ull;
+                its.it_value.tv_nsec = done % 1000000000ull;
+                if (fence < 0 || timerfd_settime(fence, TFD_TIMER_ABSTIME, &its, nullptr))
+                {
+                    if (fence >= 0)
+                        close(fence);
+                    *ret = -1;
+                    break;
+                }
+                execbuf->rsvd2 = (execbuf->rsvd2 & 0xffffffffull) | ((uint64_t)fence << 32);
+            }
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_WAIT:
+        {
+            struct drm_i915_gem_wait *wait = (struct drm_i915_gem_wait *)arg;
+            uint64_t until = __atomic_load_n(mock_gem_busy_slot(wait->bo_handle), __ATOMIC_ACQUIRE);
+            uint64_t now   = mock_gem_now_ns();
+
+            __atomic_add_fetch(&g_drmMockGem.waitCount, 1, __ATOMIC_RELAXED);
+            if (until > now && wait->timeout_ns >= 0 && until - now > (uint64_t)wait->timeout_ns)
+            {
+                mock_gem_sleep_until(now + wait->timeout_ns);
+                wait->timeout_ns = 0;
+                errno = ETIME;
+                *ret = -1;
+                break;
+            }
+            if (until > now)
+                mock_gem_sleep_until(until);
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_BUSY:
+        {
+            struct drm_i915_gem_busy *busy = (struct drm_i915_gem_busy *)arg;
+            busy->busy = __atomic_load_n(mock_gem_busy_slot(busy->handle), __ATOMIC_ACQUIRE) >
+                         mock_gem_now_ns();
+        }
+        break;
+        case DRM_IOCTL_I915_GEM_SET_DOMAIN:
+        case DRM_IOCTL_I915_GEM_SW_FINISH:
+        case DRM_IOCTL_GEM_CLOSE:
+            break;
+        default:
+            return false;
+    }
+
+    __atomic_add_fetch(&g_drmMockGem.ioctlCount, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
 int
 mosdrmIoctl(int fd, unsigned long request, void *arg)
 {
     int    ret;
+
+    if (g_drmMockGem.enabled && mock_gem_ioctl(fd, request, arg, &ret))
+        return ret;
 #if 1
     int DevIdx=fd-1;//use fd to get DevIdx
     switch (request)
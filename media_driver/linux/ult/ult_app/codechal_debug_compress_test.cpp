@@ -0,0 +1,193 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "codechal_debug_compress.h"
+
+using namespace std;
+
+static uint32_t Read32(const vector<uint8_t> &frame, size_t pos)
+{
+    return frame[pos] | (frame[pos + 1] << 8) | (frame[pos + 2] << 16) | ((uint32_t)frame[pos + 3] << 24);
+}
+
+// Reference LZ4 frame decoder, returns false on any format violation
+static bool DecodeLz4Frame(const vector<uint8_t> &frame, vector<uint8_t> &out)
+{
+    out.clear();
+    if (frame.size() < 11 || Read32(frame, 0) != 0x184d2204 || frame[4] != 0x60 || frame[5] != 0x70)
+    {
+        return false;
+    }
+
+    size_t pos = 7;
+    while (pos + 4 <= frame.size())
+    {
+        uint32_t blockSize = Read32(frame, pos);
+        pos += 4;
+        if (blockSize == 0)
+        {
+            return pos == frame.size();
+        }
+
+        bool raw = (blockSize & 0x80000000) != 0;
+        blockSize &= 0x7fffffff;
+        if (blockSize > CodechalDebugCompress::m_lz4BlockSize || pos + blockSize > frame.size())
+        {
+            return false;
+        }
+        if (raw)
+        {
+            out.insert(out.end(), frame.begin() + pos, frame.begin() + pos + blockSize);
+            pos += blockSize;
+            continue;
+        }
+
+        size_t blockStart = out.size();
+        size_t end        = pos + blockSize;
+        while (pos < end)
+        {
+            uint8_t token   = frame[pos++];
+            size_t  literal = token >> 4;
+            if (literal == 15)
+            {
+                uint8_t b;
+                do
+                {
+                    b = frame[pos++];
+                    literal += b;
+                } while (b == 255 && pos < end);
+            }
+            if (pos + literal > end)
+            {
+                return false;
+            }
+            out.insert(out.end(), frame.begin() + pos, frame.begin() + pos + literal);
+            pos += literal;
+            if (pos == end)
+            {
+                break;
+            }
+
+            size_t distance = frame[pos] | (frame[pos + 1] << 8);
+            pos += 2;
+            size_t match = (token & 15) + 4;
+            if ((token & 15) == 15)
+            {
+                uint8_t b;
+                do
+                {
+                    b = frame[pos++];
+                    match += b;
+                } while (b == 255 && pos < end);
+            }
+            if (distance == 0 || distance > out.size() - blockStart)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < match; i++)
+            {
+                out.push_back(out[out.size() - distance]);
+            }
+        }
+    }
+    return false;
+}
+
+static void RoundTrip(const vector<uint8_t> &data, size_t *compressedSize = nullptr)
+{
+    vector<uint8_t> frame, out;
+    CodechalDebugCompress::Lz4Frame(data.data(), data.size(), frame);
+    ASSERT_TRUE(DecodeLz4Frame(frame, out));
+    ASSERT_EQ(data, out);
+    if (compressedSize)
+    {
+        *compressedSize = frame.size();
+    }
+}
+
+TEST(CodechalDebugCompressTest, SmallInputs)
+{
+    for (size_t size = 0; size < 64; size++)
+    {
+        RoundTrip(vector<uint8_t>(size, 0));
+        vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = (uint8_t)(i * 7);
+        }
+        RoundTrip(data);
+    }
+}
+
+TEST(CodechalDebugCompressTest, LongRunsAndLiterals)
+{
+    mt19937         rng(0x5eed);
+    vector<uint8_t> data;
+
+    // Runs and literal stretches longer than 15 and 270 exercise the length bytes
+    for (int i = 0; i < 200; i++)
+    {
+        size_t run = rng() % 1000;
+        data.insert(data.end(), run, (uint8_t)rng());
+        size_t literals = rng() % 600;
+        for (size_t j = 0; j < literals; j++)
+        {
+            data.push_back((uint8_t)rng());
+        }
+    }
+
+    size_t compressedSize = 0;
+    RoundTrip(data, &compressedSize);
+    EXPECT_LT(compressedSize, data.size());
+}
+
+TEST(CodechalDebugCompressTest, MultipleBlocks)
+{
+    // A mostly flat NV12-like surface spanning three blocks
+    size_t          size = CodechalDebugCompress::m_lz4BlockSize * 2 + 12345;
+    vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)((i % 4096) < 1920 ? (i / 4096) & 0xff : 0x80);
+    }
+
+    size_t compressedSize = 0;
+    RoundTrip(data, &compressedSize);
+    EXPECT_LT(compressedSize, size / 8);
+}
+
+TEST(CodechalDebugCompressTest, Incompressible)
+{
+    mt19937         rng(1);
+    vector<uint8_t> data(1 << 20);
+    for (auto &b : data)
+    {
+        b = (uint8_t)rng();
+    }
+
+    // Stored raw: header, one block size, end mark
+    size_t compressedSize = 0;
+    RoundTrip(data, &compressedSize);
+    EXPECT_EQ(data.size() + 15, compressedSize);
+}
@@ -19,10 +19,26 @@
 * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 * OTHER DEALINGS IN THE SOFTWARE.
 */
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
 #include "ddi_test_encode.h"
 
 using namespace std;
 
+// Resident set size of this process in KB, 0 if it can't be read
+static int64_t GetRssKb()
+{
+    int64_t  size = 0;
+    int64_t  resident = 0;
+    ifstream statm("/proc/self/statm");
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
 TEST_F(MediaEncodeDdiTest, EncodeHEVC_DualPipe)
 {
     m_GpuCmdFactory = g_gpuCmdFactoryEncodeHevcDualPipe;
@@ -39,6 +55,34 @@ TEST_F(MediaEncodeDdiTest, EncodeAVC_DualPipe)
     delete pEncData;
 }
 
+TEST_F(MediaEncodeDdiTest, EncodeAVC_StartupTime)
+{
+    EncTestData *pEncData = m_encTestFactory.GetEncTestData("AVC-DualPipe");
+    vector<Platform_t> platforms = m_driverLoader.GetPlatforms();
+    for (int i = 0; i < m_driverLoader.GetPlatformNum(); i++)
+    {
+        if (m_encTestCfg.IsEncTestEnabled(DeviceConfigTable[platforms[i]],
+            pEncData->GetFeatureID()))
+        {
+            MeasureStartup(pEncData, platforms[i]);
+        }
+    }
+    delete pEncData;
+}
+
+TEST_F(MediaEncodeDdiTest, EncodeAVC_MfeSubmit)
+{
+    // Platforms without MFE support are skipped by MeasureMfeSubmit
+    vector<Platform_t> platforms = m_driverLoader.GetPlatforms();
+    for (int i = 0; i < m_driverLoader.GetPlatformNum(); i++)
+    {
+        for (uint32_t streamNum : {1, 4, 8, 16})
+        {
+            MeasureMfeSubmit(platforms[i], streamNum);
+        }
+    }
+}
+
 void MediaEncodeDdiTest::ExectueEncodeTest(EncTestData *pEncData)
 {
     vector<Platform_t> platforms = m_driverLoader.GetPlatforms();
@@ -152,6 +196,276 @@ void MediaEncodeDdiTest::EncodeExecute(EncTestData *pEncData, Platform_t platfor
         << ", Failed function = m_driverLoader.CloseDriver" << endl;
 }
 
+void MediaEncodeDdiTest::MeasureStartup(EncTestData *pEncData, Platform_t platform)
+{
+    const int       iterations = 10;
+    double          totalMs    = 0;
+    double          minMs      = 0;
+    double          initMs     = 0;
+    int64_t         initRssKb  = 0;
+    VAConfigID      config_id;
+    VAContextID     context_id;
+
+    for (int n = 0; n < iterations; n++)
+    {
+        // vaInitialize plus what an encoder does before its first frame
+        int64_t rssKb = GetRssKb();
+        auto    start = chrono::steady_clock::now();
+
+        int ret = m_driverLoader.InitDriver(platform);
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.InitDriver" << endl;
+
+        initMs    += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        initRssKb += GetRssKb() - rssKb;
+
+        ret = m_driverLoader.m_ctx.vtable->vaCreateConfig(&m_driverLoader.m_ctx,
+            pEncData->GetFeatureID().profile, pEncData->GetFeatureID().entrypoint,
+            (VAConfigAttrib *)&(pEncData->GetConfAttrib()[0]), pEncData->GetConfAttrib().size(), &config_id);
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateConfig" << endl;
+
+        vector<VASurfaceID> &resources = pEncData->GetResources();
+        ret = m_driverLoader.m_ctx.vtable->vaCreateSurfaces2(&m_driverLoader.m_ctx, VA_RT_FORMAT_YUV420,
+            pEncData->GetWidth(), pEncData->GetHeight(), &resources[0], resources.size(),
+            (VASurfaceAttrib *)&(pEncData->GetSurfAttrib()[0]), pEncData->GetSurfAttrib().size());
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateSurfaces2" << endl;
+
+        ret = m_driverLoader.m_ctx.vtable->vaCreateContext(&m_driverLoader.m_ctx, config_id, pEncData->GetWidth(),
+            pEncData->GetHeight(), VA_PROGRESSIVE, &resources[0], resources.size(), &context_id);
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateContext" << endl;
+
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        totalMs += ms;
+        minMs    = (n == 0 || ms < minMs) ? ms : minMs;
+
+        m_driverLoader.m_ctx.vtable->vaDestroyContext(&m_driverLoader.m_ctx, context_id);
+        m_driverLoader.m_ctx.vtable->vaDestroySurfaces(&m_driverLoader.m_ctx, &resources[0], resources.size());
+        m_driverLoader.m_ctx.vtable->vaDestroyConfig(&m_driverLoader.m_ctx, config_id);
+
+        ret = m_driverLoader.CloseDriver();
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.CloseDriver" << endl;
+    }
+
+    cout << "Platform = " << g_platformName[platform] << ", startup to AVC encode context: avg "
+         << totalMs / iterations << " ms, min " << minMs << " ms over " << iterations << " runs" << endl;
+
+    // Compare these against a build without lazy caps loading
+    string name = g_platformName[platform];
+    RecordProperty("InitUs_" + name, (int)(initMs * 1000 / iterations));
+    RecordProperty("InitRssKb_" + name, (int)(initRssKb / iterations));
+    RecordProperty("StartupUs_" + name, (int)(totalMs * 1000 / iterations));
+}
+
+// Releases what MeasureMfeSubmit created, also when an ASSERT returns early
+class MfeSubmitResources
+{
+public:
+    MfeSubmitResources(DriverDllLoader &driverLoader) : m_driverLoader(driverLoader)
+    {
+    }
+
+    ~MfeSubmitResources()
+    {
+        Release();
+        if (m_driverOpen)
+        {
+            m_driverLoader.CloseDriver();
+        }
+    }
+
+    void Release()
+    {
+        VADriverContextP ctx    = &m_driverLoader.m_ctx;
+        VADriverVTable   *vtable = ctx->vtable;
+
+        for (auto buffer : m_buffers)
+        {
+            vtable->vaDestroyBuffer(ctx, buffer);
+        }
+        for (size_t s = 0; s < m_contexts.size(); s++)
+        {
+            if (s < m_addedContexts)
+            {
+                vtable->vaMFReleaseContext(ctx, m_mfeId, m_contexts[s]);
+            }
+            vtable->vaDestroyContext(ctx, m_contexts[s]);
+        }
+        for (size_t s = 0; s < m_streams.size(); s++)
+        {
+            if (s < m_surfaceStreams)
+            {
+                vector<VASurfaceID> &resources = m_streams[s]->GetResources();
+                vtable->vaDestroySurfaces(ctx, &resources[0], resources.size());
+            }
+            delete m_streams[s];
+        }
+        if (m_mfeCreated)
+        {
+            vtable->vaDestroyContext(ctx, m_mfeId);
+        }
+        if (m_configCreated)
+        {
+            vtable->vaDestroyConfig(ctx, m_configId);
+        }
+
+        m_buffers.clear();
+        m_contexts.clear();
+        m_streams.clear();
+        m_addedContexts  = 0;
+        m_surfaceStreams = 0;
+        m_mfeCreated     = false;
+        m_configCreated  = false;
+    }
+
+    DriverDllLoader         &m_driverLoader;
+    bool                    m_driverOpen     = false;
+    bool                    m_mfeCreated     = false;
+    bool                    m_configCreated  = false;
+    VAMFContextID           m_mfeId          = 0;
+    VAConfigID              m_configId       = 0;
+    vector<EncTestData *>   m_streams;
+    size_t                  m_surfaceStreams = 0;   // Leading streams whose surfaces exist
+    vector<VAContextID>     m_contexts;
+    size_t                  m_addedContexts  = 0;   // Leading contexts added to the MFE context
+    vector<VABufferID>      m_buffers;              // Buffers of the frame in flight
+};
+
+void MediaEncodeDdiTest::MeasureMfeSubmit(Platform_t platform, uint32_t streamNum)
+{
+    const int               iterations = 10;
+    double                  totalMs    = 0;
+    int                     submits    = 0;
+    MfeSubmitResources      res(m_driverLoader);
+    VADriverVTable          *vtable    = nullptr;
+
+    int ret = m_driverLoader.InitDriver(platform);
+    ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+        << ", Failed function = m_driverLoader.InitDriver" << endl;
+    res.m_driverOpen = true;
+    vtable = m_driverLoader.m_ctx.vtable;
+
+    ret = vtable->vaCreateMFContext(&m_driverLoader.m_ctx, &res.m_mfeId);
+    if (ret == VA_STATUS_ERROR_UNIMPLEMENTED)
+    {
+        return;
+    }
+    ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+        << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateMFContext" << endl;
+    res.m_mfeCreated = true;
+
+    vector<EncTestData *> &streams  = res.m_streams;
+    vector<VAContextID>   &contexts = res.m_contexts;
+    for (uint32_t s = 0; s < streamNum; s++)
+    {
+        EncTestData *pEncData = m_encTestFactory.GetEncTestData("AVC-DualPipe");
+        streams.push_back(pEncData);
+
+        if (s == 0)
+        {
+            ret = vtable->vaCreateConfig(&m_driverLoader.m_ctx,
+                pEncData->GetFeatureID().profile, pEncData->GetFeatureID().entrypoint,
+                (VAConfigAttrib *)&(pEncData->GetConfAttrib()[0]), pEncData->GetConfAttrib().size(), &res.m_configId);
+            ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateConfig" << endl;
+            res.m_configCreated = true;
+        }
+
+        vector<VASurfaceID> &resources = pEncData->GetResources();
+        ret = vtable->vaCreateSurfaces2(&m_driverLoader.m_ctx, VA_RT_FORMAT_YUV420,
+            pEncData->GetWidth(), pEncData->GetHeight(), &resources[0], resources.size(),
+            (VASurfaceAttrib *)&(pEncData->GetSurfAttrib()[0]), pEncData->GetSurfAttrib().size());
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateSurfaces2" << endl;
+        res.m_surfaceStreams++;
+
+        VAContextID context_id;
+        ret = vtable->vaCreateContext(&m_driverLoader.m_ctx, res.m_configId, pEncData->GetWidth(),
+            pEncData->GetHeight(), VA_PROGRESSIVE, &resources[0], resources.size(), &context_id);
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateContext" << endl;
+        contexts.push_back(context_id);
+
+        ret = vtable->vaMFAddContext(&m_driverLoader.m_ctx, res.m_mfeId, context_id);
+        ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+            << ", Failed function = m_driverLoader.m_ctx.vtable->vaMFAddContext" << endl;
+        res.m_addedContexts++;
+    }
+
+    for (int n = 0; n < iterations; n++)
+    {
+        for (int i = 0; i < streams[0]->m_num_frames; i++)
+        {
+            for (uint32_t s = 0; s < streamNum; s++)
+            {
+                vector<vector<CompBufConif>> &compBufs = streams[s]->GetCompBuffers();
+
+                ret = vtable->vaBeginPicture(&m_driverLoader.m_ctx, contexts[s], streams[s]->GetResources()[0]);
+                ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                    << ", Failed function = m_driverLoader.m_ctx.vtable->vaBeginPicture" << endl;
+
+                ret = vtable->vaCreateBuffer(&m_driverLoader.m_ctx, contexts[s], compBufs[i][0].bufType,
+                    compBufs[i][0].bufSize, 1, compBufs[i][0].pData, &compBufs[i][0].bufID);
+                ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                    << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateBuffer" << endl;
+                res.m_buffers.push_back(compBufs[i][0].bufID);
+
+                streams[s]->UpdateCompBuffers(i);
+                for (int j = 1; j < compBufs[i].size(); j++)
+                {
+                    ret = vtable->vaCreateBuffer(&m_driverLoader.m_ctx, contexts[s], compBufs[i][j].bufType,
+                        compBufs[i][j].bufSize, 1, compBufs[i][j].pData, &compBufs[i][j].bufID);
+                    ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                        << ", Failed function = m_driverLoader.m_ctx.vtable->vaCreateBuffer" << endl;
+                    res.m_buffers.push_back(compBufs[i][j].bufID);
+
+                    ret = vtable->vaRenderPicture(&m_driverLoader.m_ctx, contexts[s], &compBufs[i][j].bufID, 1);
+                    ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                        << ", Failed function = m_driverLoader.m_ctx.vtable->vaRenderPicture" << endl;
+                }
+
+                // Execution is deferred to vaMFSubmit for sub contexts
+                ret = vtable->vaEndPicture(&m_driverLoader.m_ctx, contexts[s]);
+                ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                    << ", Failed function = m_driverLoader.m_ctx.vtable->vaEndPicture" << endl;
+            }
+
+            auto start = chrono::steady_clock::now();
+            ret = vtable->vaMFSubmit(&m_driverLoader.m_ctx, res.m_mfeId, &contexts[0], streamNum);
+            totalMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            submits++;
+            ASSERT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                << ", Failed function = m_driverLoader.m_ctx.vtable->vaMFSubmit" << endl;
+
+            for (uint32_t s = 0; s < streamNum; s++)
+            {
+                ret = vtable->vaSyncSurface(&m_driverLoader.m_ctx, streams[s]->GetResources()[0]);
+                EXPECT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+                    << ", Failed function = m_driverLoader.m_ctx.vtable->vaSyncSurface" << endl;
+            }
+
+            for (auto buffer : res.m_buffers)
+            {
+                vtable->vaDestroyBuffer(&m_driverLoader.m_ctx, buffer);
+            }
+            res.m_buffers.clear();
+        }
+    }
+
+    cout << "Platform = " << g_platformName[platform] << ", AVC MFE submit of " << streamNum << " streams: avg "
+         << totalMs / submits << " ms, " << totalMs / submits / streamNum << " ms per stream over "
+         << submits << " submissions" << endl;
+
+    res.Release();
+    res.m_driverOpen = false;
+    ret = m_driverLoader.CloseDriver();
+    EXPECT_EQ(VA_STATUS_SUCCESS, ret) << "Platform = " << g_platformName[platform]
+        << ", Failed function = m_driverLoader.CloseDriver" << endl;
+}
+
 EncodeTestConfig::EncodeTestConfig()
 {
     m_mapPlatformFeatureID[DeviceConfigTable[igfxSKLAKE]]     = {
@@ -54,6 +54,10 @@ protected:
 
     void ExectueEncodeTest(EncTestData *pDecData);
 
+    void MeasureStartup(EncTestData *pEncData, Platform_t platform);
+
+    void MeasureMfeSubmit(Platform_t platform, uint32_t streamNum);
+
 protected:
 
     DriverDllLoader     m_driverLoader;
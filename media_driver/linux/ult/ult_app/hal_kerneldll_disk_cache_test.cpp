@@ -0,0 +1,258 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#if defined(IGFX_GEN12_TGLLP_SUPPORTED)
+
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "hal_kerneldll.h"
+#include "igvpkrn_g12_tgllp.h"
+
+using namespace std;
+
+extern const Kdll_RuleEntry g_KdllRuleTable_g12lp[];
+
+//!
+//! \brief Builds the first combined kernel of a process with the gen12 component
+//!        kernels, with and without a kernel disk cache written by an earlier process
+//! \details The gen12 CMFC kernel binary is generated at build time, so the tests
+//!          link the component kernels in the tree with the regular kernel build
+//!
+class KernelDllDiskCacheTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir[] = "/tmp/kdll_cache_XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir));
+        m_cacheDir = dir;
+        ASSERT_EQ(0, setenv("INTEL_MEDIA_KDLL_CACHE_DIR", m_cacheDir.c_str(), 1));
+    }
+
+    void TearDown() override
+    {
+        unsetenv("INTEL_MEDIA_KDLL_CACHE_DIR");
+        RemoveCacheFiles();
+        rmdir(m_cacheDir.c_str());
+    }
+
+    void RemoveCacheFiles()
+    {
+        DIR *dir = opendir(m_cacheDir.c_str());
+        if (dir == nullptr)
+        {
+            return;
+        }
+        for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+            {
+                unlink((m_cacheDir + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+
+    static Kdll_FilterEntry Layer(Kdll_Layer layer, MOS_FORMAT format, VPHAL_CSPACE cspace, Kdll_Sampling sampler, Kdll_Processing process)
+    {
+        Kdll_FilterEntry entry;
+        MOS_ZeroMemory(&entry, sizeof(entry));
+        entry.layer           = layer;
+        entry.format          = format;
+        entry.cspace          = cspace;
+        entry.sampler         = sampler;
+        entry.colorfill       = ColorFill_False;
+        entry.lumakey         = LumaKey_False;
+        entry.samplerlumakey  = LumaKey_False;
+        entry.process         = process;
+        entry.procamp         = DL_PROCAMP_DISABLED;
+        entry.matrix          = DL_CSC_DISABLED;
+        entry.chromasiting    = DL_CHROMASITING_DISABLE;
+        entry.bWaEnableDscale = true;
+        entry.RenderMethod    = RenderMethod_MediaObjectWalker;
+        entry.SetCSCCoeffMode = SetCSCCoeffMethod_Curbe;
+        return entry;
+    }
+
+    static Kdll_FilterEntry Target(MOS_FORMAT format, VPHAL_CSPACE cspace)
+    {
+        Kdll_FilterEntry entry           = Layer(Layer_RenderTarget, format, cspace, Sample_None, Process_None);
+        entry.bWaEnableDscale              = false;
+        entry.tiletype                     = MOS_TILE_Y;
+        entry.bFillOutputAlphaWithConstant = true;
+        entry.bIsDitherNeeded              = true;
+        return entry;
+    }
+
+    //!
+    //! \brief Filters as built by CompositeState::BuildFilter
+    //!
+    void SetFilter(bool composition)
+    {
+        m_filterSize = 0;
+        if (composition)
+        {
+            // NV12 main video with AVS and colorfill, ARGB subpicture with source blending, NV12 target
+            m_filter[m_filterSize]           = Layer(Layer_MainVideo, Format_NV12, CSpace_BT709, Sample_Scaling_AVS, Process_Composite);
+            m_filter[m_filterSize].colorfill = ColorFill_True;
+            m_filterSize++;
+            m_filter[m_filterSize++] = Layer(Layer_SubVideo, Format_RGB, CSpace_sRGB, Sample_Scaling_034x, Process_SBlend);
+            m_filter[m_filterSize++] = Target(Format_NV12, CSpace_BT709);
+        }
+        else
+        {
+            // NV12 main video scaled into an ARGB target
+            m_filter[m_filterSize++] = Layer(Layer_MainVideo, Format_NV12, CSpace_BT709, Sample_Scaling_034x, Process_Composite);
+            m_filter[m_filterSize++] = Target(Format_A8R8G8B8, CSpace_sRGB);
+        }
+        m_hash = KernelDll_SimpleHash(m_filter, m_filterSize * sizeof(Kdll_FilterEntry));
+    }
+
+    //!
+    //! \brief Allocates the Kernel Dll state the way VphalRenderer::AllocateRenderComponents does
+    //!
+    static Kdll_State *AllocateStates()
+    {
+        void *kernelBin = MOS_AllocMemory(IGVPKRN_G12_TGLLP_SIZE);
+        if (kernelBin == nullptr)
+        {
+            return nullptr;
+        }
+        MOS_SecureMemcpy(kernelBin, IGVPKRN_G12_TGLLP_SIZE, IGVPKRN_G12_TGLLP, IGVPKRN_G12_TGLLP_SIZE);
+
+        return KernelDll_AllocateStates(kernelBin, IGVPKRN_G12_TGLLP_SIZE, nullptr, 0, g_KdllRuleTable_g12lp, nullptr);
+    }
+
+    //!
+    //! \brief Gets the first combined kernel of a new Kernel Dll state, like
+    //!        CompositeState::RenderPhase does on the first frame of a process
+    //! \return false if no kernel was found or built
+    //!
+    bool FirstFrame(Kdll_SearchState &search, bool &diskCacheHit, double &frameUs, double &kernelUs)
+    {
+        auto start = chrono::steady_clock::now();
+
+        Kdll_State *state = AllocateStates();
+        if (state == nullptr)
+        {
+            return false;
+        }
+
+        auto kernelStart = chrono::steady_clock::now();
+        bool built       = true;
+        state->pfnStartKernelSearch(state, &search, m_filter, m_filterSize, 1);
+        diskCacheHit = KernelDll_LoadDiskCachedKernel(state, &search, m_filter, m_filterSize, m_hash);
+        if (!diskCacheHit)
+        {
+            built = state->pfnSearchKernel(state, &search) && state->pfnBuildKernel(state, &search);
+            if (built)
+            {
+                KernelDll_StoreDiskCachedKernel(state, &search, m_filter, m_filterSize, m_hash);
+            }
+        }
+
+        auto end = chrono::steady_clock::now();
+        frameUs  = chrono::duration<double, micro>(end - start).count();
+        kernelUs = chrono::duration<double, micro>(end - kernelStart).count();
+        KernelDll_ReleaseStates(state);
+
+        return built;
+    }
+
+    string           m_cacheDir;
+    Kdll_FilterEntry m_filter[DL_MAX_SEARCH_FILTER_SIZE];
+    int32_t          m_filterSize = 0;
+    uint32_t         m_hash       = 0;
+};
+
+TEST_F(KernelDllDiskCacheTest, WarmFirstFrameMatchesColdBuild)
+{
+    for (bool composition : {false, true})
+    {
+        Kdll_SearchState *cold = (Kdll_SearchState *)MOS_AllocAndZeroMemory(sizeof(Kdll_SearchState));
+        Kdll_SearchState *warm = (Kdll_SearchState *)MOS_AllocAndZeroMemory(sizeof(Kdll_SearchState));
+        bool              coldHit = true, warmHit = false;
+        double            frameUs, kernelUs;
+        ASSERT_NE(nullptr, cold);
+        ASSERT_NE(nullptr, warm);
+        SetFilter(composition);
+
+        ASSERT_TRUE(FirstFrame(*cold, coldHit, frameUs, kernelUs));
+        EXPECT_FALSE(coldHit);
+        ASSERT_GT(cold->KernelSize, 0);
+
+        ASSERT_TRUE(FirstFrame(*warm, warmHit, frameUs, kernelUs));
+        EXPECT_TRUE(warmHit);
+
+        ASSERT_EQ(cold->KernelSize, warm->KernelSize);
+        EXPECT_EQ(0, memcmp(cold->Kernel, warm->Kernel, cold->KernelSize));
+        ASSERT_EQ(cold->iFilterSize, warm->iFilterSize);
+        EXPECT_EQ(0, memcmp(cold->Filter, warm->Filter, cold->iFilterSize * sizeof(Kdll_FilterEntry)));
+        EXPECT_EQ(0, memcmp(&cold->CscParams, &warm->CscParams, sizeof(Kdll_CSC_Params)));
+
+        MOS_FreeMemory(cold);
+        MOS_FreeMemory(warm);
+    }
+}
+
+TEST_F(KernelDllDiskCacheTest, FirstFrameLatency)
+{
+    const int         iterations = 20;
+    Kdll_SearchState *search     = (Kdll_SearchState *)MOS_AllocAndZeroMemory(sizeof(Kdll_SearchState));
+    ASSERT_NE(nullptr, search);
+
+    for (bool composition : {false, true})
+    {
+        double coldFrameUs = 0, coldKernelUs = 0, warmFrameUs = 0, warmKernelUs = 0;
+        double frameUs, kernelUs;
+        bool   hit = false;
+        SetFilter(composition);
+
+        for (int i = 0; i < iterations; i++)
+        {
+            // Every cold frame starts from an empty cache directory
+            RemoveCacheFiles();
+            ASSERT_TRUE(FirstFrame(*search, hit, frameUs, kernelUs));
+            ASSERT_FALSE(hit);
+            coldFrameUs  += frameUs;
+            coldKernelUs += kernelUs;
+
+            ASSERT_TRUE(FirstFrame(*search, hit, frameUs, kernelUs));
+            ASSERT_TRUE(hit);
+            warmFrameUs  += frameUs;
+            warmKernelUs += kernelUs;
+        }
+
+        string name = composition ? "Composition" : "Scaling";
+        RecordProperty(name + "ColdFirstFrameUs", to_string(coldFrameUs / iterations));
+        RecordProperty(name + "WarmFirstFrameUs", to_string(warmFrameUs / iterations));
+        RecordProperty(name + "ColdKernelUs", to_string(coldKernelUs / iterations));
+        RecordProperty(name + "WarmKernelUs", to_string(warmKernelUs / iterations));
+    }
+
+    MOS_FreeMemory(search);
+}
+
+#endif  // IGFX_GEN12_TGLLP_SUPPORTED
@@ -0,0 +1,473 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "heap_manager.h"
+#include "frame_tracker.h"
+
+using namespace std;
+
+static uint8_t s_fakeBo;  // Heaps only need a non-null bo, no memory behind it
+
+#if MOS_MESSAGES_ENABLED
+static MOS_STATUS FakeAllocateResource(PMOS_INTERFACE osInterface, PMOS_ALLOC_GFXRES_PARAMS params,
+    const char *functionName, const char *filename, int32_t line, PMOS_RESOURCE resource)
+#else
+static MOS_STATUS FakeAllocateResource(PMOS_INTERFACE osInterface, PMOS_ALLOC_GFXRES_PARAMS params,
+    PMOS_RESOURCE resource)
+#endif
+{
+    resource->bo = (MOS_LINUX_BO *)&s_fakeBo;
+    return MOS_STATUS_SUCCESS;
+}
+
+#if MOS_MESSAGES_ENABLED
+static void FakeFreeResource(PMOS_INTERFACE osInterface, const char *functionName, const char *filename,
+    int32_t line, PMOS_RESOURCE resource)
+#else
+static void FakeFreeResource(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource)
+#endif
+{
+    resource->bo = nullptr;
+}
+
+static MOS_STATUS FakeSkipResourceSync(PMOS_RESOURCE resource)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+// Drives MemoryBlockManager through HeapManager, with a tracker the test
+// completes by hand and the client controlling what happens when space runs out
+class MemoryBlockManagerTest : public testing::Test
+{
+protected:
+    void Init(uint32_t heapSize)
+    {
+        MOS_ZeroMemory(&m_osInterface, sizeof(m_osInterface));
+        m_osInterface.pfnAllocateResource = FakeAllocateResource;
+        m_osInterface.pfnFreeResource     = FakeFreeResource;
+        m_osInterface.pfnSkipResourceSync = FakeSkipResourceSync;
+
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.RegisterOsInterface(&m_osInterface));
+        m_heapManager.SetDefaultBehavior(HeapManager::clientControlled);
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.SetInitialHeapSize(heapSize));
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.RegisterTrackerResource(&m_completedTrackerId));
+    }
+
+    MOS_STATUS Acquire(vector<uint32_t> sizes, uint32_t trackerId, vector<MemoryBlock> &blocks, uint32_t &spaceNeeded)
+    {
+        MemoryBlockManager::AcquireParams params(trackerId, sizes);
+        return m_heapManager.AcquireSpace(params, blocks, spaceNeeded);
+    }
+
+    // Allocates one block, which must succeed
+    MemoryBlock AcquireOne(uint32_t size, uint32_t trackerId)
+    {
+        vector<MemoryBlock> blocks;
+        uint32_t            spaceNeeded = 0;
+        EXPECT_EQ(MOS_STATUS_SUCCESS, Acquire({size}, trackerId, blocks, spaceNeeded)) << "size " << size;
+        return blocks.empty() ? MemoryBlock() : blocks[0];
+    }
+
+    void Submit(vector<MemoryBlock> blocks)
+    {
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.SubmitBlocks(blocks));
+    }
+
+    static void ExpectNoOverlap(vector<MemoryBlock> blocks)
+    {
+        sort(blocks.begin(), blocks.end(),
+            [](MemoryBlock &a, MemoryBlock &b) { return a.GetOffset() < b.GetOffset(); });
+        for (size_t i = 1; i < blocks.size(); i++)
+        {
+            EXPECT_LE(blocks[i - 1].GetOffset() + blocks[i - 1].GetSize(), blocks[i].GetOffset());
+        }
+    }
+
+    static const uint32_t m_heapSize = 64 * 1024;
+
+    MOS_INTERFACE m_osInterface;
+    HeapManager   m_heapManager;
+    uint32_t      m_completedTrackerId = 0;
+};
+
+const uint32_t MemoryBlockManagerTest::m_heapSize;
+
+TEST_F(MemoryBlockManagerTest, Allocate)
+{
+    Init(m_heapSize);
+
+    vector<MemoryBlock> blocks;
+    uint32_t            spaceNeeded = 0;
+    ASSERT_EQ(MOS_STATUS_SUCCESS, Acquire({100, 64, 4096, 1}, 1, blocks, spaceNeeded));
+    ASSERT_EQ(4u, blocks.size());
+    EXPECT_EQ(0u, spaceNeeded);
+
+    // Sizes are aligned to 64 bytes and come back in request order
+    uint32_t expectedSizes[] = {128, 64, 4096, 64};
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        EXPECT_TRUE(blocks[i].IsValid());
+        EXPECT_EQ(expectedSizes[i], blocks[i].GetSize());
+        EXPECT_EQ(0u, blocks[i].GetOffset() % 64);
+        EXPECT_LE(blocks[i].GetOffset() + blocks[i].GetSize(), m_heapSize);
+        EXPECT_EQ(1u, blocks[i].GetTrackerId());
+    }
+    ExpectNoOverlap(blocks);
+    EXPECT_EQ(m_heapSize, m_heapManager.GetTotalSize());
+}
+
+TEST_F(MemoryBlockManagerTest, NoSpace)
+{
+    Init(m_heapSize);
+
+    MemoryBlock whole = AcquireOne(m_heapSize, 1);
+    EXPECT_EQ(0u, whole.GetOffset());
+
+    // Nothing is free and nothing completes, the client is told how much is missing
+    vector<MemoryBlock> blocks;
+    uint32_t            spaceNeeded = 0;
+    EXPECT_EQ(MOS_STATUS_CLIENT_AR_NO_SPACE, Acquire({1000, 64}, 2, blocks, spaceNeeded));
+    EXPECT_EQ(1024u + 64u, spaceNeeded);
+    EXPECT_TRUE(blocks.empty());
+}
+
+TEST_F(MemoryBlockManagerTest, FreeAndCoalesce)
+{
+    Init(m_heapSize);
+
+    // Fill the heap with blocks completed in a scattered order
+    vector<MemoryBlock> blocks;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        blocks.push_back(AcquireOne(m_heapSize / 16, 1 + i % 3));
+    }
+    ExpectNoOverlap(blocks);
+    Submit(blocks);
+
+    // Only blocks of tracker 1 are free, they are never adjacent
+    m_completedTrackerId = 1;
+    vector<MemoryBlock> result;
+    uint32_t            spaceNeeded = 0;
+    EXPECT_EQ(MOS_STATUS_CLIENT_AR_NO_SPACE, Acquire({2 * m_heapSize / 16}, 4, result, spaceNeeded));
+    EXPECT_EQ(2 * m_heapSize / 16, spaceNeeded);
+
+    // Once all complete they merge back into one block spanning the heap
+    m_completedTrackerId = 3;
+    MemoryBlock whole = AcquireOne(m_heapSize, 4);
+    EXPECT_EQ(0u, whole.GetOffset());
+    EXPECT_EQ(m_heapSize, whole.GetSize());
+}
+
+TEST_F(MemoryBlockManagerTest, BestFit)
+{
+    Init(m_heapSize);
+
+    // a(4K) hole4K(4K) c(4K) hole16K(16K) e(4K) f(rest)
+    MemoryBlock a       = AcquireOne(4096, 2);
+    MemoryBlock hole4K  = AcquireOne(4096, 1);
+    MemoryBlock c       = AcquireOne(4096, 2);
+    MemoryBlock hole16K = AcquireOne(16384, 1);
+    MemoryBlock e       = AcquireOne(4096, 2);
+    MemoryBlock f       = AcquireOne(m_heapSize - 32768, 2);
+    ExpectNoOverlap({a, hole4K, c, hole16K, e, f});
+    Submit({hole4K, hole16K});
+    m_completedTrackerId = 1;
+
+    // The smallest hole that fits is used, the 16K one stays whole
+    MemoryBlock small = AcquireOne(2048, 3);
+    EXPECT_EQ(hole4K.GetOffset(), small.GetOffset());
+    MemoryBlock large = AcquireOne(16384, 3);
+    EXPECT_EQ(hole16K.GetOffset(), large.GetOffset());
+}
+
+TEST_F(MemoryBlockManagerTest, Fragmentation)
+{
+    Init(m_heapSize);
+
+    // a(4K) hole4K(4K) c(4K) hole16K(16K) e(rest)
+    MemoryBlock a       = AcquireOne(4096, 2);
+    MemoryBlock hole4K  = AcquireOne(4096, 1);
+    MemoryBlock c       = AcquireOne(4096, 2);
+    MemoryBlock hole16K = AcquireOne(16384, 1);
+    MemoryBlock e       = AcquireOne(m_heapSize - 28672, 2);
+    Submit({hole4K, hole16K});
+    m_completedTrackerId = 1;
+
+    // Two 8K blocks share the 16K hole
+    vector<MemoryBlock> blocks;
+    uint32_t            spaceNeeded = 0;
+    ASSERT_EQ(MOS_STATUS_SUCCESS, Acquire({8192, 8192}, 3, blocks, spaceNeeded));
+    for (auto &block : blocks)
+    {
+        EXPECT_GE(block.GetOffset(), hole16K.GetOffset());
+        EXPECT_LE(block.GetOffset() + block.GetSize(), hole16K.GetOffset() + hole16K.GetSize());
+    }
+    ExpectNoOverlap(blocks);
+    Submit(blocks);
+    m_completedTrackerId = 3;
+
+    // 12K and 8K don't fit in 4K + 16K even though 20K is free; the
+    // availability check must agree with the allocation and give up
+    blocks.clear();
+    EXPECT_EQ(MOS_STATUS_CLIENT_AR_NO_SPACE, Acquire({12288, 8192}, 4, blocks, spaceNeeded));
+    EXPECT_EQ(8192u, spaceNeeded);
+
+    // 12K and 4K do
+    ASSERT_EQ(MOS_STATUS_SUCCESS, Acquire({12288, 4096}, 4, blocks, spaceNeeded));
+    EXPECT_EQ(hole16K.GetOffset(), blocks[0].GetOffset());
+    EXPECT_EQ(hole4K.GetOffset(), blocks[1].GetOffset());
+}
+
+TEST_F(MemoryBlockManagerTest, Benchmark10kBlocks)
+{
+    const uint32_t blockCount = 10000;
+    const uint32_t batchSize  = 8;
+    const uint32_t batchCount = blockCount / batchSize;
+    const uint32_t rounds     = 4;
+    const uint32_t maxSize    = 4096;
+
+    // Room for one round of blocks at their largest plus what is left in flight
+    Init(2 * blockCount * maxSize);
+
+    uint32_t seed        = 1;
+    uint32_t spaceNeeded = 0;
+    double   acquireUs   = 0;
+
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        // Tracker ids of a round are above those of the previous one, and
+        // scattered over its batches so completed blocks leave holes
+        uint32_t trackerBase = round * batchCount;
+        for (uint32_t batch = 0; batch < batchCount; batch++)
+        {
+            vector<uint32_t> sizes;
+            for (uint32_t i = 0; i < batchSize; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                sizes.push_back(64 + (seed >> 8) % (maxSize - 64));
+            }
+
+            vector<MemoryBlock> blocks;
+            uint32_t            trackerId = trackerBase + 1 + (batch * 7919) % batchCount;
+            auto                start     = chrono::steady_clock::now();
+            ASSERT_EQ(MOS_STATUS_SUCCESS, Acquire(sizes, trackerId, blocks, spaceNeeded));
+            acquireUs += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            Submit(blocks);
+        }
+
+        // Half of this round completes, all of the previous one
+        m_completedTrackerId = trackerBase + batchCount / 2;
+    }
+
+    RecordProperty("AcquireUsPerBlock", to_string(acquireUs / (blockCount * rounds)));
+}
+
+// Tracker memory of the fake GPU, and completions the fake wait sleeps on
+static uint32_t                s_trackerData[MAX_TRACKER_NUMBER * 2];
+static mutex                   s_gpuMutex;
+static condition_variable      s_gpuCompleted;
+static uint64_t                s_completions;
+static bool                    s_waitReturnsEarly;
+
+static MOS_STATUS FakeRegisterResource(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource, int32_t write, int32_t setSyncTag)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+static void *FakeLockResource(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource, PMOS_LOCK_PARAMS flags)
+{
+    return s_trackerData;
+}
+
+static MOS_STATUS FakeUnlockResource(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+#if MOS_MESSAGES_ENABLED
+static void FakeFreeResourceWithFlag(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource, const char *functionName,
+    const char *filename, int32_t line, uint32_t flag)
+#else
+static void FakeFreeResourceWithFlag(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource, uint32_t flag)
+#endif
+{
+    resource->bo = nullptr;
+}
+
+// Waits for the next completion of the fake GPU, or gives up at once the way
+// a wait interrupted early would
+static MOS_STATUS FakeWaitOnResourceTimeout(PMOS_INTERFACE osInterface, PMOS_RESOURCE resource, uint32_t timeOutMs)
+{
+    unique_lock<mutex> lock(s_gpuMutex);
+    if (s_waitReturnsEarly)
+    {
+        return MOS_STATUS_STILL_DRAWING;
+    }
+    uint64_t completions = s_completions;
+    return s_gpuCompleted.wait_for(lock, chrono::milliseconds(timeOutMs),
+               [&]() { return s_completions != completions; }) ?
+        MOS_STATUS_SUCCESS : MOS_STATUS_STILL_DRAWING;
+}
+
+// HeapManager in wait mode on a frame tracker producer the fake GPU completes
+class HeapManagerWaitTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        MOS_ZeroMemory(s_trackerData, sizeof(s_trackerData));
+        s_completions      = 0;
+        s_waitReturnsEarly = false;
+
+        MOS_ZeroMemory(&m_osInterface, sizeof(m_osInterface));
+        m_osInterface.pfnAllocateResource       = FakeAllocateResource;
+        m_osInterface.pfnFreeResource           = FakeFreeResource;
+        m_osInterface.pfnFreeResourceWithFlag   = FakeFreeResourceWithFlag;
+        m_osInterface.pfnSkipResourceSync       = FakeSkipResourceSync;
+        m_osInterface.pfnRegisterResource       = FakeRegisterResource;
+        m_osInterface.pfnLockResource           = FakeLockResource;
+        m_osInterface.pfnUnlockResource         = FakeUnlockResource;
+        m_osInterface.pfnWaitOnResourceTimeout  = FakeWaitOnResourceTimeout;
+
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_producer.Initialize(&m_osInterface));
+        m_trackerIndex = m_producer.AssignNewTracker();
+        ASSERT_GE(m_trackerIndex, 0);
+
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.RegisterOsInterface(&m_osInterface));
+        m_heapManager.SetDefaultBehavior(HeapManager::wait);
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.SetInitialHeapSize(m_heapSize));
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_heapManager.RegisterTrackerProducer(&m_producer));
+    }
+
+    // Acquires blocks for the next frame and submits them
+    MOS_STATUS AcquireAndSubmit(vector<uint32_t> sizes)
+    {
+        MemoryBlockManager::AcquireParams params(m_producer.GetNextTracker(m_trackerIndex), sizes);
+        params.m_trackerIndex = m_trackerIndex;
+
+        vector<MemoryBlock> blocks;
+        uint32_t            spaceNeeded = 0;
+        MOS_STATUS          status      = m_heapManager.AcquireSpace(params, blocks, spaceNeeded);
+        if (status == MOS_STATUS_SUCCESS)
+        {
+            status = m_heapManager.SubmitBlocks(blocks);
+            m_producer.StepForward(m_trackerIndex);
+        }
+        return status;
+    }
+
+    // The GPU finishes the frame with this tracker
+    void Complete(uint32_t tracker)
+    {
+        lock_guard<mutex> lock(s_gpuMutex);
+        __atomic_store_n(m_producer.GetLatestTrackerAddress(m_trackerIndex), tracker, __ATOMIC_RELEASE);
+        s_completions++;
+        s_gpuCompleted.notify_all();
+    }
+
+    static const uint32_t m_heapSize = 64 * 1024;
+
+    MOS_INTERFACE        m_osInterface;
+    FrameTrackerProducer m_producer;
+    HeapManager          m_heapManager;
+    int                  m_trackerIndex = -1;
+};
+
+const uint32_t HeapManagerWaitTest::m_heapSize;
+
+TEST_F(HeapManagerWaitTest, TimeoutCountsElapsedTime)
+{
+    ASSERT_EQ(MOS_STATUS_SUCCESS, AcquireAndSubmit({m_heapSize}));
+
+    // Waits that return early must not use up the timeout
+    s_waitReturnsEarly = true;
+    auto start = chrono::steady_clock::now();
+    EXPECT_EQ(MOS_STATUS_CLIENT_AR_NO_SPACE, AcquireAndSubmit({4096}));
+    double waitedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    EXPECT_GE(waitedMs, 95.0);
+    RecordProperty("TimeoutMs", to_string(waitedMs));
+
+    // The frame completes and the space comes back
+    Complete(1);
+    EXPECT_EQ(MOS_STATUS_SUCCESS, AcquireAndSubmit({4096}));
+}
+
+TEST_F(HeapManagerWaitTest, AcquireUnderPressure)
+{
+    const uint32_t frameCount = 2000;
+    const uint32_t blockSize  = 4096;
+
+    // The GPU completes frames in order on its own thread while the client
+    // keeps the heap full, so most acquires wait for a completion
+    atomic<uint32_t> submitted{0};
+    atomic<bool>     stop{false};
+    thread gpu([&]() {
+        uint32_t completed = 0;
+        while (!stop.load())
+        {
+            if (completed < submitted.load())
+            {
+                this_thread::sleep_for(chrono::microseconds(50));
+                Complete(++completed);
+            }
+            else
+            {
+                this_thread::yield();
+            }
+        }
+    });
+
+    double   acquireUs = 0, maxUs = 0;
+    uint32_t retries   = 0;
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        // One to four blocks per frame, so completions free mixed sizes
+        vector<uint32_t> sizes(1 + frame % 4, blockSize);
+        auto             start  = chrono::steady_clock::now();
+        MOS_STATUS       status = AcquireAndSubmit(sizes);
+        while (status == MOS_STATUS_CLIENT_AR_NO_SPACE)
+        {
+            retries++;
+            status = AcquireAndSubmit(sizes);
+        }
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        ASSERT_EQ(MOS_STATUS_SUCCESS, status);
+        acquireUs += us;
+        maxUs = max(maxUs, us);
+        submitted.store(frame + 1);
+    }
+
+    stop.store(true);
+    gpu.join();
+
+    RecordProperty("AcquireUsPerFrame", to_string(acquireUs / frameCount));
+    RecordProperty("MaxAcquireUs", to_string(maxUs));
+    RecordProperty("Retries", to_string(retries));
+}
@@ -0,0 +1,388 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "mos_bufmgr.h"
+#include "devconfig.h"
+
+using namespace std;
+
+// The mock drmIoctl picks its device from fd - 1
+static const int      MOCK_DRM_FD = 1;
+static const int      BATCH_SIZE  = 16 * 4096;
+
+//!
+//! \brief Runs the real i915 bufmgr on the GEM emulation of the libdrm mock
+//!
+class MosBufmgrTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        g_drmMockGem               = {};
+        g_drmMockGem.enabled       = true;
+        g_drmMockGem.hasExecFence  = true;
+        Init();
+    }
+
+    void TearDown() override
+    {
+        if (m_bufmgr)
+        {
+            mos_bufmgr_destroy(m_bufmgr);
+        }
+        g_drmMockGem = {};
+    }
+
+    void Init()
+    {
+        if (m_bufmgr)
+        {
+            mos_bufmgr_destroy(m_bufmgr);
+        }
+        m_bufmgr = mos_bufmgr_gem_init(MOCK_DRM_FD, BATCH_SIZE);
+        ASSERT_NE(nullptr, m_bufmgr);
+        mos_bufmgr_gem_enable_reuse(m_bufmgr);
+    }
+
+    //!
+    //! \brief Runs body(threadIndex) on threadCount threads started together
+    //! \return Wall time in seconds from the start signal to the last join
+    //!
+    template <typename Body>
+    double RunThreads(uint32_t threadCount, Body body)
+    {
+        atomic<bool>   go{false};
+        vector<thread> threads;
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back([&, i]() {
+                while (!go.load())
+                {
+                    this_thread::yield();
+                }
+                body(i);
+            });
+        }
+
+        auto start = chrono::steady_clock::now();
+        go.store(true);
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    //!
+    //! \brief Submits a batch that writes target
+    //!
+    int Submit(struct mos_linux_bo *batch, struct mos_linux_bo *target)
+    {
+        int ret = mos_bo_emit_reloc(batch, 0, target, 0, I915_GEM_DOMAIN_RENDER, I915_GEM_DOMAIN_RENDER);
+        if (ret == 0)
+        {
+            ret = mos_bo_mrb_exec(batch, 4096, nullptr, 0, 0, I915_EXEC_RENDER);
+        }
+        mos_gem_bo_clear_relocs(batch, 0);
+        return ret;
+    }
+
+    struct mos_bufmgr *m_bufmgr = nullptr;
+};
+
+TEST_F(MosBufmgrTest, ReuseFromCache)
+{
+    struct mos_linux_bo *bo = mos_bo_alloc(m_bufmgr, "a", 64 * 1024, 4096, 0);
+    ASSERT_NE(nullptr, bo);
+    uint32_t handle = bo->handle;
+    mos_bo_unreference(bo);
+
+    // Any size in the same bucket comes back as the cached BO
+    bo = mos_bo_alloc(m_bufmgr, "b", 60 * 1024, 4096, 0);
+    ASSERT_NE(nullptr, bo);
+    EXPECT_EQ(handle, bo->handle);
+    mos_bo_unreference(bo);
+
+    struct mos_bufmgr_cache_stats stats = {};
+    ASSERT_EQ(0, mos_bufmgr_gem_get_cache_stats(m_bufmgr, &stats));
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(1u, stats.cached_count);
+}
+
+TEST_F(MosBufmgrTest, CacheBudgetAndExpiry)
+{
+    const unsigned long boSize = 64 * 1024;
+    ASSERT_EQ(0, mos_bufmgr_gem_set_cache_limits(m_bufmgr, 16 * boSize, 12 * boSize, 50));
+    EXPECT_NE(0, mos_bufmgr_gem_set_cache_limits(m_bufmgr, boSize, 2 * boSize, 50));
+
+    vector<struct mos_linux_bo *> bos;
+    for (int i = 0; i < 32; i++)
+    {
+        bos.push_back(mos_bo_alloc(m_bufmgr, "budget", boSize, 4096, 0));
+        ASSERT_NE(nullptr, bos.back());
+    }
+    for (auto bo : bos)
+    {
+        mos_bo_unreference(bo);
+    }
+
+    // Going over the high watermark trims the cache to the low one
+    struct mos_bufmgr_cache_stats stats = {};
+    ASSERT_EQ(0, mos_bufmgr_gem_get_cache_stats(m_bufmgr, &stats));
+    EXPECT_LE(stats.cached_bytes, 16 * boSize);
+    EXPECT_LE(stats.peak_cached_bytes, 17 * boSize);
+    EXPECT_GT(stats.evicted, 0u);
+    EXPECT_EQ(0u, stats.expired);
+    EXPECT_EQ(stats.cached_count * boSize, stats.cached_bytes);
+
+    // Past the expiry and the sweep interval the next free drops them all
+    this_thread::sleep_for(chrono::milliseconds(200));
+    mos_bo_unreference(mos_bo_alloc(m_bufmgr, "expire", 4096, 4096, 0));
+    ASSERT_EQ(0, mos_bufmgr_gem_get_cache_stats(m_bufmgr, &stats));
+    EXPECT_GT(stats.expired, 0u);
+    EXPECT_EQ(1u, stats.cached_count);
+    EXPECT_EQ(4096u, stats.cached_bytes);
+}
+
+TEST_F(MosBufmgrTest, AllocFreeThreadScaling)
+{
+    const uint32_t opsPerThread = 20000;
+    const uint32_t liveBos      = 16;
+
+    for (uint32_t threadCount = 1; threadCount <= 16; threadCount *= 2)
+    {
+        Init();
+
+        atomic<uint32_t> failures{0};
+        double seconds = RunThreads(threadCount, [&](uint32_t index) {
+            // Each thread keeps a few BOs alive across a spread of buckets
+            // so alloc and free interleave like a codec's working set
+            struct mos_linux_bo *bos[liveBos] = {};
+            uint32_t             seed         = index + 1;
+            for (uint32_t op = 0; op < opsPerThread; op++)
+            {
+                uint32_t slot = op % liveBos;
+                if (bos[slot])
+                {
+                    mos_bo_unreference(bos[slot]);
+                }
+                seed = seed * 1103515245 + 12345;
+                unsigned long size = 4096ul << ((seed >> 8) % 8);
+                bos[slot] = mos_bo_alloc(m_bufmgr, "bench", size + (seed >> 16) % 4096, 4096, 0);
+                if (bos[slot] == nullptr)
+                {
+                    failures++;
+                }
+            }
+            for (auto bo : bos)
+            {
+                if (bo)
+                {
+                    mos_bo_unreference(bo);
+                }
+            }
+        });
+
+        EXPECT_EQ(0u, failures.load());
+
+        struct mos_bufmgr_cache_stats stats = {};
+        ASSERT_EQ(0, mos_bufmgr_gem_get_cache_stats(m_bufmgr, &stats));
+        EXPECT_EQ((uint64_t)threadCount * opsPerThread, stats.hits + stats.misses);
+        EXPECT_GT(stats.hits, stats.misses);
+
+        string name = "Threads" + to_string(threadCount);
+        RecordProperty(name + "OpsPerSec", to_string(threadCount * opsPerThread / seconds));
+        RecordProperty(name + "HitRate", to_string((double)stats.hits / (stats.hits + stats.misses)));
+    }
+}
+
+TEST_F(MosBufmgrTest, ConcurrentSubmitThreadScaling)
+{
+    const uint32_t submitsPerThread = 2000;
+    const uint32_t surfaceCount     = 32;
+
+    for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2)
+    {
+        Init();
+        mos_bufmgr_gem_enable_softpin(m_bufmgr);
+
+        // State every batch points at, whose own target list a mutator
+        // thread keeps growing and clearing while the others submit
+        struct mos_linux_bo *state = mos_bo_alloc(m_bufmgr, "state", 4096, 4096, 0);
+        ASSERT_NE(nullptr, state);
+        ASSERT_EQ(0, mos_bo_set_softpin(state));
+
+        struct mos_linux_bo *shared[4];
+        for (auto &bo : shared)
+        {
+            bo = mos_bo_alloc(m_bufmgr, "shared", 4096, 4096, 0);
+            ASSERT_NE(nullptr, bo);
+            ASSERT_EQ(0, mos_bo_set_softpin(bo));
+        }
+
+        atomic<bool>     stop{false};
+        atomic<uint32_t> failures{0};
+        thread mutator([&]() {
+            while (!stop.load())
+            {
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    mos_bo_add_softpin_target(state, shared[i % 4], false);
+                }
+                mos_gem_bo_clear_relocs(state, 0);
+            }
+        });
+
+        double seconds = RunThreads(threadCount, [&](uint32_t index) {
+            struct mos_linux_bo *batch = mos_bo_alloc(m_bufmgr, "batch", BATCH_SIZE, 4096, 0);
+            vector<struct mos_linux_bo *> surfaces;
+            if (batch == nullptr || mos_bo_set_softpin(batch))
+            {
+                failures++;
+                return;
+            }
+            for (uint32_t i = 0; i < surfaceCount; i++)
+            {
+                surfaces.push_back(mos_bo_alloc(m_bufmgr, "surface", 64 * 1024, 4096, 0));
+                mos_bo_set_softpin(surfaces.back());
+            }
+
+            for (uint32_t submit = 0; submit < submitsPerThread; submit++)
+            {
+                mos_bo_add_softpin_target(batch, state, false);
+                for (auto surface : surfaces)
+                {
+                    mos_bo_add_softpin_target(batch, surface, true);
+                }
+                if (mos_bo_mrb_exec(batch, 4096, nullptr, 0, 0, I915_EXEC_RENDER))
+                {
+                    failures++;
+                }
+                mos_gem_bo_clear_relocs(batch, 0);
+            }
+
+            for (auto surface : surfaces)
+            {
+                mos_bo_unreference(surface);
+            }
+            mos_bo_unreference(batch);
+        });
+
+        stop.store(true);
+        mutator.join();
+        for (auto bo : shared)
+        {
+            mos_bo_unreference(bo);
+        }
+        mos_bo_unreference(state);
+
+        EXPECT_EQ(0u, failures.load());
+        RecordProperty("Threads" + to_string(threadCount) + "SubmitsPerSec",
+            to_string(threadCount * submitsPerThread / seconds));
+    }
+}
+
+TEST_F(MosBufmgrTest, WaitRacingSubmitKeepsBusy)
+{
+    struct mos_linux_bo *batch  = mos_bo_alloc(m_bufmgr, "batch", BATCH_SIZE, 4096, 0);
+    struct mos_linux_bo *target = mos_bo_alloc(m_bufmgr, "target", 4096, 4096, 0);
+    ASSERT_NE(nullptr, batch);
+    ASSERT_NE(nullptr, target);
+
+    g_drmMockGem.execLatencyUs = 50000;
+    ASSERT_EQ(0, Submit(batch, target));
+
+    // The waiter sees the first batch only; the second is submitted while
+    // it waits and runs far longer than the test
+    atomic<bool> waiting{false};
+    int          waitRet = -1;
+    thread waiter([&]() {
+        waiting.store(true);
+        waitRet = mos_gem_bo_wait(target, -1);
+    });
+    while (!waiting.load())
+    {
+        this_thread::yield();
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    g_drmMockGem.execLatencyUs = 10000000;
+    ASSERT_EQ(0, Submit(batch, target));
+    waiter.join();
+
+    EXPECT_EQ(0, waitRet);
+    EXPECT_TRUE(mos_bo_busy(target));
+    EXPECT_EQ(-ETIME, mos_gem_bo_wait(target, 0));
+
+    mos_bo_unreference(target);
+    mos_bo_unreference(batch);
+}
+
+TEST_F(MosBufmgrTest, SyncAfterSubmitLatency)
+{
+    const uint32_t syncCount  = 500;
+    const uint32_t latencyUs  = 200;
+    const uint32_t resyncs    = 100;
+
+    for (bool execFence : {true, false})
+    {
+        g_drmMockGem.hasExecFence  = execFence;
+        g_drmMockGem.execLatencyUs = latencyUs;
+        Init();
+
+        struct mos_linux_bo *batch  = mos_bo_alloc(m_bufmgr, "batch", BATCH_SIZE, 4096, 0);
+        struct mos_linux_bo *target = mos_bo_alloc(m_bufmgr, "target", 4096, 4096, 0);
+        ASSERT_NE(nullptr, batch);
+        ASSERT_NE(nullptr, target);
+
+        double   syncUs     = 0;
+        uint32_t resyncIoctls = 0;
+        for (uint32_t i = 0; i < syncCount; i++)
+        {
+            ASSERT_EQ(0, Submit(batch, target));
+            auto start = chrono::steady_clock::now();
+            ASSERT_EQ(0, mos_gem_bo_wait(target, -1));
+            syncUs += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+            // Once a sync saw the buffer idle, syncing again is free
+            uint32_t ioctls = g_drmMockGem.ioctlCount;
+            for (uint32_t j = 0; j < resyncs; j++)
+            {
+                ASSERT_EQ(0, mos_gem_bo_wait(target, -1));
+                ASSERT_FALSE(mos_bo_busy(target));
+            }
+            resyncIoctls += g_drmMockGem.ioctlCount - ioctls;
+        }
+        EXPECT_EQ(0u, resyncIoctls);
+
+        string name = execFence ? "ExecFence" : "GemWait";
+        RecordProperty(name + "SyncUs", to_string(syncUs / syncCount));
+        RecordProperty(name + "OverLatencyUs", to_string(syncUs / syncCount - latencyUs));
+
+        mos_bo_unreference(target);
+        mos_bo_unreference(batch);
+    }
+}
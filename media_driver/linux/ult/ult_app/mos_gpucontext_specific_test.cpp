@@ -0,0 +1,399 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <ctime>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "devconfig.h"
+#include "mos_context_specific.h"
+#include "mos_gpucontext_specific.h"
+
+using namespace std;
+
+// The mock drmIoctl picks its device from fd - 1
+static const int      MOCK_DRM_FD    = 1;
+static const uint32_t CMD_BUFFER_SIZE = 64 * 1024;
+
+//!
+//! \brief Submits command buffers through GpuContextSpecific on the GEM
+//!        emulation of the libdrm mock
+//!
+class GpuContextSpecificTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        g_drmMockGem         = {};
+        g_drmMockGem.enabled = true;
+
+        m_bufmgr = mos_bufmgr_gem_init(MOCK_DRM_FD, CMD_BUFFER_SIZE);
+        ASSERT_NE(nullptr, m_bufmgr);
+        mos_bufmgr_gem_enable_softpin(m_bufmgr);
+
+        m_osDriverContext.bufmgr          = m_bufmgr;
+        m_osDriverContext.intel_context   = mos_gem_context_create(m_bufmgr);
+        m_osDriverContext.bUse64BitRelocs = true;
+        ASSERT_NE(nullptr, m_osDriverContext.intel_context);
+        m_osDriverContext.intel_context->pOsContext = &m_osDriverContext;
+
+        MOS_ZeroMemory(&m_osInterface, sizeof(m_osInterface));
+        m_osInterface.pOsContext    = &m_osDriverContext;
+        m_osInterface.osCpInterface = &m_cpInterface;
+
+        m_gpuContext = MOS_New(GpuContextSpecific, MOS_GPU_NODE_3D, MOS_GPU_CONTEXT_RENDER, nullptr, nullptr);
+        ASSERT_NE(nullptr, m_gpuContext);
+        MOS_GPUCTX_CREATOPTIONS createOption;
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->Init(&m_osContext, &m_osInterface, MOS_GPU_NODE_3D, &createOption));
+
+        m_cmdBo = mos_bo_alloc(m_bufmgr, "cmd", CMD_BUFFER_SIZE, 4096, 0);
+        ASSERT_NE(nullptr, m_cmdBo);
+        ASSERT_EQ(0, mos_bo_set_softpin(m_cmdBo));
+        ASSERT_EQ(0, mos_bo_map(m_cmdBo, 1));
+        m_cmdBufResource = GraphicsResource::CreateGraphicResource(GraphicsResource::osSpecificResource);
+        ASSERT_NE(nullptr, m_cmdBufResource);
+    }
+
+    void TearDown() override
+    {
+        MOS_Delete(m_gpuContext);
+        MOS_Delete(m_cmdBufResource);
+        for (auto &resource : m_resources)
+        {
+            mos_bo_unreference(resource.bo);
+        }
+        if (m_cmdBo)
+        {
+            mos_bo_unmap(m_cmdBo);
+            mos_bo_unreference(m_cmdBo);
+        }
+        if (m_osDriverContext.intel_context)
+        {
+            mos_gem_context_destroy(m_osDriverContext.intel_context);
+        }
+        if (m_bufmgr)
+        {
+            mos_bufmgr_destroy(m_bufmgr);
+        }
+        g_drmMockGem = {};
+    }
+
+    //!
+    //! \brief Allocates the softpinned surfaces the command buffers point at
+    //!
+    void AllocateResources(uint32_t count)
+    {
+        m_resources.resize(count);
+        for (auto &resource : m_resources)
+        {
+            Mos_ResetResource(&resource);
+            resource.bo = mos_bo_alloc(m_bufmgr, "surface", 4096, 4096, 0);
+            ASSERT_NE(nullptr, resource.bo);
+            ASSERT_EQ(0, mos_bo_set_softpin(resource.bo));
+        }
+    }
+
+    //!
+    //! \brief Registers resources and patches one address per registration,
+    //!        cycling through the allocated resources, then submits
+    //!
+    MOS_STATUS Submit(uint32_t registrations)
+    {
+        MOS_COMMAND_BUFFER cmdBuffer;
+        InitCmdBuffer(cmdBuffer, registrations * sizeof(uint64_t));
+
+        for (uint32_t i = 0; i < registrations; i++)
+        {
+            MOS_STATUS status = AddAddress(cmdBuffer, &m_resources[i % m_resources.size()], i * sizeof(uint64_t), (i % 3) == 0);
+            if (status != MOS_STATUS_SUCCESS)
+            {
+                return status;
+            }
+        }
+
+        return m_gpuContext->SubmitCommandBuffer(&m_osInterface, &cmdBuffer, false);
+    }
+
+    void InitCmdBuffer(MOS_COMMAND_BUFFER &cmdBuffer, uint32_t offset)
+    {
+        MOS_ZeroMemory(&cmdBuffer, sizeof(cmdBuffer));
+        cmdBuffer.OsResource.bo           = m_cmdBo;
+        cmdBuffer.OsResource.pGfxResource = m_cmdBufResource;
+        cmdBuffer.pCmdBase                = (uint32_t *)m_cmdBo->virt;
+        cmdBuffer.iOffset                 = offset;
+        cmdBuffer.pCmdPtr                 = cmdBuffer.pCmdBase + offset / sizeof(uint32_t);
+        cmdBuffer.iRemaining              = CMD_BUFFER_SIZE - offset;
+    }
+
+    //!
+    //! \brief Registers resource and sets a patch entry for its address at patchOffset
+    //!
+    MOS_STATUS AddAddress(MOS_COMMAND_BUFFER &cmdBuffer, PMOS_RESOURCE resource, uint32_t patchOffset, bool write)
+    {
+        MOS_STATUS status = m_gpuContext->RegisterResource(resource, write);
+        if (status != MOS_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        MOS_PATCH_ENTRY_PARAMS params;
+        MOS_ZeroMemory(&params, sizeof(params));
+        params.presResource      = resource;
+        params.uiAllocationIndex = resource->iAllocationIndex[MOS_GPU_CONTEXT_RENDER];
+        params.uiPatchOffset     = patchOffset;
+        params.bWrite            = write;
+        params.cmdBufBase        = (uint8_t *)cmdBuffer.pCmdBase;
+        params.cmdBuffer         = &cmdBuffer;
+        return m_gpuContext->SetPatchEntry(&m_osInterface, &params);
+    }
+
+    static double ThreadCpuUs()
+    {
+        struct timespec t;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+        return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+    }
+
+    struct mos_bufmgr    *m_bufmgr = nullptr;
+    MOS_CONTEXT           m_osDriverContext = {};
+    OsContextSpecific     m_osContext;
+    MosCpInterface        m_cpInterface;
+    MOS_INTERFACE         m_osInterface;
+    GpuContextSpecific   *m_gpuContext     = nullptr;
+    MOS_LINUX_BO         *m_cmdBo          = nullptr;
+    GraphicsResource     *m_cmdBufResource = nullptr;
+    vector<MOS_RESOURCE>  m_resources;
+};
+
+TEST_F(GpuContextSpecificTest, PatchesEveryRegistration)
+{
+    AllocateResources(8);
+    ASSERT_EQ(MOS_STATUS_SUCCESS, Submit(32));
+
+    // Every patch holds the address of the resource registered for it
+    uint64_t *patches = (uint64_t *)m_cmdBo->virt;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        EXPECT_EQ(m_resources[i % 8].bo->offset64, patches[i]) << "patch " << i;
+    }
+
+    // The registrations are reset per command buffer
+    ASSERT_EQ(MOS_STATUS_SUCCESS, Submit(16));
+}
+
+TEST_F(GpuContextSpecificTest, CpuTimePerSubmit)
+{
+    // Registrations per submission and the distinct resources behind them.
+    // The allocation list holds ALLOCATIONLIST_SIZE resources, so the 1000
+    // registration case repeats resources the way a large HEVC/AV1 frame
+    // registers its surfaces from several commands.
+    const struct
+    {
+        uint32_t registrations;
+        uint32_t resources;
+    } workloads[] = {{50, 50}, {200, 200}, {1000, 250}};
+    const uint32_t submitCount = 200;
+
+    for (auto &workload : workloads)
+    {
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->ResizeCommandBufferAndPatchList(
+            CMD_BUFFER_SIZE, workload.registrations, 0));
+        for (auto &resource : m_resources)
+        {
+            mos_bo_unreference(resource.bo);
+        }
+        AllocateResources(workload.resources);
+
+        double start = ThreadCpuUs();
+        for (uint32_t i = 0; i < submitCount; i++)
+        {
+            ASSERT_EQ(MOS_STATUS_SUCCESS, Submit(workload.registrations));
+        }
+        double usPerSubmit = (ThreadCpuUs() - start) / submitCount;
+
+        RecordProperty("Resources" + to_string(workload.registrations) + "CpuUsPerSubmit", to_string(usPerSubmit));
+    }
+}
+
+//!
+//! \brief Steady state frames built either command by command, as MHW
+//!        builds them, or by replaying a command template
+//!
+class GpuContextSpecificTemplateTest : public GpuContextSpecificTest
+{
+protected:
+    static const uint32_t CMD_COUNT      = 64;  // Commands per frame
+    static const uint32_t CMD_DWORDS     = 16;  // Dwords per command, two 64 bit addresses at dwords 2 and 4
+    static const uint32_t FRAME_DW       = 8;   // Dword of the first command holding the frame number
+    static const uint32_t TEMPLATE_ID    = 1;
+
+    void SetUp() override
+    {
+        GpuContextSpecificTest::SetUp();
+        AllocateResources(32);
+        for (auto &resource : m_frameResources)
+        {
+            Mos_ResetResource(&resource);
+            resource.bo = mos_bo_alloc(m_bufmgr, "frame", 4096, 4096, 0);
+            ASSERT_NE(nullptr, resource.bo);
+            ASSERT_EQ(0, mos_bo_set_softpin(resource.bo));
+        }
+    }
+
+    void TearDown() override
+    {
+        for (auto &resource : m_frameResources)
+        {
+            mos_bo_unreference(resource.bo);
+        }
+        GpuContextSpecificTest::TearDown();
+    }
+
+    //! \brief Bitstream and output surfaces alternate between frames
+    PMOS_RESOURCE Bitstream(uint32_t frame) { return &m_frameResources[frame % 2]; }
+    PMOS_RESOURCE Output(uint32_t frame) { return &m_frameResources[2 + frame % 2]; }
+
+    MOS_STATUS BuildFrame(MOS_COMMAND_BUFFER &cmdBuffer, uint32_t frame)
+    {
+        for (uint32_t i = 0; i < CMD_COUNT; i++)
+        {
+            uint32_t cmd[CMD_DWORDS];
+            cmd[0] = 0x70000000 | (i << 16) | (CMD_DWORDS - 2);
+            for (uint32_t dw = 1; dw < CMD_DWORDS; dw++)
+            {
+                cmd[dw] = i * CMD_DWORDS + dw;
+            }
+            if (i == 0)
+            {
+                cmd[FRAME_DW] = frame;
+            }
+
+            PMOS_RESOURCE first  = (i == 0) ? Bitstream(frame) : &m_resources[i % m_resources.size()];
+            PMOS_RESOURCE second = (i == 1) ? Output(frame) : &m_resources[(i * 7) % m_resources.size()];
+            uint32_t      offset = cmdBuffer.iOffset;
+            MOS_STATUS    status = AddAddress(cmdBuffer, first, offset + 2 * sizeof(uint32_t), false);
+            if (status == MOS_STATUS_SUCCESS)
+            {
+                status = AddAddress(cmdBuffer, second, offset + 4 * sizeof(uint32_t), i == 1);
+            }
+            if (status == MOS_STATUS_SUCCESS)
+            {
+                status = Mos_AddCommand(&cmdBuffer, cmd, sizeof(cmd));
+            }
+            if (status != MOS_STATUS_SUCCESS)
+            {
+                return status;
+            }
+        }
+        return MOS_STATUS_SUCCESS;
+    }
+
+    MOS_STATUS ReplayFrame(MOS_COMMAND_BUFFER &cmdBuffer, uint32_t frame)
+    {
+        PMOS_RESOURCE recorded[]  = {Bitstream(0), Output(0)};
+        PMOS_RESOURCE resources[] = {Bitstream(frame), Output(frame)};
+        uint32_t      offsets[]   = {FRAME_DW * sizeof(uint32_t)};
+        uint32_t      values[]    = {frame};
+
+        MOS_CMD_TEMPLATE_PARAMS params;
+        params.resourceCount     = 2;
+        params.recordedResources = recorded;
+        params.resources         = resources;
+        params.dwordCount        = 1;
+        params.dwordOffsets      = offsets;
+        params.dwordValues       = values;
+        return m_gpuContext->ReplayCmdTemplate(&m_osInterface, TEMPLATE_ID, &cmdBuffer, &params);
+    }
+
+    //! \brief Builds frame 0 and records it as the template
+    void RecordTemplate()
+    {
+        MOS_COMMAND_BUFFER cmdBuffer;
+        InitCmdBuffer(cmdBuffer, 0);
+        ASSERT_EQ(MOS_STATUS_SUCCESS, BuildFrame(cmdBuffer, 0));
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->RecordCmdTemplate(&m_osInterface, TEMPLATE_ID, &cmdBuffer, 0));
+        ASSERT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->SubmitCommandBuffer(&m_osInterface, &cmdBuffer, false));
+    }
+
+    //! \brief Submits a frame and returns the patched commands
+    vector<uint8_t> SubmitFrame(uint32_t frame, bool replay)
+    {
+        MOS_COMMAND_BUFFER cmdBuffer;
+        InitCmdBuffer(cmdBuffer, 0);
+        EXPECT_EQ(MOS_STATUS_SUCCESS, replay ? ReplayFrame(cmdBuffer, frame) : BuildFrame(cmdBuffer, frame));
+        EXPECT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->SubmitCommandBuffer(&m_osInterface, &cmdBuffer, false));
+
+        uint8_t *cmds = (uint8_t *)m_cmdBo->virt;
+        return vector<uint8_t>(cmds, cmds + cmdBuffer.iOffset);
+    }
+
+    MOS_RESOURCE m_frameResources[4];
+};
+
+TEST_F(GpuContextSpecificTemplateTest, ReplayMatchesFreshBuild)
+{
+    RecordTemplate();
+
+    for (uint32_t frame = 1; frame < 4; frame++)
+    {
+        vector<uint8_t> fresh  = SubmitFrame(frame, false);
+        vector<uint8_t> replay = SubmitFrame(frame, true);
+        EXPECT_EQ(fresh, replay) << "frame " << frame;
+    }
+}
+
+TEST_F(GpuContextSpecificTemplateTest, FailedReplayLeavesCommandBuffer)
+{
+    MOS_COMMAND_BUFFER cmdBuffer;
+    InitCmdBuffer(cmdBuffer, 0);
+    EXPECT_NE(MOS_STATUS_SUCCESS, ReplayFrame(cmdBuffer, 1));
+    EXPECT_EQ(0, cmdBuffer.iOffset);
+
+    RecordTemplate();
+    InitCmdBuffer(cmdBuffer, CMD_BUFFER_SIZE - CMD_DWORDS * sizeof(uint32_t));
+    EXPECT_EQ(MOS_STATUS_NO_SPACE, ReplayFrame(cmdBuffer, 1));
+
+    m_gpuContext->InvalidateCmdTemplate(TEMPLATE_ID);
+    InitCmdBuffer(cmdBuffer, 0);
+    EXPECT_NE(MOS_STATUS_SUCCESS, ReplayFrame(cmdBuffer, 1));
+}
+
+TEST_F(GpuContextSpecificTemplateTest, CpuTimePerFrame)
+{
+    // The mock GEM executes nothing, standing in for the null hardware path
+    const uint32_t frameCount = 500;
+    RecordTemplate();
+
+    for (bool replay : {false, true})
+    {
+        double start = ThreadCpuUs();
+        for (uint32_t frame = 1; frame <= frameCount; frame++)
+        {
+            MOS_COMMAND_BUFFER cmdBuffer;
+            InitCmdBuffer(cmdBuffer, 0);
+            ASSERT_EQ(MOS_STATUS_SUCCESS, replay ? ReplayFrame(cmdBuffer, frame) : BuildFrame(cmdBuffer, frame));
+            ASSERT_EQ(MOS_STATUS_SUCCESS, m_gpuContext->SubmitCommandBuffer(&m_osInterface, &cmdBuffer, false));
+        }
+        double usPerFrame = (ThreadCpuUs() - start) / frameCount;
+
+        RecordProperty(replay ? "ReplayCpuUsPerFrame" : "BuildCpuUsPerFrame", to_string(usPerFrame));
+    }
+}
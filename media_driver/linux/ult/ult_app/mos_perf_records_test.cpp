@@ -0,0 +1,289 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "mos_perf_records.h"
+
+using namespace std;
+
+static const uint64_t NS_PER_MS = 1000000;
+
+class MosPerfRecordsTest : public testing::Test
+{
+protected:
+    MosPerfRecords m_records{true};  // Tests pass timestamps in ns
+};
+
+TEST_F(MosPerfRecordsTest, TagIds)
+{
+    uint32_t a = m_records.GetTagId("A");
+    uint32_t b = m_records.GetTagId("B");
+    EXPECT_NE(a, b);
+
+    // Same name from a different buffer and from another thread
+    string name("A");
+    EXPECT_EQ(a, m_records.GetTagId(name.c_str()));
+
+    uint32_t other = ~0u;
+    thread([&]() { other = m_records.GetTagId("B"); }).join();
+    EXPECT_EQ(b, other);
+
+    // Enough tags to grow the per thread cache
+    vector<uint32_t> ids;
+    for (int i = 0; i < 1000; i++)
+    {
+        ids.push_back(m_records.GetTagId(("T" + to_string(i)).c_str()));
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_EQ(ids[i], m_records.GetTagId(("T" + to_string(i)).c_str()));
+    }
+}
+
+TEST_F(MosPerfRecordsTest, Percentiles)
+{
+    uint32_t tag = m_records.GetTagId("Scope");
+
+    // 1..100 ms, recorded out of order
+    for (uint64_t i = 0; i < 100; i++)
+    {
+        uint64_t ms = (i * 37) % 100 + 1;
+        m_records.Begin(tag, 0);
+        m_records.End(tag, ms * NS_PER_MS);
+    }
+
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+    ASSERT_EQ(1u, summaries.size());
+
+    const MosPerfRecords::Summary &s = summaries[0];
+    EXPECT_EQ("Scope", s.tag);
+    EXPECT_EQ(100u, s.count);
+    EXPECT_DOUBLE_EQ(50.5, s.avg);
+    EXPECT_DOUBLE_EQ(1, s.min);
+    EXPECT_DOUBLE_EQ(100, s.max);
+    EXPECT_DOUBLE_EQ(50, s.p50);
+    EXPECT_DOUBLE_EQ(90, s.p90);
+    EXPECT_DOUBLE_EQ(99, s.p99);
+    ASSERT_EQ(100u, s.times.size());
+    EXPECT_DOUBLE_EQ(1, s.times[0]);
+}
+
+TEST_F(MosPerfRecordsTest, NestedAndUnmatched)
+{
+    uint32_t outer = m_records.GetTagId("Outer");
+    uint32_t inner = m_records.GetTagId("Inner");
+
+    m_records.Begin(outer, 0);
+    m_records.Begin(inner, 1 * NS_PER_MS);
+    m_records.End(inner, 3 * NS_PER_MS);
+    m_records.End(outer, 10 * NS_PER_MS);
+
+    // Stop without start, and a stop on a thread that did not start
+    m_records.End(inner, 20 * NS_PER_MS);
+    m_records.Begin(outer, 0);
+    thread([&]() { m_records.End(outer, 5 * NS_PER_MS); }).join();
+    EXPECT_EQ(2u, m_records.GetUnmatchedCount());
+
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+    ASSERT_EQ(2u, summaries.size());
+    EXPECT_EQ("Inner", summaries[0].tag);
+    EXPECT_DOUBLE_EQ(2, summaries[0].max);
+    EXPECT_EQ("Outer", summaries[1].tag);
+    EXPECT_EQ(1u, summaries[1].count);
+    EXPECT_DOUBLE_EQ(10, summaries[1].max);
+}
+
+TEST_F(MosPerfRecordsTest, Threads)
+{
+    const int      threadCount = 8;
+    const uint32_t perThread   = 10000;  // Spans several chunks
+
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]() {
+            uint32_t shared = m_records.GetTagId("Shared");
+            uint32_t own    = m_records.GetTagId(("Thread" + to_string(t)).c_str());
+            for (uint32_t i = 0; i < perThread; i++)
+            {
+                m_records.Begin(shared, 0);
+                m_records.Begin(own, 0);
+                m_records.End(own, (t + 1) * NS_PER_MS);
+                m_records.End(shared, NS_PER_MS);
+            }
+        });
+    }
+
+    // Dumping while the threads record must be safe
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    m_records.Merge(summaries);
+    ASSERT_EQ(threadCount + 1u, summaries.size());
+    EXPECT_EQ("Shared", summaries[0].tag);
+    EXPECT_EQ(threadCount * perThread, summaries[0].count);
+    for (int t = 0; t < threadCount; t++)
+    {
+        EXPECT_EQ(perThread, summaries[t + 1].count);
+        EXPECT_DOUBLE_EQ(t + 1, summaries[t + 1].p99);
+    }
+    EXPECT_EQ(0u, m_records.GetUnmatchedCount());
+}
+
+TEST_F(MosPerfRecordsTest, SharedAcrossThreads)
+{
+    // Like "First Frame Time": started in one DDI call, stopped in another
+    uint32_t tag = m_records.GetTagId("Shared");
+    thread([&]() { m_records.BeginShared(tag, 0); }).join();
+    thread([&]() { m_records.EndShared(tag, 4 * NS_PER_MS); }).join();
+
+    // The latest open scope is closed first
+    m_records.BeginShared(tag, 0);
+    m_records.BeginShared(tag, 5 * NS_PER_MS);
+    m_records.EndShared(tag, 6 * NS_PER_MS);
+    m_records.EndShared(tag, 7 * NS_PER_MS);
+    m_records.EndShared(tag, 8 * NS_PER_MS);
+    EXPECT_EQ(1u, m_records.GetUnmatchedCount());
+
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+    ASSERT_EQ(1u, summaries.size());
+    EXPECT_EQ(3u, summaries[0].count);
+    EXPECT_DOUBLE_EQ(1, summaries[0].min);
+    EXPECT_DOUBLE_EQ(7, summaries[0].max);
+}
+
+TEST_F(MosPerfRecordsTest, ThreadExit)
+{
+    uint32_t tag = m_records.GetTagId("Exit");
+    m_records.Begin(tag, 0);
+    EXPECT_EQ(1u, m_records.GetThreadBufferCount());
+
+    // Buffers of exited threads are freed, their records kept
+    for (int t = 0; t < 4; t++)
+    {
+        thread([&, t]() {
+            m_records.Begin(tag, 0);
+            m_records.End(tag, (t + 1) * NS_PER_MS);
+            EXPECT_EQ(2u, m_records.GetThreadBufferCount());
+        }).join();
+        EXPECT_EQ(1u, m_records.GetThreadBufferCount());
+    }
+
+    m_records.End(tag, 10 * NS_PER_MS);
+
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+    ASSERT_EQ(1u, summaries.size());
+    EXPECT_EQ(5u, summaries[0].count);
+    EXPECT_DOUBLE_EQ(1, summaries[0].min);
+    EXPECT_DOUBLE_EQ(10, summaries[0].max);
+
+    // A thread outliving the instance must not touch it at exit
+    MosPerfRecords    *records = new MosPerfRecords(true);
+    bool               started = false;
+    bool               done    = false;
+    mutex              lock;
+    condition_variable cv;
+    thread late([&]() {
+        records->Begin(records->GetTagId("Late"), 0);
+        unique_lock<mutex> guard(lock);
+        started = true;
+        cv.notify_one();
+        cv.wait(guard, [&]() { return done; });
+    });
+    {
+        unique_lock<mutex> guard(lock);
+        cv.wait(guard, [&]() { return started; });
+    }
+    delete records;
+    {
+        lock_guard<mutex> guard(lock);
+        done = true;
+    }
+    cv.notify_one();
+    late.join();
+}
+
+TEST_F(MosPerfRecordsTest, TicksToMs)
+{
+    // Real timestamps are converted with the calibrated tick rate
+    MosPerfRecords records;
+    uint32_t       tag = records.GetTagId("Sleep");
+    records.Begin(tag, MosPerfRecords::GetTicks());
+    this_thread::sleep_for(chrono::milliseconds(20));
+    records.End(tag, MosPerfRecords::GetTicks());
+
+    vector<MosPerfRecords::Summary> summaries;
+    records.Merge(summaries);
+    ASSERT_EQ(1u, summaries.size());
+    EXPECT_GE(summaries[0].max, 19.0);
+    RecordProperty("SleepMs", to_string(summaries[0].max));
+}
+
+// Opt-in benchmark, run with --gtest_also_run_disabled_tests
+TEST_F(MosPerfRecordsTest, DISABLED_ScopeCost)
+{
+    // Same work as one PERF_UTILITY_AUTO scope: tag lookup, two timestamp
+    // reads, begin and end.
+    const uint32_t iterations = 1000000;
+    const char    *tag        = "ScopeCost";
+
+    uint64_t start = MosPerfRecords::GetMonotonicNs();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint32_t id = m_records.GetTagId(tag);
+        m_records.Begin(id, MosPerfRecords::GetTicks());
+        m_records.End(id, MosPerfRecords::GetTicks());
+    }
+    double nsPerScope = (double)(MosPerfRecords::GetMonotonicNs() - start) / iterations;
+
+    // The timestamp reads alone, which depend on the platform
+    volatile uint64_t sink = 0;
+    start = MosPerfRecords::GetMonotonicNs();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        sink += MosPerfRecords::GetTicks();
+        sink += MosPerfRecords::GetTicks();
+    }
+    double nsPerClock = (double)(MosPerfRecords::GetMonotonicNs() - start) / iterations;
+
+    RecordProperty("NsPerScope", to_string(nsPerScope));
+    RecordProperty("NsPerTimestampPair", to_string(nsPerClock));
+    RecordProperty("NsRecordOverhead", to_string(nsPerScope - nsPerClock));
+
+    vector<MosPerfRecords::Summary> summaries;
+    m_records.Merge(summaries);
+    ASSERT_EQ(1u, summaries.size());
+    EXPECT_EQ(iterations, summaries[0].count);
+}
@@ -19,7 +19,18 @@
 * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 * OTHER DEALINGS IN THE SOFTWARE.
 */
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <cstdlib>
 #include <cstring>
+#include <unistd.h>
+#include "mos_os.h"
+#include "mos_auxtable_mgr.h"
+#include "mos_cmdbufmgr.h"
+#include "mos_commandbuffer_specific.h"
+#include "mos_context_specific.h"
+#include "mos_graphicsresource.h"
 
 using namespace std;
 
@@ -35,6 +46,296 @@ void MOS_ZeroMemory(void *pDestination, size_t stLength)
     }
 }
 
+#if MOS_MESSAGES_ENABLED
+void *MOS_AllocMemoryUtils(size_t size, const char *functionName, const char *filename, int32_t line)
+{
+    return malloc(size);
+}
+
+void *MOS_AllocAndZeroMemoryUtils(size_t size, const char *functionName, const char *filename, int32_t line)
+{
+    return calloc(1, size);
+}
+
+void MOS_FreeMemoryUtils(void *ptr, const char *functionName, const char *filename, int32_t line)
+{
+    free(ptr);
+}
+#else
+void *MOS_AllocMemory(size_t size)
+{
+    return malloc(size);
+}
+
+void *MOS_AllocAndZeroMemory(size_t size)
+{
+    return calloc(1, size);
+}
+
+void MOS_FreeMemory(void *ptr)
+{
+    free(ptr);
+}
+#endif
+
+MOS_STATUS MOS_SecureMemcpy(void *pDestination, size_t dstLength, const void *pSource, size_t srcLength)
+{
+    if (pDestination == nullptr || pSource == nullptr || dstLength < srcLength)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+    memcpy(pDestination, pSource, srcLength);
+    return MOS_STATUS_SUCCESS;
+}
+
+int32_t MOS_SecureStringPrint(char *buffer, size_t bufSize, size_t length, const char * const format, ...)
+{
+    va_list var_args;
+    va_start(var_args, format);
+    int32_t ret = vsnprintf(buffer, length < bufSize ? length : bufSize, format, var_args);
+    va_end(var_args);
+    return ret;
+}
+
+MOS_STATUS MOS_WriteFileFromPtr(const char *pFilename, void *lpBuffer, uint32_t writeSize)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+void MOS_Sleep(uint32_t mSec)
+{
+    usleep(1000 * mSec);
+}
+
+int32_t MOS_QueryPerformanceFrequency(uint64_t *pFrequency)
+{
+    *pFrequency = 1000000000;
+    return true;
+}
+
+int32_t MOS_QueryPerformanceCounter(uint64_t *pPerformanceCount)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    *pPerformanceCount = (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+    return true;
+}
+
+PMOS_MUTEX MOS_CreateMutex()
+{
+    PMOS_MUTEX mutex = (PMOS_MUTEX)MOS_AllocMemory(sizeof(MOS_MUTEX));
+    if (mutex != nullptr)
+    {
+        pthread_mutex_init(mutex, nullptr);
+    }
+    return mutex;
+}
+
+MOS_STATUS MOS_DestroyMutex(PMOS_MUTEX pMutex)
+{
+    if (pMutex != nullptr)
+    {
+        pthread_mutex_destroy(pMutex);
+        MOS_FreeMemory(pMutex);
+    }
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS MOS_LockMutex(PMOS_MUTEX pMutex)
+{
+    return pMutex && pthread_mutex_lock(pMutex) == 0 ? MOS_STATUS_SUCCESS : MOS_STATUS_INVALID_HANDLE;
+}
+
+MOS_STATUS MOS_UnlockMutex(PMOS_MUTEX pMutex)
+{
+    return pMutex && pthread_mutex_unlock(pMutex) == 0 ? MOS_STATUS_SUCCESS : MOS_STATUS_INVALID_HANDLE;
+}
+
+MOS_STATUS Mos_AddCommand(PMOS_COMMAND_BUFFER pCmdBuffer, const void *pCmd, uint32_t dwCmdSize)
+{
+    if (pCmdBuffer == nullptr || pCmd == nullptr || (int32_t)dwCmdSize > pCmdBuffer->iRemaining)
+    {
+        return MOS_STATUS_UNKNOWN;
+    }
+    memcpy(pCmdBuffer->pCmdPtr, pCmd, dwCmdSize);
+    pCmdBuffer->pCmdPtr    += dwCmdSize / sizeof(uint32_t);
+    pCmdBuffer->iOffset    += dwCmdSize;
+    pCmdBuffer->iRemaining -= dwCmdSize;
+    return MOS_STATUS_SUCCESS;
+}
+
+int32_t Mos_ResourceIsNull(PMOS_RESOURCE pOsResource)
+{
+    return pOsResource == nullptr || pOsResource->bo == nullptr;
+}
+
+void Mos_ResetResource(PMOS_RESOURCE pOsResource)
+{
+    MOS_ZeroMemory(pOsResource, sizeof(MOS_RESOURCE));
+    pOsResource->Format = Format_None;
+    for (int32_t i = 0; i < MOS_GPU_CONTEXT_MAX; i++)
+    {
+        pOsResource->iAllocationIndex[i] = MOS_INVALID_ALLOC_INDEX;
+    }
+}
+
+#if MOS_MESSAGES_ENABLED
+void MOS_Message(MOS_MESSAGE_LEVEL level, const PCCHAR logtag, MOS_COMPONENT_ID compID, uint8_t subCompID,
+    const PCCHAR functionName, int32_t lineNum, const PCCHAR message, ...)
+{
+}
+#endif
+
+#if MOS_ASSERT_ENABLED
+void _MOS_Assert(MOS_COMPONENT_ID compID, uint8_t subCompID)
+{
+}
+#endif
+
 #ifdef __cplusplus
     } // extern "C" 
 #endif
+
+int32_t MosUtilities::m_mosMemAllocCounter = 0;
+
+double MosUtilities::MosGetTime()
+{
+    return 0;
+}
+
+uint64_t MOS_GetCurTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#if (_DEBUG || _RELEASE_INTERNAL)
+bool MosUtilities::MosSimulateAllocMemoryFail(size_t size, size_t alignment, const char *functionName, const char *filename, int32_t line)
+{
+    return false;
+}
+#endif
+
+int32_t MosUtilities::MosAtomicIncrement(int32_t *pValue)
+{
+    return __sync_add_and_fetch(pValue, 1);
+}
+
+int32_t MosUtilities::MosAtomicDecrement(int32_t *pValue)
+{
+    return __sync_sub_and_fetch(pValue, 1);
+}
+
+MOS_STATUS MosUtilities::MosSecureMemcpy(void *pDestination, size_t dstLength, const void *pSource, size_t srcLength)
+{
+    return MOS_SecureMemcpy(pDestination, dstLength, pSource, srcLength);
+}
+
+MOS_STATUS MosUtilities::MosSecureStrcpy(char *strDestination, size_t numberOfElements, const char * const strSource)
+{
+    if (strDestination == nullptr || strSource == nullptr || strlen(strSource) >= numberOfElements)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+    strcpy(strDestination, strSource);
+    return MOS_STATUS_SUCCESS;
+}
+
+uint8_t MosUtilities::m_mosUltFlag = 0;
+
+// The OS layer classes below stand in for the parts of GpuContextSpecific's
+// environment the ULT does not exercise: no aux table, no command buffer
+// pool, and graphics resources backed by plain memory.
+OsContextSpecific::OsContextSpecific()
+{
+}
+
+OsContextSpecific::~OsContextSpecific()
+{
+}
+
+MOS_STATUS OsContextSpecific::Init(PMOS_CONTEXT osDriverContext)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+void OsContextSpecific::Destroy()
+{
+}
+
+void OsContextSpecific::SetSliceCount(uint32_t *pSliceCount)
+{
+}
+
+MOS_STATUS AuxTableMgr::MapResource(GMM_RESOURCE_INFO *gmmResInfo, MOS_LINUX_BO *bo)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS AuxTableMgr::EmitAuxTableBOList(MOS_LINUX_BO *cmd_bo)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+CommandBuffer *CmdBufMgr::PickupOneCmdBuf(uint32_t size)
+{
+    return nullptr;
+}
+
+MOS_STATUS CmdBufMgr::ReleaseCmdBuf(CommandBuffer *cmdBuf)
+{
+    return MOS_STATUS_SUCCESS;
+}
+
+void CommandBufferSpecific::waitReady()
+{
+}
+
+class GraphicsResourceStub : public GraphicsResource
+{
+public:
+    MOS_STATUS SetSyncTag(OsContext *osContextPtr, SyncParams &params, uint32_t streamIndex) override
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+
+    bool ResourceIsNull() override { return m_data == nullptr; }
+
+    MOS_STATUS Allocate(OsContext *osContextPtr, CreateParams &params) override
+    {
+        m_data = (uint8_t *)MOS_AllocAndZeroMemory(params.m_width * params.m_height);
+        return m_data ? MOS_STATUS_SUCCESS : MOS_STATUS_NO_SPACE;
+    }
+
+    void Free(OsContext *osContextPtr, uint32_t freeFlag = 0) override
+    {
+        MOS_FreeMemAndSetNull(m_data);
+    }
+
+    bool IsEqual(GraphicsResource *toCompare) override { return toCompare == this; }
+
+    bool IsValid() override { return m_data != nullptr; }
+
+    void *Lock(OsContext *osContextPtr, LockParams &params) override { return m_data; }
+
+    MOS_STATUS Unlock(OsContext *osContextPtr) override { return MOS_STATUS_SUCCESS; }
+
+    MOS_STATUS ConvertToMosResource(MOS_RESOURCE *pMosResource) override { return MOS_STATUS_SUCCESS; }
+
+private:
+    uint8_t *m_data = nullptr;
+};
+
+GraphicsResource::GraphicsResource()
+{
+}
+
+GraphicsResource::~GraphicsResource()
+{
+}
+
+GraphicsResource *GraphicsResource::CreateGraphicResource(GraphicsResource::ResourceType resourceType)
+{
+    return MOS_New(GraphicsResourceStub);
+}
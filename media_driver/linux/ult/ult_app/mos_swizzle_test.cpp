@@ -0,0 +1,223 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "mos_swizzle.h"
+
+using namespace std;
+
+// Per byte path of Mos_SwizzleData, which the tile line copy replaced for X
+// and Y tiles: every byte goes through Mos_SwizzleOffset without CSX.
+static int32_t RefSwizzleOffset(int32_t offsetX, int32_t offsetY, int32_t pitch, MOS_TILE_TYPE tileFormat)
+{
+    int32_t lBits = (tileFormat == MOS_TILE_Y) ? 5 : 3;
+    int32_t lPos  = (tileFormat == MOS_TILE_Y) ? 4 : 9;
+    int32_t row   = offsetY >> lBits;
+    int32_t line  = offsetY & ((1 << lBits) - 1);
+    int32_t col   = offsetX >> lPos;
+    int32_t x     = offsetX & ((1 << lPos) - 1);
+
+    return (((((row * (pitch >> lPos)) + col) << lBits) + line) << lPos) + x;
+}
+
+static void RefSwizzleData(uint8_t *src, uint8_t *dst, MOS_TILE_TYPE srcTiling, MOS_TILE_TYPE dstTiling,
+    int32_t height, int32_t pitch)
+{
+    int32_t linearOffset = 0;
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < pitch; x++, linearOffset++)
+        {
+            if (srcTiling != MOS_TILE_LINEAR)
+            {
+                dst[linearOffset] = src[RefSwizzleOffset(x, y, pitch, srcTiling)];
+            }
+            else
+            {
+                dst[RefSwizzleOffset(x, y, pitch, dstTiling)] = src[linearOffset];
+            }
+        }
+    }
+}
+
+// Runs every band on the caller, as Mos_SwizzleData does when no thread
+// can be created
+static bool SwizzleData(uint8_t *src, uint8_t *dst, MOS_TILE_TYPE srcTiling, MOS_TILE_TYPE dstTiling,
+    int32_t height, int32_t pitch, int32_t maxBands)
+{
+    MOS_SWIZZLE_BAND bands[MOS_SWIZZLE_MAX_BANDS];
+    int32_t bandCount = Mos_SwizzleSplitBands(src, dst, srcTiling, dstTiling, height, pitch, maxBands, bands);
+    for (int32_t i = 0; i < bandCount; i++)
+    {
+        Mos_SwizzleBand(&bands[i]);
+    }
+    return bandCount > 0;
+}
+
+class MosSwizzleTest : public testing::Test
+{
+protected:
+    // Tiled surfaces take whole tile rows
+    static size_t TiledSize(MOS_TILE_TYPE tiling, int32_t height, int32_t pitch)
+    {
+        int32_t lines = (tiling == MOS_TILE_Y) ? 32 : 8;
+        return (size_t)((height + lines - 1) / lines * lines) * pitch;
+    }
+
+    static void Fill(vector<uint8_t> &buffer, uint32_t seed)
+    {
+        for (size_t i = 0; i < buffer.size(); i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            buffer[i] = (uint8_t)(seed >> 16);
+        }
+    }
+
+    void ExpectBitExact(MOS_TILE_TYPE tiling, int32_t height, int32_t pitch, int32_t maxBands)
+    {
+        size_t tiledSize  = TiledSize(tiling, height, pitch);
+        size_t linearSize = (size_t)height * pitch;
+
+        // Tiled to linear
+        vector<uint8_t> tiled(tiledSize);
+        vector<uint8_t> ref(linearSize, 0xcd);
+        vector<uint8_t> out(linearSize, 0xcd);
+        Fill(tiled, height * 31 + pitch);
+        RefSwizzleData(tiled.data(), ref.data(), tiling, MOS_TILE_LINEAR, height, pitch);
+        ASSERT_TRUE(SwizzleData(tiled.data(), out.data(), tiling, MOS_TILE_LINEAR, height, pitch, maxBands));
+        EXPECT_TRUE(ref == out) << "tiled to linear, height " << height << ", pitch " << pitch << ", bands " << maxBands;
+
+        // Linear to tiled, bytes past the last line must be left alone
+        vector<uint8_t> linear(linearSize);
+        vector<uint8_t> refTiled(tiledSize, 0xcd);
+        vector<uint8_t> outTiled(tiledSize, 0xcd);
+        Fill(linear, height * 17 + pitch);
+        RefSwizzleData(linear.data(), refTiled.data(), MOS_TILE_LINEAR, tiling, height, pitch);
+        ASSERT_TRUE(SwizzleData(linear.data(), outTiled.data(), MOS_TILE_LINEAR, tiling, height, pitch, maxBands));
+        EXPECT_TRUE(refTiled == outTiled) << "linear to tiled, height " << height << ", pitch " << pitch << ", bands " << maxBands;
+    }
+};
+
+TEST_F(MosSwizzleTest, TileYBitExact)
+{
+    // Odd multiples of the 16 byte span, and heights with partial tile rows
+    for (int32_t pitch : {16, 48, 208, 720, 1936})
+    {
+        for (int32_t height : {1, 7, 31, 32, 33, 65, 97, 255})
+        {
+            for (int32_t bands = 1; bands <= MOS_SWIZZLE_MAX_BANDS; bands++)
+            {
+                ExpectBitExact(MOS_TILE_Y, height, pitch, bands);
+            }
+        }
+    }
+}
+
+TEST_F(MosSwizzleTest, TileXBitExact)
+{
+    // Odd multiples of the 512 byte span, and heights with partial tile rows
+    for (int32_t pitch : {512, 1536, 2560})
+    {
+        for (int32_t height : {1, 3, 7, 8, 9, 17, 63, 129})
+        {
+            for (int32_t bands = 1; bands <= MOS_SWIZZLE_MAX_BANDS; bands++)
+            {
+                ExpectBitExact(MOS_TILE_X, height, pitch, bands);
+            }
+        }
+    }
+}
+
+TEST_F(MosSwizzleTest, PerBytePathKept)
+{
+    MOS_SWIZZLE_BAND bands[MOS_SWIZZLE_MAX_BANDS];
+    uint8_t          src[16];
+    uint8_t          dst[16];
+
+    // Tile lines would overlap at pitches that are not a multiple of the span
+    for (int32_t pitch : {1, 17, 100, 1000, 1937})
+    {
+        EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_Y, MOS_TILE_LINEAR, 64, pitch, 1, bands)) << pitch;
+        EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_LINEAR, MOS_TILE_Y, 64, pitch, 1, bands)) << pitch;
+    }
+    for (int32_t pitch : {16, 513, 1000, 2048 + 16})
+    {
+        EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_X, MOS_TILE_LINEAR, 64, pitch, 1, bands)) << pitch;
+        EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_LINEAR, MOS_TILE_X, 64, pitch, 1, bands)) << pitch;
+    }
+
+    // Other tilings, tiled to tiled and empty surfaces
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_YS, MOS_TILE_LINEAR, 64, 512, 1, bands));
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_LINEAR, MOS_TILE_YF, 64, 512, 1, bands));
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_X, MOS_TILE_Y, 64, 512, 1, bands));
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_LINEAR, MOS_TILE_LINEAR, 64, 512, 1, bands));
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_Y, MOS_TILE_LINEAR, 0, 512, 1, bands));
+    EXPECT_EQ(0, Mos_SwizzleSplitBands(src, dst, MOS_TILE_Y, MOS_TILE_LINEAR, 64, 0, 1, bands));
+}
+
+TEST_F(MosSwizzleTest, BandsCoverWholeTileRows)
+{
+    MOS_SWIZZLE_BAND bands[MOS_SWIZZLE_MAX_BANDS];
+    uint8_t          src[16];
+    uint8_t          dst[16];
+
+    // Never more bands than tile rows, and no band starts inside a tile row
+    EXPECT_EQ(2, Mos_SwizzleSplitBands(src, dst, MOS_TILE_Y, MOS_TILE_LINEAR, 33, 64, 8, bands));
+    EXPECT_EQ(MOS_SWIZZLE_MAX_BANDS, Mos_SwizzleSplitBands(src, dst, MOS_TILE_Y, MOS_TILE_LINEAR, 1000, 64, 8, bands));
+    int32_t rowEnd = 0;
+    for (int32_t i = 0; i < MOS_SWIZZLE_MAX_BANDS; i++)
+    {
+        EXPECT_EQ(rowEnd, bands[i].iRowStart);
+        EXPECT_EQ(0, bands[i].iRowStart % 32);
+        rowEnd = bands[i].iRowEnd;
+    }
+    EXPECT_EQ(1000, rowEnd);
+}
+
+TEST_F(MosSwizzleTest, Timing)
+{
+    const int32_t pitch  = 4096;
+    const int32_t height = 2160;
+
+    for (MOS_TILE_TYPE tiling : {MOS_TILE_Y, MOS_TILE_X})
+    {
+        string          name   = (tiling == MOS_TILE_Y) ? "TileY" : "TileX";
+        vector<uint8_t> tiled(TiledSize(tiling, height, pitch));
+        vector<uint8_t> ref((size_t)height * pitch);
+        vector<uint8_t> out((size_t)height * pitch);
+        Fill(tiled, 1);
+
+        auto start = chrono::steady_clock::now();
+        RefSwizzleData(tiled.data(), ref.data(), tiling, MOS_TILE_LINEAR, height, pitch);
+        auto refUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        ASSERT_TRUE(SwizzleData(tiled.data(), out.data(), tiling, MOS_TILE_LINEAR, height, pitch, 1));
+        auto tileLineUs = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+        EXPECT_TRUE(ref == out);
+        RecordProperty(name + "PerByteUs", to_string(refUs));
+        RecordProperty(name + "TileLineUs", to_string(tileLineUs));
+    }
+}
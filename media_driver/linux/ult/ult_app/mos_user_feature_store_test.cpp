@@ -0,0 +1,239 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+#include "gtest/gtest.h"
+#include "mos_user_feature_store.h"
+
+using namespace std;
+
+static atomic<int> s_liveKeyLists{0};
+
+// Parses a file holding one decimal number into key "Key", value "Value"
+static MOS_STATUS DumpFile(const char * const fileName, MOS_PUF_KEYLIST *keyList)
+{
+    *keyList = nullptr;
+
+    FILE *file = fopen(fileName, "r");
+    if (file == nullptr)
+    {
+        return MOS_STATUS_USER_FEATURE_KEY_OPEN_FAILED;
+    }
+    uint32_t number = 0;
+    if (fscanf(file, "%u", &number) != 1)
+    {
+        number = 0;
+    }
+    fclose(file);
+
+    MOS_UF_KEYNODE *node  = (MOS_UF_KEYNODE *)calloc(1, sizeof(MOS_UF_KEYNODE));
+    MOS_UF_KEY     *key   = (MOS_UF_KEY *)calloc(1, sizeof(MOS_UF_KEY));
+    MOS_UF_VALUE   *value = (MOS_UF_VALUE *)calloc(1, sizeof(MOS_UF_VALUE));
+    uint32_t       *data  = (uint32_t *)malloc(sizeof(uint32_t));
+
+    *data = number;
+    strcpy(value->pcValueName, "Value");
+    value->ulValueLen  = sizeof(uint32_t);
+    value->ulValueBuf  = data;
+    value->ulValueType = 4;
+    strcpy(key->pcKeyName, "Key");
+    key->UFKey       = (void *)(uintptr_t)0x10;
+    key->ulValueNum  = 1;
+    key->pValueArray = value;
+    node->pElem      = key;
+
+    *keyList = node;
+    s_liveKeyLists++;
+    return MOS_STATUS_SUCCESS;
+}
+
+static void FreeKeyList(MOS_PUF_KEYLIST keyList)
+{
+    if (keyList == nullptr)
+    {
+        return;
+    }
+    free(keyList->pElem->pValueArray->ulValueBuf);
+    free(keyList->pElem->pValueArray);
+    free(keyList->pElem);
+    free(keyList);
+    s_liveKeyLists--;
+}
+
+class TestUserFeatureStore : public MosUserFeatureStore
+{
+public:
+    TestUserFeatureStore() : MosUserFeatureStore(DumpFile, FreeKeyList) {}
+
+    using MosUserFeatureStore::Acquire;
+    using MosUserFeatureStore::SnapshotPtr;
+};
+
+class MosUserFeatureStoreTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char fileName[] = "/tmp/mos_uf_store_XXXXXX";
+        int  fd         = mkstemp(fileName);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        m_fileName = fileName;
+        s_liveKeyLists = 0;
+    }
+
+    void TearDown() override
+    {
+        m_store.Clear();
+        EXPECT_EQ(0, s_liveKeyLists.load());
+        unlink(m_fileName.c_str());
+    }
+
+    // Same size and mtime, so only Invalidate() reveals the change
+    void Write(uint32_t number)
+    {
+        struct stat before = {};
+        stat(m_fileName.c_str(), &before);
+
+        FILE *file = fopen(m_fileName.c_str(), "w");
+        ASSERT_NE(nullptr, file);
+        fprintf(file, "%08u", number);
+        fclose(file);
+
+        struct timespec times[2] = {before.st_atim, before.st_mtim};
+        utimensat(AT_FDCWD, m_fileName.c_str(), times, 0);
+    }
+
+    // New inode, so readers never see a partly written file
+    void Replace(uint32_t number)
+    {
+        string tmpName = m_fileName + ".tmp";
+        FILE  *file    = fopen(tmpName.c_str(), "w");
+        ASSERT_NE(nullptr, file);
+        fprintf(file, "%08u", number);
+        fclose(file);
+        ASSERT_EQ(0, rename(tmpName.c_str(), m_fileName.c_str()));
+    }
+
+    uint32_t Read()
+    {
+        uint32_t number = ~0u;
+        EXPECT_EQ(MOS_STATUS_SUCCESS, m_store.QueryValue(m_fileName.c_str(), "Key", "Value", nullptr, &number, nullptr));
+        return number;
+    }
+
+    string               m_fileName;
+    TestUserFeatureStore m_store;
+};
+
+TEST_F(MosUserFeatureStoreTest, WriteVisibleAfterInvalidate)
+{
+    Write(1);
+    EXPECT_EQ(1u, Read());
+
+    Write(2);
+    EXPECT_EQ(1u, Read());  // Cached, the file looks unchanged
+
+    m_store.Invalidate();
+    EXPECT_EQ(2u, Read());
+    EXPECT_EQ(1, s_liveKeyLists.load());
+
+    void *ufKey = nullptr;
+    char  keyName[MAX_USERFEATURE_LINE_LENGTH];
+    EXPECT_EQ(MOS_STATUS_SUCCESS, m_store.GetKeyIdByName(m_fileName.c_str(), "Key", &ufKey));
+    EXPECT_EQ(MOS_STATUS_SUCCESS, m_store.GetKeyNameById(m_fileName.c_str(), ufKey, keyName));
+    EXPECT_STREQ("Key", keyName);
+    EXPECT_EQ(MOS_STATUS_UNKNOWN, m_store.QueryValue(m_fileName.c_str(), "Key", "Missing", nullptr, &ufKey, nullptr));
+}
+
+TEST_F(MosUserFeatureStoreTest, OldReaderStaysValid)
+{
+    Write(1);
+    TestUserFeatureStore::SnapshotPtr reader = m_store.Acquire(m_fileName.c_str());
+    ASSERT_NE(nullptr, reader);
+
+    Write(2);
+    m_store.Invalidate();
+    EXPECT_EQ(2u, Read());
+
+    // The old snapshot lives on until its reader drops it
+    EXPECT_EQ(2, s_liveKeyLists.load());
+    auto it = reader->values.find("Key\nValue");
+    ASSERT_NE(reader->values.end(), it);
+    EXPECT_EQ(1u, *(uint32_t *)it->second->ulValueBuf);
+
+    reader.reset();
+    EXPECT_EQ(1, s_liveKeyLists.load());
+}
+
+TEST_F(MosUserFeatureStoreTest, RetiredSnapshotsReclaimed)
+{
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        Write(i);
+        m_store.Invalidate();
+        EXPECT_EQ(i, Read());
+    }
+    EXPECT_EQ(1, s_liveKeyLists.load());
+}
+
+TEST_F(MosUserFeatureStoreTest, ConcurrentReadersAndWriter)
+{
+    Replace(0);
+    atomic<bool> stop{false};
+
+    vector<thread> readers;
+    for (int t = 0; t < 4; t++)
+    {
+        readers.emplace_back([&]() {
+            uint32_t last = 0;
+            while (!stop)
+            {
+                uint32_t number = Read();
+                EXPECT_GE(number, last);
+                last = number;
+            }
+        });
+    }
+
+    for (uint32_t i = 1; i <= 200; i++)
+    {
+        Replace(i);
+        m_store.Invalidate();
+    }
+    stop = true;
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(200u, Read());
+    EXPECT_EQ(1, s_liveKeyLists.load());
+}
@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <map>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "mos_vma.h"
+
+using namespace std;
+
+static const uint64_t VMA_START = 1ull << 16;
+static const uint64_t VMA_SIZE  = (1ull << 48) - VMA_START;
+
+class MosVmaHeapTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(0, mos_vma_heap_init(&m_heap, VMA_START, VMA_SIZE));
+    }
+
+    void TearDown() override
+    {
+        mos_vma_heap_finish(&m_heap);
+    }
+
+    mos_vma_heap m_heap;
+};
+
+TEST_F(MosVmaHeapTest, AlignmentClasses)
+{
+    uint64_t small = mos_vma_heap_alloc(&m_heap, 4096, MOS_VMA_PAGE_SIZE);
+    uint64_t large = mos_vma_heap_alloc(&m_heap, 3 * MOS_VMA_2M_SIZE, MOS_VMA_2M_SIZE);
+
+    EXPECT_EQ(VMA_START, small);
+    EXPECT_EQ(0u, large % MOS_VMA_2M_SIZE);
+
+    // The padding in front of the 2M aligned block stays usable
+    uint64_t next = mos_vma_heap_alloc(&m_heap, MOS_VMA_PAGE_SIZE, MOS_VMA_PAGE_SIZE);
+    EXPECT_EQ(VMA_START + MOS_VMA_PAGE_SIZE, next);
+
+    mos_vma_heap_free(&m_heap, small, 4096);
+    mos_vma_heap_free(&m_heap, large, 3 * MOS_VMA_2M_SIZE);
+    mos_vma_heap_free(&m_heap, next, MOS_VMA_PAGE_SIZE);
+
+    mos_vma_heap_stats stats;
+    mos_vma_heap_get_stats(&m_heap, &stats);
+    EXPECT_EQ(1u, stats.hole_count);
+    EXPECT_EQ(0u, stats.used_size);
+    EXPECT_EQ(VMA_SIZE, stats.largest_hole);
+}
+
+TEST_F(MosVmaHeapTest, ReuseAfterFree)
+{
+    // Address space is returned, so a bounded working set never runs out
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t offset = mos_vma_heap_alloc(&m_heap, 64 * MOS_VMA_2M_SIZE, MOS_VMA_2M_SIZE);
+        ASSERT_NE(0u, offset);
+        ASSERT_LT(offset, VMA_START + 64 * MOS_VMA_2M_SIZE * 2);
+        mos_vma_heap_free(&m_heap, offset, 64 * MOS_VMA_2M_SIZE);
+    }
+}
+
+TEST_F(MosVmaHeapTest, RandomChurn)
+{
+    mt19937_64                  rng(0x5eed);
+    map<uint64_t, uint64_t>     live;
+    vector<uint64_t>            order;
+
+    for (int i = 0; i < 2000000; i++)
+    {
+        if (!order.empty() && (live.size() > 4096 || (rng() & 1)))
+        {
+            size_t   pick   = rng() % order.size();
+            uint64_t offset = order[pick];
+            order[pick]     = order.back();
+            order.pop_back();
+
+            mos_vma_heap_free(&m_heap, offset, live[offset]);
+            live.erase(offset);
+            continue;
+        }
+
+        uint64_t size      = (rng() % (8 << 20)) + 1;
+        uint64_t alignment = size >= MOS_VMA_2M_SIZE ? MOS_VMA_2M_SIZE : MOS_VMA_PAGE_SIZE;
+        uint64_t offset    = mos_vma_heap_alloc(&m_heap, size, alignment);
+        ASSERT_NE(0u, offset);
+        ASSERT_EQ(0u, offset % alignment);
+
+        // Must not overlap either neighbour
+        auto next = live.lower_bound(offset);
+        if (next != live.end())
+        {
+            ASSERT_LE(offset + size, next->first);
+        }
+        if (next != live.begin())
+        {
+            auto prev = std::prev(next);
+            ASSERT_LE(prev->first + prev->second, offset);
+        }
+
+        live[offset] = size;
+        order.push_back(offset);
+    }
+
+    mos_vma_heap_stats stats;
+    mos_vma_heap_get_stats(&m_heap, &stats);
+    EXPECT_EQ(live.size(), stats.alloc_count);
+    EXPECT_EQ(0u, stats.fail_count);
+    EXPECT_LE(stats.fragmentation, 1000u);
+
+    for (auto &block : live)
+    {
+        mos_vma_heap_free(&m_heap, block.first, block.second);
+    }
+
+    mos_vma_heap_get_stats(&m_heap, &stats);
+    EXPECT_EQ(1u, stats.hole_count);
+    EXPECT_EQ(0u, stats.used_size);
+    EXPECT_EQ(0u, stats.fragmentation);
+    EXPECT_LT(stats.peak_used_size, VMA_SIZE / 1024);
+}
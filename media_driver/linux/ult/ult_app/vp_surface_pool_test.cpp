@@ -0,0 +1,322 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <chrono>
+#include <string>
+#include "gtest/gtest.h"
+#include "vp_surface_pool.h"
+
+using namespace std;
+using namespace vp;
+
+// VpAllocator backed by zeroed system memory, standing in for the GEM allocations
+// of the driver. Counts allocations and frees.
+static uint32_t g_allocatorAllocs = 0;
+static uint32_t g_allocatorFrees  = 0;
+
+VpAllocator::VpAllocator(PMOS_INTERFACE osInterface, VPMediaMemComp *mmc) :
+    m_osInterface(osInterface),
+    m_mmc(mmc)
+{
+}
+
+VpAllocator::~VpAllocator()
+{
+}
+
+VP_SURFACE *VpAllocator::AllocateVpSurface(MOS_ALLOC_GFXRES_PARAMS &param, bool zeroOnAllocate, VPHAL_CSPACE ColorSpace, uint32_t ChromaSiting)
+{
+    uint32_t bitsPerPixel = (param.Format == Format_YUY2) ? 16 : (param.Format == Format_NV12) ? 12 : 8;
+    uint32_t pitch        = MOS_ALIGN_CEIL(param.dwWidth * MOS_MIN(bitsPerPixel, 16) / 8, 128);
+    uint32_t size         = pitch * param.dwHeight * bitsPerPixel / MOS_MIN(bitsPerPixel, 16);
+
+    VP_SURFACE  *surface   = MOS_New(VP_SURFACE);
+    MOS_SURFACE *osSurface = MOS_New(MOS_SURFACE);
+    uint8_t     *data      = (uint8_t *)MOS_AllocMemory(size);
+    if (surface == nullptr || osSurface == nullptr || data == nullptr)
+    {
+        MOS_Delete(surface);
+        MOS_Delete(osSurface);
+        MOS_FreeMemory(data);
+        return nullptr;
+    }
+    // The kernel hands out zeroed pages for new buffer objects
+    memset(data, 0, size);
+
+    MOS_ZeroMemory(surface, sizeof(*surface));
+    MOS_ZeroMemory(osSurface, sizeof(*osSurface));
+    osSurface->Format           = param.Format;
+    osSurface->TileType         = param.TileType;
+    osSurface->dwWidth          = param.dwWidth;
+    osSurface->dwHeight         = param.dwHeight;
+    osSurface->dwPitch          = pitch;
+    osSurface->bCompressible    = param.bIsCompressible;
+    osSurface->CompressionMode  = param.CompressionMode;
+    osSurface->OsResource.pData = data;
+
+    surface->osSurface       = osSurface;
+    surface->isResourceOwner = true;
+    surface->ColorSpace      = ColorSpace;
+    surface->ChromaSiting    = ChromaSiting;
+    surface->rcSrc.right     = param.dwWidth;
+    surface->rcSrc.bottom    = param.dwHeight;
+    surface->rcDst           = surface->rcSrc;
+    surface->rcMaxSrc        = surface->rcSrc;
+
+    g_allocatorAllocs++;
+    return surface;
+}
+
+MOS_STATUS VpAllocator::DestroyVpSurface(VP_SURFACE *&surface, MOS_GFXRES_FREE_FLAGS flags)
+{
+    if (surface == nullptr)
+    {
+        return MOS_STATUS_SUCCESS;
+    }
+    if (surface->osSurface)
+    {
+        MOS_FreeMemory(surface->osSurface->OsResource.pData);
+        MOS_Delete(surface->osSurface);
+    }
+    MOS_Delete(surface);
+
+    g_allocatorFrees++;
+    return MOS_STATUS_SUCCESS;
+}
+
+bool VpAllocator::isSyncFreeNeededForMMCSurface(PMOS_SURFACE pOsSurface)
+{
+    return false;
+}
+
+//!
+//! \brief Requests the vebox intermediate surfaces of VpResourceManager for a
+//!        stream switching between two resolutions, through VpSurfacePool and
+//!        through the free and reallocate on change it replaced
+//!
+class VpSurfacePoolTest : public testing::Test
+{
+protected:
+    struct SurfaceSlot
+    {
+        const char             *name;
+        MOS_FORMAT              format;
+        MOS_HW_RESOURCE_DEF     usage;
+    };
+
+    //! 4 vebox outputs, 2 denoise outputs and 2 STMM surfaces per frame
+    static const uint32_t m_slotNum = 8;
+
+    void SetUp() override
+    {
+        g_allocatorAllocs = 0;
+        g_allocatorFrees  = 0;
+        m_allocator       = new VpAllocator(nullptr, nullptr);
+    }
+
+    void TearDown() override
+    {
+        for (auto &surface : m_direct)
+        {
+            m_allocator->DestroyVpSurface(surface);
+        }
+        delete m_allocator;
+    }
+
+    static const SurfaceSlot &Slot(uint32_t i)
+    {
+        static const SurfaceSlot slots[m_slotNum] = {
+            {"VeboxSurfaceOutput", Format_YUY2, MOS_HW_RESOURCE_USAGE_VP_OUTPUT_PICTURE_FF},
+            {"VeboxSurfaceOutput", Format_YUY2, MOS_HW_RESOURCE_USAGE_VP_OUTPUT_PICTURE_FF},
+            {"VeboxSurfaceOutput", Format_YUY2, MOS_HW_RESOURCE_USAGE_VP_OUTPUT_PICTURE_FF},
+            {"VeboxSurfaceOutput", Format_YUY2, MOS_HW_RESOURCE_USAGE_VP_OUTPUT_PICTURE_FF},
+            {"VeboxFFDNSurface",   Format_NV12, MOS_HW_RESOURCE_USAGE_VP_INPUT_REFERENCE_FF},
+            {"VeboxFFDNSurface",   Format_NV12, MOS_HW_RESOURCE_USAGE_VP_INPUT_REFERENCE_FF},
+            {"VeboxSTMMSurface",   Format_STMM, MOS_HW_RESOURCE_USAGE_VP_INTERNAL_READ_WRITE_FF},
+            {"VeboxSTMMSurface",   Format_STMM, MOS_HW_RESOURCE_USAGE_VP_INTERNAL_READ_WRITE_FF},
+        };
+        return slots[i];
+    }
+
+    //!
+    //! \brief One frame of surface requests through the pool
+    //!
+    MOS_STATUS PoolFrame(VpSurfacePool &pool, uint32_t width, uint32_t height)
+    {
+        pool.StartNewFrame();
+        for (uint32_t i = 0; i < m_slotNum; i++)
+        {
+            bool allocated = false;
+            MOS_STATUS status = pool.ReAllocateSurface(m_pooled[i], Slot(i).name, Slot(i).format, MOS_TILE_Y,
+                width, height, false, MOS_MMC_DISABLED, allocated, Slot(i).usage);
+            if (status != MOS_STATUS_SUCCESS)
+            {
+                return status;
+            }
+        }
+        return MOS_STATUS_SUCCESS;
+    }
+
+    //!
+    //! \brief One frame of surface requests the way VpAllocator::ReAllocateSurface serves them
+    //!
+    MOS_STATUS DirectFrame(uint32_t width, uint32_t height)
+    {
+        for (uint32_t i = 0; i < m_slotNum; i++)
+        {
+            VP_SURFACE *&surface = m_direct[i];
+            if (surface && surface->osSurface->dwWidth == width && surface->osSurface->dwHeight == height)
+            {
+                continue;
+            }
+            m_allocator->DestroyVpSurface(surface);
+
+            MOS_ALLOC_GFXRES_PARAMS allocParams = {};
+            allocParams.Type         = MOS_GFXRES_2D;
+            allocParams.TileType     = MOS_TILE_Y;
+            allocParams.dwWidth      = width;
+            allocParams.dwHeight     = height;
+            allocParams.Format       = Slot(i).format;
+            allocParams.pBufName     = Slot(i).name;
+            allocParams.dwArraySize  = 1;
+            allocParams.ResUsageType = Slot(i).usage;
+            surface = m_allocator->AllocateVpSurface(allocParams);
+            if (surface == nullptr)
+            {
+                return MOS_STATUS_NO_SPACE;
+            }
+        }
+        return MOS_STATUS_SUCCESS;
+    }
+
+    static void Resolution(uint32_t frame, uint32_t period, uint32_t &width, uint32_t &height)
+    {
+        bool high = (frame / period) % 2 == 0;
+        width     = high ? 1920 : 1280;
+        height    = high ? 1080 : 720;
+    }
+
+    VpAllocator *m_allocator = nullptr;
+    VP_SURFACE  *m_pooled[m_slotNum] = {};
+    VP_SURFACE  *m_direct[m_slotNum] = {};
+};
+
+const uint32_t VpSurfacePoolTest::m_slotNum;
+
+TEST_F(VpSurfacePoolTest, AlternatingResolutionsReusePooledSurfaces)
+{
+    const uint32_t frameNum = 32;
+    uint32_t       width, height;
+
+    {
+        VpSurfacePool pool(*m_allocator);
+        for (uint32_t frame = 0; frame < frameNum; frame++)
+        {
+            Resolution(frame, 1, width, height);
+            ASSERT_EQ(MOS_STATUS_SUCCESS, PoolFrame(pool, width, height));
+
+            for (uint32_t i = 0; i < m_slotNum; i++)
+            {
+                ASSERT_NE(nullptr, m_pooled[i]);
+                EXPECT_EQ(width, m_pooled[i]->osSurface->dwWidth);
+                EXPECT_EQ(height, m_pooled[i]->osSurface->dwHeight);
+                EXPECT_EQ((long)width, m_pooled[i]->rcSrc.right);
+            }
+        }
+
+        // A 1080p surface wastes more than 2x of a 720p request, so each size has its own set
+        const VP_SURFACE_POOL_STATS &stats = pool.GetStats();
+        EXPECT_EQ(2 * m_slotNum, stats.allocCount);
+        EXPECT_EQ((frameNum - 2) * m_slotNum, stats.reuseCount);
+        EXPECT_EQ(0u, stats.freeCount);
+
+        // The 720p set is freed once it has been idle for the release delay
+        for (uint32_t frame = 0; frame < VP_SURFACE_POOL_RELEASE_DELAY + 2; frame++)
+        {
+            ASSERT_EQ(MOS_STATUS_SUCCESS, PoolFrame(pool, 1920, 1080));
+        }
+        EXPECT_EQ(m_slotNum, stats.freeCount);
+        EXPECT_EQ(2 * m_slotNum, stats.allocCount);
+
+        for (uint32_t i = 0; i < m_slotNum; i++)
+        {
+            pool.ReleaseSurface(m_pooled[i]);
+            EXPECT_EQ(nullptr, m_pooled[i]);
+        }
+    }
+
+    EXPECT_EQ(g_allocatorAllocs, g_allocatorFrees);
+}
+
+TEST_F(VpSurfacePoolTest, AlternatingResolutionsAllocationCost)
+{
+    const uint32_t frameNum = 64;
+    uint32_t       width, height;
+
+    for (uint32_t period : {1, 4, 16})
+    {
+        double   poolUs = 0, directUs = 0;
+        uint32_t poolAllocs, directAllocs;
+        uint64_t poolPeakBytes;
+
+        {
+            VpSurfacePool pool(*m_allocator);
+            for (uint32_t frame = 0; frame < frameNum; frame++)
+            {
+                Resolution(frame, period, width, height);
+                auto start = chrono::steady_clock::now();
+                ASSERT_EQ(MOS_STATUS_SUCCESS, PoolFrame(pool, width, height));
+                poolUs += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            }
+            poolAllocs    = pool.GetStats().allocCount;
+            poolPeakBytes = pool.GetStats().peakBytes;
+            for (uint32_t i = 0; i < m_slotNum; i++)
+            {
+                pool.ReleaseSurface(m_pooled[i]);
+            }
+        }
+
+        uint32_t allocsBefore = g_allocatorAllocs;
+        for (uint32_t frame = 0; frame < frameNum; frame++)
+        {
+            Resolution(frame, period, width, height);
+            auto start = chrono::steady_clock::now();
+            ASSERT_EQ(MOS_STATUS_SUCCESS, DirectFrame(width, height));
+            directUs += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        }
+        directAllocs = g_allocatorAllocs - allocsBefore;
+
+        EXPECT_EQ(frameNum / period * m_slotNum, directAllocs);
+        EXPECT_LE(poolAllocs, directAllocs);
+        if (period <= VP_SURFACE_POOL_RELEASE_DELAY)
+        {
+            // The idle set outlives the switch back and is reused
+            EXPECT_EQ(2 * m_slotNum, poolAllocs);
+        }
+
+        string name = "SwitchEvery" + to_string(period);
+        RecordProperty(name + "PoolAllocs", to_string(poolAllocs));
+        RecordProperty(name + "DirectAllocs", to_string(directAllocs));
+        RecordProperty(name + "PoolUsPerFrame", to_string(poolUs / frameNum));
+        RecordProperty(name + "DirectUsPerFrame", to_string(directUs / frameNum));
+        RecordProperty(name + "PoolPeakBytes", to_string(poolPeakBytes));
+    }
+}
@@ -35,6 +35,7 @@
 #include <stdlib.h>    // atoi atol
 #include <math.h>
 #include "mos_os.h"
+#include "mos_swizzle.h"
 
 #if MOS_MESSAGES_ENABLED
 #include <time.h>     //for simulate random memory allcation failure
@@ -2536,6 +2537,39 @@ void MosUtilities::MosSwizzleData(
     int32_t x;
     int32_t y;
 
+#ifndef _MOS_UTILITY_EXT
+    // X and Y tiles are copied a tile line at a time. Other tilings, and
+    // pitches that would make tile lines overlap, keep the per byte path.
+    MOS_SWIZZLE_BAND bands[MOS_SWIZZLE_MAX_BANDS];
+    int32_t          maxBands  = ((int64_t)iPitch * iHeight >= MOS_SWIZZLE_MT_THRESHOLD) ? (int32_t)MosGetLogicalCoreNumber() : 1;
+    int32_t          bandCount = Mos_SwizzleSplitBands(pSrc, pDst, SrcTiling, DstTiling, iHeight, iPitch, maxBands, bands);
+
+    if (bandCount > 0)
+    {
+        MOS_THREADHANDLE threads[MOS_SWIZZLE_MAX_BANDS] = {};
+
+        // Band 0 runs on the caller; any band whose thread cannot be
+        // created runs there as well.
+        for (int32_t i = 1; i < bandCount; i++)
+        {
+            threads[i] = MosCreateThread((void *)Mos_SwizzleBand, &bands[i]);
+        }
+        Mos_SwizzleBand(&bands[0]);
+        for (int32_t i = 1; i < bandCount; i++)
+        {
+            if (threads[i])
+            {
+                MosWaitThread(threads[i]);
+            }
+            else
+            {
+                Mos_SwizzleBand(&bands[i]);
+            }
+        }
+        return;
+    }
+#endif
+
     // Translate from one format to another
     for (y = 0, LinearOffset = 0, TileOffset = 0; y < iHeight; y++)
     {
@@ -146,7 +146,7 @@ extern const VEBOX_SPATIAL_ATTRIBUTES_CONFIGURATION g_cInit_VEBOX_SPATIAL_ATTRIB
 };
 
 VpResourceManager::VpResourceManager(MOS_INTERFACE &osInterface, VpAllocator &allocator, VphalFeatureReport &reporting)
-    : m_osInterface(osInterface), m_allocator(allocator), m_reporting(reporting)
+    : m_osInterface(osInterface), m_allocator(allocator), m_reporting(reporting), m_surfacePool(allocator)
 {
     InitSurfaceConfigMap();
 }
@@ -156,14 +156,7 @@ VpResourceManager::~VpResourceManager()
     // Clean all intermedia Resource
     DestoryVeboxOutputSurface();
     DestoryVeboxDenoiseOutputSurface();
-
-    for (uint32_t i = 0; i < VP_NUM_STMM_SURFACES; i++)
-    {
-        if (m_veboxSTMMSurface[i])
-        {
-            m_allocator.DestroyVpSurface(m_veboxSTMMSurface[i]);
-        }
-    }
+    DestoryVeboxSTMMSurface();
 
     if (m_veboxStatisticsSurface)
     {
@@ -276,6 +269,9 @@ MOS_STATUS VpResourceManager::StartProcessNewFrame(SwFilterPipe &pipe)
 
     m_pastFrameIds = m_currentFrameIds;
 
+    // Age the intermediate surfaces released by previous frames.
+    m_surfacePool.StartNewFrame();
+
     return MOS_STATUS_SUCCESS;
 }
 
@@ -427,18 +423,16 @@ MOS_STATUS VpResourceManager::ReAllocateVeboxOutputSurface(VP_EXECUTE_CAPS& caps
 
     for (i = 0; i < m_veboxOutputCount; i++)
     {
-        VP_PUBLIC_CHK_STATUS_RETURN(m_allocator.ReAllocateSurface(
+        VP_PUBLIC_CHK_STATUS_RETURN(m_surfacePool.ReAllocateSurface(
             m_veboxOutput[i],
             "VeboxSurfaceOutput",
             veboxOutputFormat,
-            MOS_GFXRES_2D,
             veboxOutputTileType,
             inputSurface->osSurface->dwWidth,
             inputSurface->osSurface->dwHeight,
             bSurfCompressible,
             surfCompressionMode,
             allocated,
-            false,
             MOS_HW_RESOURCE_USAGE_VP_OUTPUT_PICTURE_FF));
 
         m_veboxOutput[i]->ColorSpace = inputSurface->ColorSpace;
@@ -481,18 +475,16 @@ MOS_STATUS VpResourceManager::ReAllocateVeboxDenoiseOutputSurface(VP_EXECUTE_CAP
 
     for (uint32_t i = 0; i < VP_NUM_DN_SURFACES; i++)
     {
-        VP_PUBLIC_CHK_STATUS_RETURN(m_allocator.ReAllocateSurface(
+        VP_PUBLIC_CHK_STATUS_RETURN(m_surfacePool.ReAllocateSurface(
             m_veboxDenoiseOutput[i],
             "VeboxFFDNSurface",
             inputSurface->osSurface->Format,
-            MOS_GFXRES_2D,
             inputSurface->osSurface->TileType,
             inputSurface->osSurface->dwWidth,
             inputSurface->osSurface->dwHeight,
             bSurfCompressible,
             surfCompressionMode,
             allocated,
-            false,
             MOS_HW_RESOURCE_USAGE_VP_INPUT_REFERENCE_FF));
 
         // if allocated, pVeboxState->PastSurface is not valid for DN reference.
@@ -620,18 +612,16 @@ MOS_STATUS VpResourceManager::ReAllocateVeboxSTMMSurface(VP_EXECUTE_CAPS& caps,
     allocated = false;
     for (i = 0; i < VP_NUM_STMM_SURFACES; i++)
     {
-        VP_PUBLIC_CHK_STATUS_RETURN(m_allocator.ReAllocateSurface(
+        VP_PUBLIC_CHK_STATUS_RETURN(m_surfacePool.ReAllocateSurface(
             m_veboxSTMMSurface[i],
             "VeboxSTMMSurface",
             Format_STMM,
-            MOS_GFXRES_2D,
             MOS_TILE_Y,
             inputSurface->osSurface->dwWidth,
             inputSurface->osSurface->dwHeight,
             bSurfCompressible,
             surfCompressionMode,
             allocated,
-            false,
             MOS_HW_RESOURCE_USAGE_VP_INTERNAL_READ_WRITE_FF));
 
         if (allocated)
@@ -650,7 +640,7 @@ void VpResourceManager::DestoryVeboxOutputSurface()
 {
     for (uint32_t i = 0; i < VP_MAX_NUM_VEBOX_SURFACES; i++)
     {
-        m_allocator.DestroyVpSurface(m_veboxOutput[i]);
+        m_surfacePool.ReleaseSurface(m_veboxOutput[i]);
     }
 }
 
@@ -658,7 +648,7 @@ void VpResourceManager::DestoryVeboxDenoiseOutputSurface()
 {
     for (uint32_t i = 0; i < VP_NUM_DN_SURFACES; i++)
     {
-        m_allocator.DestroyVpSurface(m_veboxDenoiseOutput[i]);
+        m_surfacePool.ReleaseSurface(m_veboxDenoiseOutput[i]);
     }
 }
 
@@ -667,7 +657,7 @@ void VpResourceManager::DestoryVeboxSTMMSurface()
     // Free DI history buffers (STMM = Spatial-temporal motion measure)
     for (uint32_t i = 0; i < VP_NUM_STMM_SURFACES; i++)
     {
-        m_allocator.DestroyVpSurface(m_veboxSTMMSurface[i]);
+        m_surfacePool.ReleaseSurface(m_veboxSTMMSurface[i]);
     }
 }
 
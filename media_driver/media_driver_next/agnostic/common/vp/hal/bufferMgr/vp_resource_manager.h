@@ -30,6 +30,7 @@
 
 #include <map>
 #include "vp_allocator.h"
+#include "vp_surface_pool.h"
 #include "vp_pipeline_common.h"
 #include "vp_utils.h"
 
@@ -426,6 +427,7 @@ protected:
     MOS_INTERFACE                &m_osInterface;
     VpAllocator                  &m_allocator;
     VphalFeatureReport           &m_reporting;
+    VpSurfacePool                m_surfacePool;                           //!< Pool of the vebox output, DN output and STMM surfaces
 
     // Vebox Resource
     VP_SURFACE* m_veboxDenoiseOutput[VP_NUM_DN_SURFACES] = {};            //!< Vebox Denoise output surface
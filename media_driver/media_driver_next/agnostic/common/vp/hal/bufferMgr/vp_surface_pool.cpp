@@ -0,0 +1,317 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     vp_surface_pool.cpp
+//! \brief    Implements the keyed pool of vp intermediate surfaces
+//! \details  Surfaces released by the resource manager are kept in the pool and
+//!           handed out again to requests with the same format, tiling and
+//!           compression whose size fits.
+//!
+
+#include "vp_surface_pool.h"
+#include "vp_utils.h"
+
+using namespace vp;
+
+VpSurfacePool::VpSurfacePool(VpAllocator &allocator, uint64_t budget) :
+    m_allocator(allocator),
+    m_budget(budget)
+{
+}
+
+VpSurfacePool::~VpSurfacePool()
+{
+    VP_PUBLIC_NORMALMESSAGE("Surface pool: %d allocations in %llu us (max %llu us), %d reuses, %d frees, peak %llu bytes",
+        m_stats.allocCount, (unsigned long long)m_stats.allocTimeUs, (unsigned long long)m_stats.maxAllocTimeUs,
+        m_stats.reuseCount, m_stats.freeCount, (unsigned long long)m_stats.peakBytes);
+
+    while (!m_entries.empty())
+    {
+        FreeEntry((uint32_t)m_entries.size() - 1);
+    }
+}
+
+bool VpSurfacePool::IsMatched(
+    const PoolEntry        &entry,
+    MOS_FORMAT              format,
+    MOS_TILE_TYPE           tileType,
+    bool                    compressible,
+    MOS_RESOURCE_MMC_MODE   compressionMode,
+    MOS_HW_RESOURCE_DEF     resUsageType,
+    uint32_t                width,
+    uint32_t                height)
+{
+    uint64_t alignedArea = (uint64_t)MOS_ALIGN_CEIL(width, VP_SURFACE_POOL_WIDTH_ALIGNMENT) *
+                           MOS_ALIGN_CEIL(height, VP_SURFACE_POOL_HEIGHT_ALIGNMENT);
+
+    return entry.format             == format           &&
+           entry.tileType           == tileType         &&
+           entry.compressible       == compressible     &&
+           entry.compressionMode    == compressionMode  &&
+           entry.resUsageType       == resUsageType     &&
+           entry.allocWidth         >= width            &&
+           entry.allocHeight        >= height           &&
+           (uint64_t)entry.allocWidth * entry.allocHeight <= VP_SURFACE_POOL_MAX_WASTE_RATIO * alignedArea;
+}
+
+VpSurfacePool::PoolEntry *VpSurfacePool::FindEntry(VP_SURFACE *surface)
+{
+    if (nullptr == surface)
+    {
+        return nullptr;
+    }
+
+    for (auto &entry : m_entries)
+    {
+        if (entry.surface == surface)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+VpSurfacePool::PoolEntry *VpSurfacePool::AllocateEntry(
+    PCCHAR                  surfaceName,
+    MOS_FORMAT              format,
+    MOS_TILE_TYPE           tileType,
+    bool                    compressible,
+    MOS_RESOURCE_MMC_MODE   compressionMode,
+    MOS_HW_RESOURCE_DEF     resUsageType,
+    uint32_t                width,
+    uint32_t                height)
+{
+    MOS_ALLOC_GFXRES_PARAMS allocParams = {};
+
+    allocParams.Type            = MOS_GFXRES_2D;
+    allocParams.TileType        = tileType;
+    allocParams.dwWidth         = MOS_ALIGN_CEIL(width, VP_SURFACE_POOL_WIDTH_ALIGNMENT);
+    allocParams.dwHeight        = MOS_ALIGN_CEIL(height, VP_SURFACE_POOL_HEIGHT_ALIGNMENT);
+    allocParams.Format          = format;
+    allocParams.bIsCompressible = compressible;
+    allocParams.CompressionMode = compressionMode;
+    allocParams.pBufName        = surfaceName;
+    allocParams.dwArraySize     = 1;
+    allocParams.ResUsageType    = resUsageType;
+
+    uint64_t    startTime   = MOS_GetCurTime();
+    VP_SURFACE  *surface    = m_allocator.AllocateVpSurface(allocParams, false);
+    uint64_t    allocTime   = MOS_GetCurTime() - startTime;
+
+    if (nullptr == surface)
+    {
+        VP_PUBLIC_ASSERTMESSAGE("Failed to allocate pooled surface %s.", surfaceName);
+        return nullptr;
+    }
+
+    MOS_SURFACE &osSurface = *surface->osSurface;
+
+    PoolEntry entry         = {};
+    entry.surface           = surface;
+    entry.format            = format;
+    entry.tileType          = tileType;
+    entry.compressible      = compressible;
+    entry.compressionMode   = compressionMode;
+    entry.resUsageType      = resUsageType;
+    entry.allocWidth        = osSurface.dwWidth;
+    entry.allocHeight       = osSurface.dwHeight;
+    entry.size              = osSurface.OsResource.pGmmResInfo ?
+                              osSurface.OsResource.pGmmResInfo->GetSizeSurface() :
+                              (uint64_t)osSurface.dwPitch * osSurface.dwHeight;
+    entry.lastUsedFrame     = m_frameId;
+    entry.inUse             = false;
+    m_entries.push_back(entry);
+
+    m_stats.allocCount++;
+    m_stats.allocTimeUs     += allocTime;
+    m_stats.maxAllocTimeUs  = MOS_MAX(m_stats.maxAllocTimeUs, allocTime);
+    m_stats.totalBytes      += entry.size;
+    m_stats.peakBytes       = MOS_MAX(m_stats.peakBytes, m_stats.totalBytes);
+
+    return &m_entries.back();
+}
+
+void VpSurfacePool::SetSurfaceSize(VP_SURFACE &surface, uint32_t width, uint32_t height)
+{
+    // Pitch and plane offsets stay those of the allocation, only the region used changes.
+    surface.osSurface->dwWidth  = width;
+    surface.osSurface->dwHeight = height;
+
+    surface.rcSrc.left      = surface.rcSrc.top = 0;
+    surface.rcSrc.right     = width;
+    surface.rcSrc.bottom    = height;
+    surface.rcDst           = surface.rcSrc;
+    surface.rcMaxSrc        = surface.rcSrc;
+}
+
+void VpSurfacePool::FreeEntry(uint32_t index)
+{
+    PoolEntry               &entry          = m_entries[index];
+    MOS_GFXRES_FREE_FLAGS   resFreeFlags    = {0};
+
+    //if free the compressed surface, need set the sync dealloc flag as 1 for sync dealloc for aux table update
+    if (m_allocator.isSyncFreeNeededForMMCSurface(entry.surface->osSurface))
+    {
+        resFreeFlags.SynchronousDestroy = 1;
+    }
+
+    if (!entry.inUse)
+    {
+        m_stats.idleBytes -= entry.size;
+    }
+    m_stats.totalBytes -= entry.size;
+    m_stats.freeCount++;
+
+    m_allocator.DestroyVpSurface(entry.surface, resFreeFlags);
+
+    entry = m_entries.back();
+    m_entries.pop_back();
+}
+
+MOS_STATUS VpSurfacePool::ReAllocateSurface(
+    VP_SURFACE             *&surface,
+    PCCHAR                  surfaceName,
+    MOS_FORMAT              format,
+    MOS_TILE_TYPE           tileType,
+    uint32_t                width,
+    uint32_t                height,
+    bool                    compressible,
+    MOS_RESOURCE_MMC_MODE   compressionMode,
+    bool                    &allocated,
+    MOS_HW_RESOURCE_DEF     resUsageType)
+{
+    allocated = false;
+
+    PoolEntry *entry = FindEntry(surface);
+
+    if (surface && nullptr == entry)
+    {
+        // Only surfaces handed out by the pool can be reallocated here.
+        VP_PUBLIC_CHK_STATUS_RETURN(MOS_STATUS_INVALID_PARAMETER);
+    }
+
+    if (entry && IsMatched(*entry, format, tileType, compressible, compressionMode, resUsageType, width, height))
+    {
+        entry->lastUsedFrame = m_frameId;
+        if (surface->osSurface->dwWidth != width || surface->osSurface->dwHeight != height)
+        {
+            SetSurfaceSize(*surface, width, height);
+            allocated = true;
+        }
+        return MOS_STATUS_SUCCESS;
+    }
+
+    ReleaseSurface(surface);
+
+    // Take the smallest idle surface which fits.
+    entry = nullptr;
+    for (auto &candidate : m_entries)
+    {
+        if (!candidate.inUse &&
+            IsMatched(candidate, format, tileType, compressible, compressionMode, resUsageType, width, height) &&
+            (nullptr == entry || candidate.size < entry->size))
+        {
+            entry = &candidate;
+        }
+    }
+
+    if (entry)
+    {
+        m_stats.reuseCount++;
+        m_stats.idleBytes -= entry->size;
+    }
+    else
+    {
+        entry = AllocateEntry(surfaceName, format, tileType, compressible, compressionMode, resUsageType, width, height);
+        VP_PUBLIC_CHK_NULL_RETURN(entry);
+    }
+
+    entry->inUse         = true;
+    entry->lastUsedFrame = m_frameId;
+
+    surface = entry->surface;
+    SetSurfaceSize(*surface, width, height);
+    allocated = true;
+
+    return MOS_STATUS_SUCCESS;
+}
+
+void VpSurfacePool::ReleaseSurface(VP_SURFACE *&surface)
+{
+    if (nullptr == surface)
+    {
+        return;
+    }
+
+    PoolEntry *entry = FindEntry(surface);
+    if (nullptr == entry)
+    {
+        VP_PUBLIC_ASSERTMESSAGE("Surface is not owned by the pool.");
+        m_allocator.DestroyVpSurface(surface);
+        return;
+    }
+
+    if (entry->inUse)
+    {
+        entry->inUse         = false;
+        entry->lastUsedFrame = m_frameId;
+        m_stats.idleBytes    += entry->size;
+    }
+    surface = nullptr;
+}
+
+void VpSurfacePool::StartNewFrame()
+{
+    m_frameId++;
+
+    // Free the surfaces nobody asked for during the release delay.
+    for (uint32_t i = (uint32_t)m_entries.size(); i > 0; i--)
+    {
+        PoolEntry &entry = m_entries[i - 1];
+        if (!entry.inUse && m_frameId - entry.lastUsedFrame > VP_SURFACE_POOL_RELEASE_DELAY)
+        {
+            FreeEntry(i - 1);
+        }
+    }
+
+    // Then the oldest ones until the budget is met. The surfaces released in the
+    // last frame may still be referenced by the work in flight, so they are kept.
+    while (m_stats.idleBytes > m_budget)
+    {
+        int32_t oldest = -1;
+        for (uint32_t i = 0; i < m_entries.size(); i++)
+        {
+            const PoolEntry &entry = m_entries[i];
+            if (!entry.inUse && m_frameId - entry.lastUsedFrame > 1 &&
+                (oldest < 0 || entry.lastUsedFrame < m_entries[oldest].lastUsedFrame))
+            {
+                oldest = (int32_t)i;
+            }
+        }
+
+        if (oldest < 0)
+        {
+            break;
+        }
+        FreeEntry((uint32_t)oldest);
+    }
+}
@@ -0,0 +1,167 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file     vp_surface_pool.h
+//! \brief    Defines the keyed pool of vp intermediate surfaces
+//! \details  Surfaces released by the resource manager are kept in the pool and
+//!           handed out again to requests with the same format, tiling and
+//!           compression whose size fits, so that resolution switches do not
+//!           free and allocate the large vebox intermediate surfaces each time.
+//!
+#ifndef __VP_SURFACE_POOL_H__
+#define __VP_SURFACE_POOL_H__
+
+#include <vector>
+#include "vp_allocator.h"
+
+#define VP_SURFACE_POOL_WIDTH_ALIGNMENT     64                  //!< Allocation width granule, so close resolutions share one surface
+#define VP_SURFACE_POOL_HEIGHT_ALIGNMENT    32                  //!< Allocation height granule, one tile Y row
+#define VP_SURFACE_POOL_MAX_WASTE_RATIO     2                   //!< A surface is reused only if its area is at most this times the request
+#define VP_SURFACE_POOL_RELEASE_DELAY       8                   //!< Frames an idle surface is kept before being freed
+#define VP_SURFACE_POOL_BUDGET_DEFAULT      (64 * 1024 * 1024)  //!< Bytes of idle surfaces kept in the pool
+
+namespace vp {
+
+struct VP_SURFACE_POOL_STATS
+{
+    uint32_t    allocCount;         //!< Surfaces allocated from the OS
+    uint32_t    reuseCount;         //!< Requests served by a pooled surface
+    uint32_t    freeCount;          //!< Pooled surfaces freed by aging or budget
+    uint64_t    allocTimeUs;        //!< Total time spent in allocation
+    uint64_t    maxAllocTimeUs;     //!< Longest single allocation
+    uint64_t    idleBytes;          //!< Bytes of surfaces waiting in the pool
+    uint64_t    totalBytes;         //!< Bytes of all surfaces owned by the pool
+    uint64_t    peakBytes;          //!< High watermark of totalBytes
+};
+
+class VpSurfacePool
+{
+public:
+    //!
+    //! \brief  Constructor
+    //! \param  [in] allocator
+    //!         Reference to VpAllocator
+    //! \param  [in] budget
+    //!         Bytes of idle surfaces to keep after aging
+    //!
+    VpSurfacePool(VpAllocator &allocator, uint64_t budget = VP_SURFACE_POOL_BUDGET_DEFAULT);
+
+    //!
+    //! \brief  Destructor, frees all surfaces owned by the pool
+    //!
+    virtual ~VpSurfacePool();
+
+    //!
+    //! \brief    Get a surface for the expected parameters
+    //! \details  Keeps the current surface if it still fits, otherwise returns it
+    //!           to the pool and takes the smallest fitting idle surface, or
+    //!           allocates a new one with the size aligned to the pool granules.
+    //!           The logical width and height of the surface are set to the request.
+    //! \param    [in,out] surface
+    //!           Pointer to VP_SURFACE, nullptr or a surface from this pool
+    //! \param    [in] surfaceName
+    //!           Pointer to surface name
+    //! \param    [in] format
+    //!           Expected MOS_FORMAT
+    //! \param    [in] tileType
+    //!           Expected Surface Tile Type
+    //! \param    [in] width
+    //!           Expected Surface Width
+    //! \param    [in] height
+    //!           Expected Surface Height
+    //! \param    [in] compressible
+    //!           Surface compressible or not
+    //! \param    [in] compressionMode
+    //!           Compression Mode
+    //! \param    [out] allocated
+    //!           true if the surface changed and its content is undefined
+    //! \param    [in] resUsageType
+    //!           resource usage type for cache policy
+    //! \return   MOS_STATUS
+    //!           MOS_STATUS_SUCCESS if success. Error code otherwise
+    //!
+    MOS_STATUS ReAllocateSurface(
+        VP_SURFACE             *&surface,
+        PCCHAR                  surfaceName,
+        MOS_FORMAT              format,
+        MOS_TILE_TYPE           tileType,
+        uint32_t                width,
+        uint32_t                height,
+        bool                    compressible,
+        MOS_RESOURCE_MMC_MODE   compressionMode,
+        bool                    &allocated,
+        MOS_HW_RESOURCE_DEF     resUsageType);
+
+    //!
+    //! \brief    Return a surface to the pool
+    //! \details  The surface is not freed before it has been idle for
+    //!           VP_SURFACE_POOL_RELEASE_DELAY frames or the budget is exceeded.
+    //! \param    [in,out] surface
+    //!           Pointer to VP_SURFACE, set to nullptr
+    //!
+    void ReleaseSurface(VP_SURFACE *&surface);
+
+    //!
+    //! \brief    Advance the pool to a new frame
+    //! \details  Frees the surfaces which have been idle for too long, then the
+    //!           oldest idle ones until the idle bytes fit the budget. Surfaces
+    //!           released during the last frame are never freed here.
+    //!
+    void StartNewFrame();
+
+    const VP_SURFACE_POOL_STATS &GetStats()
+    {
+        return m_stats;
+    }
+
+protected:
+    struct PoolEntry
+    {
+        VP_SURFACE             *surface;
+        MOS_FORMAT              format;
+        MOS_TILE_TYPE           tileType;
+        bool                    compressible;
+        MOS_RESOURCE_MMC_MODE   compressionMode;
+        MOS_HW_RESOURCE_DEF     resUsageType;
+        uint32_t                allocWidth;
+        uint32_t                allocHeight;
+        uint64_t                size;
+        uint32_t                lastUsedFrame;
+        bool                    inUse;
+    };
+
+    bool IsMatched(const PoolEntry &entry, MOS_FORMAT format, MOS_TILE_TYPE tileType, bool compressible,
+        MOS_RESOURCE_MMC_MODE compressionMode, MOS_HW_RESOURCE_DEF resUsageType, uint32_t width, uint32_t height);
+    PoolEntry *FindEntry(VP_SURFACE *surface);
+    PoolEntry *AllocateEntry(PCCHAR surfaceName, MOS_FORMAT format, MOS_TILE_TYPE tileType, bool compressible,
+        MOS_RESOURCE_MMC_MODE compressionMode, MOS_HW_RESOURCE_DEF resUsageType, uint32_t width, uint32_t height);
+    void SetSurfaceSize(VP_SURFACE &surface, uint32_t width, uint32_t height);
+    void FreeEntry(uint32_t index);
+
+    VpAllocator                 &m_allocator;
+    std::vector<PoolEntry>      m_entries;
+    uint64_t                    m_budget        = VP_SURFACE_POOL_BUDGET_DEFAULT;
+    uint32_t                    m_frameId       = 0;
+    VP_SURFACE_POOL_STATS       m_stats         = {};
+};
+}
+#endif // __VP_SURFACE_POOL_H__
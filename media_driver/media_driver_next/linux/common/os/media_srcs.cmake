@@ -23,6 +23,7 @@ set(TMP_SOURCES_
     ${CMAKE_CURRENT_LIST_DIR}/mos_graphicsresource_specific_next.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_debug_specific_next.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_utilities_specific_next.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/mos_user_feature_store.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_commandbuffer_specific_next.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_gpucontext_specific_next.cpp
     ${CMAKE_CURRENT_LIST_DIR}/mos_gpucontext_specific_next_ext.cpp
@@ -36,6 +37,7 @@ set(TMP_HEADERS_
     ${CMAKE_CURRENT_LIST_DIR}/mos_graphicsresource_specific_next.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_util_devult_specific_next.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_utilities_specific_next.h
+    ${CMAKE_CURRENT_LIST_DIR}/mos_user_feature_store.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_commandbuffer_specific_next.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_gpucontext_specific_next.h
     ${CMAKE_CURRENT_LIST_DIR}/mos_os_specific_next.h
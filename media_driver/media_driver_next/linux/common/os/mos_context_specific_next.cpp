@@ -86,7 +86,7 @@ MOS_STATUS OsContextSpecificNext::Init(DDI_DEVICE_CONTEXT ddiDriverContext)
             MOS_OS_ASSERTMESSAGE("Not able to allocate buffer manager, fd=0x%d", m_fd);
             return MOS_STATUS_INVALID_PARAMETER;
         }
-        mos_bufmgr_gem_enable_reuse(m_bufmgr);
+        Mos_Specific_EnableBufmgrReuse(m_bufmgr);
         osDriverContext->bufmgr                 = m_bufmgr;
 
         //Latency reducation:replace HWGetDeviceID to get device using ioctl from drm.
@@ -247,6 +247,7 @@ void OsContextSpecificNext::Destroy()
         m_skuTable.reset();
         m_waTable.reset();
 
+        Mos_Specific_ReportBufmgrReuse(m_bufmgr);
         mos_bufmgr_destroy(m_bufmgr);
 
         GmmExportEntries GmmFuncs;
@@ -0,0 +1,245 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_user_feature_store.cpp
+//! \brief       Parsed-once cache of the Linux user feature file
+//!
+
+#include "mos_user_feature_store.h"
+#include "mos_utilities.h"
+
+MosUserFeatureStore::MosUserFeatureStore(PFN_MOS_UF_DUMP_FILE pfnDumpFile, PFN_MOS_UF_FREE_KEY_LIST pfnFreeKeyList) :
+    m_pfnDumpFile(pfnDumpFile),
+    m_pfnFreeKeyList(pfnFreeKeyList),
+    m_generation(0)
+{
+}
+
+MosUserFeatureStore::~MosUserFeatureStore()
+{
+    Clear();
+}
+
+bool MosUserFeatureStore::IsUpToDate(
+    const Snapshot      *snapshot,
+    const char          *fileName,
+    bool                exists,
+    const struct stat   &fileStat,
+    uint32_t            generation)
+{
+    if (snapshot->generation != generation || snapshot->exists != exists || snapshot->fileName != fileName)
+    {
+        return false;
+    }
+
+    return !exists ||
+           (snapshot->dev           == fileStat.st_dev          &&
+            snapshot->ino           == fileStat.st_ino          &&
+            snapshot->size          == fileStat.st_size         &&
+            snapshot->mtime.tv_sec  == fileStat.st_mtim.tv_sec  &&
+            snapshot->mtime.tv_nsec == fileStat.st_mtim.tv_nsec);
+}
+
+MosUserFeatureStore::SnapshotPtr MosUserFeatureStore::Parse(
+    const char          *fileName,
+    bool                exists,
+    const struct stat   &fileStat,
+    uint32_t            generation)
+{
+    // Freed by whichever of the store and its readers drops it last
+    SnapshotPtr snapshot = std::make_shared<Snapshot>();
+
+    snapshot->fileName          = fileName;
+    snapshot->exists            = exists;
+    snapshot->dev               = exists ? fileStat.st_dev : 0;
+    snapshot->ino               = exists ? fileStat.st_ino : 0;
+    snapshot->size              = exists ? fileStat.st_size : 0;
+    snapshot->mtime             = exists ? fileStat.st_mtim : timespec{};
+    snapshot->generation        = generation;
+    snapshot->pfnFreeKeyList    = m_pfnFreeKeyList;
+
+    snapshot->status = m_pfnDumpFile(fileName, &snapshot->keyList);
+    if (snapshot->status != MOS_STATUS_SUCCESS)
+    {
+        m_pfnFreeKeyList(snapshot->keyList);
+        snapshot->keyList = nullptr;
+        return snapshot;
+    }
+
+    // The first key of a name in list order wins, as with the linear search.
+    for (MOS_PUF_KEYLIST node = snapshot->keyList; node; node = node->pNext)
+    {
+        MOS_UF_KEY *key = node->pElem;
+
+        snapshot->ids.emplace((uintptr_t)key->UFKey, key);
+        if (!snapshot->keys.emplace(key->pcKeyName, key).second)
+        {
+            continue;
+        }
+
+        std::string name = key->pcKeyName;
+        name += '\n';
+        for (uint32_t i = 0; i < key->ulValueNum; i++)
+        {
+            snapshot->values.emplace(name + key->pValueArray[i].pcValueName, &key->pValueArray[i]);
+        }
+    }
+
+    return snapshot;
+}
+
+MosUserFeatureStore::SnapshotPtr MosUserFeatureStore::Acquire(const char *fileName)
+{
+    struct stat fileStat    = {};
+    bool        exists      = stat(fileName, &fileStat) == 0;
+    uint32_t    generation  = m_generation.load(std::memory_order_acquire);
+
+    SnapshotPtr snapshot = std::atomic_load(&m_current);
+    if (snapshot && IsUpToDate(snapshot.get(), fileName, exists, fileStat, generation))
+    {
+        return snapshot;
+    }
+
+    std::lock_guard<std::mutex> lock(m_parseMutex);
+
+    // Another thread may have parsed the same content meanwhile.
+    snapshot = std::atomic_load(&m_current);
+    if (snapshot && IsUpToDate(snapshot.get(), fileName, exists, fileStat, generation))
+    {
+        return snapshot;
+    }
+
+    SnapshotPtr newSnapshot = Parse(fileName, exists, fileStat, generation);
+
+    // The old snapshot is freed here, or by the last reader still holding it.
+    std::atomic_store(&m_current, newSnapshot);
+
+    return newSnapshot;
+}
+
+void MosUserFeatureStore::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_parseMutex);
+
+    std::atomic_store(&m_current, SnapshotPtr());
+}
+
+MOS_STATUS MosUserFeatureStore::QueryValue(
+    const char  *fileName,
+    const char  *keyName,
+    const char  *valueName,
+    uint32_t    *valueType,
+    void        *data,
+    int32_t     *dataSize)
+{
+    if (fileName == nullptr || keyName == nullptr || valueName == nullptr)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    SnapshotPtr snapshot = Acquire(fileName);
+    if (snapshot == nullptr)
+    {
+        return MOS_STATUS_NO_SPACE;
+    }
+    if (snapshot->status != MOS_STATUS_SUCCESS)
+    {
+        return snapshot->status;
+    }
+
+    std::string name = keyName;
+    name += '\n';
+    name += valueName;
+
+    auto it = snapshot->values.find(name);
+    if (it == snapshot->values.end())
+    {
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    const MOS_UF_VALUE *value = it->second;
+    MosUtilities::MosSecureMemcpy(data, value->ulValueLen, value->ulValueBuf, value->ulValueLen);
+
+    if (valueType != nullptr)
+    {
+        *valueType = value->ulValueType;
+    }
+    if (dataSize != nullptr)
+    {
+        *dataSize = value->ulValueLen;
+    }
+
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS MosUserFeatureStore::GetKeyIdByName(const char *fileName, const char *keyName, void **ufKey)
+{
+    if (fileName == nullptr || keyName == nullptr || ufKey == nullptr)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    SnapshotPtr snapshot = Acquire(fileName);
+    if (snapshot == nullptr)
+    {
+        return MOS_STATUS_NO_SPACE;
+    }
+    if (snapshot->status != MOS_STATUS_SUCCESS)
+    {
+        return snapshot->status;
+    }
+
+    auto it = snapshot->keys.find(keyName);
+    if (it == snapshot->keys.end())
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    *ufKey = it->second->UFKey;
+    return MOS_STATUS_SUCCESS;
+}
+
+MOS_STATUS MosUserFeatureStore::GetKeyNameById(const char *fileName, void *ufKey, char *keyName)
+{
+    if (fileName == nullptr || keyName == nullptr)
+    {
+        return MOS_STATUS_INVALID_PARAMETER;
+    }
+
+    SnapshotPtr snapshot = Acquire(fileName);
+    if (snapshot == nullptr)
+    {
+        return MOS_STATUS_NO_SPACE;
+    }
+    if (snapshot->status != MOS_STATUS_SUCCESS)
+    {
+        return snapshot->status;
+    }
+
+    auto it = snapshot->ids.find((uintptr_t)ufKey);
+    if (it == snapshot->ids.end())
+    {
+        return MOS_STATUS_UNKNOWN;
+    }
+
+    return MosUtilities::MosSecureStrcpy(keyName, MAX_USERFEATURE_LINE_LENGTH, it->second->pcKeyName);
+}
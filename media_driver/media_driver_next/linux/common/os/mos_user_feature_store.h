@@ -0,0 +1,167 @@
+/*
+* Copyright (c) 2020, Intel Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+//!
+//! \file        mos_user_feature_store.h
+//! \brief       Parsed-once cache of the Linux user feature file
+//! \details     The user feature file is parsed into a snapshot indexed by key
+//!              name, key id and value name. Readers take a reference on the
+//!              published snapshot and use it without locking; it is rebuilt
+//!              when the file changes on disk (inode, size or mtime) or after
+//!              the driver wrote to it. A replaced snapshot is freed when its
+//!              last reader drops it.
+//!
+#ifndef __MOS_USER_FEATURE_STORE_H__
+#define __MOS_USER_FEATURE_STORE_H__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+#include "mos_utilities_specific.h"
+
+typedef MOS_STATUS (*PFN_MOS_UF_DUMP_FILE)(const char * const szFileName, MOS_PUF_KEYLIST *pKeyList);
+typedef void (*PFN_MOS_UF_FREE_KEY_LIST)(MOS_PUF_KEYLIST pKeyList);
+
+class MosUserFeatureStore
+{
+public:
+    //!
+    //! \brief  Constructor
+    //! \param  [in] pfnDumpFile
+    //!         Parser building the key list from the user feature file
+    //! \param  [in] pfnFreeKeyList
+    //!         Function freeing a key list built by pfnDumpFile
+    //!
+    MosUserFeatureStore(PFN_MOS_UF_DUMP_FILE pfnDumpFile, PFN_MOS_UF_FREE_KEY_LIST pfnFreeKeyList);
+
+    ~MosUserFeatureStore();
+
+    //!
+    //! \brief  Retrieve the type and data of a value under a key
+    //! \details  The data is copied to pData with the length stored in the file,
+    //!           as done by the uncached query.
+    //! \param  [in] fileName
+    //!         User feature file name
+    //! \param  [in] keyName
+    //!         Full name of the user feature key
+    //! \param  [in] valueName
+    //!         Name of the value
+    //! \param  [out] valueType
+    //!         Type of the value, may be nullptr
+    //! \param  [out] data
+    //!         Buffer receiving the value data
+    //! \param  [out] dataSize
+    //!         Size of the value data, may be nullptr
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS if found, MOS_STATUS_UNKNOWN if the key or value
+    //!         does not exist, else the error from parsing the file
+    //!
+    MOS_STATUS QueryValue(
+        const char  *fileName,
+        const char  *keyName,
+        const char  *valueName,
+        uint32_t    *valueType,
+        void        *data,
+        int32_t     *dataSize);
+
+    //!
+    //! \brief  Get the id of a user feature key by its name
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS if found, MOS_STATUS_INVALID_PARAMETER if the key
+    //!         does not exist, else the error from parsing the file
+    //!
+    MOS_STATUS GetKeyIdByName(const char *fileName, const char *keyName, void **ufKey);
+
+    //!
+    //! \brief  Get the name of a user feature key by its id
+    //! \details  keyName must hold MAX_USERFEATURE_LINE_LENGTH characters.
+    //! \return MOS_STATUS
+    //!         MOS_STATUS_SUCCESS if found, MOS_STATUS_UNKNOWN if the key does
+    //!         not exist, else the error from parsing the file
+    //!
+    MOS_STATUS GetKeyNameById(const char *fileName, void *ufKey, char *keyName);
+
+    //!
+    //! \brief  Force the next read to parse the file again
+    //! \details  Called after the driver wrote the file, as a write within the
+    //!           mtime granularity may leave inode, size and mtime unchanged.
+    //!
+    void Invalidate()
+    {
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    //!
+    //! \brief  Drop the published snapshot
+    //! \details  It is freed once no reader holds it any more.
+    //!
+    void Clear();
+
+protected:
+    struct Snapshot
+    {
+        ~Snapshot()
+        {
+            if (pfnFreeKeyList)
+            {
+                pfnFreeKeyList(keyList);
+            }
+        }
+
+        std::string                                         fileName;
+        bool                                                exists;
+        dev_t                                               dev;
+        ino_t                                               ino;
+        off_t                                               size;
+        struct timespec                                     mtime;
+        uint32_t                                            generation;
+        MOS_STATUS                                          status;
+        MOS_PUF_KEYLIST                                     keyList         = nullptr;
+        PFN_MOS_UF_FREE_KEY_LIST                            pfnFreeKeyList  = nullptr;
+        std::unordered_map<std::string, MOS_UF_KEY *>       keys;       //!< Key name to key
+        std::unordered_map<uintptr_t, MOS_UF_KEY *>         ids;        //!< Key id to key
+        std::unordered_map<std::string, MOS_UF_VALUE *>     values;     //!< Key name '\n' value name to value
+    };
+
+    typedef std::shared_ptr<Snapshot> SnapshotPtr;
+
+    //!
+    //! \brief  Get the snapshot of the current file content, parsing it if needed
+    //! \details  The snapshot stays valid while the returned reference is held,
+    //!           even if the file is parsed again meanwhile.
+    //!
+    SnapshotPtr Acquire(const char *fileName);
+
+    bool IsUpToDate(const Snapshot *snapshot, const char *fileName, bool exists, const struct stat &fileStat, uint32_t generation);
+
+    SnapshotPtr Parse(const char *fileName, bool exists, const struct stat &fileStat, uint32_t generation);
+
+    PFN_MOS_UF_DUMP_FILE        m_pfnDumpFile       = nullptr;
+    PFN_MOS_UF_FREE_KEY_LIST    m_pfnFreeKeyList    = nullptr;
+    SnapshotPtr                 m_current;                          //!< Published snapshot, only accessed with std::atomic_load/store
+    std::atomic<uint32_t>       m_generation;                       //!< Bumped by Invalidate
+    std::mutex                  m_parseMutex;                       //!< Serializes parsing
+};
+
+#endif // __MOS_USER_FEATURE_STORE_H__
@@ -47,6 +47,9 @@
 #include <unistd.h>  // fork
 
 const char *MosUtilitiesSpecificNext::m_szUserFeatureFile = USER_FEATURE_FILE;
+MosUserFeatureStore MosUtilitiesSpecificNext::m_userFeatureStore(
+    MosUtilitiesSpecificNext::UserFeatureDumpFile,
+    MosUtilitiesSpecificNext::UserFeatureFreeKeyList);
 
 double MosUtilities::MosGetTime()
 {
@@ -1072,6 +1075,7 @@ MOS_STATUS  MosUtilitiesSpecificNext::UserFeatureSetValue(
     if ( ( eStatus = UserFeatureSet(&pKeyList, NewKey)) == MOS_STATUS_SUCCESS )
     {
         eStatus = UserFeatureDumpDataToFile(m_szUserFeatureFile, pKeyList);
+        m_userFeatureStore.Invalidate();
     }
 
     UserFeatureFreeKeyList(pKeyList);
@@ -1085,91 +1089,23 @@ MOS_STATUS MosUtilitiesSpecificNext::UserFeatureQueryValue(
     void                *pData,
     int32_t             *nDataSize)
 {
-    MOS_UF_KEY          NewKey;
-    MOS_UF_VALUE        NewValue;
-    size_t              nKeyLen, nValueLen;
-    MOS_STATUS          eStatus;
-    MOS_PUF_KEYLIST     pKeyList;
-    char                strTempKey[MAX_USERFEATURE_LINE_LENGTH];
-    char                strTempValueName[MAX_USERFEATURE_LINE_LENGTH];
-
-    eStatus   = MOS_STATUS_UNKNOWN;
-    pKeyList   = nullptr;
-
     if ( (strKey == nullptr) || (pcValueName == nullptr))
     {
         return MOS_STATUS_INVALID_PARAMETER;
     }
-    MosUtilities::MosZeroMemory(NewValue.pcValueName, MAX_USERFEATURE_LINE_LENGTH);
-    MosUtilities::MosSecureStrcpy(NewValue.pcValueName, MAX_USERFEATURE_LINE_LENGTH, pcValueName);
-    NewValue.ulValueBuf     = pData;
-
-    MosUtilities::MosZeroMemory(NewKey.pcKeyName, MAX_USERFEATURE_LINE_LENGTH);
-    MosUtilities::MosSecureStrcpy(NewKey.pcKeyName, MAX_USERFEATURE_LINE_LENGTH, strKey);
-    NewKey.pValueArray = &NewValue;
-    NewKey.ulValueNum = 1;
 
-    if ((eStatus = UserFeatureDumpFile(m_szUserFeatureFile, &pKeyList)) == MOS_STATUS_SUCCESS)
-    {
-        if ( (eStatus = UserFeatureQuery(pKeyList, &NewKey)) == MOS_STATUS_SUCCESS )
-        {
-            if(uiValueType != nullptr)
-            {
-                *uiValueType = NewKey.pValueArray[0].ulValueType;
-            }
-            if (nDataSize != nullptr)
-            {
-                *nDataSize   = NewKey.pValueArray[0].ulValueLen;
-            }
-        }
-    }
-    UserFeatureFreeKeyList(pKeyList);
-
-    return eStatus;
+    return m_userFeatureStore.QueryValue(m_szUserFeatureFile, strKey, pcValueName, uiValueType, pData, nDataSize);
 }
 
 MOS_STATUS MosUtilitiesSpecificNext::UserFeatureGetKeyIdbyName(const char  *pcKeyName, void **pUFKey)
 {
-    MOS_PUF_KEYLIST     pKeyList;
-    int32_t             iResult;
-    MOS_STATUS          eStatus;
-    MOS_PUF_KEYLIST     pTempNode;
-
-    pKeyList   = nullptr;
-    iResult    = -1;
-
-    if ((eStatus = UserFeatureDumpFile(m_szUserFeatureFile, &pKeyList)) !=
-        MOS_STATUS_SUCCESS )
-    {
-        UserFeatureFreeKeyList(pKeyList);
-        return eStatus;
-    }
-
-    eStatus   = MOS_STATUS_INVALID_PARAMETER;
-
-    for(pTempNode=pKeyList; pTempNode; pTempNode=pTempNode->pNext)
-    {
-        iResult = strcmp(pTempNode->pElem->pcKeyName, pcKeyName);
-        if ( iResult == 0 )
-        {
-            *pUFKey = pTempNode->pElem->UFKey;
-            eStatus = MOS_STATUS_SUCCESS;
-            break;
-        }
-    }
-    UserFeatureFreeKeyList(pKeyList);
-
-    return eStatus;
+    return m_userFeatureStore.GetKeyIdByName(m_szUserFeatureFile, pcKeyName, pUFKey);
 }
 
 MOS_STATUS MosUtilitiesSpecificNext::UserFeatureGetKeyNamebyId(void  *UFKey, char  *pcKeyName)
 {
-    MOS_PUF_KEYLIST     pKeyList;
-    MOS_PUF_KEYLIST     pTempNode;
     MOS_STATUS          eStatus;
 
-    pKeyList   = nullptr;
-
     switch((uintptr_t)UFKey)
     {
     case UFKEY_INTERNAL:
@@ -1181,25 +1117,7 @@ MOS_STATUS MosUtilitiesSpecificNext::UserFeatureGetKeyNamebyId(void  *UFKey, cha
         eStatus = MOS_STATUS_SUCCESS;
         break;
     default:
-        if ((eStatus = UserFeatureDumpFile(m_szUserFeatureFile, &pKeyList)) !=
-            MOS_STATUS_SUCCESS )
-        {
-            UserFeatureFreeKeyList(pKeyList);
-            return eStatus;
-        }
-
-        eStatus   = MOS_STATUS_UNKNOWN;
-
-        for(pTempNode=pKeyList;pTempNode;pTempNode=pTempNode->pNext)
-        {
-            if(pTempNode->pElem->UFKey == UFKey)
-            {
-                MosUtilities::MosSecureStrcpy(pcKeyName, MAX_USERFEATURE_LINE_LENGTH, pTempNode->pElem->pcKeyName);
-                eStatus = MOS_STATUS_SUCCESS;
-                break;
-            }
-        }
-        UserFeatureFreeKeyList(pKeyList);
+        eStatus = m_userFeatureStore.GetKeyNameById(m_szUserFeatureFile, UFKey, pcKeyName);
         break;
     }
 
@@ -1376,6 +1294,8 @@ MOS_STATUS MosUtilities::MosOsUtilitiesClose(MOS_CONTEXT_HANDLE mosCtx)
     m_mosUtilInitCount--;
     if (m_mosUtilInitCount == 0)
     {
+        // The cached user feature file is not a leak, release it before counting.
+        MosUtilitiesSpecificNext::m_userFeatureStore.Clear();
         MosTraceEventClose();
         m_mosMemAllocCounter -= m_mosMemAllocFakeCounter;
         MemoryCounter = m_mosMemAllocCounter + m_mosMemAllocCounterGfx;
@@ -1388,6 +1308,7 @@ MOS_STATUS MosUtilities::MosOsUtilitiesClose(MOS_CONTEXT_HANDLE mosCtx)
         MosUserFeatureWriteValuesID(NULL, &UserFeatureWriteData, 1, mosCtx);
 
         eStatus = MosDestroyUserFeatureKeysForAllDescFields();
+        MosUtilitiesSpecificNext::m_userFeatureStore.Clear();
 #if _MEDIA_RESERVED
         if (m_codecUserFeatureExt)
         {
@@ -28,6 +28,7 @@
 
 #include "mos_defs.h"
 #include "mos_utilities_specific.h"
+#include "mos_user_feature_store.h"
 
 class MosUtilitiesSpecificNext
 {
@@ -289,6 +290,7 @@ private:
 
 public:
     static const char*          m_szUserFeatureFile;
+    static MosUserFeatureStore  m_userFeatureStore;     //!< Parsed user feature file shared by all queries
     static int32_t              m_mosTraceFd;
     static const char* const    m_mosTracePath;
 };